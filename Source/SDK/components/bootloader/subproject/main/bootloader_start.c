@@ -10,6 +10,7 @@
 #include "bootloader_utility.h"
 #include "bootloader_common.h"
 #include "bootloader_hooks.h"
+#include "esp_boot_trace.h"
 
 static const char *TAG = "boot";
 
@@ -23,6 +24,8 @@ static int selected_boot_partition(const bootloader_state_t *bs);
  */
 void __attribute__((noreturn)) call_start_cpu0(void)
 {
+    esp_boot_trace_mark(ESP_BOOT_TRACE_BOOTLOADER_START);
+
     // (0. Call the before-init hook, if available)
     if (bootloader_before_init) {
         bootloader_before_init();
@@ -37,6 +40,7 @@ void __attribute__((noreturn)) call_start_cpu0(void)
     if (bootloader_after_init) {
         bootloader_after_init();
     }
+    esp_boot_trace_mark(ESP_BOOT_TRACE_BOOTLOADER_INIT);
 
 #ifdef CONFIG_BOOTLOADER_SKIP_VALIDATE_IN_DEEP_SLEEP
     // If this boot is a wake up from the deep sleep then go to the short way,
@@ -52,6 +56,7 @@ void __attribute__((noreturn)) call_start_cpu0(void)
     if (boot_index == INVALID_INDEX) {
         bootloader_reset();
     }
+    esp_boot_trace_mark(ESP_BOOT_TRACE_PARTITION_SELECTED);
 
     // 3. Load the app image for booting
     bootloader_utility_load_boot_image(&bs, boot_index);
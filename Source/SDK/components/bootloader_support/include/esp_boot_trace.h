@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Boot markers, in the order they are reached on a normal boot
+ */
+typedef enum {
+    ESP_BOOT_TRACE_BOOTLOADER_START,    /*!< Second stage bootloader entry, before the before-init hook */
+    ESP_BOOT_TRACE_BOOTLOADER_CLOCK,    /*!< Bootloader clocks and console configured */
+    ESP_BOOT_TRACE_BOOTLOADER_FLASH,    /*!< Bootloader SPI flash configured */
+    ESP_BOOT_TRACE_BOOTLOADER_INIT,     /*!< bootloader_init and the after-init hook done */
+    ESP_BOOT_TRACE_PARTITION_SELECTED,  /*!< Partition table read and boot partition selected */
+    ESP_BOOT_TRACE_IMAGE_LOAD,          /*!< App image header read */
+    ESP_BOOT_TRACE_IMAGE_SEGMENTS,      /*!< App segments loaded and checksummed */
+    ESP_BOOT_TRACE_IMAGE_VERIFIED,      /*!< App hash or signature verified */
+    ESP_BOOT_TRACE_APP_START,           /*!< App entry, flash cache configured */
+    ESP_BOOT_TRACE_APP_CLOCK,           /*!< App clocks configured */
+    ESP_BOOT_TRACE_CORE_INIT,           /*!< Core components and services initialized */
+    ESP_BOOT_TRACE_GLOBAL_CTORS,        /*!< C++ constructors run */
+    ESP_BOOT_TRACE_SECONDARY_INIT,      /*!< Component init functions run, the scheduler starts next */
+    ESP_BOOT_TRACE_MAX,
+} esp_boot_trace_marker_t;
+
+#if CONFIG_BOOTLOADER_BOOT_TRACE
+
+/**
+ * @brief Record the time a boot marker is reached
+ *
+ * The time is kept as RTC slow clock ticks since ESP_BOOT_TRACE_BOOTLOADER_START, in the
+ * custom part of the RTC FAST memory retained by the bootloader, so that the bootloader
+ * markers survive until the app reads them. ESP_BOOT_TRACE_BOOTLOADER_START starts a new
+ * trace.
+ *
+ * Note: On ESP32, only the PRO_CPU can access RTC FAST memory, calls from the APP_CPU are
+ *       ignored.
+ *
+ * @param marker Boot marker reached
+ */
+void esp_boot_trace_mark(esp_boot_trace_marker_t marker);
+
+#ifndef BOOTLOADER_BUILD
+/**
+ * @brief Read the boot trace of the current boot
+ *
+ * Ticks are converted with the current slow clock calibration.
+ *
+ * Note: Make sure that this function is used only PRO_CPU.
+ *
+ * @param[out] time_us Microseconds from ESP_BOOT_TRACE_BOOTLOADER_START to each marker,
+ *                     0 for markers that were not reached
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if time_us is NULL
+ *      - ESP_ERR_INVALID_STATE if called from the APP_CPU
+ *      - ESP_ERR_NOT_FOUND if the bootloader did not record a trace
+ */
+esp_err_t esp_boot_trace_get(uint32_t time_us[ESP_BOOT_TRACE_MAX]);
+
+/**
+ * @brief Microseconds elapsed since ESP_BOOT_TRACE_BOOTLOADER_START
+ *
+ * Used to put app markers on the same time base as the boot trace.
+ *
+ * @return Microseconds since the bootloader started, 0 if the bootloader did not record a trace
+ */
+uint32_t esp_boot_trace_elapsed_us(void);
+#endif // BOOTLOADER_BUILD
+
+#else
+
+static inline void esp_boot_trace_mark(esp_boot_trace_marker_t marker)
+{
+    (void)marker;
+}
+
+#endif // CONFIG_BOOTLOADER_BOOT_TRACE
+
+#ifdef __cplusplus
+}
+#endif
@@ -146,7 +146,14 @@ static void update_rtc_retain_mem_crc(void)
 
 NOINLINE_ATTR void bootloader_common_reset_rtc_retain_mem(void)
 {
+#if CONFIG_BOOTLOADER_BOOT_TRACE
+    /* The custom memory already holds the boot trace of this boot, it is not part of the CRC */
+    rtc_retain_mem_t* rtc_retain_mem = bootloader_common_get_rtc_retain_mem();
+    hal_memset(rtc_retain_mem, 0, offsetof(rtc_retain_mem_t, custom));
+    rtc_retain_mem->crc = 0;
+#else
     hal_memset(bootloader_common_get_rtc_retain_mem(), 0, sizeof(rtc_retain_mem_t));
+#endif
 }
 
 uint16_t bootloader_common_get_rtc_retain_mem_reboot_counter(void)
@@ -36,6 +36,7 @@
 #include "esp_rom_sys.h"
 #include "esp_rom_spiflash.h"
 #include "esp_efuse.h"
+#include "esp_boot_trace.h"
 
 static const char *TAG = "boot.esp32";
 
@@ -207,6 +208,7 @@ esp_err_t bootloader_init(void)
     bootloader_console_init();
     /* print 2nd bootloader banner */
     bootloader_print_banner();
+    esp_boot_trace_mark(ESP_BOOT_TRACE_BOOTLOADER_CLOCK);
 
 #if !CONFIG_APP_BUILD_TYPE_RAM
     // reset MMU
@@ -230,6 +232,7 @@ esp_err_t bootloader_init(void)
     if ((ret = bootloader_init_spi_flash()) != ESP_OK) {
         return ret;
     }
+    esp_boot_trace_mark(ESP_BOOT_TRACE_BOOTLOADER_FLASH);
 #endif // #if !CONFIG_APP_BUILD_TYPE_RAM
 
     // check whether a WDT reset happend
@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdint.h>
+#include <string.h>
+#include "esp_assert.h"
+#include "esp_cpu.h"
+#include "esp_image_format.h"
+#include "bootloader_common.h"
+#include "esp_boot_trace.h"
+#include "soc/rtc.h"
+#ifndef BOOTLOADER_BUILD
+#include "esp_private/esp_clk.h"
+#endif
+
+#define BOOT_TRACE_MAGIC    0x54425345  /* "ESBT" */
+
+/* Kept at the start of rtc_retain_mem_t::custom, which the bootloader does not reset while the trace is enabled */
+typedef struct {
+    uint32_t magic;
+    uint32_t start_lo;                      /* RTC time of ESP_BOOT_TRACE_BOOTLOADER_START */
+    uint32_t start_hi;
+    uint32_t ticks[ESP_BOOT_TRACE_MAX];     /* Ticks since start_lo/start_hi, 0 when not reached */
+} boot_trace_t;
+
+ESP_STATIC_ASSERT(sizeof(boot_trace_t) <= CONFIG_BOOTLOADER_CUSTOM_RESERVE_RTC_SIZE,
+                  "CONFIG_BOOTLOADER_CUSTOM_RESERVE_RTC_SIZE is too small for the boot trace");
+
+static inline boot_trace_t *boot_trace(void)
+{
+    return (boot_trace_t *)bootloader_common_get_rtc_retain_mem()->custom;
+}
+
+static inline uint64_t boot_trace_start(const boot_trace_t *trace)
+{
+    return ((uint64_t)trace->start_hi << 32) | trace->start_lo;
+}
+
+void esp_boot_trace_mark(esp_boot_trace_marker_t marker)
+{
+    if (marker >= ESP_BOOT_TRACE_MAX || esp_cpu_get_core_id() != 0) {
+        return;
+    }
+    boot_trace_t *trace = boot_trace();
+    uint64_t now = rtc_time_get();
+
+    if (marker == ESP_BOOT_TRACE_BOOTLOADER_START) {
+        memset(trace, 0, sizeof(*trace));
+        trace->start_lo = (uint32_t)now;
+        trace->start_hi = (uint32_t)(now >> 32);
+        trace->magic = BOOT_TRACE_MAGIC;
+    } else if (trace->magic == BOOT_TRACE_MAGIC) {
+        uint64_t ticks = now - boot_trace_start(trace);
+        /* 0 stands for a marker that was not reached */
+        trace->ticks[marker] = (ticks > UINT32_MAX) ? UINT32_MAX : ((ticks == 0) ? 1 : (uint32_t)ticks);
+    }
+}
+
+#ifndef BOOTLOADER_BUILD
+
+esp_err_t esp_boot_trace_get(uint32_t time_us[ESP_BOOT_TRACE_MAX])
+{
+    if (time_us == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (esp_cpu_get_core_id() != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const boot_trace_t *trace = boot_trace();
+    if (trace->magic != BOOT_TRACE_MAGIC) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t cal = esp_clk_slowclk_cal_get();
+    for (int i = 0; i < ESP_BOOT_TRACE_MAX; i++) {
+        time_us[i] = (trace->ticks[i] == 0) ? 0 : (uint32_t)rtc_time_slowclk_to_us(trace->ticks[i], cal);
+    }
+    return ESP_OK;
+}
+
+uint32_t esp_boot_trace_elapsed_us(void)
+{
+    if (esp_cpu_get_core_id() != 0) {
+        return 0;
+    }
+    const boot_trace_t *trace = boot_trace();
+    if (trace->magic != BOOT_TRACE_MAGIC) {
+        return 0;
+    }
+    uint64_t ticks = rtc_time_get() - boot_trace_start(trace);
+    return (uint32_t)rtc_time_slowclk_to_us(ticks, esp_clk_slowclk_cal_get());
+}
+
+#endif // BOOTLOADER_BUILD
@@ -22,6 +22,7 @@
 #include "bootloader_memory_utils.h"
 #include "soc/soc_caps.h"
 #include "hal/cache_ll.h"
+#include "esp_boot_trace.h"
 
 #define ALIGN_UP(num, align) (((num) + ((align) - 1)) & ~((align) - 1))
 
@@ -145,7 +146,13 @@ static esp_err_t image_load(esp_image_load_mode_t mode, const esp_partition_pos_
 
     bootloader_sha256_handle_t *p_sha_handle = &sha_handle;
     CHECK_ERR(process_image_header(data, part->offset, (verify_sha) ? p_sha_handle : NULL, do_verify, silent));
+    if (do_load) {
+        esp_boot_trace_mark(ESP_BOOT_TRACE_IMAGE_LOAD);
+    }
     CHECK_ERR(process_segments(data, silent, do_load, sha_handle, checksum));
+    if (do_load) {
+        esp_boot_trace_mark(ESP_BOOT_TRACE_IMAGE_SEGMENTS);
+    }
     bool skip_check_checksum = !do_verify || esp_cpu_dbgr_is_attached();
     CHECK_ERR(process_checksum(sha_handle, checksum_word, data, silent, skip_check_checksum));
     CHECK_ERR(process_appended_hash_and_sig(data, part->offset, part->size, do_verify, silent));
@@ -182,6 +189,9 @@ static esp_err_t image_load(esp_image_load_mode_t mode, const esp_partition_pos_
     if (err != ESP_OK) {
         goto err;
     }
+    if (do_load) {
+        esp_boot_trace_mark(ESP_BOOT_TRACE_IMAGE_VERIFIED);
+    }
 
 #ifdef BOOTLOADER_BUILD
 
@@ -124,6 +124,8 @@ struct httpd_data {
     struct sock_db *hd_sd;                  /*!< The socket database */
     int hd_sd_active_count;                 /*!< The number of the active sockets */
     httpd_uri_t **hd_calls;                 /*!< Registered URI handlers */
+    struct httpd_uri_trie *hd_uri_trie;     /*!< Routing trie compiled from hd_calls, NULL if not compiled */
+    bool hd_uri_trie_stale;                 /*!< hd_calls changed since the routing trie was compiled */
     struct httpd_req hd_req;                /*!< The current HTTPD request */
     struct httpd_req_aux hd_req_aux;        /*!< Additional data about the HTTPD request kept unexposed */
     uint64_t lru_counter;                   /*!< LRU counter */
@@ -315,7 +317,7 @@ void httpd_sess_close_all(struct httpd_data *hd);
 esp_err_t httpd_uri(struct httpd_data *hd);
 
 /**
- * @brief   Unregister all URI handlers
+ * @brief   Unregister all URI handlers and free the routing trie
  *
  * @param[in] hd  Server instance data
  */
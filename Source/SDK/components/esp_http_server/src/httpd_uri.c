@@ -123,6 +123,216 @@ static httpd_uri_t* httpd_find_uri_handler(struct httpd_data *hd,
     return NULL;
 }
 
+/* Routing trie
+ *
+ * Requests are routed through a character trie compiled from hd_calls, so the
+ * cost of finding a handler depends on the length of the URI and not on the
+ * number of registered handlers. Every template is split into the URIs it
+ * matches with httpd_uri_match_wildcard():
+ *      "/a"    : exactly "/a"
+ *      "/a*"   : anything starting with "/a"
+ *      "/ab?"  : exactly "/a" or exactly "/ab"
+ *      "/ab?*" : exactly "/a" or anything starting with "/ab"
+ * and a route to the handler is attached to the trie node where each of these
+ * ends. Among the routes found along the URI, the earliest registered handler
+ * wins, as it would with the linear search. Templates handled by a custom
+ * uri_match_fn can't be split, the linear search is used for those.
+ *
+ * The trie is only compiled and used by the server task, when a request comes
+ * in after hd_calls has changed, so it is never freed under a running lookup.
+ */
+#define HTTPD_URI_TRIE_NONE     UINT16_MAX
+
+struct httpd_uri_trie_node {
+    uint16_t child;                     /*!< First child node */
+    uint16_t sibling;                   /*!< Next child node of the same parent */
+    uint16_t exact;                     /*!< First route for URIs ending at this node */
+    uint16_t prefix;                    /*!< First route for URIs going through this node */
+    char c;                             /*!< Character leading to this node */
+};
+
+struct httpd_uri_trie_route {
+    uint16_t handler;                   /*!< Index of the handler in hd_calls */
+    uint16_t next;                      /*!< Next route of the same node */
+};
+
+struct httpd_uri_trie {
+    struct httpd_uri_trie_node *nodes;
+    struct httpd_uri_trie_route *routes;
+    uint16_t node_count;
+    uint16_t route_count;
+};
+
+static uint16_t httpd_uri_trie_insert(struct httpd_uri_trie *trie, const char *path, size_t len)
+{
+    uint16_t node = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint16_t child = trie->nodes[node].child;
+        while (child != HTTPD_URI_TRIE_NONE && trie->nodes[child].c != path[i]) {
+            child = trie->nodes[child].sibling;
+        }
+        if (child == HTTPD_URI_TRIE_NONE) {
+            child = trie->node_count++;
+            trie->nodes[child] = (struct httpd_uri_trie_node) {
+                .child   = HTTPD_URI_TRIE_NONE,
+                .sibling = trie->nodes[node].child,
+                .exact   = HTTPD_URI_TRIE_NONE,
+                .prefix  = HTTPD_URI_TRIE_NONE,
+                .c       = path[i],
+            };
+            trie->nodes[node].child = child;
+        }
+        node = child;
+    }
+    return node;
+}
+
+static void httpd_uri_trie_add_route(struct httpd_uri_trie *trie, const char *path,
+                                     size_t len, bool prefix, uint16_t handler)
+{
+    struct httpd_uri_trie_node *node = &trie->nodes[httpd_uri_trie_insert(trie, path, len)];
+    uint16_t *head = prefix ? &node->prefix : &node->exact;
+
+    trie->routes[trie->route_count] = (struct httpd_uri_trie_route) {
+        .handler = handler,
+        .next    = *head,
+    };
+    *head = trie->route_count++;
+}
+
+static void httpd_uri_trie_free(struct httpd_data *hd)
+{
+    free(hd->hd_uri_trie);
+    hd->hd_uri_trie = NULL;
+}
+
+/* Compile the routing trie from hd_calls. On failure the trie is left
+ * NULL and requests fall back to the linear search */
+static void httpd_uri_trie_compile(struct httpd_data *hd)
+{
+    httpd_uri_trie_free(hd);
+    hd->hd_uri_trie_stale = false;
+
+    const bool wildcard = hd->config.uri_match_fn == httpd_uri_match_wildcard;
+    if (hd->config.uri_match_fn && !wildcard) {
+        return;
+    }
+
+    /* Each template character adds at most one node, and each
+     * template is split into at most two routes */
+    size_t max_nodes = 1, max_routes = 0;
+    for (int i = 0; i < hd->config.max_uri_handlers && hd->hd_calls[i]; i++) {
+        max_nodes += strlen(hd->hd_calls[i]->uri);
+        max_routes += 2;
+    }
+    if (max_nodes >= HTTPD_URI_TRIE_NONE || max_routes >= HTTPD_URI_TRIE_NONE) {
+        return;
+    }
+
+    struct httpd_uri_trie *trie = malloc(sizeof(struct httpd_uri_trie) +
+                                         max_nodes * sizeof(struct httpd_uri_trie_node) +
+                                         max_routes * sizeof(struct httpd_uri_trie_route));
+    if (trie == NULL) {
+        ESP_LOGW(TAG, LOG_FMT("no memory for routing trie, using linear search"));
+        return;
+    }
+    trie->nodes = (struct httpd_uri_trie_node *) (trie + 1);
+    trie->routes = (struct httpd_uri_trie_route *) (trie->nodes + max_nodes);
+    trie->nodes[0] = (struct httpd_uri_trie_node) {
+        .child   = HTTPD_URI_TRIE_NONE,
+        .sibling = HTTPD_URI_TRIE_NONE,
+        .exact   = HTTPD_URI_TRIE_NONE,
+        .prefix  = HTTPD_URI_TRIE_NONE,
+    };
+    trie->node_count = 1;
+    trie->route_count = 0;
+
+    for (int i = 0; i < hd->config.max_uri_handlers && hd->hd_calls[i]; i++) {
+        const char *tpl = hd->hd_calls[i]->uri;
+        const size_t tpl_len = strlen(tpl);
+
+        if (!wildcard) {
+            httpd_uri_trie_add_route(trie, tpl, tpl_len, false, i);
+            continue;
+        }
+
+        /* Same parsing as httpd_uri_match_wildcard() */
+        const char last = (const char) (tpl_len > 0 ? tpl[tpl_len - 1] : 0);
+        const char prevlast = (const char) (tpl_len > 1 ? tpl[tpl_len - 2] : 0);
+        const bool asterisk = last == '*' || (prevlast == '*' && last == '?');
+        const bool quest = last == '?' || (prevlast == '?' && last == '*');
+
+        if (tpl_len < asterisk + quest*2) {
+            /* Invalid template, never matches */
+            continue;
+        }
+        const size_t exact_match_chars = tpl_len - (asterisk + quest*2);
+
+        if (quest) {
+            /* Without the optional character */
+            httpd_uri_trie_add_route(trie, tpl, exact_match_chars, false, i);
+            /* With the optional character */
+            httpd_uri_trie_add_route(trie, tpl, exact_match_chars + 1, asterisk, i);
+        } else {
+            httpd_uri_trie_add_route(trie, tpl, exact_match_chars, asterisk, i);
+        }
+    }
+
+    ESP_LOGD(TAG, LOG_FMT("routing trie compiled, %d nodes %d routes"),
+             trie->node_count, trie->route_count);
+    hd->hd_uri_trie = trie;
+}
+
+/* Scan the routes of a trie node, keeping the earliest registered
+ * handler supporting the method in best */
+static void httpd_uri_trie_match_routes(const struct httpd_data *hd, uint16_t route,
+                                        httpd_method_t method, int *best, bool *uri_found)
+{
+    const struct httpd_uri_trie *trie = hd->hd_uri_trie;
+    for (; route != HTTPD_URI_TRIE_NONE; route = trie->routes[route].next) {
+        const int i = trie->routes[route].handler;
+        *uri_found = true;
+        if ((*best < 0 || i < *best) &&
+            (hd->hd_calls[i]->method == method || hd->hd_calls[i]->method == HTTP_ANY)) {
+            *best = i;
+        }
+    }
+}
+
+/* Same as httpd_find_uri_handler(), going through the routing trie */
+static httpd_uri_t* httpd_uri_trie_find(struct httpd_data *hd,
+                                        const char *uri, size_t uri_len,
+                                        httpd_method_t method,
+                                        httpd_err_code_t *err)
+{
+    const struct httpd_uri_trie *trie = hd->hd_uri_trie;
+    int best = -1;
+    bool uri_found = false;
+    uint16_t node = 0;
+
+    for (size_t depth = 0; ; depth++) {
+        httpd_uri_trie_match_routes(hd, trie->nodes[node].prefix, method, &best, &uri_found);
+        if (depth == uri_len) {
+            httpd_uri_trie_match_routes(hd, trie->nodes[node].exact, method, &best, &uri_found);
+            break;
+        }
+        node = trie->nodes[node].child;
+        while (node != HTTPD_URI_TRIE_NONE && trie->nodes[node].c != uri[depth]) {
+            node = trie->nodes[node].sibling;
+        }
+        if (node == HTTPD_URI_TRIE_NONE) {
+            break;
+        }
+    }
+
+    if (best >= 0) {
+        *err = 0;
+        return hd->hd_calls[best];
+    }
+    *err = uri_found ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND;
+    return NULL;
+}
+
 esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
                                      const httpd_uri_t *uri_handler)
 {
@@ -174,6 +384,7 @@ esp_err_t httpd_register_uri_handler(httpd_handle_t handle,
             }
 #endif
             ESP_LOGD(TAG, LOG_FMT("[%d] installed %s"), i, uri_handler->uri);
+            hd->hd_uri_trie_stale = true;
             return ESP_OK;
         }
         ESP_LOGD(TAG, LOG_FMT("[%d] exists %s"), i, hd->hd_calls[i]->uri);
@@ -212,6 +423,7 @@ esp_err_t httpd_unregister_uri_handler(httpd_handle_t handle,
             }
             /* Nullify the following non null entry */
             hd->hd_calls[i-1] = NULL;
+            hd->hd_uri_trie_stale = true;
             return ESP_OK;
         }
     }
@@ -255,6 +467,8 @@ esp_err_t httpd_unregister_uri(httpd_handle_t handle, const char *uri)
 
     if (!found) {
         ESP_LOGW(TAG, LOG_FMT("no handler found for URI %s"), uri);
+    } else {
+        hd->hd_uri_trie_stale = true;
     }
     return (found ? ESP_OK : ESP_ERR_NOT_FOUND);
 }
@@ -271,6 +485,7 @@ void httpd_unregister_all_uri_handlers(struct httpd_data *hd)
         free(hd->hd_calls[i]);
         hd->hd_calls[i] = NULL;
     }
+    httpd_uri_trie_free(hd);
 }
 
 esp_err_t httpd_uri(struct httpd_data *hd)
@@ -284,10 +499,20 @@ esp_err_t httpd_uri(struct httpd_data *hd)
 
     ESP_LOGD(TAG, LOG_FMT("request for %s with type %d"), req->uri, req->method);
 
+    /* Handlers were registered or unregistered since the last request */
+    if (hd->hd_uri_trie_stale) {
+        httpd_uri_trie_compile(hd);
+    }
+
     /* URL parser result contains offset and length of path string */
     if (res->field_set & (1 << UF_PATH)) {
-        uri = httpd_find_uri_handler(hd, req->uri + res->field_data[UF_PATH].off,
-                                     res->field_data[UF_PATH].len, req->method, &err);
+        if (hd->hd_uri_trie) {
+            uri = httpd_uri_trie_find(hd, req->uri + res->field_data[UF_PATH].off,
+                                      res->field_data[UF_PATH].len, req->method, &err);
+        } else {
+            uri = httpd_find_uri_handler(hd, req->uri + res->field_data[UF_PATH].off,
+                                         res->field_data[UF_PATH].len, req->method, &err);
+        }
     }
 
     /* If URI with method not found, respond with error code */
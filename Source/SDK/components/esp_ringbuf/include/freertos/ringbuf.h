@@ -65,6 +65,14 @@ typedef struct xSTATIC_RINGBUFFER {
     /** @endcond */
 } StaticRingbuffer_t;
 
+/**
+ * @brief Item retrieved from a no-split ring buffer by xRingbufferReceiveMultiple()
+ */
+typedef struct {
+    void *pvItem;       /**< Pointer to the item's data inside the ring buffer */
+    size_t xItemSize;   /**< Size of the item in bytes */
+} RingbufItem_t;
+
 /**
  * @brief       Create a ring buffer
  *
@@ -214,6 +222,54 @@ BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, s
  */
 BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem);
 
+/**
+ * @brief Acquire memory for several items from the ring buffer at once
+ *
+ * Attempt to allocate buffers for uxItemCount items in one step. Either all of
+ * the buffers are acquired or none of them are. This function will block until
+ * enough free space is available for all of the items or until it times out.
+ *
+ * The buffers are acquired in array order, i.e. the item in ppvItems[0] will be
+ * received first. Each buffer must be sent with ``xRingbufferSendComplete`` or
+ * ``xRingbufferSendCompleteMultiple``.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to allocate the memory
+ * @param[out]  ppvItems        Array of uxItemCount pointers to the memory acquired (all set to NULL on failure)
+ * @param[in]   pxItemSizes     Array of uxItemCount item sizes to acquire
+ * @param[in]   uxItemCount     Number of items to acquire
+ * @param[in]   xTicksToWait    Ticks to wait for room in the ring buffer.
+ *
+ * @note Only applicable for no-split ring buffers.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE on time-out or when the items are larger than the maximum permissible size of the buffer
+ */
+BaseType_t xRingbufferSendAcquireMultiple(RingbufHandle_t xRingbuffer,
+                                          void **ppvItems,
+                                          const size_t *pxItemSizes,
+                                          UBaseType_t uxItemCount,
+                                          TickType_t xTicksToWait);
+
+/**
+ * @brief       Actually send several items into the ring buffer allocated
+ *              before by ``xRingbufferSendAcquire`` or ``xRingbufferSendAcquireMultiple``.
+ *
+ * Equivalent to calling ``xRingbufferSendComplete`` for each item, but the
+ * ring buffer is only locked once.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to insert the items into
+ * @param[in]   ppvItems        Array of pointers to items in allocated memory to insert.
+ * @param[in]   uxItemCount     Number of items in ppvItems
+ *
+ * @note Only applicable for no-split ring buffers.
+ *
+ * @return
+ *      - pdTRUE if succeeded
+ *      - pdFALSE if fail for some reason.
+ */
+BaseType_t xRingbufferSendCompleteMultiple(RingbufHandle_t xRingbuffer, void * const *ppvItems, UBaseType_t uxItemCount);
+
 /**
  * @brief   Retrieve an item from the ring buffer
  *
@@ -362,6 +418,44 @@ void *xRingbufferReceiveUpTo(RingbufHandle_t xRingbuffer,
  */
 void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemSize, size_t xMaxSize);
 
+/**
+ * @brief   Retrieve all available items from a no-split ring buffer
+ *
+ * Attempt to retrieve up to uxMaxItems items from the ring buffer without
+ * copying them. This function will block until at least one item is available
+ * or until it times out. All other items available at that time are then
+ * retrieved as well, and the ring buffer is locked only once for them.
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the items from
+ * @param[out]  pxItems         Array of at least uxMaxItems entries, filled in FIFO order
+ * @param[in]   uxMaxItems      Maximum number of items to retrieve, must be greater than 0
+ * @param[in]   xTicksToWait    Ticks to wait for items in the ring buffer.
+ *
+ * @note    The items must be returned, e.g. by calling vRingbufferReturnItems().
+ * @note    This function should only be called on no-split buffers
+ *
+ * @return  Number of items retrieved, 0 on timeout
+ */
+UBaseType_t xRingbufferReceiveMultiple(RingbufHandle_t xRingbuffer, RingbufItem_t *pxItems, UBaseType_t uxMaxItems, TickType_t xTicksToWait);
+
+/**
+ * @brief   Retrieve all available items from a no-split ring buffer in an ISR
+ *
+ * Attempt to retrieve up to uxMaxItems items from the ring buffer without
+ * copying them. This function returns immediately if there are no items
+ * available for retrieval
+ *
+ * @param[in]   xRingbuffer     Ring buffer to retrieve the items from
+ * @param[out]  pxItems         Array of at least uxMaxItems entries, filled in FIFO order
+ * @param[in]   uxMaxItems      Maximum number of items to retrieve
+ *
+ * @note    Calls to vRingbufferReturnItemFromISR() are required after this to free the items retrieved.
+ * @note    This function should only be called on no-split buffers
+ *
+ * @return  Number of items retrieved, 0 when the ring buffer is empty
+ */
+UBaseType_t xRingbufferReceiveMultipleFromISR(RingbufHandle_t xRingbuffer, RingbufItem_t *pxItems, UBaseType_t uxMaxItems);
+
 /**
  * @brief   Return a previously-retrieved item to the ring buffer
  *
@@ -384,6 +478,18 @@ void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
  */
 void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken);
 
+/**
+ * @brief   Return several previously-retrieved items to the ring buffer
+ *
+ * Equivalent to calling vRingbufferReturnItem() for each item, but the ring
+ * buffer is only locked once.
+ *
+ * @param[in]   xRingbuffer Ring buffer the items were retrieved from
+ * @param[in]   pxItems     Items that were received earlier, e.g. by xRingbufferReceiveMultiple()
+ * @param[in]   uxItemCount Number of items in pxItems
+ */
+void vRingbufferReturnItems(RingbufHandle_t xRingbuffer, const RingbufItem_t *pxItems, UBaseType_t uxItemCount);
+
 /**
  * @brief   Delete a ring buffer
  *
@@ -149,6 +149,14 @@ static void *prvGetItemByteBuf(Ringbuffer_t *pxRingbuffer,
                                size_t xMaxSize,
                                size_t *pxItemSize);
 
+/*
+Retrieve up to uxMaxItems items from a no-split ring buffer
+Exit:
+    - Every item available for retrieval (up to uxMaxItems) is returned in pxItems
+    - Returns the number of items retrieved, which can be 0
+*/
+static UBaseType_t prvGetItemsNoSplit(Ringbuffer_t *pxRingbuffer, RingbufItem_t *pxItems, UBaseType_t uxMaxItems);
+
 /*
 Return an item to a split/no-split ring buffer
 Exit:
@@ -169,15 +177,25 @@ static size_t prvGetCurMaxSizeAllowSplit(Ringbuffer_t *pxRingbuffer);
 //Get the maximum size an item that can currently have if sent to a byte buffer
 static size_t prvGetCurMaxSizeByteBuf(Ringbuffer_t *pxRingbuffer);
 
+/*
+Acquire buffers for several items in a no-split ring buffer
+Exit:
+    - pdTRUE if all items fit. ppvItems[] filled and pucAcquire updated past the last item
+    - pdFALSE if any item does not fit. No buffer is acquired, ppvItems[] are set to NULL and pucAcquire is left unchanged
+*/
+static BaseType_t prvAcquireItemsNoSplit(Ringbuffer_t *pxRingbuffer, void **ppvItems, const size_t *pxItemSizes, UBaseType_t uxItemCount);
+
 /*
 Generic function used to send or acquire an item/buffer.
-- If sending, set ppvItem to NULL. pvItem remains unchanged on failure.
-- If acquiring, set pvItem to NULL. ppvItem remains unchanged on failure.
+- If sending, set ppvItem to NULL and uxItemCount to 1. pvItem remains unchanged on failure.
+- If acquiring, set pvItem to NULL. ppvItem points to an array of uxItemCount
+  pointers, which are either all acquired or set to NULL on failure.
 */
 static BaseType_t prvSendAcquireGeneric(Ringbuffer_t *pxRingbuffer,
                                         const void *pvItem,
                                         void **ppvItem,
-                                        size_t xItemSize,
+                                        const size_t *pxItemSizes,
+                                        UBaseType_t uxItemCount,
                                         TickType_t xTicksToWait);
 
 /*
@@ -360,6 +378,27 @@ static uint8_t* prvAcquireItemNoSplit(Ringbuffer_t *pxRingbuffer, size_t xItemSi
     return item_address;
 }
 
+static BaseType_t prvAcquireItemsNoSplit(Ringbuffer_t *pxRingbuffer, void **ppvItems, const size_t *pxItemSizes, UBaseType_t uxItemCount)
+{
+    //Save the acquire state so that a partial reservation can be rolled back
+    uint8_t *pucAcquire = pxRingbuffer->pucAcquire;
+    UBaseType_t uxFullFlag = pxRingbuffer->uxRingbufferFlags & rbBUFFER_FULL_FLAG;
+
+    for (UBaseType_t i = 0; i < uxItemCount; i++) {
+        if (prvCheckItemFitsDefault(pxRingbuffer, pxItemSizes[i]) == pdFALSE) {
+            //Headers written so far are in free space and are discarded by restoring pucAcquire
+            pxRingbuffer->pucAcquire = pucAcquire;
+            pxRingbuffer->uxRingbufferFlags = (pxRingbuffer->uxRingbufferFlags & ~rbBUFFER_FULL_FLAG) | uxFullFlag;
+            while (i > 0) {
+                ppvItems[--i] = NULL;
+            }
+            return pdFALSE;
+        }
+        ppvItems[i] = prvAcquireItemNoSplit(pxRingbuffer, pxItemSizes[i]);
+    }
+    return pdTRUE;
+}
+
 static void prvSendItemDoneNoSplit(Ringbuffer_t *pxRingbuffer, uint8_t* pucItem)
 {
     //Check arguments and buffer state
@@ -553,6 +592,19 @@ static void *prvGetItemDefault(Ringbuffer_t *pxRingbuffer,
     return (void *)pcReturn;
 }
 
+static UBaseType_t prvGetItemsNoSplit(Ringbuffer_t *pxRingbuffer, RingbufItem_t *pxItems, UBaseType_t uxMaxItems)
+{
+    UBaseType_t uxCount = 0;
+    BaseType_t xIsSplit;
+
+    while (uxCount < uxMaxItems && prvCheckItemAvail(pxRingbuffer) == pdTRUE) {
+        pxItems[uxCount].pvItem = prvGetItemDefault(pxRingbuffer, &xIsSplit, 0, &pxItems[uxCount].xItemSize);
+        configASSERT(xIsSplit == pdFALSE);  //Items are never split in no-split buffers
+        uxCount++;
+    }
+    return uxCount;
+}
+
 static void *prvGetItemByteBuf(Ringbuffer_t *pxRingbuffer,
                                BaseType_t *pxUnusedParam,
                                size_t xMaxSize,
@@ -745,7 +797,8 @@ static size_t prvGetCurMaxSizeByteBuf(Ringbuffer_t *pxRingbuffer)
 static BaseType_t prvSendAcquireGeneric(Ringbuffer_t *pxRingbuffer,
                                         const void *pvItem,
                                         void **ppvItem,
-                                        size_t xItemSize,
+                                        const size_t *pxItemSizes,
+                                        UBaseType_t uxItemCount,
                                         TickType_t xTicksToWait)
 {
     BaseType_t xReturn = pdFALSE;
@@ -756,14 +809,17 @@ static BaseType_t prvSendAcquireGeneric(Ringbuffer_t *pxRingbuffer,
 
     while (xExitLoop == pdFALSE) {
         portENTER_CRITICAL(&pxRingbuffer->mux);
-        if (pxRingbuffer->xCheckItemFits(pxRingbuffer, xItemSize) == pdTRUE) {
-            //xItemSize will fit. Copy or acquire the buffer immediately
-            if (ppvItem) {
-                //Acquire the buffer
-                *ppvItem = prvAcquireItemNoSplit(pxRingbuffer, xItemSize);
-            } else {
+        if (ppvItem) {
+            //Acquire the buffers. Either all of them fit and are acquired, or none is
+            xReturn = prvAcquireItemsNoSplit(pxRingbuffer, ppvItem, pxItemSizes, uxItemCount);
+        } else if (pxRingbuffer->xCheckItemFits(pxRingbuffer, pxItemSizes[0]) == pdTRUE) {
+            xReturn = pdTRUE;
+        }
+        if (xReturn == pdTRUE) {
+            //Item(s) fit. The buffers have already been acquired, or copy the item immediately
+            if (ppvItem == NULL) {
                 //Copy item into buffer
-                pxRingbuffer->vCopyItem(pxRingbuffer, pvItem, xItemSize);
+                pxRingbuffer->vCopyItem(pxRingbuffer, pvItem, pxItemSizes[0]);
                 if (pxRingbuffer->xQueueSet) {
                     //If ring buffer was added to a queue set, notify the queue set
                     xNotifyQueueSet = pdTRUE;
@@ -777,7 +833,6 @@ static BaseType_t prvSendAcquireGeneric(Ringbuffer_t *pxRingbuffer,
                     }
                 }
             }
-            xReturn = pdTRUE;
             xExitLoop = pdTRUE;
             goto loop_end;
         } else if (xTicksToWait == (TickType_t) 0) {
@@ -993,7 +1048,7 @@ BaseType_t xRingbufferSendAcquire(RingbufHandle_t xRingbuffer, void **ppvItem, s
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
 
-    return prvSendAcquireGeneric(pxRingbuffer, NULL, ppvItem, xItemSize, xTicksToWait);
+    return prvSendAcquireGeneric(pxRingbuffer, NULL, ppvItem, &xItemSize, 1, xTicksToWait);
 }
 
 BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem)
@@ -1028,6 +1083,75 @@ BaseType_t xRingbufferSendComplete(RingbufHandle_t xRingbuffer, void *pvItem)
     return pdTRUE;
 }
 
+BaseType_t xRingbufferSendAcquireMultiple(RingbufHandle_t xRingbuffer,
+                                          void **ppvItems,
+                                          const size_t *pxItemSizes,
+                                          UBaseType_t uxItemCount,
+                                          TickType_t xTicksToWait)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+
+    //Check arguments
+    configASSERT(pxRingbuffer);
+    configASSERT(ppvItems != NULL && pxItemSizes != NULL);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0); //Send acquire currently only supported in NoSplit buffers
+
+    size_t xTotalSize = 0;
+    for (UBaseType_t i = 0; i < uxItemCount; i++) {
+        ppvItems[i] = NULL;
+        if (pxItemSizes[i] > pxRingbuffer->xMaxItemSize) {
+            return pdFALSE;     //Data will never ever fit in the queue.
+        }
+        xTotalSize += rbALIGN_SIZE(pxItemSizes[i]) + rbHEADER_SIZE;
+    }
+    if (xTotalSize > pxRingbuffer->xSize) {
+        return pdFALSE;     //The items will never fit in the queue at the same time.
+    }
+    if (uxItemCount == 0) {
+        return pdTRUE;
+    }
+
+    return prvSendAcquireGeneric(pxRingbuffer, NULL, ppvItems, pxItemSizes, uxItemCount, xTicksToWait);
+}
+
+BaseType_t xRingbufferSendCompleteMultiple(RingbufHandle_t xRingbuffer, void * const *ppvItems, UBaseType_t uxItemCount)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    BaseType_t xNotifyQueueSet = pdFALSE;
+
+    //Check arguments
+    configASSERT(pxRingbuffer);
+    configASSERT(ppvItems != NULL || uxItemCount == 0);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0);
+
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    for (UBaseType_t i = 0; i < uxItemCount; i++) {
+        configASSERT(ppvItems[i] != NULL);
+        prvSendItemDoneNoSplit(pxRingbuffer, ppvItems[i]);
+    }
+    if (pxRingbuffer->xQueueSet) {
+        //If ring buffer was added to a queue set, notify the queue set
+        xNotifyQueueSet = pdTRUE;
+    } else {
+        //Unblock as many tasks waiting for data as there are new items
+        for (UBaseType_t i = 0; i < uxItemCount && listLIST_IS_EMPTY(&pxRingbuffer->xTasksWaitingToReceive) == pdFALSE; i++) {
+            if (xTaskRemoveFromEventList(&pxRingbuffer->xTasksWaitingToReceive) == pdTRUE) {
+                //The unblocked task will preempt us. Trigger a yield here.
+                portYIELD_WITHIN_API();
+            }
+        }
+    }
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+
+    if (xNotifyQueueSet == pdTRUE) {
+        //The queue set expects one notification per item
+        for (UBaseType_t i = 0; i < uxItemCount; i++) {
+            xQueueSend((QueueHandle_t)pxRingbuffer->xQueueSet, (QueueSetMemberHandle_t *)&pxRingbuffer, 0);
+        }
+    }
+    return pdTRUE;
+}
+
 BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer,
                            const void *pvItem,
                            size_t xItemSize,
@@ -1045,7 +1169,7 @@ BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer,
         return pdTRUE;      //Sending 0 bytes to byte buffer has no effect
     }
 
-    return prvSendAcquireGeneric(pxRingbuffer, pvItem, NULL, xItemSize, xTicksToWait);
+    return prvSendAcquireGeneric(pxRingbuffer, pvItem, NULL, &xItemSize, 1, xTicksToWait);
 }
 
 BaseType_t xRingbufferSendFromISR(RingbufHandle_t xRingbuffer,
@@ -1202,6 +1326,45 @@ void *xRingbufferReceiveUpToFromISR(RingbufHandle_t xRingbuffer, size_t *pxItemS
     }
 }
 
+UBaseType_t xRingbufferReceiveMultiple(RingbufHandle_t xRingbuffer, RingbufItem_t *pxItems, UBaseType_t uxMaxItems, TickType_t xTicksToWait)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+
+    //Check arguments
+    configASSERT(pxRingbuffer && pxItems);
+    configASSERT(uxMaxItems > 0);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0); //Only supported in NoSplit buffers
+
+    //Block until the first item is available
+    if (prvReceiveGeneric(pxRingbuffer, &pxItems[0].pvItem, NULL, &pxItems[0].xItemSize, NULL, 0, xTicksToWait) == pdFALSE) {
+        return 0;
+    }
+
+    //Retrieve all other available items in one go
+    UBaseType_t uxCount = 1;
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    uxCount += prvGetItemsNoSplit(pxRingbuffer, &pxItems[1], uxMaxItems - 1);
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+
+    return uxCount;
+}
+
+UBaseType_t xRingbufferReceiveMultipleFromISR(RingbufHandle_t xRingbuffer, RingbufItem_t *pxItems, UBaseType_t uxMaxItems)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    UBaseType_t uxCount;
+
+    //Check arguments
+    configASSERT(pxRingbuffer && pxItems);
+    configASSERT((pxRingbuffer->uxRingbufferFlags & (rbBYTE_BUFFER_FLAG | rbALLOW_SPLIT_FLAG)) == 0); //Only supported in NoSplit buffers
+
+    portENTER_CRITICAL_ISR(&pxRingbuffer->mux);
+    uxCount = prvGetItemsNoSplit(pxRingbuffer, pxItems, uxMaxItems);
+    portEXIT_CRITICAL_ISR(&pxRingbuffer->mux);
+
+    return uxCount;
+}
+
 void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
@@ -1220,6 +1383,27 @@ void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem)
     portEXIT_CRITICAL(&pxRingbuffer->mux);
 }
 
+void vRingbufferReturnItems(RingbufHandle_t xRingbuffer, const RingbufItem_t *pxItems, UBaseType_t uxItemCount)
+{
+    Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
+    configASSERT(pxRingbuffer);
+    configASSERT(pxItems != NULL || uxItemCount == 0);
+
+    portENTER_CRITICAL(&pxRingbuffer->mux);
+    for (UBaseType_t i = 0; i < uxItemCount; i++) {
+        configASSERT(pxItems[i].pvItem != NULL);
+        pxRingbuffer->vReturnItem(pxRingbuffer, (uint8_t *)pxItems[i].pvItem);
+    }
+    //Unblock as many tasks waiting for space to send as there are freed items
+    for (UBaseType_t i = 0; i < uxItemCount && listLIST_IS_EMPTY(&pxRingbuffer->xTasksWaitingToSend) == pdFALSE; i++) {
+        if (xTaskRemoveFromEventList(&pxRingbuffer->xTasksWaitingToSend) == pdTRUE) {
+            //The unblocked task will preempt us. Trigger a yield here.
+            portYIELD_WITHIN_API();
+        }
+    }
+    portEXIT_CRITICAL(&pxRingbuffer->mux);
+}
+
 void vRingbufferReturnItemFromISR(RingbufHandle_t xRingbuffer, void *pvItem, BaseType_t *pxHigherPriorityTaskWoken)
 {
     Ringbuffer_t *pxRingbuffer = (Ringbuffer_t *)xRingbuffer;
@@ -7,6 +7,7 @@
 #include "sdkconfig.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -1096,6 +1097,66 @@ TEST_CASE("Test ringbuffer 0 item size", "[esp_ringbuf]")
     vRingbufferDelete(byte_rb);
 }
 
+/* ------------------ Test ring buffer batched acquire/receive -----------------
+ * The following test case tests acquiring, sending, receiving and returning
+ * several items of a no-split buffer in one call. Specifically the following
+ * APIs:
+ *
+ * - xRingbufferSendAcquireMultiple()
+ * - xRingbufferSendCompleteMultiple()
+ * - xRingbufferReceiveMultiple()
+ * - xRingbufferReceiveMultipleFromISR()
+ * - vRingbufferReturnItems()
+ */
+
+#define BATCH_ITEMS     3
+
+TEST_CASE("Test ringbuffer batched acquire and receive", "[esp_ringbuf]")
+{
+    RingbufHandle_t no_split_rb = xRingbufferCreate(BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    TEST_ASSERT_MESSAGE(no_split_rb, "Failed to create ring buffer");
+    const size_t item_sizes[BATCH_ITEMS] = { SMALL_ITEM_SIZE, MEDIUM_ITEM_SIZE, LARGE_ITEM_SIZE };
+    void *items[BATCH_ITEMS];
+    RingbufItem_t received[BATCH_ITEMS + 1];
+
+    //Test that a batch which does not fit is not acquired at all, even if its first item fits
+    const size_t max_item_size = xRingbufferGetMaxItemSize(no_split_rb);
+    const size_t partial_sizes[2] = { SMALL_ITEM_SIZE, max_item_size };
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendAcquire(no_split_rb, &items[0], max_item_size, 0));
+    TEST_ASSERT_EQUAL(pdFALSE, xRingbufferSendAcquireMultiple(no_split_rb, &items[1], partial_sizes, 2, 0));
+    TEST_ASSERT_EQUAL(NULL, items[1]);
+    TEST_ASSERT_EQUAL(NULL, items[2]);
+    //The remaining free space must be unchanged by the failed attempt
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendAcquire(no_split_rb, &items[1], max_item_size, 0));
+    TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendCompleteMultiple(no_split_rb, items, 2));
+    TEST_ASSERT_EQUAL(2, xRingbufferReceiveMultiple(no_split_rb, received, BATCH_ITEMS + 1, 0));
+    vRingbufferReturnItems(no_split_rb, received, 2);
+
+    //Iterate enough times so that the batches wrap around the end of the buffer
+    for (int i = 0; i < BUFFER_SIZE / SMALL_ITEM_SIZE; i++) {
+        TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendAcquireMultiple(no_split_rb, items, item_sizes, BATCH_ITEMS, TIMEOUT_TICKS));
+        for (int j = 0; j < BATCH_ITEMS; j++) {
+            TEST_ASSERT_NOT_EQUAL(NULL, items[j]);
+            memcpy(items[j], large_item, item_sizes[j]);
+        }
+        //Acquired items must not be received before they are sent
+        TEST_ASSERT_EQUAL(0, xRingbufferReceiveMultiple(no_split_rb, received, BATCH_ITEMS + 1, 0));
+        TEST_ASSERT_EQUAL(pdTRUE, xRingbufferSendCompleteMultiple(no_split_rb, items, BATCH_ITEMS));
+
+        UBaseType_t count = (i % 2) ? xRingbufferReceiveMultipleFromISR(no_split_rb, received, BATCH_ITEMS + 1) :
+                            xRingbufferReceiveMultiple(no_split_rb, received, BATCH_ITEMS + 1, TIMEOUT_TICKS);
+        TEST_ASSERT_EQUAL(BATCH_ITEMS, count);
+        for (int j = 0; j < BATCH_ITEMS; j++) {
+            TEST_ASSERT_EQUAL(item_sizes[j], received[j].xItemSize);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(large_item, received[j].pvItem, item_sizes[j]);
+        }
+        vRingbufferReturnItems(no_split_rb, received, count);
+    }
+
+    //Cleanup
+    vRingbufferDelete(no_split_rb);
+}
+
 /* --------------------- Test ring buffer create with caps ---------------------
  * The following test case tests ring buffer creation with caps. Specifically
  * the following APIs:
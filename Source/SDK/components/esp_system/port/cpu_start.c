@@ -109,6 +109,7 @@
 #endif
 
 #include "bootloader_mem.h"
+#include "esp_boot_trace.h"
 
 #if CONFIG_APP_BUILD_TYPE_RAM
 #include "esp_rom_spiflash.h"
@@ -594,6 +595,8 @@ void IRAM_ATTR call_start_cpu0(void)
 
 #endif // !CONFIG_APP_BUILD_TYPE_PURE_RAM_APP
 
+    esp_boot_trace_mark(ESP_BOOT_TRACE_APP_START);
+
 #if CONFIG_ESP_SYSTEM_SINGLE_CORE_MODE
     ESP_EARLY_LOGI(TAG, "Unicore app");
 #else
@@ -707,6 +710,7 @@ void IRAM_ATTR call_start_cpu0(void)
     // Now that the clocks have been set-up, set the startup time from RTC
     // and default RTC-backed system time provider.
     g_startup_time = esp_rtc_get_time_us();
+    esp_boot_trace_mark(ESP_BOOT_TRACE_APP_CLOCK);
 
     // Clear interrupt matrix for PRO CPU core
     core_intr_matrix_clear();
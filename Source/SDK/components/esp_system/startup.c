@@ -19,6 +19,7 @@
 #include "esp_cpu.h"
 
 #include "esp_private/startup_internal.h"
+#include "esp_boot_trace.h"
 
 // Ensure that system configuration matches the underlying number of cores.
 // This should enable us to avoid checking for both everytime.
@@ -196,13 +197,16 @@ static void start_cpu0_default(void)
 {
     // Initialize core components and services.
     do_core_init();
+    esp_boot_trace_mark(ESP_BOOT_TRACE_CORE_INIT);
 
     // Execute constructors.
     do_global_ctors();
+    esp_boot_trace_mark(ESP_BOOT_TRACE_GLOBAL_CTORS);
 
     // Execute init functions of other components; blocks
     // until all cores finish (when !CONFIG_ESP_SYSTEM_SINGLE_CORE_MODE).
     do_secondary_init();
+    esp_boot_trace_mark(ESP_BOOT_TRACE_SECONDARY_INIT);
 
 #if SOC_CPU_CORES_NUM > 1 && !CONFIG_ESP_SYSTEM_SINGLE_CORE_MODE
     s_system_full_inited = true;
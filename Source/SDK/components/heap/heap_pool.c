@@ -0,0 +1,201 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "esp_heap_caps.h"
+#include "esp_heap_pool.h"
+
+/*
+ The free list is a Treiber stack. The head packs the index + 1 of the first
+ free block (0 for an empty list) in the low 16 bits and a tag in the high 16
+ bits. The tag is incremented on every update so that a pop which read a stale
+ next index fails its compare-and-swap (ABA problem). Each free block stores the
+ index + 1 of the next free block in its first word.
+*/
+#define POOL_HEAD_INDEX_MASK    0xFFFFu
+#define POOL_HEAD_TAG_SHIFT     16
+
+#define POOL_HEAD(index, tag)   (((uint32_t)(tag) << POOL_HEAD_TAG_SHIFT) | (uint32_t)(index))
+#define POOL_HEAD_INDEX(head)   ((head) & POOL_HEAD_INDEX_MASK)
+#define POOL_HEAD_TAG(head)     ((head) >> POOL_HEAD_TAG_SHIFT)
+
+struct heap_pool {
+    const char *name;
+    uint8_t *storage;
+    size_t block_size;
+    size_t block_count;
+    uint32_t caps;
+    _Atomic uint32_t head;
+    atomic_size_t in_use;
+    atomic_size_t high_water;
+    atomic_size_t failures;
+    atomic_size_t fallbacks;
+};
+
+static inline uint32_t *pool_block_link(heap_pool_handle_t pool, uint32_t index)
+{
+    return (uint32_t *)(pool->storage + (index - 1) * pool->block_size);
+}
+
+static inline uint32_t pool_block_index(heap_pool_handle_t pool, const void *ptr)
+{
+    size_t offset = (const uint8_t *)ptr - pool->storage;
+    assert(offset % pool->block_size == 0);
+    return offset / pool->block_size + 1;
+}
+
+static void pool_update_high_water(heap_pool_handle_t pool, size_t in_use)
+{
+    size_t high_water = atomic_load_explicit(&pool->high_water, memory_order_relaxed);
+    while (in_use > high_water &&
+           !atomic_compare_exchange_weak_explicit(&pool->high_water, &high_water, in_use,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+esp_err_t heap_pool_create(const heap_pool_config_t *config, heap_pool_handle_t *ret_pool)
+{
+    if (config == NULL || ret_pool == NULL || config->block_size == 0 ||
+        config->block_count == 0 || config->block_count > HEAP_POOL_MAX_BLOCKS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Blocks hold the free list link and must be usable for any pointer-sized data
+    size_t block_size = (config->block_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    if (block_size > SIZE_MAX / config->block_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The control structure is updated with atomics, keep it in internal RAM
+    heap_pool_handle_t pool = heap_caps_calloc(1, sizeof(struct heap_pool), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pool == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    pool->storage = heap_caps_malloc(block_size * config->block_count, config->caps);
+    if (pool->storage == NULL) {
+        heap_caps_free(pool);
+        return ESP_ERR_NO_MEM;
+    }
+
+    pool->name = config->name;
+    pool->block_size = block_size;
+    pool->block_count = config->block_count;
+    pool->caps = config->caps;
+
+    for (uint32_t index = 1; index <= pool->block_count; index++) {
+        *pool_block_link(pool, index) = (index < pool->block_count) ? index + 1 : 0;
+    }
+    atomic_init(&pool->head, POOL_HEAD(1, 0));
+    atomic_init(&pool->in_use, 0);
+    atomic_init(&pool->high_water, 0);
+    atomic_init(&pool->failures, 0);
+    atomic_init(&pool->fallbacks, 0);
+
+    *ret_pool = pool;
+    return ESP_OK;
+}
+
+void heap_pool_delete(heap_pool_handle_t pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    assert(atomic_load(&pool->in_use) == 0);
+    heap_caps_free(pool->storage);
+    heap_caps_free(pool);
+}
+
+void *heap_pool_alloc(heap_pool_handle_t pool)
+{
+    assert(pool != NULL);
+
+    uint32_t head = atomic_load_explicit(&pool->head, memory_order_acquire);
+    uint32_t index;
+    do {
+        index = POOL_HEAD_INDEX(head);
+        if (index == 0) {
+            atomic_fetch_add_explicit(&pool->failures, 1, memory_order_relaxed);
+            return NULL;
+        }
+        /* The block may be popped and overwritten by another task before the
+           compare-and-swap, the tag change makes the swap fail in that case. */
+        uint32_t next = *(volatile uint32_t *)pool_block_link(pool, index);
+        if (atomic_compare_exchange_weak_explicit(&pool->head, &head, POOL_HEAD(next, POOL_HEAD_TAG(head) + 1),
+                                                  memory_order_acquire, memory_order_acquire)) {
+            break;
+        }
+    } while (true);
+
+    size_t in_use = atomic_fetch_add_explicit(&pool->in_use, 1, memory_order_relaxed) + 1;
+    pool_update_high_water(pool, in_use);
+
+    return pool_block_link(pool, index);
+}
+
+void *heap_pool_malloc(heap_pool_handle_t pool, size_t size)
+{
+    assert(pool != NULL);
+
+    if (size <= pool->block_size) {
+        return heap_pool_alloc(pool);
+    }
+
+    atomic_fetch_add_explicit(&pool->fallbacks, 1, memory_order_relaxed);
+    return heap_caps_malloc(size, pool->caps);
+}
+
+void heap_pool_free(heap_pool_handle_t pool, void *ptr)
+{
+    assert(pool != NULL);
+
+    if (ptr == NULL) {
+        return;
+    }
+    if (!heap_pool_owns(pool, ptr)) {
+        heap_caps_free(ptr);
+        return;
+    }
+
+    // Counted out before the push so in_use never exceeds the blocks actually taken
+    atomic_fetch_sub_explicit(&pool->in_use, 1, memory_order_relaxed);
+
+    uint32_t index = pool_block_index(pool, ptr);
+    uint32_t head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+    do {
+        *pool_block_link(pool, index) = POOL_HEAD_INDEX(head);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->head, &head, POOL_HEAD(index, POOL_HEAD_TAG(head) + 1),
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+bool heap_pool_owns(heap_pool_handle_t pool, const void *ptr)
+{
+    if (pool == NULL || ptr == NULL) {
+        return false;
+    }
+    const uint8_t *p = ptr;
+    return p >= pool->storage && p < pool->storage + pool->block_size * pool->block_count;
+}
+
+esp_err_t heap_pool_get_info(heap_pool_handle_t pool, heap_pool_info_t *info)
+{
+    if (pool == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t in_use = atomic_load_explicit(&pool->in_use, memory_order_relaxed);
+
+    info->block_size = pool->block_size;
+    info->total_blocks = pool->block_count;
+    info->free_blocks = (in_use < pool->block_count) ? pool->block_count - in_use : 0;
+    info->high_water = atomic_load_explicit(&pool->high_water, memory_order_relaxed);
+    info->failures = atomic_load_explicit(&pool->failures, memory_order_relaxed);
+    info->fallbacks = atomic_load_explicit(&pool->fallbacks, memory_order_relaxed);
+
+    return ESP_OK;
+}
@@ -0,0 +1,338 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <sdkconfig.h>
+#include <inttypes.h>
+
+#define HEAP_TRACE_SRCFILE /* don't warn on inclusion here */
+#include "esp_heap_trace.h"
+#undef HEAP_TRACE_SRCFILE
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define STACK_DEPTH CONFIG_HEAP_TRACING_STACK_DEPTH
+
+#if CONFIG_HEAP_TRACING_SAMPLING
+
+#define CALLSITES_SIZE CONFIG_HEAP_TRACE_SAMPLING_CALLSITES
+
+static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool tracing;
+static heap_trace_mode_t mode;
+
+/* Average number of allocations per sample, 0 until initialised */
+static uint32_t sample_period;
+
+/* Allocations left until the next sample, and the state of the
+   generator used to randomize the interval between samples */
+static uint32_t countdown;
+static uint32_t rand_state = 0x2545F491;
+
+/* Open addressing table of callsites, an entry with count 0 is empty */
+static heap_trace_callsite_t callsites[CALLSITES_SIZE];
+static size_t callsite_count;
+static size_t dropped_samples;
+
+/* Every allocation and free made while tracing, sampled or not */
+static size_t total_allocations;
+static size_t total_frees;
+
+// Forward Defines
+static bool sample_allocation(void *p);
+static bool count_free(void *p);
+
+#define TRACE_SHOULD_RECORD_ALLOCATION(p, size)  sample_allocation(p)
+#define TRACE_SHOULD_RECORD_FREE(p)              count_free(p)
+
+/* xorshift32, only used to spread the samples, not for anything secure */
+static HEAP_IRAM_ATTR uint32_t next_sample_gap(void)
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    // uniform in [1, 2 * period - 1], so the mean gap is the period
+    return 1 + rand_state % (2 * sample_period - 1);
+}
+
+static HEAP_IRAM_ATTR size_t callsite_hash(void * const *callers)
+{
+    static const uint32_t fnv_prime = 16777619UL;
+    uint32_t hash = 2166136261UL;
+    for (int i = 0; i < STACK_DEPTH; i++) {
+        hash = (hash ^ (uint32_t)(uintptr_t)callers[i]) * fnv_prime;
+    }
+    return hash % (uint32_t)CALLSITES_SIZE;
+}
+
+esp_err_t heap_trace_init_sampling(uint32_t sample_period_param)
+{
+    if (tracing) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (sample_period_param == 0 || sample_period_param > UINT32_MAX / 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sample_period = sample_period_param;
+
+    return ESP_OK;
+}
+
+static esp_err_t set_tracing(bool enable)
+{
+    if (tracing == enable) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    tracing = enable;
+    return ESP_OK;
+}
+
+esp_err_t heap_trace_start(heap_trace_mode_t mode_param)
+{
+    if (sample_period == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&trace_mux);
+
+    set_tracing(false);
+    mode = mode_param;
+
+    memset(callsites, 0, sizeof(callsites));
+    callsite_count = 0;
+    dropped_samples = 0;
+
+    total_allocations = 0;
+    total_frees = 0;
+
+    countdown = next_sample_gap();
+
+    const esp_err_t ret_val = set_tracing(true);
+
+    portEXIT_CRITICAL(&trace_mux);
+    return ret_val;
+}
+
+esp_err_t heap_trace_stop(void)
+{
+    portENTER_CRITICAL(&trace_mux);
+    const esp_err_t ret_val = set_tracing(false);
+    portEXIT_CRITICAL(&trace_mux);
+    return ret_val;
+}
+
+esp_err_t heap_trace_resume(void)
+{
+    if (sample_period == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&trace_mux);
+    const esp_err_t ret_val = set_tracing(true);
+    portEXIT_CRITICAL(&trace_mux);
+    return ret_val;
+}
+
+size_t heap_trace_get_count(void)
+{
+    return callsite_count;
+}
+
+esp_err_t heap_trace_get(size_t index, heap_trace_record_t *record)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t heap_trace_get_callsite(size_t index, heap_trace_callsite_t *callsite)
+{
+    if (callsite == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t result = ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&trace_mux);
+
+    for (size_t i = 0; i < CALLSITES_SIZE; i++) {
+        if (callsites[i].count == 0) {
+            continue;
+        }
+        if (index-- == 0) {
+            memcpy(callsite, &callsites[i], sizeof(heap_trace_callsite_t));
+            result = ESP_OK;
+            break;
+        }
+    }
+
+    portEXIT_CRITICAL(&trace_mux);
+    return result;
+}
+
+esp_err_t heap_trace_summary(heap_trace_summary_t *summary)
+{
+    if (summary == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&trace_mux);
+    summary->mode = mode;
+    summary->total_allocations = total_allocations;
+    summary->total_frees = total_frees;
+    summary->count = callsite_count;
+    summary->capacity = CALLSITES_SIZE;
+    summary->high_water_mark = callsite_count;
+    summary->has_overflowed = dropped_samples != 0;
+    portEXIT_CRITICAL(&trace_mux);
+
+    return ESP_OK;
+}
+
+void heap_trace_dump(void)
+{
+    portENTER_CRITICAL(&trace_mux);
+
+    esp_rom_printf("====== Heap Sampling Profile: 1 in %"PRIu32" allocations ======\n", sample_period);
+    esp_rom_printf("  est. KiB  est. allocs  caller\n");
+
+    /* Callsites are printed by decreasing size, the bitmap marks the ones
+       already printed so the table does not have to be sorted in place */
+    uint32_t printed[(CALLSITES_SIZE + 31) / 32] = { 0 };
+
+    for (size_t n = 0; n < callsite_count; n++) {
+        const heap_trace_callsite_t *c_max = NULL;
+        size_t i_max = 0;
+
+        for (size_t i = 0; i < CALLSITES_SIZE; i++) {
+            const heap_trace_callsite_t *c_cur = &callsites[i];
+            if (c_cur->count == 0 || (printed[i / 32] & (1u << (i % 32)))) {
+                continue;
+            }
+            if (c_max == NULL || c_cur->bytes > c_max->bytes) {
+                c_max = c_cur;
+                i_max = i;
+            }
+        }
+        if (c_max == NULL) {
+            break;
+        }
+        printed[i_max / 32] |= 1u << (i_max % 32);
+
+        esp_rom_printf("%10"PRIu32"  %11"PRIu32"  ",
+                       (uint32_t)(c_max->bytes * sample_period / 1024), c_max->count * sample_period);
+        for (int j = 0; j < STACK_DEPTH && c_max->callers[j] != 0; j++) {
+            esp_rom_printf("%p%s", c_max->callers[j], (j < STACK_DEPTH - 1) ? ":" : "");
+        }
+        esp_rom_printf("\n");
+    }
+
+    esp_rom_printf("====== Heap Sampling Summary ======\n");
+    esp_rom_printf("total allocations: %"PRIu32"\n", total_allocations);
+    esp_rom_printf("total frees: %"PRIu32"\n", total_frees);
+    esp_rom_printf("callsites: %"PRIu32" (%"PRIu32" capacity)\n", callsite_count, (size_t)CALLSITES_SIZE);
+    if (dropped_samples != 0) {
+        esp_rom_printf("(NB: %"PRIu32" samples did not fit in the callsite table, increase CONFIG_HEAP_TRACE_SAMPLING_CALLSITES.)\n",
+                       dropped_samples);
+    }
+    esp_rom_printf("===================================\n");
+
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+void heap_trace_dump_caps(__attribute__((unused)) const uint32_t caps)
+{
+    // Sampled allocations are aggregated by callsite, not by address
+    heap_trace_dump();
+}
+
+/* Count the allocation, returns true if it is sampled */
+static HEAP_IRAM_ATTR bool sample_allocation(void *p)
+{
+    if (!tracing || p == NULL) {
+        return false;
+    }
+
+    bool sampled = false;
+
+    portENTER_CRITICAL(&trace_mux);
+    if (tracing) {
+        total_allocations++;
+        if (--countdown == 0) {
+            countdown = next_sample_gap();
+            sampled = true;
+        }
+    }
+    portEXIT_CRITICAL(&trace_mux);
+
+    return sampled;
+}
+
+/* Count the free, frees are never recorded */
+static HEAP_IRAM_ATTR bool count_free(void *p)
+{
+    if (!tracing || p == NULL) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&trace_mux);
+    if (tracing) {
+        total_frees++;
+    }
+    portEXIT_CRITICAL(&trace_mux);
+
+    return false;
+}
+
+/* Add a sampled allocation to the counters of its callsite */
+static HEAP_IRAM_ATTR void record_allocation(const heap_trace_record_t *r_allocation)
+{
+    size_t idx = callsite_hash(r_allocation->alloced_by);
+
+    portENTER_CRITICAL(&trace_mux);
+
+    if (tracing) {
+        heap_trace_callsite_t *c_found = NULL;
+
+        // linear probing, stops at the callsite or at the first empty entry
+        for (size_t probe = 0; probe < CALLSITES_SIZE; probe++) {
+            heap_trace_callsite_t *c_cur = &callsites[idx];
+            if (c_cur->count == 0) {
+                memcpy(c_cur->callers, r_allocation->alloced_by, sizeof(void *) * STACK_DEPTH);
+                callsite_count++;
+                c_found = c_cur;
+                break;
+            }
+            if (memcmp(c_cur->callers, r_allocation->alloced_by, sizeof(void *) * STACK_DEPTH) == 0) {
+                c_found = c_cur;
+                break;
+            }
+            idx = (idx + 1) % CALLSITES_SIZE;
+        }
+
+        if (c_found != NULL) {
+            c_found->count++;
+            c_found->bytes += r_allocation->size;
+        } else {
+            dropped_samples++;
+        }
+    }
+
+    portEXIT_CRITICAL(&trace_mux);
+}
+
+/* Frees are filtered out by count_free() */
+static HEAP_IRAM_ATTR void record_free(void *p, void **callers)
+{
+}
+
+#include "heap_trace.inc"
+
+ESP_STATIC_ASSERT(STACK_DEPTH > 0, "The sampling profiler needs CONFIG_HEAP_TRACING_STACK_DEPTH > 0");
+
+#endif // CONFIG_HEAP_TRACING_SAMPLING
@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of blocks in a pool
+ */
+#define HEAP_POOL_MAX_BLOCKS    (UINT16_MAX - 1)
+
+/**
+ * @brief Opaque handle to a fixed-block memory pool
+ */
+typedef struct heap_pool *heap_pool_handle_t;
+
+/**
+ * @brief Configuration of a fixed-block memory pool
+ */
+typedef struct {
+    const char *name;       ///< Name of the pool, for diagnostics. Not copied, must outlive the pool.
+    size_t block_size;      ///< Size of each block in bytes, rounded up to pointer alignment
+    size_t block_count;     ///< Number of blocks, at most HEAP_POOL_MAX_BLOCKS
+    uint32_t caps;          ///< Bitwise OR of MALLOC_CAP_* flags for the pool storage
+} heap_pool_config_t;
+
+/**
+ * @brief Statistics of a fixed-block memory pool
+ */
+typedef struct {
+    size_t block_size;      ///< Size of each block in bytes, after rounding
+    size_t total_blocks;    ///< Number of blocks in the pool
+    size_t free_blocks;     ///< Number of blocks currently free
+    size_t high_water;      ///< Maximum number of blocks ever in use at the same time
+    size_t failures;        ///< Number of allocations that failed because the pool was empty
+    size_t fallbacks;       ///< Number of heap_pool_malloc() requests too large for a block, served by heap_caps_malloc()
+} heap_pool_info_t;
+
+/**
+ * @brief Create a fixed-block memory pool
+ *
+ * The storage for all blocks is allocated once with heap_caps_malloc() and the
+ * given capabilities, after that allocating and freeing a block is a constant
+ * time operation that never touches the heap. Blocks are kept on a lock-free
+ * free list, so the pool can be used from several tasks without a mutex.
+ *
+ * @param config Pool configuration
+ * @param[out] ret_pool Handle of the created pool
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if the configuration is invalid
+ *      - ESP_ERR_NO_MEM if the pool storage could not be allocated
+ */
+esp_err_t heap_pool_create(const heap_pool_config_t *config, heap_pool_handle_t *ret_pool);
+
+/**
+ * @brief Delete a fixed-block memory pool and release its storage
+ *
+ * @note All blocks must have been returned to the pool.
+ *
+ * @param pool Pool to delete. Can be NULL.
+ */
+void heap_pool_delete(heap_pool_handle_t pool);
+
+/**
+ * @brief Allocate a block from a pool
+ *
+ * @param pool Pool to allocate from
+ *
+ * @return A pointer to a block of the pool block size, NULL if the pool is empty
+ */
+void *heap_pool_alloc(heap_pool_handle_t pool);
+
+/**
+ * @brief Allocate memory from a pool, with libc malloc() semantics
+ *
+ * Requests that fit in a block are served by the pool. Larger requests are
+ * served by heap_caps_malloc() with the pool capabilities and counted as
+ * fallbacks, which makes this function and heap_pool_free() suitable for
+ * allocator hooks of libraries that also make occasional large allocations,
+ * e.g. cJSON_InitHooks().
+ *
+ * @param pool Pool to allocate from
+ * @param size Size, in bytes, of the amount of memory to allocate
+ *
+ * @return A pointer to the memory allocated on success, NULL on failure
+ */
+void *heap_pool_malloc(heap_pool_handle_t pool, size_t size);
+
+/**
+ * @brief Free memory allocated with heap_pool_alloc() or heap_pool_malloc()
+ *
+ * Pointers that do not belong to the pool are passed to heap_caps_free().
+ *
+ * @param pool Pool the memory was allocated from
+ * @param ptr Pointer to the memory to free. Can be NULL.
+ */
+void heap_pool_free(heap_pool_handle_t pool, void *ptr);
+
+/**
+ * @brief Check if a pointer is a block of a pool
+ *
+ * @param pool Pool to check
+ * @param ptr Pointer to check
+ *
+ * @return true if ptr points into the pool storage
+ */
+bool heap_pool_owns(heap_pool_handle_t pool, const void *ptr);
+
+/**
+ * @brief Get statistics of a pool
+ *
+ * @param pool Pool to query
+ * @param[out] info Statistics of the pool
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if an argument is NULL
+ */
+esp_err_t heap_pool_get_info(heap_pool_handle_t pool, heap_pool_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
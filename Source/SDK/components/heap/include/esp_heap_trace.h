@@ -61,6 +61,15 @@ typedef struct {
 #endif
 } heap_trace_summary_t;
 
+/**
+ * @brief Allocation callsite aggregated by the sampling profiler.
+ */
+typedef struct {
+    void *callers[CONFIG_HEAP_TRACING_STACK_DEPTH]; ///< Call stack identifying the callsite
+    uint32_t count;                                 ///< Number of sampled allocations made from the callsite
+    uint64_t bytes;                                 ///< Total size of the sampled allocations
+} heap_trace_callsite_t;
+
 /**
  * @brief Initialise heap tracing in standalone mode.
  *
@@ -89,6 +98,43 @@ esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t
  */
 esp_err_t heap_trace_init_tohost(void);
 
+/**
+ * @brief Initialise heap tracing in sampling mode.
+ *
+ * This function must be called before any other heap tracing functions.
+ *
+ * In sampling mode, one allocation in sample_period on average is sampled, at a
+ * randomized interval so that periodic allocation patterns are not aliased. The
+ * size of each sampled allocation is added to the counters of its callsite, identified
+ * by its call stack, in a table of CONFIG_HEAP_TRACE_SAMPLING_CALLSITES entries.
+ * Frees are only counted. Unsampled allocations skip the call stack walk, so
+ * the profiler can be left running for hours to find the sources of steady heap churn.
+ *
+ * @param sample_period Average number of allocations per sample, 1 samples every allocation.
+ * @return
+ *  - ESP_ERR_INVALID_STATE Heap tracing is currently in progress.
+ *  - ESP_ERR_INVALID_ARG sample_period is zero or larger than UINT32_MAX / 2.
+ *  - ESP_OK Heap tracing initialised successfully.
+ */
+esp_err_t heap_trace_init_sampling(uint32_t sample_period);
+
+/**
+ * @brief Return a callsite from the sampling profiler table
+ *
+ * The number of callsites is returned by heap_trace_get_count(). Multiplying the
+ * counters by the sample period estimates the totals of the callsite.
+ *
+ * @note It is safe to call this function while heap tracing is running.
+ *
+ * @param index Index (zero-based) of the callsite to return.
+ * @param[out] callsite Where the callsite will be copied.
+ * @return
+ * - ESP_ERR_INVALID_STATE callsite is NULL.
+ * - ESP_ERR_INVALID_ARG Index is out of bounds for the current callsite count.
+ * - ESP_OK Callsite returned successfully.
+ */
+esp_err_t heap_trace_get_callsite(size_t index, heap_trace_callsite_t *callsite);
+
 /**
  * @brief Start heap tracing. All heap allocations & frees will be traced, until heap_trace_stop() is called.
  *
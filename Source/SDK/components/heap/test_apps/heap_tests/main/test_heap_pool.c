@@ -0,0 +1,198 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/*
+ Tests for the fixed-block pool allocator.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unity.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_pool.h"
+
+#define POOL_BLOCK_SIZE     30
+#define POOL_BLOCK_COUNT    16
+
+static heap_pool_handle_t create_test_pool(void)
+{
+    heap_pool_config_t config = {
+        .name = "test",
+        .block_size = POOL_BLOCK_SIZE,
+        .block_count = POOL_BLOCK_COUNT,
+        .caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT,
+    };
+    heap_pool_handle_t pool = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, heap_pool_create(&config, &pool));
+    TEST_ASSERT_NOT_NULL(pool);
+    return pool;
+}
+
+TEST_CASE("heap pool rejects invalid configurations", "[heap][pool]")
+{
+    heap_pool_handle_t pool = NULL;
+    heap_pool_config_t config = {
+        .block_size = 0,
+        .block_count = 1,
+        .caps = MALLOC_CAP_DEFAULT,
+    };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_pool_create(&config, &pool));
+
+    config.block_size = 4;
+    config.block_count = HEAP_POOL_MAX_BLOCKS + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_pool_create(&config, &pool));
+
+    config.block_count = 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_pool_create(NULL, &pool));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_pool_create(&config, NULL));
+    TEST_ASSERT_NULL(pool);
+}
+
+TEST_CASE("heap pool allocates every block once and tracks statistics", "[heap][pool]")
+{
+    heap_pool_handle_t pool = create_test_pool();
+    void *blocks[POOL_BLOCK_COUNT];
+    heap_pool_info_t info;
+
+    TEST_ASSERT_EQUAL(ESP_OK, heap_pool_get_info(pool, &info));
+    TEST_ASSERT_GREATER_OR_EQUAL(POOL_BLOCK_SIZE, info.block_size);
+    TEST_ASSERT_EQUAL(0, info.block_size % sizeof(void *));
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, info.total_blocks);
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, info.free_blocks);
+
+    for (int i = 0; i < POOL_BLOCK_COUNT; i++) {
+        blocks[i] = heap_pool_alloc(pool);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT_TRUE(heap_pool_owns(pool, blocks[i]));
+        memset(blocks[i], i, POOL_BLOCK_SIZE);
+        for (int j = 0; j < i; j++) {
+            TEST_ASSERT_NOT_EQUAL(blocks[j], blocks[i]);
+        }
+    }
+    TEST_ASSERT_NULL(heap_pool_alloc(pool));
+
+    for (int i = 0; i < POOL_BLOCK_COUNT; i++) {
+        TEST_ASSERT_EACH_EQUAL_HEX8(i, blocks[i], POOL_BLOCK_SIZE);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_OK, heap_pool_get_info(pool, &info));
+    TEST_ASSERT_EQUAL(0, info.free_blocks);
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, info.high_water);
+    TEST_ASSERT_EQUAL(1, info.failures);
+
+    for (int i = 0; i < POOL_BLOCK_COUNT; i++) {
+        heap_pool_free(pool, blocks[i]);
+    }
+    heap_pool_free(pool, NULL);
+
+    TEST_ASSERT_EQUAL(ESP_OK, heap_pool_get_info(pool, &info));
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, info.free_blocks);
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, info.high_water);
+
+    // the last block freed is the first one handed out again
+    TEST_ASSERT_EQUAL_PTR(blocks[POOL_BLOCK_COUNT - 1], heap_pool_alloc(pool));
+    heap_pool_free(pool, blocks[POOL_BLOCK_COUNT - 1]);
+
+    heap_pool_delete(pool);
+}
+
+TEST_CASE("heap pool malloc falls back to heap_caps for large requests", "[heap][pool]")
+{
+    heap_pool_handle_t pool = create_test_pool();
+    heap_pool_info_t info;
+
+    void *small = heap_pool_malloc(pool, POOL_BLOCK_SIZE);
+    TEST_ASSERT_NOT_NULL(small);
+    TEST_ASSERT_TRUE(heap_pool_owns(pool, small));
+
+    void *large = heap_pool_malloc(pool, 4 * POOL_BLOCK_SIZE);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT_FALSE(heap_pool_owns(pool, large));
+    memset(large, 0xA5, 4 * POOL_BLOCK_SIZE);
+
+    TEST_ASSERT_EQUAL(ESP_OK, heap_pool_get_info(pool, &info));
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT - 1, info.free_blocks);
+    TEST_ASSERT_EQUAL(1, info.fallbacks);
+
+    heap_pool_free(pool, large);
+    heap_pool_free(pool, small);
+
+    TEST_ASSERT_EQUAL(ESP_OK, heap_pool_get_info(pool, &info));
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, info.free_blocks);
+
+    heap_pool_delete(pool);
+}
+
+#define POOL_STRESS_ITERATIONS  10000
+#define POOL_STRESS_HELD        (POOL_BLOCK_COUNT / 2)
+
+typedef struct {
+    heap_pool_handle_t pool;
+    SemaphoreHandle_t done;
+    uint8_t pattern;
+    bool corrupted;
+} pool_stress_arg_t;
+
+static void pool_stress_task(void *arg)
+{
+    pool_stress_arg_t *stress = (pool_stress_arg_t *)arg;
+    uint8_t *held[POOL_STRESS_HELD] = { 0 };
+
+    for (int i = 0; i < POOL_STRESS_ITERATIONS; i++) {
+        int slot = i % POOL_STRESS_HELD;
+        if (held[slot] != NULL) {
+            for (int j = 0; j < POOL_BLOCK_SIZE; j++) {
+                if (held[slot][j] != stress->pattern) {
+                    stress->corrupted = true;
+                }
+            }
+            heap_pool_free(stress->pool, held[slot]);
+        }
+        held[slot] = heap_pool_alloc(stress->pool);
+        if (held[slot] != NULL) {
+            memset(held[slot], stress->pattern, POOL_BLOCK_SIZE);
+        }
+    }
+    for (int slot = 0; slot < POOL_STRESS_HELD; slot++) {
+        heap_pool_free(stress->pool, held[slot]);
+    }
+
+    xSemaphoreGive(stress->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("heap pool can be shared between tasks without locking", "[heap][pool]")
+{
+    heap_pool_handle_t pool = create_test_pool();
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(2, 0);
+    TEST_ASSERT_NOT_NULL(done);
+
+    pool_stress_arg_t args[2] = {
+        { .pool = pool, .done = done, .pattern = 0x55 },
+        { .pool = pool, .done = done, .pattern = 0xAA },
+    };
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(pool_stress_task, "pool_stress", 4096, &args[i],
+                                                          UNITY_FREERTOS_PRIORITY - 1, NULL, i % portNUM_PROCESSORS));
+    }
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_TRUE(xSemaphoreTake(done, pdMS_TO_TICKS(10000)));
+    }
+
+    TEST_ASSERT_FALSE(args[0].corrupted);
+    TEST_ASSERT_FALSE(args[1].corrupted);
+
+    heap_pool_info_t info;
+    TEST_ASSERT_EQUAL(ESP_OK, heap_pool_get_info(pool, &info));
+    TEST_ASSERT_EQUAL(POOL_BLOCK_COUNT, info.free_blocks);
+    TEST_ASSERT_LESS_OR_EQUAL(POOL_BLOCK_COUNT, info.high_water);
+
+    vSemaphoreDelete(done);
+    heap_pool_delete(pool);
+}
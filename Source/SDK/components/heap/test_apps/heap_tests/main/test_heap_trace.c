@@ -6,7 +6,7 @@
 /*
  Generic test for heap tracing support
 
- Only compiled in if CONFIG_HEAP_TRACING is set
+ Only compiled in if CONFIG_HEAP_TRACING_STANDALONE is set
 */
 
 #include <esp_types.h>
@@ -21,8 +21,8 @@
 
 #include "esp_heap_caps.h"
 
-#ifdef CONFIG_HEAP_TRACING
-// only compile in heap tracing tests if tracing is enabled
+#ifdef CONFIG_HEAP_TRACING_STANDALONE
+// only compile in heap tracing tests if standalone tracing is enabled
 
 #include "esp_heap_trace.h"
 
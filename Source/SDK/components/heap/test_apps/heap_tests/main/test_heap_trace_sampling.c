@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+/*
+ Test for the sampling heap profiler
+
+ Only compiled in if CONFIG_HEAP_TRACING_SAMPLING is set
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "unity.h"
+
+#include "esp_heap_caps.h"
+
+#ifdef CONFIG_HEAP_TRACING_SAMPLING
+
+#include "esp_heap_trace.h"
+
+#define SAMPLE_PERIOD       8
+#define SMALL_ALLOCS        4000
+#define SMALL_SIZE          16
+#define LARGE_SIZE          512
+
+static void __attribute__((noinline)) small_churn(void)
+{
+    for (int i = 0; i < SMALL_ALLOCS; i++) {
+        void *p = malloc(SMALL_SIZE);
+        TEST_ASSERT_NOT_NULL(p);
+        free(p);
+    }
+}
+
+static void __attribute__((noinline)) large_churn(void)
+{
+    for (int i = 0; i < SMALL_ALLOCS / 4; i++) {
+        void *p = malloc(LARGE_SIZE);
+        TEST_ASSERT_NOT_NULL(p);
+        free(p);
+    }
+}
+
+TEST_CASE("heap trace sampling aggregates allocations per callsite", "[heap-trace-sampling]")
+{
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_trace_init_sampling(0));
+    TEST_ASSERT_EQUAL(ESP_OK, heap_trace_init_sampling(SAMPLE_PERIOD));
+
+    printf("Sampling test\n"); // Print something before trace starts, or stdout allocations skew total counts
+    fflush(stdout);
+
+    TEST_ASSERT_EQUAL(ESP_OK, heap_trace_start(HEAP_TRACE_ALL));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, heap_trace_init_sampling(SAMPLE_PERIOD));
+
+    small_churn();
+    large_churn();
+
+    TEST_ASSERT_EQUAL(ESP_OK, heap_trace_stop());
+
+    heap_trace_summary_t summary;
+    TEST_ASSERT_EQUAL(ESP_OK, heap_trace_summary(&summary));
+    TEST_ASSERT_GREATER_OR_EQUAL(SMALL_ALLOCS + SMALL_ALLOCS / 4, summary.total_allocations);
+    TEST_ASSERT_GREATER_OR_EQUAL(SMALL_ALLOCS + SMALL_ALLOCS / 4, summary.total_frees);
+    TEST_ASSERT_FALSE(summary.has_overflowed);
+
+    // the two loops are the largest callsites, find them by allocation size
+    uint32_t small_count = 0;
+    uint32_t large_count = 0;
+    heap_trace_callsite_t callsite;
+    for (size_t i = 0; i < heap_trace_get_count(); i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, heap_trace_get_callsite(i, &callsite));
+        TEST_ASSERT_NOT_EQUAL(0, callsite.count);
+        TEST_ASSERT_NOT_NULL(callsite.callers[0]);
+        if (callsite.bytes == (uint64_t)callsite.count * SMALL_SIZE && callsite.count > small_count) {
+            small_count = callsite.count;
+        }
+        if (callsite.bytes == (uint64_t)callsite.count * LARGE_SIZE && callsite.count > large_count) {
+            large_count = callsite.count;
+        }
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, heap_trace_get_callsite(heap_trace_get_count(), &callsite));
+
+    // the sampled counts estimate the real ones within a generous margin
+    TEST_ASSERT_UINT32_WITHIN(SMALL_ALLOCS / 4, SMALL_ALLOCS, small_count * SAMPLE_PERIOD);
+    TEST_ASSERT_UINT32_WITHIN(SMALL_ALLOCS / 16, SMALL_ALLOCS / 4, large_count * SAMPLE_PERIOD);
+
+    heap_trace_dump();
+}
+
+#endif // CONFIG_HEAP_TRACING_SAMPLING
@@ -158,6 +158,8 @@ typedef struct internal_hooks
     void *(CJSON_CDECL *allocate)(size_t size);
     void (CJSON_CDECL *deallocate)(void *pointer);
     void *(CJSON_CDECL *reallocate)(void *pointer, size_t size);
+    /* when set, memory comes from this arena instead and is never freed individually */
+    cJSON_Arena *arena;
 } internal_hooks;
 
 #if defined(_MSC_VER)
@@ -183,7 +185,48 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 /* strlen of character literals resolved at compile time */
 #define static_strlen(string_literal) (sizeof(string_literal) - sizeof(""))
 
-static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc };
+static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc, NULL };
+
+/* arena blocks are aligned for the strictest member of a cJSON item */
+#define arena_alignment sizeof(double)
+
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
+{
+    size_t start = 0;
+
+    if ((arena == NULL) || (arena->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    start = arena->used + ((arena_alignment - ((size_t)(arena->buffer + arena->used) % arena_alignment)) % arena_alignment);
+    if ((start < arena->used) || (start > arena->size) || (size > (arena->size - start)))
+    {
+        return NULL;
+    }
+    arena->used = start + size;
+
+    return arena->buffer + start;
+}
+
+static void *hooks_allocate(const internal_hooks * const hooks, size_t size)
+{
+    if (hooks->arena != NULL)
+    {
+        return arena_allocate(hooks->arena, size);
+    }
+
+    return hooks->allocate(size);
+}
+
+static void hooks_deallocate(const internal_hooks * const hooks, void *pointer)
+{
+    /* arena memory is only released by cJSON_ResetArena */
+    if (hooks->arena == NULL)
+    {
+        hooks->deallocate(pointer);
+    }
+}
 
 static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
 {
@@ -196,7 +239,7 @@ static unsigned char* cJSON_strdup(const unsigned char* string, const internal_h
     }
 
     length = strlen((const char*)string) + sizeof("");
-    copy = (unsigned char*)hooks->allocate(length);
+    copy = (unsigned char*)hooks_allocate(hooks, length);
     if (copy == NULL)
     {
         return NULL;
@@ -240,7 +283,7 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    cJSON* node = (cJSON*)hooks_allocate(hooks, sizeof(cJSON));
     if (node)
     {
         memset(node, '\0', sizeof(cJSON));
@@ -260,6 +303,13 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
         {
             cJSON_Delete(item->child);
         }
+        cJSON_ResetObjectIndex(item);
+        if (item->type & cJSON_InArena)
+        {
+            /* the item and its strings are released together with the arena */
+            item = next;
+            continue;
+        }
         if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
         {
             global_hooks.deallocate(item->valuestring);
@@ -418,6 +468,11 @@ CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
         strcpy(object->valuestring, valuestring);
         return object->valuestring;
     }
+    /* a longer string can't be allocated from the arena the item lives in */
+    if (object->type & cJSON_InArena)
+    {
+        return NULL;
+    }
     copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
     if (copy == NULL)
     {
@@ -817,7 +872,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
 
         /* This is at most how much we need for the output */
         allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        output = (unsigned char*)hooks_allocate(&input_buffer->hooks, allocation_length + sizeof(""));
         if (output == NULL)
         {
             goto fail; /* allocation failure */
@@ -895,7 +950,7 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
 fail:
     if (output != NULL)
     {
-        input_buffer->hooks.deallocate(output);
+        hooks_deallocate(&input_buffer->hooks, output);
         output = NULL;
     }
 
@@ -1100,11 +1155,23 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
     return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
 }
 
+/* Flag a parsed tree as arena memory, so that cJSON_Delete doesn't free it. */
+static void mark_in_arena(cJSON *item)
+{
+    while (item != NULL)
+    {
+        item->type |= cJSON_InArena;
+        mark_in_arena(item->child);
+        item = item->next;
+    }
+}
+
 /* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+static cJSON *parse_with_hooks(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, const internal_hooks * const hooks)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, NULL } };
     cJSON *item = NULL;
+    size_t arena_used = (hooks->arena != NULL) ? hooks->arena->used : 0;
 
     /* reset error position */
     global_error.json = NULL;
@@ -1118,9 +1185,9 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.content = (const unsigned char*)value;
     buffer.length = buffer_length;
     buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    buffer.hooks = *hooks;
 
-    item = cJSON_New_Item(&global_hooks);
+    item = cJSON_New_Item(hooks);
     if (item == NULL) /* memory fail */
     {
         goto fail;
@@ -1146,10 +1213,20 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
         *return_parse_end = (const char*)buffer_at_offset(&buffer);
     }
 
+    if (hooks->arena != NULL)
+    {
+        mark_in_arena(item);
+    }
+
     return item;
 
 fail:
-    if (item != NULL)
+    if (hooks->arena != NULL)
+    {
+        /* give back everything the failed parse took from the arena */
+        hooks->arena->used = arena_used;
+    }
+    else if (item != NULL)
     {
         cJSON_Delete(item);
     }
@@ -1180,6 +1257,56 @@ fail:
     return NULL;
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_with_hooks(value, buffer_length, return_parse_end, require_null_terminated, &global_hooks);
+}
+
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    arena->buffer = (unsigned char*)buffer;
+    arena->size = (buffer != NULL) ? size : 0;
+    arena->used = 0;
+}
+
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
+{
+    if (arena != NULL)
+    {
+        arena->used = 0;
+    }
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArenaOpts(cJSON_Arena *arena, const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    internal_hooks hooks;
+
+    if ((arena == NULL) || (arena->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    hooks = global_hooks;
+    hooks.arena = arena;
+
+    return parse_with_hooks(value, buffer_length, return_parse_end, require_null_terminated, &hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(cJSON_Arena *arena, const char *value)
+{
+    if (NULL == value)
+    {
+        return NULL;
+    }
+
+    return cJSON_ParseWithArenaOpts(arena, value, strlen(value) + sizeof(""), 0, 0);
+}
+
 /* Default options for cJSON_Parse */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
 {
@@ -1273,7 +1400,7 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
 
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, NULL } };
 
     if (prebuffer < 0)
     {
@@ -1304,7 +1431,7 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, NULL } };
 
     if ((length < 0) || (buffer == NULL))
     {
@@ -1540,7 +1667,8 @@ success:
     return true;
 
 fail:
-    if (head != NULL)
+    /* items from an arena are dropped when the arena is rolled back */
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
         cJSON_Delete(head);
     }
@@ -1720,7 +1848,8 @@ success:
     return true;
 
 fail:
-    if (head != NULL)
+    /* items from an arena are dropped when the arena is rolled back */
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
         cJSON_Delete(head);
     }
@@ -1895,21 +2024,163 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
     return get_array_item(array, (size_t)index);
 }
 
+/* Hash index of the members of an object. Keys are hashed case folded, so that it serves case sensitive and
+ * case insensitive lookups. Members are inserted in list order and never removed, so along the probe sequence of
+ * a key the members come in list order, and the first match is the one the linear search would find. */
+typedef struct object_index_slot
+{
+    cJSON *item;
+    size_t hash;
+} object_index_slot;
+
+typedef struct cJSON_ObjectIndex
+{
+    size_t capacity; /* number of slots, a power of two */
+    size_t count;
+    object_index_slot *slots;
+} cJSON_ObjectIndex;
+
+static size_t hash_key(const unsigned char *key)
+{
+    /* FNV-1a */
+    size_t hash = 2166136261u;
+    for (; *key != '\0'; key++)
+    {
+        hash = (hash ^ (size_t)tolower(*key)) * 16777619u;
+    }
+
+    return hash;
+}
+
+static void object_index_insert(cJSON_ObjectIndex * const index, cJSON * const item, const size_t hash)
+{
+    size_t slot = hash & (index->capacity - 1);
+    while (index->slots[slot].item != NULL)
+    {
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+
+    index->slots[slot].item = item;
+    index->slots[slot].hash = hash;
+    index->count++;
+}
+
+/* Returns NULL if out of memory or if a member has no key, the linear search stops at those. */
+static cJSON_ObjectIndex *create_object_index(const cJSON * const object)
+{
+    cJSON_ObjectIndex *index = NULL;
+    cJSON *member = NULL;
+    size_t members = 0;
+    size_t capacity = 16;
+
+    for (member = object->child; member != NULL; member = member->next)
+    {
+        if (member->string == NULL)
+        {
+            return NULL;
+        }
+        members++;
+    }
+
+    /* at most half full, so that members can be added for a while before the index has to grow */
+    while (capacity < members * 2)
+    {
+        capacity *= 2;
+    }
+
+    index = (cJSON_ObjectIndex*)global_hooks.allocate(sizeof(cJSON_ObjectIndex) + capacity * sizeof(object_index_slot));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+    index->capacity = capacity;
+    index->count = 0;
+    index->slots = (object_index_slot*)(index + 1);
+    memset(index->slots, '\0', capacity * sizeof(object_index_slot));
+
+    for (member = object->child; member != NULL; member = member->next)
+    {
+        object_index_insert(index, member, hash_key((const unsigned char*)member->string));
+    }
+
+    return index;
+}
+
+CJSON_PUBLIC(void) cJSON_ResetObjectIndex(cJSON *object)
+{
+    if ((object != NULL) && (object->member_index != NULL))
+    {
+        global_hooks.deallocate(object->member_index);
+        object->member_index = NULL;
+    }
+}
+
+/* Keeps the index of an object up to date after item was appended to it. */
+static void object_index_append(cJSON * const object, cJSON * const item)
+{
+    cJSON_ObjectIndex *index = object->member_index;
+
+    if (item->string == NULL)
+    {
+        cJSON_ResetObjectIndex(object);
+        return;
+    }
+    if ((index->count + 1) * 4 <= index->capacity * 3)
+    {
+        object_index_insert(index, item, hash_key((const unsigned char*)item->string));
+        return;
+    }
+
+    /* rebuild with more room, the list already contains item */
+    cJSON_ResetObjectIndex(object);
+    object->member_index = create_object_index(object);
+}
+
+static cJSON *object_index_find(const cJSON_ObjectIndex * const index, const char * const name, const cJSON_bool case_sensitive)
+{
+    size_t hash = hash_key((const unsigned char*)name);
+    size_t slot = hash & (index->capacity - 1);
+
+    for (; index->slots[slot].item != NULL; slot = (slot + 1) & (index->capacity - 1))
+    {
+        cJSON *item = index->slots[slot].item;
+        if (index->slots[slot].hash != hash)
+        {
+            continue;
+        }
+        if (case_sensitive ? (strcmp(name, item->string) == 0) : (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)item->string) == 0))
+        {
+            return item;
+        }
+    }
+
+    return NULL;
+}
+
+static void* cast_away_const(const void* string);
+
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
     cJSON *current_element = NULL;
+    size_t steps = 0;
 
     if ((object == NULL) || (name == NULL))
     {
         return NULL;
     }
 
+    if (object->member_index != NULL)
+    {
+        return object_index_find(object->member_index, name, case_sensitive);
+    }
+
     current_element = object->child;
     if (case_sensitive)
     {
         while ((current_element != NULL) && (current_element->string != NULL) && (strcmp(name, current_element->string) != 0))
         {
             current_element = current_element->next;
+            steps++;
         }
     }
     else
@@ -1917,9 +2188,17 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
         while ((current_element != NULL) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)(current_element->string)) != 0))
         {
             current_element = current_element->next;
+            steps++;
         }
     }
 
+    /* the object is large enough for an index to pay off */
+    if ((CJSON_OBJECT_INDEX_THRESHOLD > 0) && (steps >= CJSON_OBJECT_INDEX_THRESHOLD)
+            && ((object->type & 0xFF) == cJSON_Object) && !(object->type & (cJSON_IsReference | cJSON_InArena)))
+    {
+        ((cJSON*)cast_away_const(object))->member_index = create_object_index(object);
+    }
+
     if ((current_element == NULL) || (current_element->string == NULL)) {
         return NULL;
     }
@@ -1966,8 +2245,10 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
 
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
-    reference->type |= cJSON_IsReference;
+    /* the reference itself is allocated with hooks, even if the item lives in an arena */
+    reference->type = (reference->type & ~cJSON_InArena) | cJSON_IsReference;
     reference->next = reference->prev = NULL;
+    reference->member_index = NULL;
     return reference;
 }
 
@@ -1999,6 +2280,17 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
             suffix_object(child->prev, item);
             array->child->prev = item;
         }
+        else
+        {
+            /* nothing was appended, don't index item */
+            cJSON_ResetObjectIndex(array);
+            return true;
+        }
+    }
+
+    if (array->member_index != NULL)
+    {
+        object_index_append(array, item);
     }
 
     return true;
@@ -2043,6 +2335,12 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
     }
     else
     {
+        /* the key is freed together with the item, so it has to come from the same place */
+        if (((item->type & cJSON_InArena) != 0) != (hooks->arena != NULL))
+        {
+            return false;
+        }
+
         new_key = (char*)cJSON_strdup((const unsigned char*)string, hooks);
         if (new_key == NULL)
         {
@@ -2052,7 +2350,7 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
         new_type = item->type & ~cJSON_StringIsConst;
     }
 
-    if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+    if (!(item->type & (cJSON_StringIsConst | cJSON_InArena)) && (item->string != NULL))
     {
         hooks->deallocate(item->string);
     }
@@ -2235,6 +2533,8 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
     item->prev = NULL;
     item->next = NULL;
 
+    cJSON_ResetObjectIndex(parent);
+
     return item;
 }
 
@@ -2309,6 +2609,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
     {
         newitem->prev->next = newitem;
     }
+    /* the index only supports appending */
+    cJSON_ResetObjectIndex(array);
     return true;
 }
 
@@ -2358,6 +2660,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON
     item->prev = NULL;
     cJSON_Delete(item);
 
+    cJSON_ResetObjectIndex(parent);
+
     return true;
 }
 
@@ -2378,6 +2682,12 @@ static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSO
         return false;
     }
 
+    /* the new name is allocated with hooks, which an item from an arena can't own */
+    if (replacement->type & cJSON_InArena)
+    {
+        return false;
+    }
+
     /* replace the name in the replacement */
     if (!(replacement->type & cJSON_StringIsConst) && (replacement->string != NULL))
     {
@@ -2725,6 +3035,149 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char *const *strings, int co
     return a;
 }
 
+/* Arena builders: */
+static cJSON *create_arena_item(cJSON_Arena * const arena, const int type)
+{
+    internal_hooks hooks = global_hooks;
+    cJSON *item = NULL;
+
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+
+    hooks.arena = arena;
+    item = cJSON_New_Item(&hooks);
+    if (item != NULL)
+    {
+        item->type = type | cJSON_InArena;
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateNullInArena(cJSON_Arena *arena)
+{
+    return create_arena_item(arena, cJSON_NULL);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateBoolInArena(cJSON_Arena *arena, cJSON_bool boolean)
+{
+    return create_arena_item(arena, boolean ? cJSON_True : cJSON_False);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumberInArena(cJSON_Arena *arena, double num)
+{
+    cJSON *item = create_arena_item(arena, cJSON_Number);
+    if (item != NULL)
+    {
+        cJSON_SetNumberHelper(item, num);
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringInArena(cJSON_Arena *arena, const char *string)
+{
+    internal_hooks hooks = global_hooks;
+    size_t arena_used = 0;
+    cJSON *item = NULL;
+
+    if ((arena == NULL) || (string == NULL))
+    {
+        return NULL;
+    }
+
+    arena_used = arena->used;
+    hooks.arena = arena;
+    item = create_arena_item(arena, cJSON_String);
+    if (item != NULL)
+    {
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, &hooks);
+        if (item->valuestring == NULL)
+        {
+            arena->used = arena_used;
+            return NULL;
+        }
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateArrayInArena(cJSON_Arena *arena)
+{
+    return create_arena_item(arena, cJSON_Array);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateObjectInArena(cJSON_Arena *arena)
+{
+    return create_arena_item(arena, cJSON_Object);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectInArena(cJSON_Arena *arena, cJSON *object, const char *string, cJSON *item)
+{
+    internal_hooks hooks = global_hooks;
+
+    if (arena == NULL)
+    {
+        return false;
+    }
+
+    hooks.arena = arena;
+    return add_item_to_object(object, string, item, &hooks, false);
+}
+
+/* Adds an item created in the arena to an object, giving back its memory if that fails. */
+static cJSON *add_arena_item_to_object(cJSON_Arena * const arena, const size_t arena_used, cJSON * const object, const char * const name, cJSON * const item)
+{
+    if (cJSON_AddItemToObjectInArena(arena, object, name, item))
+    {
+        return item;
+    }
+
+    if (arena != NULL)
+    {
+        arena->used = arena_used;
+    }
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddNullToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name)
+{
+    size_t arena_used = (arena != NULL) ? arena->used : 0;
+    return add_arena_item_to_object(arena, arena_used, object, name, cJSON_CreateNullInArena(arena));
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddBoolToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name, const cJSON_bool boolean)
+{
+    size_t arena_used = (arena != NULL) ? arena->used : 0;
+    return add_arena_item_to_object(arena, arena_used, object, name, cJSON_CreateBoolInArena(arena, boolean));
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddNumberToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name, const double number)
+{
+    size_t arena_used = (arena != NULL) ? arena->used : 0;
+    return add_arena_item_to_object(arena, arena_used, object, name, cJSON_CreateNumberInArena(arena, number));
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddStringToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name, const char * const string)
+{
+    size_t arena_used = (arena != NULL) ? arena->used : 0;
+    return add_arena_item_to_object(arena, arena_used, object, name, cJSON_CreateStringInArena(arena, string));
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name)
+{
+    size_t arena_used = (arena != NULL) ? arena->used : 0;
+    return add_arena_item_to_object(arena, arena_used, object, name, cJSON_CreateObjectInArena(arena));
+}
+
+CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name)
+{
+    size_t arena_used = (arena != NULL) ? arena->used : 0;
+    return add_arena_item_to_object(arena, arena_used, object, name, cJSON_CreateArrayInArena(arena));
+}
+
 /* Duplication */
 CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
 {
@@ -2745,7 +3198,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         goto fail;
     }
     /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
+    newitem->type = item->type & ~(cJSON_IsReference | cJSON_InArena);
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
     if (item->valuestring)
@@ -98,6 +98,7 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+#define cJSON_InArena 1024 /* item and its strings are owned by a cJSON_Arena */
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -120,6 +121,9 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Hash index of an object's members, built by cJSON when an object is searched by key, see CJSON_OBJECT_INDEX_THRESHOLD. */
+    struct cJSON_ObjectIndex *member_index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -129,6 +133,14 @@ typedef struct cJSON_Hooks
       void (CJSON_CDECL *free_fn)(void *ptr);
 } cJSON_Hooks;
 
+/* A caller supplied buffer that items are carved from one after the other. Everything in it is released at once with cJSON_ResetArena. */
+typedef struct cJSON_Arena
+{
+    unsigned char *buffer;
+    size_t size;
+    size_t used;
+} cJSON_Arena;
+
 typedef int cJSON_bool;
 
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
@@ -137,6 +149,14 @@ typedef int cJSON_bool;
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* When looking up a key takes this many steps through the members of an object, cJSON builds a hash index for the
+ * object, so that later lookups don't have to walk the members. The index is kept up to date by the cJSON functions
+ * that add, remove or replace members, but not when a member's string or the child list is changed directly, see
+ * cJSON_ResetObjectIndex. Objects in an arena and references are never indexed. 0 disables the index. */
+#ifndef CJSON_OBJECT_INDEX_THRESHOLD
+#define CJSON_OBJECT_INDEX_THRESHOLD 16
+#endif
+
 /* returns the version of cJSON as a string */
 CJSON_PUBLIC(const char*) cJSON_Version(void);
 
@@ -152,6 +172,15 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
 
+/* Arenas: parse or build a document without calling the allocator. All items and strings are taken from the arena buffer,
+ * so a document is released by resetting its arena, which invalidates every item in it. cJSON_Delete may still be called
+ * on arena items, it only frees items that were added to them with the heap based functions. */
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size);
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+/* Same as cJSON_Parse/cJSON_ParseWithLengthOpts, but the result lives in the arena. Returns NULL if the arena is too small, in which case the arena is left as it was. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(cJSON_Arena *arena, const char *value);
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArenaOpts(cJSON_Arena *arena, const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. */
@@ -172,6 +201,8 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
+/* Drop the hash index of an object. Call this after changing the key or the order of members without the cJSON functions. */
+CJSON_PUBLIC(void) cJSON_ResetObjectIndex(cJSON *object);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
@@ -245,11 +276,30 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON
 CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInObject(cJSON *object,const char *string,cJSON *newitem);
 CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object,const char *string,cJSON *newitem);
 
+/* Create items in an arena. Keys of arena items must be added with cJSON_AddItemToObjectInArena or cJSON_AddItemToObjectCS,
+ * cJSON_AddItemToObject and cJSON_ReplaceItemInObject refuse them. */
+CJSON_PUBLIC(cJSON *) cJSON_CreateNullInArena(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_CreateBoolInArena(cJSON_Arena *arena, cJSON_bool boolean);
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumberInArena(cJSON_Arena *arena, double num);
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringInArena(cJSON_Arena *arena, const char *string);
+CJSON_PUBLIC(cJSON *) cJSON_CreateArrayInArena(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_CreateObjectInArena(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectInArena(cJSON_Arena *arena, cJSON *object, const char *string, cJSON *item);
+/* Helper functions for creating and adding arena items to an object at the same time.
+ * They return the added item or NULL on failure. */
+CJSON_PUBLIC(cJSON*) cJSON_AddNullToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name);
+CJSON_PUBLIC(cJSON*) cJSON_AddBoolToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name, const cJSON_bool boolean);
+CJSON_PUBLIC(cJSON*) cJSON_AddNumberToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name, const double number);
+CJSON_PUBLIC(cJSON*) cJSON_AddStringToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name, const char * const string);
+CJSON_PUBLIC(cJSON*) cJSON_AddObjectToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name);
+CJSON_PUBLIC(cJSON*) cJSON_AddArrayToObjectInArena(cJSON_Arena *arena, cJSON * const object, const char * const name);
+
 /* Duplicate a cJSON item */
 CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse);
 /* Duplicate will create a new, identical cJSON item to the one you pass, in new memory that will
  * need to be released. With recurse!=0, it will duplicate any children connected to the item.
- * The item->next and ->prev pointers are always zero on return from Duplicate. */
+ * The item->next and ->prev pointers are always zero on return from Duplicate.
+ * Items from an arena are duplicated to the heap. */
 /* Recursively compare two cJSON items for equality. If either a or b is NULL or invalid, they will be considered unequal.
  * case_sensitive determines if object keys are treated case sensitive (1) or case insensitive (0) */
 CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive);
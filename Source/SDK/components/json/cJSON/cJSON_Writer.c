@@ -0,0 +1,536 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* disable warnings about old C89 functions in MSVC */
+#if !defined(_CRT_SECURE_NO_DEPRECATE) && defined(_MSC_VER)
+#define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#ifdef __GNUC__
+#pragma GCC visibility push(default)
+#endif
+#if defined(_MSC_VER)
+#pragma warning (push)
+/* disable warning about single line comments in system headers */
+#pragma warning (disable : 4001)
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#ifdef ENABLE_LOCALES
+#include <locale.h>
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning (pop)
+#endif
+#ifdef __GNUC__
+#pragma GCC visibility pop
+#endif
+
+#include "cJSON_Writer.h"
+
+/* define our own boolean type */
+#ifdef true
+#undef true
+#endif
+#define true ((cJSON_bool)1)
+
+#ifdef false
+#undef false
+#endif
+#define false ((cJSON_bool)0)
+
+/* flags of a nesting level in cJSON_Writer.levels */
+#define level_object 1 /* the level is an object, not an array */
+#define level_has_members 2 /* a value (or key) was written at this level, so the next one needs a comma */
+#define level_has_key 4 /* the key of an object member was written, its value is next */
+
+/* doubles with a larger magnitude can't be scaled to an exact integer */
+#define max_exact_integer 9007199254740992.0
+/* the most fraction digits the fast number formatting tries */
+#define max_fraction_digits 9
+
+static const double powers_of_ten[max_fraction_digits + 1] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+static cJSON_bool fail(cJSON_Writer * const writer)
+{
+    writer->failed = true;
+    return false;
+}
+
+static cJSON_bool write_bytes(cJSON_Writer * const writer, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t chunk = writer->size - writer->length;
+        if (chunk == 0)
+        {
+            if ((writer->flush == NULL) || !writer->flush(writer->context, writer->buffer, writer->length))
+            {
+                return fail(writer);
+            }
+            writer->length = 0;
+            chunk = writer->size;
+        }
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+
+        memcpy(writer->buffer + writer->length, data, chunk);
+        writer->length += chunk;
+        writer->written += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+
+    return true;
+}
+
+static cJSON_bool write_char(cJSON_Writer * const writer, const char character)
+{
+    if (writer->length < writer->size)
+    {
+        writer->buffer[writer->length++] = character;
+        writer->written++;
+        return true;
+    }
+
+    return write_bytes(writer, &character, 1);
+}
+
+/* Writes a string with quotes and escape sequences, the same way cJSON_Print does. */
+static cJSON_bool write_string(cJSON_Writer * const writer, const char *string)
+{
+    const unsigned char *run = (const unsigned char*)string;
+    const unsigned char *current = run;
+    char escape[6] = { '\\', 'u', '0', '0', 0, 0 };
+    static const char hex_digits[] = "0123456789abcdef";
+
+    if (!write_char(writer, '\"'))
+    {
+        return false;
+    }
+
+    for (; *current != '\0'; current++)
+    {
+        if ((*current >= 32) && (*current != '\"') && (*current != '\\'))
+        {
+            continue;
+        }
+
+        /* write the characters before the one that needs escaping in one go */
+        if (!write_bytes(writer, (const char*)run, (size_t)(current - run)))
+        {
+            return false;
+        }
+        run = current + 1;
+
+        switch (*current)
+        {
+            case '\"':
+            case '\\':
+                escape[1] = (char)*current;
+                break;
+            case '\b':
+                escape[1] = 'b';
+                break;
+            case '\f':
+                escape[1] = 'f';
+                break;
+            case '\n':
+                escape[1] = 'n';
+                break;
+            case '\r':
+                escape[1] = 'r';
+                break;
+            case '\t':
+                escape[1] = 't';
+                break;
+            default:
+                escape[1] = 'u';
+                escape[4] = hex_digits[*current >> 4];
+                escape[5] = hex_digits[*current & 0xf];
+                if (!write_bytes(writer, escape, sizeof(escape)))
+                {
+                    return false;
+                }
+                continue;
+        }
+        if (!write_bytes(writer, escape, 2))
+        {
+            return false;
+        }
+    }
+
+    if (!write_bytes(writer, (const char*)run, (size_t)(current - run)))
+    {
+        return false;
+    }
+    return write_char(writer, '\"');
+}
+
+/* Writes the separator a value needs at the current position and checks that a value is allowed there. */
+static cJSON_bool begin_value(cJSON_Writer * const writer)
+{
+    unsigned char *level = NULL;
+
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+
+    level = &writer->levels[writer->depth];
+    if (writer->depth == 0)
+    {
+        /* only one value at the top level */
+        if (*level & level_has_members)
+        {
+            return fail(writer);
+        }
+        *level |= level_has_members;
+        return true;
+    }
+
+    if (*level & level_object)
+    {
+        if (!(*level & level_has_key))
+        {
+            return fail(writer);
+        }
+        *level &= (unsigned char)~level_has_key;
+        return true;
+    }
+
+    if ((*level & level_has_members) && !write_char(writer, ','))
+    {
+        return false;
+    }
+    *level |= level_has_members;
+
+    return true;
+}
+
+static cJSON_bool start_container(cJSON_Writer * const writer, const char opening, const unsigned char flags)
+{
+    if (!begin_value(writer))
+    {
+        return false;
+    }
+    if (writer->depth >= CJSON_WRITER_NESTING_LIMIT)
+    {
+        return fail(writer);
+    }
+    if (!write_char(writer, opening))
+    {
+        return false;
+    }
+
+    writer->depth++;
+    writer->levels[writer->depth] = flags;
+
+    return true;
+}
+
+static cJSON_bool end_container(cJSON_Writer * const writer, const char closing, const unsigned char flags)
+{
+    unsigned char level = 0;
+
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+
+    level = writer->levels[writer->depth];
+    if ((writer->depth == 0) || ((level & level_object) != flags) || (level & level_has_key))
+    {
+        return fail(writer);
+    }
+    if (!write_char(writer, closing))
+    {
+        return false;
+    }
+
+    writer->depth--;
+
+    return true;
+}
+
+/* Formats an integer with fraction_digits digits after the decimal point, working back from the end of the buffer. */
+static char *format_scaled_integer(double integer, size_t fraction_digits, char *end)
+{
+    /* split to fit into unsigned long, which may only have 32 bits */
+    double high_part = floor(integer / 1e9);
+    double low_part = integer - high_part * 1e9;
+    unsigned long high = 0;
+    unsigned long low = 0;
+    char *current = end;
+    size_t digits = 0;
+
+    if (low_part < 0)
+    {
+        high_part -= 1;
+        low_part += 1e9;
+    }
+    high = (unsigned long)high_part;
+    low = (unsigned long)low_part;
+
+    while ((low > 0) || (high > 0) || (digits <= fraction_digits))
+    {
+        if ((digits == fraction_digits) && (digits > 0))
+        {
+            *--current = '.';
+        }
+        *--current = (char)('0' + (low % 10));
+        low /= 10;
+        digits++;
+        if ((digits == 9) && (high > 0))
+        {
+            low = high;
+            high = 0;
+        }
+    }
+
+    return current;
+}
+
+static cJSON_bool write_number(cJSON_Writer * const writer, double number)
+{
+    /* large enough for %1.17g and for a scaled integer with a sign and a decimal point */
+    char number_buffer[26];
+    char *start = NULL;
+    char *end = number_buffer + sizeof(number_buffer);
+    double magnitude = fabs(number);
+    size_t fraction_digits = 0;
+    double test = 0.0;
+
+    if ((number != number) || ((number - number) != 0.0))
+    {
+        /* NaN or infinity */
+        return write_bytes(writer, "null", 4);
+    }
+
+    /* Find the fewest fraction digits for which the scaled value is an integer that reads back as the same
+     * number. Both the integer and the power of ten are exact doubles, so the division is the correctly rounded
+     * value of the decimal, which is also what a correct strtod makes of it. */
+    for (fraction_digits = 0; fraction_digits <= max_fraction_digits; fraction_digits++)
+    {
+        double scaled = magnitude * powers_of_ten[fraction_digits];
+        double integer = 0.0;
+        if (scaled >= max_exact_integer)
+        {
+            break;
+        }
+
+        integer = floor(scaled + 0.5);
+        if ((integer / powers_of_ten[fraction_digits]) == magnitude)
+        {
+            start = format_scaled_integer(integer, fraction_digits, end);
+            if ((number < 0) && (integer > 0))
+            {
+                *--start = '-';
+            }
+            return write_bytes(writer, start, (size_t)(end - start));
+        }
+    }
+
+    /* Fall back to the formatting of cJSON_Print: try 15 decimal places of precision to avoid nonsignificant
+     * nonzero digits, otherwise use 17 */
+    sprintf(number_buffer, "%1.15g", number);
+    if ((sscanf(number_buffer, "%lg", &test) != 1) || (test != number))
+    {
+        sprintf(number_buffer, "%1.17g", number);
+    }
+
+#ifdef ENABLE_LOCALES
+    {
+        char decimal_point = localeconv()->decimal_point[0];
+        for (start = number_buffer; *start != '\0'; start++)
+        {
+            if (*start == decimal_point)
+            {
+                *start = '.';
+            }
+        }
+    }
+#endif
+
+    return write_bytes(writer, number_buffer, strlen(number_buffer));
+}
+
+CJSON_PUBLIC(void) cJSON_WriterInit(cJSON_Writer *writer, char *buffer, size_t size, cJSON_WriterFlush flush, void *context)
+{
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    memset(writer, 0, sizeof(cJSON_Writer));
+    writer->buffer = buffer;
+    writer->size = (buffer != NULL) ? size : 0;
+    writer->flush = flush;
+    writer->context = context;
+    /* a flush callback can't make room in an empty buffer */
+    writer->failed = (writer->size == 0);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterFinish(cJSON_Writer *writer)
+{
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+    if ((writer->depth != 0) || !(writer->levels[0] & level_has_members))
+    {
+        return fail(writer);
+    }
+
+    if (writer->flush != NULL)
+    {
+        if ((writer->length > 0) && !writer->flush(writer->context, writer->buffer, writer->length))
+        {
+            return fail(writer);
+        }
+        writer->length = 0;
+        return true;
+    }
+
+    if (writer->length >= writer->size)
+    {
+        return fail(writer);
+    }
+    writer->buffer[writer->length] = '\0';
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterStartObject(cJSON_Writer *writer)
+{
+    return start_container(writer, '{', level_object);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterEndObject(cJSON_Writer *writer)
+{
+    return end_container(writer, '}', level_object);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterStartArray(cJSON_Writer *writer)
+{
+    return start_container(writer, '[', 0);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterEndArray(cJSON_Writer *writer)
+{
+    return end_container(writer, ']', 0);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterKey(cJSON_Writer *writer, const char *key)
+{
+    unsigned char *level = NULL;
+
+    if ((writer == NULL) || writer->failed)
+    {
+        return false;
+    }
+
+    level = &writer->levels[writer->depth];
+    if ((key == NULL) || !(*level & level_object) || (*level & level_has_key))
+    {
+        return fail(writer);
+    }
+    if ((*level & level_has_members) && !write_char(writer, ','))
+    {
+        return false;
+    }
+    *level |= level_has_members | level_has_key;
+
+    return write_string(writer, key) && write_char(writer, ':');
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterNull(cJSON_Writer *writer)
+{
+    return begin_value(writer) && write_bytes(writer, "null", 4);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterBool(cJSON_Writer *writer, cJSON_bool boolean)
+{
+    if (!begin_value(writer))
+    {
+        return false;
+    }
+
+    return boolean ? write_bytes(writer, "true", 4) : write_bytes(writer, "false", 5);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterNumber(cJSON_Writer *writer, double number)
+{
+    return begin_value(writer) && write_number(writer, number);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterInt(cJSON_Writer *writer, long number)
+{
+    char number_buffer[sizeof(long) * 3 + 2];
+    char *end = number_buffer + sizeof(number_buffer);
+    char *start = end;
+    /* negating in unsigned arithmetic also works for LONG_MIN */
+    unsigned long magnitude = (number < 0) ? (0UL - (unsigned long)number) : (unsigned long)number;
+
+    if (!begin_value(writer))
+    {
+        return false;
+    }
+
+    do
+    {
+        *--start = (char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (number < 0)
+    {
+        *--start = '-';
+    }
+
+    return write_bytes(writer, start, (size_t)(end - start));
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterString(cJSON_Writer *writer, const char *string)
+{
+    if (string == NULL)
+    {
+        return (writer != NULL) ? fail(writer) : false;
+    }
+
+    return begin_value(writer) && write_string(writer, string);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterRaw(cJSON_Writer *writer, const char *raw)
+{
+    if (raw == NULL)
+    {
+        return (writer != NULL) ? fail(writer) : false;
+    }
+
+    return begin_value(writer) && write_bytes(writer, raw, strlen(raw));
+}
@@ -0,0 +1,88 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef cJSON_Writer__h
+#define cJSON_Writer__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cJSON.h"
+
+/* Streaming writer: emits unformatted JSON event by event, without building a tree of cJSON items and without
+ * allocating. Output goes to a caller supplied buffer. If a flush callback is given, the buffer is handed to it
+ * whenever it is full, so documents can be larger than the buffer. */
+
+/* How deeply arrays/objects can be nested in a written document. */
+#ifndef CJSON_WRITER_NESTING_LIMIT
+#define CJSON_WRITER_NESTING_LIMIT 32
+#endif
+
+/* Receives length bytes of output. Returns 0 to abort writing. */
+typedef cJSON_bool (*cJSON_WriterFlush)(void *context, const char *data, size_t length);
+
+typedef struct cJSON_Writer
+{
+    char *buffer;
+    size_t size;
+    /* number of bytes in buffer that haven't been flushed */
+    size_t length;
+    /* number of bytes written since cJSON_WriterInit, including flushed ones */
+    size_t written;
+    cJSON_WriterFlush flush;
+    void *context;
+    size_t depth;
+    unsigned char levels[CJSON_WRITER_NESTING_LIMIT + 1];
+    cJSON_bool failed;
+} cJSON_Writer;
+
+/* Without a flush callback, the whole document has to fit into buffer, including the terminating zero added by cJSON_WriterFinish. */
+CJSON_PUBLIC(void) cJSON_WriterInit(cJSON_Writer *writer, char *buffer, size_t size, cJSON_WriterFlush flush, void *context);
+/* Checks that all arrays and objects were closed and flushes the rest of the output.
+ * Without a flush callback, the output is zero terminated and writer->written is its length.
+ * Returns 0 if any call since cJSON_WriterInit failed. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterFinish(cJSON_Writer *writer);
+
+/* Every function returns 0 on failure, e.g. if the output doesn't fit or the call is not valid at this point of
+ * the document. A failure is sticky, so it is enough to check the result of cJSON_WriterFinish. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterStartObject(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterEndObject(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterStartArray(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterEndArray(cJSON_Writer *writer);
+/* Inside an object, every value has to be preceded by its key. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterKey(cJSON_Writer *writer, const char *key);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterNull(cJSON_Writer *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterBool(cJSON_Writer *writer, cJSON_bool boolean);
+/* Numbers are written with as few digits as needed to read back the same double. NaN and infinity are written as null, like cJSON_Print does. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterNumber(cJSON_Writer *writer, double number);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterInt(cJSON_Writer *writer, long number);
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterString(cJSON_Writer *writer, const char *string);
+/* Writes raw JSON as it is, the caller is responsible for it being valid. */
+CJSON_PUBLIC(cJSON_bool) cJSON_WriterRaw(cJSON_Writer *writer, const char *raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Compares parsing the example inputs on the heap and in an arena.
+ * Run from the build directory of the tests, so that inputs/ is found. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+
+#define ITERATIONS 20000
+
+static size_t allocations = 0;
+
+static void * CJSON_CDECL counting_malloc(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+static void CJSON_CDECL normal_free(void *pointer)
+{
+    free(pointer);
+}
+
+static cJSON_Hooks counting_hooks = {
+    counting_malloc,
+    normal_free
+};
+
+static double arena_memory[4096];
+
+static double elapsed_us(clock_t start, clock_t end)
+{
+    return (double)(end - start) * 1e6 / CLOCKS_PER_SEC / ITERATIONS;
+}
+
+int CJSON_CDECL main(void)
+{
+    const char *inputs[] = { "test1", "test2", "test3", "test4", "test5", "test7", "test8", "test9", "test10", "test11" };
+    cJSON_Arena arena;
+    size_t i = 0;
+
+    cJSON_InitArena(&arena, arena_memory, sizeof(arena_memory));
+    cJSON_InitHooks(&counting_hooks);
+
+    printf("%-8s %6s %12s %12s %12s %12s %12s\n", "input", "bytes", "heap allocs", "arena allocs", "arena bytes", "heap us", "arena us");
+    for (i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    {
+        char path[64];
+        char *content = NULL;
+        size_t heap_allocations = 0;
+        size_t arena_allocations = 0;
+        size_t arena_used = 0;
+        clock_t start = 0;
+        clock_t heap_end = 0;
+        clock_t arena_end = 0;
+        int iteration = 0;
+
+        sprintf(path, "inputs/%s", inputs[i]);
+        content = read_file(path);
+        if (content == NULL)
+        {
+            fprintf(stderr, "Failed to read %s\n", path);
+            return EXIT_FAILURE;
+        }
+
+        allocations = 0;
+        start = clock();
+        for (iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            cJSON_Delete(cJSON_Parse(content));
+        }
+        heap_end = clock();
+        heap_allocations = allocations / ITERATIONS;
+
+        allocations = 0;
+        for (iteration = 0; iteration < ITERATIONS; iteration++)
+        {
+            cJSON_ResetArena(&arena);
+            if (cJSON_ParseWithArena(&arena, content) == NULL)
+            {
+                fprintf(stderr, "Failed to parse %s\n", path);
+                return EXIT_FAILURE;
+            }
+        }
+        arena_end = clock();
+        arena_allocations = allocations / ITERATIONS;
+        arena_used = arena.used;
+
+        printf("%-8s %6lu %12lu %12lu %12lu %12.2f %12.2f\n", inputs[i], (unsigned long)strlen(content),
+               (unsigned long)heap_allocations, (unsigned long)arena_allocations, (unsigned long)arena_used,
+               elapsed_us(start, heap_end), elapsed_us(heap_end, arena_end));
+        free(content);
+    }
+
+    cJSON_InitHooks(NULL);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+static size_t allocations = 0;
+static size_t deallocations = 0;
+
+static void * CJSON_CDECL counting_malloc(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+static void CJSON_CDECL counting_free(void *pointer)
+{
+    deallocations++;
+    free(pointer);
+}
+
+static cJSON_Hooks counting_hooks = {
+    counting_malloc,
+    counting_free
+};
+
+static double arena_memory[4096];
+static cJSON_Arena arena;
+
+static void compare_with_heap_parse(const char *test_name)
+{
+    char path[64];
+    char *content = NULL;
+    cJSON *heap_tree = NULL;
+    cJSON *arena_tree = NULL;
+    char *heap_printed = NULL;
+    char *arena_printed = NULL;
+
+    sprintf(path, "inputs/%s", test_name);
+    content = read_file(path);
+    TEST_ASSERT_NOT_NULL_MESSAGE(content, "Failed to read test input.");
+
+    heap_tree = cJSON_Parse(content);
+    TEST_ASSERT_NOT_NULL(heap_tree);
+
+    cJSON_ResetArena(&arena);
+    cJSON_InitHooks(&counting_hooks);
+    allocations = 0;
+    arena_tree = cJSON_ParseWithArena(&arena, content);
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(0, allocations, "Parsing into an arena must not allocate.");
+    cJSON_InitHooks(NULL);
+    TEST_ASSERT_NOT_NULL(arena_tree);
+    TEST_ASSERT_BITS_HIGH(cJSON_InArena, arena_tree->type);
+
+    heap_printed = cJSON_Print(heap_tree);
+    arena_printed = cJSON_Print(arena_tree);
+    TEST_ASSERT_EQUAL_STRING(heap_printed, arena_printed);
+    TEST_ASSERT_TRUE(cJSON_Compare(heap_tree, arena_tree, true));
+
+    free(content);
+    free(heap_printed);
+    free(arena_printed);
+    cJSON_Delete(heap_tree);
+}
+
+static void arena_should_parse_examples(void)
+{
+    compare_with_heap_parse("test1");
+    compare_with_heap_parse("test2");
+    compare_with_heap_parse("test3");
+    compare_with_heap_parse("test4");
+    compare_with_heap_parse("test5");
+    compare_with_heap_parse("test7");
+    compare_with_heap_parse("test8");
+    compare_with_heap_parse("test9");
+    compare_with_heap_parse("test10");
+    compare_with_heap_parse("test11");
+}
+
+static void arena_should_align_items(void)
+{
+    cJSON *array = NULL;
+    cJSON *item = NULL;
+
+    cJSON_ResetArena(&arena);
+    array = cJSON_ParseWithArena(&arena, "[\"a\", 1, \"bc\", 2.5, \"def\", null]");
+    TEST_ASSERT_NOT_NULL(array);
+
+    cJSON_ArrayForEach(item, array)
+    {
+        TEST_ASSERT_EQUAL_UINT(0, (size_t)item % sizeof(double));
+    }
+}
+
+static void arena_parse_should_give_back_memory_on_failure(void)
+{
+    unsigned char small_buffer[sizeof(cJSON) * 3];
+    cJSON_Arena small_arena;
+    const char *end = NULL;
+
+    cJSON_InitArena(&small_arena, small_buffer, sizeof(small_buffer));
+    small_arena.used = 8;
+
+    /* runs out of arena memory */
+    TEST_ASSERT_NULL(cJSON_ParseWithArena(&small_arena, "[1, 2, 3, 4, 5]"));
+    TEST_ASSERT_EQUAL_UINT(8, small_arena.used);
+
+    /* invalid JSON */
+    TEST_ASSERT_NULL(cJSON_ParseWithArenaOpts(&small_arena, "[1, }", 6, &end, false));
+    TEST_ASSERT_EQUAL_UINT(8, small_arena.used);
+    TEST_ASSERT_EQUAL_STRING(", }", end);
+
+    TEST_ASSERT_NOT_NULL(cJSON_ParseWithArena(&small_arena, "[1]"));
+}
+
+static void arena_should_fail_without_memory(void)
+{
+    cJSON_Arena empty_arena;
+
+    cJSON_InitArena(&empty_arena, NULL, 100);
+    TEST_ASSERT_EQUAL_UINT(0, empty_arena.size);
+
+    TEST_ASSERT_NULL(cJSON_ParseWithArena(NULL, "{}"));
+    TEST_ASSERT_NULL(cJSON_ParseWithArena(&empty_arena, "{}"));
+    TEST_ASSERT_NULL(cJSON_ParseWithArena(&arena, NULL));
+    TEST_ASSERT_NULL(cJSON_CreateObjectInArena(NULL));
+    TEST_ASSERT_NULL(cJSON_CreateObjectInArena(&empty_arena));
+}
+
+static void arena_should_build_documents(void)
+{
+    cJSON *root = NULL;
+    cJSON *samples = NULL;
+    char *printed = NULL;
+    size_t used = 0;
+
+    cJSON_ResetArena(&arena);
+    cJSON_InitHooks(&counting_hooks);
+    allocations = 0;
+
+    root = cJSON_CreateObjectInArena(&arena);
+    TEST_ASSERT_NOT_NULL(root);
+    TEST_ASSERT_NOT_NULL(cJSON_AddStringToObjectInArena(&arena, root, "device", "sensor-1"));
+    TEST_ASSERT_NOT_NULL(cJSON_AddNumberToObjectInArena(&arena, root, "uptime", 1234));
+    TEST_ASSERT_NOT_NULL(cJSON_AddBoolToObjectInArena(&arena, root, "charging", true));
+    TEST_ASSERT_NOT_NULL(cJSON_AddNullToObjectInArena(&arena, root, "error"));
+    TEST_ASSERT_NOT_NULL(cJSON_AddObjectToObjectInArena(&arena, root, "config"));
+    samples = cJSON_AddArrayToObjectInArena(&arena, root, "samples");
+    TEST_ASSERT_NOT_NULL(samples);
+    TEST_ASSERT_TRUE(cJSON_AddItemToArray(samples, cJSON_CreateNumberInArena(&arena, 1.5)));
+    TEST_ASSERT_TRUE(cJSON_AddItemToArray(samples, cJSON_CreateStringInArena(&arena, "x")));
+    TEST_ASSERT_TRUE(cJSON_AddItemToArray(samples, cJSON_CreateArrayInArena(&arena)));
+
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(0, allocations, "Building in an arena must not allocate.");
+    cJSON_InitHooks(NULL);
+
+    printed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT_EQUAL_STRING("{\"device\":\"sensor-1\",\"uptime\":1234,\"charging\":true,\"error\":null,\"config\":{},\"samples\":[1.5,\"x\",[]]}", printed);
+    free(printed);
+
+    /* nothing is taken from the arena if an item can't be added */
+    used = arena.used;
+    TEST_ASSERT_NULL(cJSON_AddStringToObjectInArena(&arena, NULL, "name", "value"));
+    TEST_ASSERT_NULL(cJSON_AddStringToObjectInArena(&arena, root, "name", NULL));
+    TEST_ASSERT_EQUAL_UINT(used, arena.used);
+
+    cJSON_ResetArena(&arena);
+    TEST_ASSERT_EQUAL_UINT(0, arena.used);
+}
+
+static void arena_items_should_not_mix_keys_with_heap(void)
+{
+    cJSON *arena_object = NULL;
+    cJSON *heap_object = NULL;
+    cJSON *arena_item = NULL;
+    cJSON *heap_item = NULL;
+
+    cJSON_ResetArena(&arena);
+    arena_object = cJSON_CreateObjectInArena(&arena);
+    arena_item = cJSON_CreateNumberInArena(&arena, 1);
+    heap_object = cJSON_CreateObject();
+    heap_item = cJSON_CreateNumber(2);
+
+    TEST_ASSERT_FALSE(cJSON_AddItemToObject(heap_object, "arena", arena_item));
+    TEST_ASSERT_FALSE(cJSON_AddItemToObjectInArena(&arena, arena_object, "heap", heap_item));
+    TEST_ASSERT_FALSE(cJSON_ReplaceItemInObject(arena_object, "arena", arena_item));
+
+    /* constant keys and arrays work either way */
+    TEST_ASSERT_TRUE(cJSON_AddItemToObjectCS(heap_object, "arena", arena_item));
+    TEST_ASSERT_TRUE(cJSON_AddItemToObject(arena_object, "heap", heap_item));
+
+    cJSON_InitHooks(&counting_hooks);
+    deallocations = 0;
+    cJSON_Delete(heap_object);
+    /* the object itself, heap_item stays with the arena object */
+    TEST_ASSERT_EQUAL_UINT(1, deallocations);
+    deallocations = 0;
+    cJSON_Delete(arena_object);
+    /* heap_item and its key */
+    TEST_ASSERT_EQUAL_UINT(2, deallocations);
+    cJSON_InitHooks(NULL);
+}
+
+static void arena_set_valuestring_should_only_shrink(void)
+{
+    cJSON *string = NULL;
+
+    cJSON_ResetArena(&arena);
+    string = cJSON_CreateStringInArena(&arena, "abc");
+    TEST_ASSERT_NOT_NULL(string);
+
+    TEST_ASSERT_NOT_NULL(cJSON_SetValuestring(string, "ab"));
+    TEST_ASSERT_EQUAL_STRING("ab", string->valuestring);
+    TEST_ASSERT_NULL(cJSON_SetValuestring(string, "abcd"));
+    TEST_ASSERT_EQUAL_STRING("ab", string->valuestring);
+}
+
+static void arena_duplicate_should_be_on_heap(void)
+{
+    cJSON *tree = NULL;
+    cJSON *copy = NULL;
+
+    cJSON_ResetArena(&arena);
+    tree = cJSON_ParseWithArena(&arena, "{\"a\":[1,\"b\"],\"c\":{\"d\":null}}");
+    TEST_ASSERT_NOT_NULL(tree);
+
+    copy = cJSON_Duplicate(tree, true);
+    TEST_ASSERT_NOT_NULL(copy);
+    TEST_ASSERT_BITS_LOW(cJSON_InArena, copy->type);
+    TEST_ASSERT_BITS_LOW(cJSON_InArena, copy->child->child->next->type);
+
+    cJSON_ResetArena(&arena);
+    memset(arena_memory, 0, sizeof(arena_memory));
+    TEST_ASSERT_EQUAL_STRING("b", cJSON_GetArrayItem(cJSON_GetObjectItem(copy, "a"), 1)->valuestring);
+
+    cJSON_Delete(copy);
+}
+
+static void arena_reference_should_be_on_heap(void)
+{
+    cJSON *tree = NULL;
+    cJSON *heap_object = NULL;
+
+    cJSON_ResetArena(&arena);
+    tree = cJSON_ParseWithArena(&arena, "{\"a\":\"b\"}");
+    TEST_ASSERT_NOT_NULL(tree);
+
+    heap_object = cJSON_CreateObject();
+    TEST_ASSERT_TRUE(cJSON_AddItemReferenceToObject(heap_object, "ref", tree));
+    TEST_ASSERT_BITS_LOW(cJSON_InArena, heap_object->child->type);
+
+    cJSON_InitHooks(&counting_hooks);
+    deallocations = 0;
+    cJSON_Delete(heap_object);
+    /* object, reference and its key */
+    TEST_ASSERT_EQUAL_UINT(3, deallocations);
+    cJSON_InitHooks(NULL);
+}
+
+int CJSON_CDECL main(void)
+{
+    cJSON_InitArena(&arena, arena_memory, sizeof(arena_memory));
+
+    UNITY_BEGIN();
+
+    RUN_TEST(arena_should_parse_examples);
+    RUN_TEST(arena_should_align_items);
+    RUN_TEST(arena_parse_should_give_back_memory_on_failure);
+    RUN_TEST(arena_should_fail_without_memory);
+    RUN_TEST(arena_should_build_documents);
+    RUN_TEST(arena_items_should_not_mix_keys_with_heap);
+    RUN_TEST(arena_set_valuestring_should_only_shrink);
+    RUN_TEST(arena_duplicate_should_be_on_heap);
+    RUN_TEST(arena_reference_should_be_on_heap);
+
+    return UNITY_END();
+}
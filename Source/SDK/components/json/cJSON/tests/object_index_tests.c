@@ -0,0 +1,359 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+static cJSON *create_object(int members)
+{
+    cJSON *object = cJSON_CreateObject();
+    char key[16];
+    int i = 0;
+
+    TEST_ASSERT_NOT_NULL(object);
+    for (i = 0; i < members; i++)
+    {
+        sprintf(key, "Key%d", i);
+        TEST_ASSERT_NOT_NULL(cJSON_AddNumberToObject(object, key, i));
+    }
+
+    return object;
+}
+
+/* The linear search cJSON does without an index */
+static cJSON *linear_search(const cJSON *object, const char *name, cJSON_bool case_sensitive)
+{
+    cJSON *member = NULL;
+    for (member = object->child; member != NULL; member = member->next)
+    {
+        if (case_sensitive ? (strcmp(name, member->string) == 0) : (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)member->string) == 0))
+        {
+            return member;
+        }
+    }
+
+    return NULL;
+}
+
+static void assert_lookups_match_linear_search(const cJSON *object, int members)
+{
+    char key[16];
+    int i = 0;
+
+    for (i = 0; i < members + 10; i++)
+    {
+        sprintf(key, "Key%d", i);
+        TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, key) == linear_search(object, key, true));
+        TEST_ASSERT_TRUE(cJSON_GetObjectItem(object, key) == linear_search(object, key, false));
+        sprintf(key, "kEY%d", i);
+        TEST_ASSERT_NULL(cJSON_GetObjectItemCaseSensitive(object, key));
+        TEST_ASSERT_TRUE(cJSON_GetObjectItem(object, key) == linear_search(object, key, false));
+    }
+}
+
+static void small_objects_should_not_be_indexed(void)
+{
+    cJSON *object = create_object(CJSON_OBJECT_INDEX_THRESHOLD - 1);
+
+    assert_lookups_match_linear_search(object, CJSON_OBJECT_INDEX_THRESHOLD - 1);
+    TEST_ASSERT_NULL(object->member_index);
+
+    cJSON_Delete(object);
+}
+
+static void large_objects_should_be_indexed(void)
+{
+    cJSON *object = create_object(1000);
+
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItemCaseSensitive(object, "Key999"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+    assert_lookups_match_linear_search(object, 1000);
+
+    cJSON_Delete(object);
+}
+
+static void parsed_objects_should_be_indexed(void)
+{
+    cJSON *object = NULL;
+    char json[64 * 40] = "{";
+    int i = 0;
+
+    for (i = 0; i < 40; i++)
+    {
+        sprintf(json + strlen(json), "%s\"Key%d\":%d", (i > 0) ? "," : "", i, i);
+    }
+    strcat(json, "}");
+    object = cJSON_Parse(json);
+    TEST_ASSERT_NOT_NULL(object);
+
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+    assert_lookups_match_linear_search(object, 40);
+
+    cJSON_Delete(object);
+}
+
+static void index_should_return_first_of_duplicate_keys(void)
+{
+    cJSON *object = create_object(100);
+    cJSON *first = NULL;
+    int i = 0;
+
+    /* appended while the index exists */
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+    first = cJSON_AddNullToObject(object, "dup");
+    for (i = 0; i < 50; i++)
+    {
+        cJSON_AddNullToObject(object, (i % 2) ? "DUP" : "dup");
+    }
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, "dup") == first);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(object, "DUP") == first);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, "DUP") == first->next->next);
+
+    /* rebuilt from the list */
+    cJSON_ResetObjectIndex(object);
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, "dup") == first);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(object, "DUP") == first);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, "DUP") == first->next->next);
+
+    cJSON_Delete(object);
+}
+
+static void index_should_follow_added_members(void)
+{
+    cJSON *object = create_object(20);
+    char key[16];
+    int i = 0;
+
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+
+    /* lookup before each add, the index has to grow several times */
+    for (i = 20; i < 2000; i++)
+    {
+        sprintf(key, "Key%d", i);
+        TEST_ASSERT_NULL(cJSON_GetObjectItemCaseSensitive(object, key));
+        TEST_ASSERT_NOT_NULL(cJSON_AddNumberToObject(object, key, i));
+        TEST_ASSERT_NOT_NULL(object->member_index);
+    }
+    assert_lookups_match_linear_search(object, 2000);
+
+    cJSON_Delete(object);
+}
+
+static void index_should_follow_removed_and_replaced_members(void)
+{
+    cJSON *object = create_object(100);
+    cJSON *replacement = NULL;
+
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+
+    cJSON_DeleteItemFromObjectCaseSensitive(object, "Key50");
+    TEST_ASSERT_NULL(cJSON_GetObjectItemCaseSensitive(object, "Key50"));
+    assert_lookups_match_linear_search(object, 100);
+
+    replacement = cJSON_CreateString("replaced");
+    TEST_ASSERT_TRUE(cJSON_ReplaceItemInObjectCaseSensitive(object, "Key60", replacement));
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, "Key60") == replacement);
+    assert_lookups_match_linear_search(object, 100);
+
+    replacement = cJSON_CreateString("inserted");
+    replacement->string = (char*)cJSON_strdup((const unsigned char*)"Key70", &global_hooks);
+    TEST_ASSERT_TRUE(cJSON_InsertItemInArray(object, 0, replacement));
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, "Key70") == replacement);
+    assert_lookups_match_linear_search(object, 100);
+
+    cJSON_Delete(object);
+}
+
+static void index_should_not_return_detached_members(void)
+{
+    cJSON *object = create_object(100);
+    cJSON *other = create_object(100);
+    cJSON *detached = NULL;
+    cJSON *added = NULL;
+
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(other, "missing"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+    TEST_ASSERT_NOT_NULL(other->member_index);
+
+    /* a freed member must not be found again */
+    detached = cJSON_DetachItemFromObject(object, "Key10");
+    TEST_ASSERT_NOT_NULL(detached);
+    cJSON_Delete(detached);
+    TEST_ASSERT_NULL(cJSON_GetObjectItemCaseSensitive(object, "Key10"));
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "key10"));
+    assert_lookups_match_linear_search(object, 100);
+
+    /* a member moved to another object is only found there */
+    detached = cJSON_DetachItemViaPointer(object, cJSON_GetObjectItemCaseSensitive(object, "Key20"));
+    TEST_ASSERT_NOT_NULL(detached);
+    TEST_ASSERT_TRUE(cJSON_AddItemToObject(other, "Moved", detached));
+    TEST_ASSERT_NULL(cJSON_GetObjectItemCaseSensitive(object, "Key20"));
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(other, "Moved") == detached);
+    assert_lookups_match_linear_search(object, 100);
+    assert_lookups_match_linear_search(other, 100);
+
+    /* a deleted key added again is the new member */
+    cJSON_DeleteItemFromObject(object, "Key30");
+    added = cJSON_AddStringToObject(object, "Key30", "again");
+    TEST_ASSERT_NOT_NULL(added);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, "Key30") == added);
+    TEST_ASSERT_TRUE(cJSON_GetObjectItem(object, "KEY30") == added);
+    assert_lookups_match_linear_search(object, 100);
+
+    /* replaced members are freed */
+    TEST_ASSERT_TRUE(cJSON_ReplaceItemInObject(object, "Key40", cJSON_CreateTrue()));
+    TEST_ASSERT_TRUE(cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(object, "Key40")));
+    added = cJSON_CreateFalse();
+    added->string = (char*)cJSON_strdup((const unsigned char*)"Key40", &global_hooks);
+    TEST_ASSERT_TRUE(cJSON_ReplaceItemViaPointer(object, cJSON_GetObjectItemCaseSensitive(object, "Key40"), added));
+    TEST_ASSERT_TRUE(cJSON_IsFalse(cJSON_GetObjectItemCaseSensitive(object, "Key40")));
+    assert_lookups_match_linear_search(object, 100);
+
+    /* deleting the members one by one, the index is rebuilt on the way */
+    while (object->child != NULL)
+    {
+        char key[64];
+        strcpy(key, object->child->string);
+        cJSON_DeleteItemFromObjectCaseSensitive(object, key);
+        TEST_ASSERT_TRUE(cJSON_GetObjectItemCaseSensitive(object, key) == linear_search(object, key, true));
+        assert_lookups_match_linear_search(object, 100);
+    }
+
+    cJSON_Delete(other);
+    cJSON_Delete(object);
+}
+
+static void objects_with_keyless_members_should_not_be_indexed(void)
+{
+    cJSON *object = create_object(100);
+
+    cJSON_AddItemToArray(object, cJSON_CreateNull());
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NULL(object->member_index);
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(object, "Key99"));
+
+    /* appending one drops the index */
+    cJSON_DeleteItemFromArray(object, 100);
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+    TEST_ASSERT_NOT_NULL(object->member_index);
+    cJSON_AddItemToArray(object, cJSON_CreateNull());
+    TEST_ASSERT_NULL(object->member_index);
+
+    cJSON_Delete(object);
+}
+
+static void references_and_arrays_should_not_be_indexed(void)
+{
+    cJSON *object = create_object(100);
+    cJSON *reference = cJSON_CreateObjectReference(object->child);
+    cJSON *array = cJSON_CreateArray();
+
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(reference, "Key99"));
+    TEST_ASSERT_NULL(reference->member_index);
+
+    cJSON_AddItemToArray(array, cJSON_Duplicate(object, true));
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(array, "Key99"));
+    TEST_ASSERT_NULL(array->member_index);
+
+    cJSON_Delete(reference);
+    cJSON_Delete(array);
+    cJSON_Delete(object);
+}
+
+static double lookup_time(const cJSON *object, int members, int rounds)
+{
+    char (*keys)[16] = (char (*)[16])malloc((size_t)members * 16);
+    clock_t start = 0;
+    int round = 0;
+    int i = 0;
+
+    TEST_ASSERT_NOT_NULL(keys);
+    for (i = 0; i < members; i++)
+    {
+        sprintf(keys[i], "Key%d", i);
+    }
+
+    start = clock();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < members; i++)
+        {
+            TEST_ASSERT_NOT_NULL(cJSON_GetObjectItemCaseSensitive(object, keys[i]));
+        }
+    }
+    free(keys);
+
+    /* nanoseconds per lookup */
+    return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / rounds / members;
+}
+
+static void lookup_timing_with_and_without_index(void)
+{
+    static const int sizes[] = { 10, 100, 1000 };
+    size_t i = 0;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        int rounds = 2000000 / sizes[i] / (sizes[i] > 100 ? 10 : 1);
+        cJSON *object = create_object(sizes[i]);
+        /* lookups through a reference walk the members, it is never indexed */
+        cJSON *reference = cJSON_CreateObjectReference(object->child);
+        double linear = lookup_time(reference, sizes[i], rounds);
+        double indexed = lookup_time(object, sizes[i], rounds);
+
+        printf("%4d members: %8.1f ns per lookup without index, %6.1f ns with index%s\n", sizes[i], linear, indexed,
+               (object->member_index == NULL) ? " (not indexed)" : "");
+        cJSON_Delete(reference);
+        cJSON_Delete(object);
+    }
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(small_objects_should_not_be_indexed);
+    RUN_TEST(large_objects_should_be_indexed);
+    RUN_TEST(parsed_objects_should_be_indexed);
+    RUN_TEST(index_should_return_first_of_duplicate_keys);
+    RUN_TEST(index_should_follow_added_members);
+    RUN_TEST(index_should_follow_removed_and_replaced_members);
+    RUN_TEST(index_should_not_return_detached_members);
+    RUN_TEST(objects_with_keyless_members_should_not_be_indexed);
+    RUN_TEST(references_and_arrays_should_not_be_indexed);
+    RUN_TEST(lookup_timing_with_and_without_index);
+
+    return UNITY_END();
+}
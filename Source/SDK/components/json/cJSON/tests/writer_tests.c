@@ -0,0 +1,356 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+#include "../cJSON_Writer.h"
+
+static char buffer[512];
+static cJSON_Writer writer;
+
+static char flushed[512];
+static size_t flushed_length = 0;
+static size_t flush_calls = 0;
+
+static cJSON_bool CJSON_CDECL collect(void *context, const char *data, size_t length)
+{
+    (void)context;
+    if (flushed_length + length > sizeof(flushed) - 1)
+    {
+        return false;
+    }
+    memcpy(flushed + flushed_length, data, length);
+    flushed_length += length;
+    flushed[flushed_length] = '\0';
+    flush_calls++;
+    return true;
+}
+
+static cJSON_bool CJSON_CDECL refuse(void *context, const char *data, size_t length)
+{
+    (void)context;
+    (void)data;
+    (void)length;
+    return false;
+}
+
+static void write_status(cJSON_Writer *status_writer)
+{
+    cJSON_WriterStartObject(status_writer);
+    cJSON_WriterKey(status_writer, "device");
+    cJSON_WriterString(status_writer, "sensor \"1\"\n");
+    cJSON_WriterKey(status_writer, "uptime");
+    cJSON_WriterInt(status_writer, 1234);
+    cJSON_WriterKey(status_writer, "voltage");
+    cJSON_WriterNumber(status_writer, 3.3);
+    cJSON_WriterKey(status_writer, "charging");
+    cJSON_WriterBool(status_writer, true);
+    cJSON_WriterKey(status_writer, "error");
+    cJSON_WriterNull(status_writer);
+    cJSON_WriterKey(status_writer, "config");
+    cJSON_WriterStartObject(status_writer);
+    cJSON_WriterEndObject(status_writer);
+    cJSON_WriterKey(status_writer, "samples");
+    cJSON_WriterStartArray(status_writer);
+    cJSON_WriterNumber(status_writer, -0.5);
+    cJSON_WriterRaw(status_writer, "{\"raw\":1}");
+    cJSON_WriterStartArray(status_writer);
+    cJSON_WriterEndArray(status_writer);
+    cJSON_WriterString(status_writer, "\x01");
+    cJSON_WriterEndArray(status_writer);
+    cJSON_WriterEndObject(status_writer);
+}
+
+#define expected_status "{\"device\":\"sensor \\\"1\\\"\\n\",\"uptime\":1234,\"voltage\":3.3,\"charging\":true,\"error\":null,\"config\":{},\"samples\":[-0.5,{\"raw\":1},[],\"\\u0001\"]}"
+
+static void writer_should_write_documents(void)
+{
+    cJSON *tree = NULL;
+    char *printed = NULL;
+
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    write_status(&writer);
+    TEST_ASSERT_TRUE(cJSON_WriterFinish(&writer));
+    TEST_ASSERT_EQUAL_STRING(expected_status, buffer);
+    TEST_ASSERT_EQUAL_UINT(strlen(expected_status), writer.written);
+
+    /* cJSON reads it back and prints the same */
+    tree = cJSON_Parse(buffer);
+    TEST_ASSERT_NOT_NULL(tree);
+    printed = cJSON_PrintUnformatted(tree);
+    TEST_ASSERT_EQUAL_STRING(buffer, printed);
+    free(printed);
+    cJSON_Delete(tree);
+}
+
+static void writer_should_flush_through_small_buffer(void)
+{
+    char small_buffer[7];
+
+    flushed_length = 0;
+    flush_calls = 0;
+    cJSON_WriterInit(&writer, small_buffer, sizeof(small_buffer), collect, NULL);
+    write_status(&writer);
+    TEST_ASSERT_TRUE(cJSON_WriterFinish(&writer));
+    TEST_ASSERT_EQUAL_STRING(expected_status, flushed);
+    TEST_ASSERT_EQUAL_UINT(strlen(expected_status), writer.written);
+    TEST_ASSERT_EQUAL_UINT((strlen(expected_status) + sizeof(small_buffer) - 1) / sizeof(small_buffer), flush_calls);
+}
+
+static void writer_should_fail_when_output_does_not_fit(void)
+{
+    size_t size = 0;
+
+    /* without a flush callback the terminating zero has to fit as well */
+    for (size = 1; size <= strlen(expected_status); size++)
+    {
+        cJSON_WriterInit(&writer, buffer, size, NULL, NULL);
+        write_status(&writer);
+        TEST_ASSERT_FALSE(cJSON_WriterFinish(&writer));
+    }
+    cJSON_WriterInit(&writer, buffer, size, NULL, NULL);
+    write_status(&writer);
+    TEST_ASSERT_TRUE(cJSON_WriterFinish(&writer));
+
+    cJSON_WriterInit(&writer, buffer, 4, refuse, NULL);
+    write_status(&writer);
+    TEST_ASSERT_FALSE(cJSON_WriterFinish(&writer));
+
+    cJSON_WriterInit(&writer, NULL, 10, collect, NULL);
+    TEST_ASSERT_FALSE(cJSON_WriterNull(&writer));
+}
+
+static void writer_should_reject_invalid_structure(void)
+{
+    int depth = 0;
+
+    /* value without a key */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterStartObject(&writer));
+    TEST_ASSERT_FALSE(cJSON_WriterNull(&writer));
+    /* failures are sticky */
+    TEST_ASSERT_FALSE(cJSON_WriterKey(&writer, "a"));
+    TEST_ASSERT_FALSE(cJSON_WriterFinish(&writer));
+
+    /* key in an array */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterStartArray(&writer));
+    TEST_ASSERT_FALSE(cJSON_WriterKey(&writer, "a"));
+
+    /* two keys in a row */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterStartObject(&writer));
+    TEST_ASSERT_TRUE(cJSON_WriterKey(&writer, "a"));
+    TEST_ASSERT_FALSE(cJSON_WriterKey(&writer, "b"));
+
+    /* key without a value */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterStartObject(&writer));
+    TEST_ASSERT_TRUE(cJSON_WriterKey(&writer, "a"));
+    TEST_ASSERT_FALSE(cJSON_WriterEndObject(&writer));
+
+    /* mismatched end */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterStartObject(&writer));
+    TEST_ASSERT_FALSE(cJSON_WriterEndArray(&writer));
+
+    /* unclosed container, empty document and two top level values */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterStartArray(&writer));
+    TEST_ASSERT_FALSE(cJSON_WriterFinish(&writer));
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_FALSE(cJSON_WriterFinish(&writer));
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterNull(&writer));
+    TEST_ASSERT_FALSE(cJSON_WriterNull(&writer));
+
+    /* NULL strings */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_FALSE(cJSON_WriterString(&writer, NULL));
+    TEST_ASSERT_FALSE(cJSON_WriterString(NULL, "a"));
+
+    /* nesting limit */
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    for (depth = 0; depth < CJSON_WRITER_NESTING_LIMIT; depth++)
+    {
+        TEST_ASSERT_TRUE(cJSON_WriterStartArray(&writer));
+    }
+    TEST_ASSERT_FALSE(cJSON_WriterStartArray(&writer));
+}
+
+static void assert_number_reads_back(double number)
+{
+    double read = 0.0;
+    char reference[32];
+
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterNumber(&writer, number));
+    TEST_ASSERT_TRUE(cJSON_WriterFinish(&writer));
+
+    TEST_ASSERT_EQUAL_INT(1, sscanf(buffer, "%lg", &read));
+    TEST_ASSERT_TRUE_MESSAGE(read == number, buffer);
+
+    /* no longer than the shorter of %1.15g and %1.17g that reads back exactly. cJSON_Print isn't the reference,
+     * it compares with a tolerance and may print a %1.15g that reads back as a slightly different number. */
+    sprintf(reference, "%1.15g", number);
+    if ((sscanf(reference, "%lg", &read) != 1) || (read != number))
+    {
+        sprintf(reference, "%1.17g", number);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(strlen(buffer) <= strlen(reference), buffer);
+}
+
+static void assert_number_is_written_as(double number, const char *expected)
+{
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_WriterNumber(&writer, number));
+    TEST_ASSERT_TRUE(cJSON_WriterFinish(&writer));
+    TEST_ASSERT_EQUAL_STRING(expected, buffer);
+}
+
+static void writer_should_write_numbers(void)
+{
+    unsigned int seed = 42;
+    int i = 0;
+
+    assert_number_is_written_as(0, "0");
+    assert_number_is_written_as(-0.0, "0");
+    assert_number_is_written_as(1, "1");
+    assert_number_is_written_as(-1, "-1");
+    assert_number_is_written_as(0.05, "0.05");
+    assert_number_is_written_as(-123.456, "-123.456");
+    assert_number_is_written_as(1000000001, "1000000001");
+    assert_number_is_written_as(9007199254740991.0, "9007199254740991");
+    assert_number_is_written_as(23.000000001, "23.000000001");
+    assert_number_is_written_as(0.1 + 0.2, "0.30000000000000004");
+    assert_number_is_written_as(1e300, "1e+300");
+    assert_number_is_written_as(1.5e-12, "1.5e-12");
+
+    /* NaN and infinity */
+    assert_number_is_written_as(NAN, "null");
+    assert_number_is_written_as(1e308 * 10.0, "null");
+
+    for (i = 0; i < 10000; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        assert_number_reads_back((double)(int)(seed >> 8) / 1000.0 - 4000.0);
+        assert_number_reads_back((double)seed / 3.0);
+        assert_number_reads_back((double)(seed >> 4) * 1e-7);
+    }
+}
+
+static void writer_should_write_ints(void)
+{
+    char expected[64];
+
+    cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+    cJSON_WriterStartArray(&writer);
+    cJSON_WriterInt(&writer, 0);
+    cJSON_WriterInt(&writer, -7);
+    cJSON_WriterInt(&writer, LONG_MAX);
+    cJSON_WriterInt(&writer, LONG_MIN);
+    cJSON_WriterEndArray(&writer);
+    TEST_ASSERT_TRUE(cJSON_WriterFinish(&writer));
+
+    sprintf(expected, "[0,-7,%ld,%ld]", LONG_MAX, LONG_MIN);
+    TEST_ASSERT_EQUAL_STRING(expected, buffer);
+}
+
+static void writer_timing_compared_to_printing_a_tree(void)
+{
+    const int iterations = 20000;
+    clock_t start = 0;
+    clock_t tree_end = 0;
+    clock_t writer_end = 0;
+    int i = 0;
+    int j = 0;
+
+    start = clock();
+    for (i = 0; i < iterations; i++)
+    {
+        cJSON *root = cJSON_CreateObject();
+        cJSON *rails = cJSON_AddArrayToObject(root, "rails");
+        char *printed = NULL;
+        for (j = 0; j < 8; j++)
+        {
+            cJSON *rail = cJSON_CreateObject();
+            cJSON_AddNumberToObject(rail, "voltage", 3.3 + j * 0.01);
+            cJSON_AddNumberToObject(rail, "current", 0.125 * j);
+            cJSON_AddNumberToObject(rail, "temperature", 25.5 + j);
+            cJSON_AddItemToArray(rails, rail);
+        }
+        printed = cJSON_PrintUnformatted(root);
+        TEST_ASSERT_NOT_NULL(printed);
+        free(printed);
+        cJSON_Delete(root);
+    }
+    tree_end = clock();
+
+    for (i = 0; i < iterations; i++)
+    {
+        cJSON_WriterInit(&writer, buffer, sizeof(buffer), NULL, NULL);
+        cJSON_WriterStartObject(&writer);
+        cJSON_WriterKey(&writer, "rails");
+        cJSON_WriterStartArray(&writer);
+        for (j = 0; j < 8; j++)
+        {
+            cJSON_WriterStartObject(&writer);
+            cJSON_WriterKey(&writer, "voltage");
+            cJSON_WriterNumber(&writer, 3.3 + j * 0.01);
+            cJSON_WriterKey(&writer, "current");
+            cJSON_WriterNumber(&writer, 0.125 * j);
+            cJSON_WriterKey(&writer, "temperature");
+            cJSON_WriterNumber(&writer, 25.5 + j);
+            cJSON_WriterEndObject(&writer);
+        }
+        cJSON_WriterEndArray(&writer);
+        cJSON_WriterEndObject(&writer);
+        TEST_ASSERT_TRUE(cJSON_WriterFinish(&writer));
+    }
+    writer_end = clock();
+
+    printf("tree + cJSON_PrintUnformatted: %.2f us, cJSON_Writer: %.2f us per document\n",
+           (double)(tree_end - start) * 1e6 / CLOCKS_PER_SEC / iterations,
+           (double)(writer_end - tree_end) * 1e6 / CLOCKS_PER_SEC / iterations);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(writer_should_write_documents);
+    RUN_TEST(writer_should_flush_through_small_buffer);
+    RUN_TEST(writer_should_fail_when_output_does_not_fit);
+    RUN_TEST(writer_should_reject_invalid_structure);
+    RUN_TEST(writer_should_write_numbers);
+    RUN_TEST(writer_should_write_ints);
+    RUN_TEST(writer_timing_compared_to_printing_a_tree);
+
+    return UNITY_END();
+}
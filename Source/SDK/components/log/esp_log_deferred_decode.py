@@ -0,0 +1,176 @@
+#!/usr/bin/env python
+#
+# Decoder for binary deferred log frames (CONFIG_LOG_DEFERRED_OUTPUT_BINARY).
+#
+# Format strings and constant string arguments are stored on the target as
+# pointers; they are resolved here from the application ELF file.
+#
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+import argparse
+import re
+import struct
+import sys
+from typing import BinaryIO, Dict, List, Optional, TextIO, Tuple
+
+from elftools.elf.constants import SH_FLAGS
+from elftools.elf.elffile import ELFFile
+
+FRAME_MAGIC = b'\xe5\x1d'
+FRAME_HEADER = struct.Struct('<2sBBIIIBBH')
+
+RECORD_FLAG_TRUNCATED = 1 << 0
+RECORD_FLAG_DROPPED = 1 << 2
+
+# printf conversion specification, the same subset as parse_spec() in log_deferred.c
+SPEC_RE = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXceEfFgGaAspn%])')
+
+# Size in 32-bit words of an argument on the target, by length modifier
+WIDE_MODIFIERS = ('ll', 'j')
+
+
+class ElfStrings(object):
+    """ Reads zero terminated strings from the allocated sections of an ELF file """
+
+    def __init__(self, elf_path: str) -> None:
+        self.sections = []  # type: List[Tuple[int, bytes]]
+        self.cache = {}  # type: Dict[int, str]
+        with open(elf_path, 'rb') as f:
+            elf = ELFFile(f)
+            for section in elf.iter_sections():
+                if section['sh_flags'] & SH_FLAGS.SHF_ALLOC and section['sh_type'] != 'SHT_NOBITS':
+                    self.sections.append((section['sh_addr'], section.data()))
+
+    def get(self, addr: int) -> str:
+        if addr == 0:
+            return '(null)'
+        if addr in self.cache:
+            return self.cache[addr]
+        for start, data in self.sections:
+            if start <= addr < start + len(data):
+                offset = addr - start
+                end = data.find(b'\0', offset)
+                text = data[offset:end if end >= 0 else len(data)].decode('utf-8', errors='replace')
+                self.cache[addr] = text
+                return text
+        return '<unknown string 0x{:08x}>'.format(addr)
+
+
+class Record(object):
+    def __init__(self, core_id: int, fmt: int, timestamp: int, inline_mask: int, level: int, flags: int,
+                 args: List[int]) -> None:
+        self.core_id = core_id
+        self.format = fmt
+        self.timestamp = timestamp
+        self.inline_mask = inline_mask
+        self.level = level
+        self.flags = flags
+        self.args = args
+
+
+def format_record(record: Record, strings: ElfStrings) -> str:
+    if record.flags & RECORD_FLAG_DROPPED:
+        return 'W ({}) log: {} deferred log records dropped\n'.format(record.timestamp, record.args[0])
+
+    words = iter(record.args)
+    str_index = [0]
+
+    def next_word() -> int:
+        return next(words, 0)
+
+    def convert(match: 're.Match') -> str:
+        flags, width, precision, length, conv = match.groups()
+        if conv == '%':
+            return '%'
+        spec = '%' + flags
+        if width == '*':
+            width = str(struct.unpack('<i', struct.pack('<I', next_word()))[0])
+        if precision == '*':
+            precision = str(struct.unpack('<i', struct.pack('<I', next_word()))[0])
+        spec += (width or '') + ('.' + precision if precision is not None else '')
+
+        if conv == 's':
+            if record.inline_mask & (1 << str_index[0]):
+                length_bytes = next_word()
+                raw = b''.join(struct.pack('<I', next_word()) for _ in range((length_bytes + 3) // 4))
+                value = raw[:length_bytes].decode('utf-8', errors='replace')
+            else:
+                value = strings.get(next_word())
+            str_index[0] += 1
+            return (spec + 's') % value
+        if conv in 'eEfFgGaA':
+            value = struct.unpack('<d', struct.pack('<II', next_word(), next_word()))[0]
+            if conv in 'aA':
+                return value.hex()
+            return (spec + conv) % value
+        if conv == 'p':
+            return '0x{:x}'.format(next_word())
+
+        value = next_word()
+        if length in WIDE_MODIFIERS:
+            value |= next_word() << 32
+            bits = 64
+        else:
+            bits = 32
+        if conv in 'di':
+            if value & (1 << (bits - 1)):
+                value -= 1 << bits
+            conv = 'd'
+        elif conv == 'u':
+            conv = 'd'
+        elif conv == 'c':
+            value &= 0xff
+        return (spec + conv) % value
+
+    text = SPEC_RE.sub(convert, strings.get(record.format))
+    if record.flags & RECORD_FLAG_TRUNCATED:
+        text = text.rstrip('\n') + ' [truncated]\n'
+    return text
+
+
+def read_frames(stream: BinaryIO, out: TextIO, strings: ElfStrings) -> None:
+    """ Decodes frames from the stream; bytes outside of frames are passed through as text """
+    data = b''
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            break
+        data += chunk
+        while True:
+            start = data.find(FRAME_MAGIC)
+            if start < 0:
+                keep = 1 if data.endswith(FRAME_MAGIC[:1]) else 0
+                out.write(data[:len(data) - keep].decode('utf-8', errors='replace'))
+                data = data[len(data) - keep:]
+                break
+            out.write(data[:start].decode('utf-8', errors='replace'))
+            data = data[start:]
+            if len(data) < FRAME_HEADER.size:
+                break
+            _, core_id, arg_words, fmt, timestamp, inline_mask, level, flags, _ = FRAME_HEADER.unpack_from(data)
+            frame_len = FRAME_HEADER.size + arg_words * 4
+            if len(data) < frame_len:
+                break
+            args = list(struct.unpack_from('<{}I'.format(arg_words), data, FRAME_HEADER.size))
+            out.write(format_record(Record(core_id, fmt, timestamp, inline_mask, level, flags, args), strings))
+            data = data[frame_len:]
+    out.write(data.decode('utf-8', errors='replace'))
+    out.flush()
+
+
+def main(argv: Optional[List[str]] = None) -> None:
+    parser = argparse.ArgumentParser(description='Decode binary deferred log output using the application ELF file')
+    parser.add_argument('elf', help='Application ELF file')
+    parser.add_argument('input', nargs='?', help='Captured log output (default: stdin)')
+    args = parser.parse_args(argv)
+
+    strings = ElfStrings(args.elf)
+    if args.input:
+        with open(args.input, 'rb') as f:
+            read_frames(f, sys.stdout, strings)
+    else:
+        read_frames(sys.stdin.buffer, sys.stdout, strings)
+
+
+if __name__ == '__main__':
+    main()
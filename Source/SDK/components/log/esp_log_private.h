@@ -7,6 +7,8 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdarg.h>
+#include "esp_log.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,6 +18,22 @@ void esp_log_impl_lock(void);
 bool esp_log_impl_lock_timeout(void);
 void esp_log_impl_unlock(void);
 
+/* Write an already formatted string using the function set by esp_log_set_vprintf() */
+void esp_log_output_str(const char *str);
+
+/* log_deferred.c needs FreeRTOS, it is not built for the bootloader, non-OS and linux builds */
+#if CONFIG_LOG_DEFERRED && !BOOTLOADER_BUILD && !CONFIG_IDF_TARGET_LINUX && defined(LOG_DEFERRED_FREERTOS)
+#define LOG_DEFERRED_ENABLED 1
+#else
+#define LOG_DEFERRED_ENABLED 0
+#endif
+
+#if LOG_DEFERRED_ENABLED
+/* Store the message into the deferred log ring. Returns false if the message
+   could not be encoded and has to be printed by the caller. */
+bool esp_log_deferred_write(esp_log_level_t level, const char *format, va_list args);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
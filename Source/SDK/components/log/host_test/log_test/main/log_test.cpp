@@ -192,6 +192,37 @@ TEST_CASE("changing log level")
     CHECK(regex_search(fix.get_print_buffer_string(), test_print) == true);
 }
 
+TEST_CASE("changing log level of many tags")
+{
+    PrintFixture fix(ESP_LOG_INFO);
+    const int TAG_COUNT = 300;
+    static char tags[TAG_COUNT][8];
+    for (int i = 0; i < TAG_COUNT; i++) {
+        snprintf(tags[i], sizeof(tags[i]), "tag%d", i);
+        if (i % 2) {
+            esp_log_level_set(tags[i], ESP_LOG_WARN);
+        }
+    }
+
+    for (int i = 0; i < TAG_COUNT; i++) {
+        fix.reset_buffer();
+        ESP_LOGI(tags[i], "info");
+        CHECK((fix.get_print_buffer_string().size() == 0) == (i % 2 == 1));
+        CHECK(esp_log_level_get(tags[i]) == ((i % 2) ? ESP_LOG_WARN : ESP_LOG_INFO));
+    }
+
+    // Level changes must also apply to tags which have been looked up already
+    esp_log_level_set(tags[0], ESP_LOG_ERROR);
+    fix.reset_buffer();
+    ESP_LOGW(tags[0], "warn");
+    CHECK(fix.get_print_buffer_string().size() == 0);
+
+    esp_log_level_set("*", ESP_LOG_INFO);
+    for (int i = 0; i < TAG_COUNT; i++) {
+        CHECK(esp_log_level_get(tags[i]) == ESP_LOG_INFO);
+    }
+}
+
 TEST_CASE("log buffer")
 {
     PrintFixture fix(ESP_LOG_INFO);
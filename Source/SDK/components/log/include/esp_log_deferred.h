@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the deferred log drain task
+ *
+ * Creates a low-priority task which takes records from the per-core rings,
+ * formats them and writes them to the log output (or writes binary frames
+ * when CONFIG_LOG_DEFERRED_OUTPUT_BINARY is selected).
+ * Records logged before this call are kept in the rings until the task runs.
+ *
+ * @note Only available when CONFIG_LOG_DEFERRED is enabled.
+ *
+ * @return
+ *      - ESP_OK: Task created, or already running
+ *      - ESP_ERR_NO_MEM: Failed to create the task
+ */
+esp_err_t esp_log_deferred_init(void);
+
+/**
+ * @brief Output pending deferred records from the calling task
+ *
+ * Can be used to flush the rings without the drain task, for example
+ * before a software reset.
+ *
+ * @param max_records Maximum number of records to output, 0 means no limit.
+ *
+ * @return Number of records which were output
+ */
+size_t esp_log_deferred_flush(size_t max_records);
+
+/**
+ * @brief Get the number of records dropped because a ring was full
+ *
+ * @return Total number of dropped records since boot
+ */
+uint32_t esp_log_deferred_get_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -21,6 +21,18 @@
  * After that, bubble-down operation is performed to fix ordering in the
  * min-heap.
  *
+ * With CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE, the cache is instead an
+ * open-addressed hash table (linear probing) from tag pointer to level,
+ * which can be read without taking the lock. Slots are only ever added,
+ * never removed, and writers hold the lock. A slot is published by
+ * storing its level first and its tag pointer last, so a reader which
+ * sees the tag pointer also sees a valid level. esp_log_level_set updates
+ * levels in place. When the table becomes half full, a copy twice as large
+ * is built and published by swapping the table pointer. Readers may still
+ * be walking the old table at that moment, and there is no cheap way to
+ * know when they are done, so retired tables are never freed. Since the
+ * size doubles each time, they take less memory than the current table.
+ *
  */
 
 #include <stdbool.h>
@@ -30,6 +42,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdatomic.h>
 #include "esp_log.h"
 #include "esp_log_private.h"
 
@@ -42,6 +55,25 @@
 
 #include "sys/queue.h"
 
+#if CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
+// Initial number of slots in the tag table. Must be 2**n.
+#define TAG_TABLE_INITIAL_SIZE 64
+#define TAG_TABLE_MAX_SIZE CONFIG_LOG_TAG_LEVEL_HASH_TABLE_MAX_SIZE
+
+_Static_assert((TAG_TABLE_MAX_SIZE & (TAG_TABLE_MAX_SIZE - 1)) == 0,
+               "CONFIG_LOG_TAG_LEVEL_HASH_TABLE_MAX_SIZE must be a power of two");
+
+typedef struct {
+    _Atomic(const char *) tag;
+    _Atomic uint8_t level;      // esp_log_level_t as uint8_t
+} tag_table_slot_t;
+
+typedef struct {
+    uint32_t mask;              // number of slots - 1
+    uint32_t count;             // number of used slots, only accessed with the lock taken
+    tag_table_slot_t *slots;
+} tag_table_t;
+#else
 // Number of tags to be cached. Must be 2**n - 1, n >= 2.
 #define TAG_CACHE_SIZE 31
 #define MAX_GENERATION ((1 << 29) - 1)
@@ -51,6 +83,7 @@ typedef struct {
     uint32_t level : 3;
     uint32_t generation : 29; // this size should be the same in MAX_GENERATION
 } cached_tag_entry_t;
+#endif // CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
 
 typedef struct uncached_tag_entry_ {
     SLIST_ENTRY(uncached_tag_entry_) entries;
@@ -63,9 +96,19 @@ esp_log_level_t g_master_log_level = CONFIG_LOG_DEFAULT_LEVEL;
 #endif
 esp_log_level_t esp_log_default_level = CONFIG_LOG_DEFAULT_LEVEL;
 static SLIST_HEAD(log_tags_head, uncached_tag_entry_) s_log_tags = SLIST_HEAD_INITIALIZER(s_log_tags);
+#if CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
+static tag_table_slot_t s_tag_table_initial_slots[TAG_TABLE_INITIAL_SIZE];
+static tag_table_t s_tag_table_initial = {
+    .mask = TAG_TABLE_INITIAL_SIZE - 1,
+    .count = 0,
+    .slots = s_tag_table_initial_slots,
+};
+static _Atomic(tag_table_t *) s_tag_table = &s_tag_table_initial;
+#else
 static cached_tag_entry_t s_log_cache[TAG_CACHE_SIZE];
 static uint32_t s_log_cache_max_generation = 0;
 static uint32_t s_log_cache_entry_count = 0;
+#endif // CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
 static vprintf_like_t s_log_print_func = &vprintf;
 
 #ifdef LOG_BUILTIN_CHECKS
@@ -75,11 +118,15 @@ static uint32_t s_log_cache_misses = 0;
 static inline bool get_cached_log_level(const char *tag, esp_log_level_t *level);
 static inline bool get_uncached_log_level(const char *tag, esp_log_level_t *level);
 static inline void add_to_cache(const char *tag, esp_log_level_t level);
+static inline void update_cached_log_level(const char *tag, esp_log_level_t level);
+static inline void clear_cache(void);
+#if !CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
 static void heap_bubble_down(int index);
 static inline void heap_swap(int i, int j);
+static void fix_cache_generation_overflow(void);
+#endif
 static inline bool should_output(esp_log_level_t level_for_message, esp_log_level_t level_for_tag);
 static inline void clear_log_level_list(void);
-static void fix_cache_generation_overflow(void);
 
 vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
 {
@@ -140,15 +187,7 @@ void esp_log_level_set(const char *tag, esp_log_level_t level)
     }
 
     // search in the cache and update the entry it if exists
-    for (uint32_t i = 0; i < s_log_cache_entry_count; ++i) {
-#ifdef LOG_BUILTIN_CHECKS
-        assert(i == 0 || s_log_cache[(i - 1) / 2].generation < s_log_cache[i].generation);
-#endif
-        if (strcmp(s_log_cache[i].tag, tag) == 0) {
-            s_log_cache[i].level = level;
-            break;
-        }
-    }
+    update_cached_log_level(tag, level);
     esp_log_impl_unlock();
 }
 
@@ -176,6 +215,12 @@ static esp_log_level_t s_log_level_get_and_unlock(const char *tag)
 
 esp_log_level_t esp_log_level_get(const char *tag)
 {
+#if CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
+    esp_log_level_t level_for_tag;
+    if (get_cached_log_level(tag, &level_for_tag)) {
+        return level_for_tag;
+    }
+#endif
     esp_log_impl_lock();
     return s_log_level_get_and_unlock(tag);
 }
@@ -187,8 +232,7 @@ void clear_log_level_list(void)
         SLIST_REMOVE_HEAD(&s_log_tags, entries);
         free(it);
     }
-    s_log_cache_entry_count = 0;
-    s_log_cache_max_generation = 0;
+    clear_cache();
 #ifdef LOG_BUILTIN_CHECKS
     s_log_cache_misses = 0;
 #endif
@@ -199,16 +243,40 @@ void esp_log_writev(esp_log_level_t level,
                     const char *format,
                     va_list args)
 {
-    if (!esp_log_impl_lock_timeout()) {
-        return;
+    esp_log_level_t level_for_tag;
+#if CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
+    // Fast path, without taking the lock
+    if (!get_cached_log_level(tag, &level_for_tag))
+#endif
+    {
+        if (!esp_log_impl_lock_timeout()) {
+            return;
+        }
+        level_for_tag = s_log_level_get_and_unlock(tag);
     }
-    esp_log_level_t level_for_tag = s_log_level_get_and_unlock(tag);
     if (!should_output(level, level_for_tag)) {
         return;
     }
 
+#if LOG_DEFERRED_ENABLED
+    if (esp_log_deferred_write(level, format, args)) {
+        return;
+    }
+#endif
     (*s_log_print_func)(format, args);
+}
 
+static void log_print(const char *format, ...)
+{
+    va_list list;
+    va_start(list, format);
+    (*s_log_print_func)(format, list);
+    va_end(list);
+}
+
+void esp_log_output_str(const char *str)
+{
+    log_print("%s", str);
 }
 
 void esp_log_write(esp_log_level_t level,
@@ -221,6 +289,111 @@ void esp_log_write(esp_log_level_t level,
     va_end(list);
 }
 
+#if CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
+
+static inline uint32_t tag_hash(const char *tag)
+{
+    // Fibonacci hashing of the pointer, upper bits are the best mixed
+    uint32_t h = (uint32_t)(uintptr_t)tag * 2654435769u;
+    return h ^ (h >> 16);
+}
+
+static inline bool get_cached_log_level(const char *tag, esp_log_level_t *level)
+{
+    // May be called without the lock, see the implementation notes at the top of the file
+    const tag_table_t *table = atomic_load_explicit(&s_tag_table, memory_order_acquire);
+    for (uint32_t i = tag_hash(tag); ; ++i) {
+        const tag_table_slot_t *slot = &table->slots[i & table->mask];
+        const char *slot_tag = atomic_load_explicit(&slot->tag, memory_order_acquire);
+        if (slot_tag == tag) {
+            *level = (esp_log_level_t) atomic_load_explicit(&slot->level, memory_order_relaxed);
+            return true;
+        }
+        if (slot_tag == NULL) { // The table is never full, so the probe always ends
+            return false;
+        }
+    }
+}
+
+static void tag_table_insert(tag_table_t *table, const char *tag, esp_log_level_t level)
+{
+    for (uint32_t i = tag_hash(tag); ; ++i) {
+        tag_table_slot_t *slot = &table->slots[i & table->mask];
+        const char *slot_tag = atomic_load_explicit(&slot->tag, memory_order_relaxed);
+        if (slot_tag == tag) {
+            // Another task added the tag between its lock-free lookup and taking the lock
+            atomic_store_explicit(&slot->level, level, memory_order_relaxed);
+            return;
+        }
+        if (slot_tag == NULL) {
+            atomic_store_explicit(&slot->level, level, memory_order_relaxed);
+            atomic_store_explicit(&slot->tag, tag, memory_order_release);
+            ++table->count;
+            return;
+        }
+    }
+}
+
+static tag_table_t *tag_table_grow(tag_table_t *table)
+{
+    uint32_t size = (table->mask + 1) * 2;
+    if (size > TAG_TABLE_MAX_SIZE) {
+        return NULL;
+    }
+    tag_table_t *new_table = (tag_table_t *) calloc(1, sizeof(tag_table_t) + size * sizeof(tag_table_slot_t));
+    if (new_table == NULL) {
+        return NULL;
+    }
+    new_table->mask = size - 1;
+    new_table->slots = (tag_table_slot_t *)(new_table + 1);
+    for (uint32_t i = 0; i <= table->mask; ++i) {
+        const char *tag = atomic_load_explicit(&table->slots[i].tag, memory_order_relaxed);
+        if (tag != NULL) {
+            tag_table_insert(new_table, tag, (esp_log_level_t) atomic_load_explicit(&table->slots[i].level, memory_order_relaxed));
+        }
+    }
+    // The old table is retired, not freed: readers may still be walking it
+    atomic_store_explicit(&s_tag_table, new_table, memory_order_release);
+    return new_table;
+}
+
+static inline void add_to_cache(const char *tag, esp_log_level_t level)
+{
+    tag_table_t *table = atomic_load_explicit(&s_tag_table, memory_order_relaxed);
+    // Keep the load factor at or below 1/2 so that probe sequences stay short
+    if ((table->count + 1) * 2 > table->mask + 1) {
+        table = tag_table_grow(table);
+        if (table == NULL) {
+            // Table is at its maximum size, the level will be looked up in the list next time
+            return;
+        }
+    }
+    tag_table_insert(table, tag, level);
+}
+
+static inline void update_cached_log_level(const char *tag, esp_log_level_t level)
+{
+    // The same string may be cached under several pointers, update all of them
+    tag_table_t *table = atomic_load_explicit(&s_tag_table, memory_order_relaxed);
+    for (uint32_t i = 0; i <= table->mask; ++i) {
+        const char *slot_tag = atomic_load_explicit(&table->slots[i].tag, memory_order_relaxed);
+        if (slot_tag != NULL && strcmp(slot_tag, tag) == 0) {
+            atomic_store_explicit(&table->slots[i].level, level, memory_order_relaxed);
+        }
+    }
+}
+
+static inline void clear_cache(void)
+{
+    // Slots cannot be removed while readers may be using them; all tags now use the default level
+    tag_table_t *table = atomic_load_explicit(&s_tag_table, memory_order_relaxed);
+    for (uint32_t i = 0; i <= table->mask; ++i) {
+        atomic_store_explicit(&table->slots[i].level, esp_log_default_level, memory_order_relaxed);
+    }
+}
+
+#else // !CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
+
 static inline bool get_cached_log_level(const char *tag, esp_log_level_t *level)
 {
     // Look for `tag` in cache
@@ -286,6 +459,25 @@ static inline void add_to_cache(const char *tag, esp_log_level_t level)
     }
 }
 
+static inline void update_cached_log_level(const char *tag, esp_log_level_t level)
+{
+    for (uint32_t i = 0; i < s_log_cache_entry_count; ++i) {
+#ifdef LOG_BUILTIN_CHECKS
+        assert(i == 0 || s_log_cache[(i - 1) / 2].generation < s_log_cache[i].generation);
+#endif
+        if (strcmp(s_log_cache[i].tag, tag) == 0) {
+            s_log_cache[i].level = level;
+            break;
+        }
+    }
+}
+
+static inline void clear_cache(void)
+{
+    s_log_cache_entry_count = 0;
+    s_log_cache_max_generation = 0;
+}
+
 static void fix_cache_generation_overflow(void)
 {
     // Fix generation count wrap
@@ -295,6 +487,8 @@ static void fix_cache_generation_overflow(void)
     s_log_cache_max_generation = s_log_cache_entry_count;
 }
 
+#endif // !CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
+
 static inline bool get_uncached_log_level(const char *tag, esp_log_level_t *level)
 {
     // Walk the linked list of all tags and see if given tag is present in the list.
@@ -314,6 +508,7 @@ static inline bool should_output(esp_log_level_t level_for_message, esp_log_leve
     return level_for_message <= level_for_tag;
 }
 
+#if !CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
 static void heap_bubble_down(int index)
 {
     while (index < TAG_CACHE_SIZE / 2) {
@@ -331,3 +526,4 @@ static inline void heap_swap(int i, int j)
     s_log_cache[i] = s_log_cache[j];
     s_log_cache[j] = tmp;
 }
+#endif // !CONFIG_LOG_TAG_LEVEL_CACHE_HASH_TABLE
@@ -0,0 +1,560 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Deferred logging implementation notes.
+ *
+ * When CONFIG_LOG_DEFERRED is enabled, esp_log_writev() does not format the
+ * message. It stores the format string pointer, a timestamp and the raw
+ * argument words into a record of a per-core ring and returns.
+ *
+ * Each ring is a bounded lock-free queue (D. Vyukov's design): every slot
+ * carries a sequence number which tells producers whether the slot is free
+ * for a given position and tells the consumer whether the record at a given
+ * position has been committed. Producers reserve a position with a CAS on
+ * 'head', fill the slot and publish it by updating the sequence number. This
+ * makes the ring safe to use from any task or ISR on the same core and lets a
+ * producer be preempted mid-write without blocking anybody. When the ring is
+ * full, the record is dropped and counted.
+ *
+ * Arguments are decoded by walking the format string, the same way printf
+ * does. String arguments which point to flash (DROM) are stored as pointers,
+ * since both the drain task and the host decoder can resolve them. Other
+ * strings are copied into the record. Records are formatted later by the
+ * drain task, one conversion at a time, or written out as binary frames for
+ * esp_log_deferred_decode.py.
+ */
+
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_memory_utils.h"
+#include "esp_log.h"
+#include "esp_log_deferred.h"
+#include "esp_log_private.h"
+
+#define RING_SIZE           CONFIG_LOG_DEFERRED_RING_SIZE
+#define RECORD_ARGS         CONFIG_LOG_DEFERRED_RECORD_ARGS
+#define LINE_MAX_LEN        256
+#define SPEC_MAX_LEN        16
+#define DRAIN_PERIOD_MS     20
+
+// Binary frame marker, must match esp_log_deferred_decode.py
+#define FRAME_MAGIC_0       0xE5
+#define FRAME_MAGIC_1       0x1D
+
+#define RECORD_FLAG_TRUNCATED   (1 << 0)    // an inline string argument was truncated
+#define RECORD_FLAG_SKIP        (1 << 1)    // record could not be encoded and was printed immediately
+#define RECORD_FLAG_DROPPED     (1 << 2)    // not a message: args[0] is the number of dropped records
+
+_Static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "CONFIG_LOG_DEFERRED_RING_SIZE must be a power of two");
+
+typedef struct {
+    _Atomic uint32_t seq;       // see slot_seq()
+    const char *format;
+    uint32_t timestamp;
+    uint32_t str_inline_mask;   // bit n is set if the n-th "%s" argument is stored inline
+    uint8_t level;
+    uint8_t arg_words;
+    uint8_t flags;
+    uint8_t core_id;
+    uint32_t args[RECORD_ARGS];
+} log_record_t;
+
+typedef struct {
+    _Atomic uint32_t head;      // next position to be reserved by producers
+    _Atomic uint32_t tail;      // next position to be consumed
+    log_record_t records[RING_SIZE];
+} log_ring_t;
+
+typedef enum {
+    ARG_NONE,       // "%%"
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_PTR,
+    ARG_STR,
+    ARG_UNSUPPORTED,
+} arg_kind_t;
+
+typedef struct {
+    const char *start;          // points to '%'
+    size_t len;                 // length of the conversion specification
+    arg_kind_t kind;
+    uint8_t star_args;          // number of '*' width/precision arguments
+} conv_spec_t;
+
+static log_ring_t s_rings[portNUM_PROCESSORS];
+static _Atomic uint32_t s_dropped;
+static uint32_t s_dropped_reported;
+static TaskHandle_t s_drain_task;
+
+/* Sequence numbers are stored relative to the slot index, so that a zeroed
+   ring (.bss) is a valid empty ring: slot i is free for position i. */
+static inline uint32_t slot_seq(const log_record_t *rec, uint32_t idx)
+{
+    return atomic_load_explicit(&rec->seq, memory_order_acquire) + idx;
+}
+
+static inline void slot_seq_set(log_record_t *rec, uint32_t idx, uint32_t seq)
+{
+    atomic_store_explicit(&rec->seq, seq - idx, memory_order_release);
+}
+
+static log_record_t *ring_reserve(log_ring_t *ring, uint32_t *pos_out)
+{
+    uint32_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;) {
+        uint32_t idx = pos & (RING_SIZE - 1);
+        log_record_t *rec = &ring->records[idx];
+        int32_t diff = (int32_t)(slot_seq(rec, idx) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *pos_out = pos;
+                return rec;
+            }
+        } else if (diff < 0) {
+            return NULL; // ring is full
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+}
+
+static inline void ring_commit(log_record_t *rec, uint32_t pos)
+{
+    slot_seq_set(rec, pos & (RING_SIZE - 1), pos + 1);
+}
+
+static bool ring_pop(log_ring_t *ring, log_record_t *out)
+{
+    uint32_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (;;) {
+        uint32_t idx = pos & (RING_SIZE - 1);
+        log_record_t *rec = &ring->records[idx];
+        int32_t diff = (int32_t)(slot_seq(rec, idx) - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                memcpy(out, rec, sizeof(*out));
+                slot_seq_set(rec, idx, pos + RING_SIZE);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // ring is empty, or the next record is not committed yet
+        } else {
+            pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        }
+    }
+}
+
+static const char *parse_spec(const char *p, conv_spec_t *spec)
+{
+    spec->start = p++;
+    spec->star_args = 0;
+    if (*p == '%') {
+        spec->kind = ARG_NONE;
+        spec->len = 2;
+        return p + 1;
+    }
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+        p++;
+    }
+    if (*p == '*') {
+        spec->star_args++;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->star_args++;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    arg_kind_t int_kind = ARG_INT;
+    bool wide = false;
+    switch (*p) {
+    case 'h':
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        if (p[1] == 'l') {
+            int_kind = ARG_LLONG;
+            p += 2;
+        } else {
+            int_kind = ARG_LONG;
+            wide = true;
+            p++;
+        }
+        break;
+    case 'j':
+        int_kind = ARG_INTMAX;
+        p++;
+        break;
+    case 'z':
+        int_kind = ARG_SIZE;
+        p++;
+        break;
+    case 't':
+        int_kind = ARG_PTRDIFF;
+        p++;
+        break;
+    case 'L':
+        int_kind = ARG_UNSUPPORTED;
+        p++;
+        break;
+    default:
+        break;
+    }
+    switch (*p) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        spec->kind = int_kind;
+        break;
+    case 'c':
+        spec->kind = wide ? ARG_UNSUPPORTED : ARG_INT;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec->kind = (int_kind == ARG_UNSUPPORTED) ? ARG_UNSUPPORTED : ARG_DOUBLE;
+        break;
+    case 's':
+        spec->kind = wide ? ARG_UNSUPPORTED : ARG_STR;
+        break;
+    case 'p':
+        spec->kind = ARG_PTR;
+        break;
+    default:
+        // "%n", unknown conversions and a truncated specification
+        spec->kind = ARG_UNSUPPORTED;
+        return p;
+    }
+    p++;
+    spec->len = p - spec->start;
+    return p;
+}
+
+static inline bool put_words(log_record_t *rec, const void *value, size_t size)
+{
+    size_t words = (size + 3) / 4;
+    if (rec->arg_words + words > RECORD_ARGS) {
+        return false;
+    }
+    memcpy(&rec->args[rec->arg_words], value, size);
+    rec->arg_words += words;
+    return true;
+}
+
+static inline const void *get_words(const log_record_t *rec, size_t *word, size_t size)
+{
+    const void *value = &rec->args[*word];
+    *word += (size + 3) / 4;
+    return value;
+}
+
+#define PUT_ARG(type) do { \
+        type v = va_arg(args, type); \
+        if (!put_words(rec, &v, sizeof(v))) { \
+            return false; \
+        } \
+    } while (0)
+
+static bool encode_args(log_record_t *rec, const char *format, va_list args)
+{
+    unsigned str_index = 0;
+    const char *p = format;
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        conv_spec_t spec;
+        p = parse_spec(p, &spec);
+        for (int i = 0; i < spec.star_args; i++) {
+            PUT_ARG(int);
+        }
+        switch (spec.kind) {
+        case ARG_NONE:      break;
+        case ARG_INT:       PUT_ARG(int); break;
+        case ARG_LONG:      PUT_ARG(long); break;
+        case ARG_LLONG:     PUT_ARG(long long); break;
+        case ARG_INTMAX:    PUT_ARG(intmax_t); break;
+        case ARG_SIZE:      PUT_ARG(size_t); break;
+        case ARG_PTRDIFF:   PUT_ARG(ptrdiff_t); break;
+        case ARG_DOUBLE:    PUT_ARG(double); break;
+        case ARG_PTR:       PUT_ARG(void *); break;
+        case ARG_STR: {
+            const char *s = va_arg(args, const char *);
+            if (str_index >= 32) {
+                return false;
+            }
+            if (s == NULL || esp_ptr_in_drom(s)) {
+                if (!put_words(rec, &s, sizeof(s))) {
+                    return false;
+                }
+            } else {
+                // Inline string: length word followed by the characters, without terminator
+                if (rec->arg_words >= RECORD_ARGS) {
+                    return false;
+                }
+                size_t room = (RECORD_ARGS - rec->arg_words - 1) * 4;
+                uint32_t len = strnlen(s, room + 1);
+                if (len > room) {
+                    len = room;
+                    rec->flags |= RECORD_FLAG_TRUNCATED;
+                }
+                rec->args[rec->arg_words++] = len;
+                memcpy(&rec->args[rec->arg_words], s, len);
+                rec->arg_words += (len + 3) / 4;
+                rec->str_inline_mask |= 1UL << str_index;
+            }
+            str_index++;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool esp_log_deferred_write(esp_log_level_t level, const char *format, va_list args)
+{
+    // The format string must outlive the record and be resolvable from the ELF file
+    if (!esp_ptr_in_drom(format)) {
+        return false;
+    }
+    uint32_t core_id = esp_cpu_get_core_id();
+    log_ring_t *ring = &s_rings[core_id];
+    uint32_t pos;
+    log_record_t *rec = ring_reserve(ring, &pos);
+    if (rec == NULL) {
+        atomic_fetch_add_explicit(&s_dropped, 1, memory_order_relaxed);
+        return true;
+    }
+    rec->format = format;
+    rec->timestamp = esp_log_timestamp();
+    rec->str_inline_mask = 0;
+    rec->level = level;
+    rec->arg_words = 0;
+    rec->flags = 0;
+    rec->core_id = core_id;
+
+    va_list copy;
+    va_copy(copy, args);
+    bool encoded = encode_args(rec, format, copy);
+    va_end(copy);
+    if (!encoded) {
+        // Keep the slot consistent for the consumer, the caller prints the message directly
+        rec->flags = RECORD_FLAG_SKIP;
+    }
+    ring_commit(rec, pos);
+    return encoded;
+}
+
+#if CONFIG_LOG_DEFERRED_OUTPUT_TEXT
+
+#define FORMAT_ONE(type) do { \
+        type v; \
+        memcpy(&v, get_words(rec, &word, sizeof(v)), sizeof(v)); \
+        n = (spec.star_args == 0) ? snprintf(out, room, spec_fmt, v) : \
+            (spec.star_args == 1) ? snprintf(out, room, spec_fmt, stars[0], v) : \
+            snprintf(out, room, spec_fmt, stars[0], stars[1], v); \
+    } while (0)
+
+static size_t format_record(const log_record_t *rec, char *line, size_t size)
+{
+    size_t len = 0;
+    size_t word = 0;
+    unsigned str_index = 0;
+    const char *p = rec->format;
+    while (*p && len + 1 < size) {
+        const char *lit = p;
+        while (*p && *p != '%') {
+            p++;
+        }
+        size_t lit_len = p - lit;
+        if (lit_len > size - 1 - len) {
+            lit_len = size - 1 - len;
+        }
+        memcpy(line + len, lit, lit_len);
+        len += lit_len;
+        if (*p == '\0') {
+            break;
+        }
+
+        conv_spec_t spec;
+        p = parse_spec(p, &spec);
+        if (spec.kind == ARG_NONE) {
+            line[len++] = '%';
+            continue;
+        }
+        char spec_fmt[SPEC_MAX_LEN];
+        if (spec.kind == ARG_UNSUPPORTED || spec.len >= sizeof(spec_fmt)) {
+            break; // cannot happen for committed records
+        }
+        memcpy(spec_fmt, spec.start, spec.len);
+        spec_fmt[spec.len] = '\0';
+
+        int stars[2] = { 0 };
+        for (int i = 0; i < spec.star_args; i++) {
+            memcpy(&stars[i], get_words(rec, &word, sizeof(int)), sizeof(int));
+        }
+        char *out = line + len;
+        size_t room = size - len;
+        int n = 0;
+        switch (spec.kind) {
+        case ARG_INT:       FORMAT_ONE(int); break;
+        case ARG_LONG:      FORMAT_ONE(long); break;
+        case ARG_LLONG:     FORMAT_ONE(long long); break;
+        case ARG_INTMAX:    FORMAT_ONE(intmax_t); break;
+        case ARG_SIZE:      FORMAT_ONE(size_t); break;
+        case ARG_PTRDIFF:   FORMAT_ONE(ptrdiff_t); break;
+        case ARG_DOUBLE:    FORMAT_ONE(double); break;
+        case ARG_PTR:       FORMAT_ONE(void *); break;
+        case ARG_STR:
+            if (rec->str_inline_mask & (1UL << str_index)) {
+                char str[RECORD_ARGS * 4 + 1];
+                uint32_t str_len = rec->args[word++];
+                memcpy(str, &rec->args[word], str_len);
+                str[str_len] = '\0';
+                word += (str_len + 3) / 4;
+                const char *v = str;
+                n = (spec.star_args == 0) ? snprintf(out, room, spec_fmt, v) :
+                    (spec.star_args == 1) ? snprintf(out, room, spec_fmt, stars[0], v) :
+                    snprintf(out, room, spec_fmt, stars[0], stars[1], v);
+            } else {
+                FORMAT_ONE(const char *);
+            }
+            str_index++;
+            break;
+        default:
+            break;
+        }
+        if (n > 0) {
+            len += ((size_t)n < room) ? (size_t)n : room - 1;
+        }
+    }
+    line[len] = '\0';
+    return len;
+}
+
+static void output_record(const log_record_t *rec)
+{
+    char line[LINE_MAX_LEN];
+    if (rec->flags & RECORD_FLAG_DROPPED) {
+        snprintf(line, sizeof(line), "W (%" PRIu32 ") log: %" PRIu32 " deferred log records dropped\n",
+                 rec->timestamp, rec->args[0]);
+    } else {
+        format_record(rec, line, sizeof(line));
+    }
+    esp_log_output_str(line);
+}
+
+#else // CONFIG_LOG_DEFERRED_OUTPUT_BINARY
+
+static void output_record(const log_record_t *rec)
+{
+    // Frame layout (little endian), see esp_log_deferred_decode.py:
+    // magic[2], core_id, arg_words, format, timestamp, str_inline_mask, level, flags, reserved[2], args
+    uint8_t header[16] = { FRAME_MAGIC_0, FRAME_MAGIC_1, rec->core_id, rec->arg_words };
+    uint32_t format = (uint32_t)(uintptr_t)rec->format;
+    memcpy(&header[4], &format, 4);
+    memcpy(&header[8], &rec->timestamp, 4);
+    memcpy(&header[12], &rec->str_inline_mask, 4);
+    uint8_t meta[4] = { rec->level, rec->flags, 0, 0 };
+    fwrite(header, 1, sizeof(header), stdout);
+    fwrite(meta, 1, sizeof(meta), stdout);
+    fwrite(rec->args, 4, rec->arg_words, stdout);
+}
+
+#endif // CONFIG_LOG_DEFERRED_OUTPUT_TEXT
+
+static void report_dropped(void)
+{
+    uint32_t dropped = atomic_load_explicit(&s_dropped, memory_order_relaxed);
+    if (dropped == s_dropped_reported) {
+        return;
+    }
+    log_record_t rec = {
+        .timestamp = esp_log_timestamp(),
+        .level = ESP_LOG_WARN,
+        .arg_words = 1,
+        .flags = RECORD_FLAG_DROPPED,
+        .core_id = esp_cpu_get_core_id(),
+        .args = { dropped - s_dropped_reported },
+    };
+    s_dropped_reported = dropped;
+    output_record(&rec);
+}
+
+size_t esp_log_deferred_flush(size_t max_records)
+{
+    size_t count = 0;
+    bool pending = true;
+    log_record_t rec;
+    // Take records from the rings alternately, to roughly keep the order between cores
+    while (pending && (max_records == 0 || count < max_records)) {
+        pending = false;
+        for (int i = 0; i < portNUM_PROCESSORS && (max_records == 0 || count < max_records); i++) {
+            if (ring_pop(&s_rings[i], &rec)) {
+                pending = true;
+                if (!(rec.flags & RECORD_FLAG_SKIP)) {
+                    output_record(&rec);
+                    count++;
+                }
+            }
+        }
+    }
+    report_dropped();
+#if CONFIG_LOG_DEFERRED_OUTPUT_BINARY
+    if (count) {
+        fflush(stdout);
+    }
+#endif
+    return count;
+}
+
+uint32_t esp_log_deferred_get_dropped(void)
+{
+    return atomic_load_explicit(&s_dropped, memory_order_relaxed);
+}
+
+static void log_deferred_task(void *arg)
+{
+    for (;;) {
+        if (esp_log_deferred_flush(0) == 0) {
+            vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+        }
+    }
+}
+
+esp_err_t esp_log_deferred_init(void)
+{
+    if (s_drain_task != NULL) {
+        return ESP_OK;
+    }
+    BaseType_t ret = xTaskCreate(log_deferred_task, "log_deferred",
+                                 CONFIG_LOG_DEFERRED_TASK_STACK_SIZE, NULL,
+                                 CONFIG_LOG_DEFERRED_TASK_PRIORITY, &s_drain_task);
+    return (ret == pdPASS) ? ESP_OK : ESP_ERR_NO_MEM;
+}
@@ -10,8 +10,10 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_log_deferred.h"
 #include "esp_timer.h"
 #include "sdkconfig.h"
+#include <string.h>
 
 static const char * TAG = "log_test";
 
@@ -55,3 +57,45 @@ TEST_CASE("test master logging level performance", "[log]")
     esp_log_level_set("*", ESP_LOG_INFO);
     ESP_LOGI(TAG, "End");
 }
+
+#if CONFIG_LOG_DEFERRED
+static char s_output[256];
+
+static int capture_vprintf(const char *format, va_list args)
+{
+    size_t len = strlen(s_output);
+    return vsnprintf(s_output + len, sizeof(s_output) - len, format, args);
+}
+
+TEST_CASE("deferred logging stores records and formats them on flush", "[log]")
+{
+    char dynamic[16] = "dynamic";
+    esp_log_deferred_flush(0);
+    vprintf_like_t orig = esp_log_set_vprintf(capture_vprintf);
+    s_output[0] = '\0';
+
+    ESP_LOGI(TAG, "value %d %s %s", 42, "const", dynamic);
+    strcpy(dynamic, "changed");
+    // Nothing is output until the ring is flushed
+    TEST_ASSERT_EQUAL_STRING("", s_output);
+
+    TEST_ASSERT_EQUAL(1, esp_log_deferred_flush(0));
+    esp_log_set_vprintf(orig);
+    TEST_ASSERT_NOT_NULL(strstr(s_output, "log_test: value 42 const dynamic"));
+}
+
+TEST_CASE("deferred logging performance", "[log]")
+{
+    const int ITERATIONS = CONFIG_LOG_DEFERRED_RING_SIZE;
+    esp_log_deferred_flush(0);
+    esp_log_level_set("*", ESP_LOG_INFO);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < ITERATIONS; i++) {
+        ESP_LOGI(TAG, "some test data, %d, %d, %d", i, ITERATIONS - i, 12);
+    }
+    int diff = (int)(esp_timer_get_time() - start);
+    esp_log_deferred_flush(0);
+    printf("%d deferred log calls took %d usec\n", ITERATIONS, diff);
+    TEST_ASSERT_LESS_THAN(10 * ITERATIONS, diff);
+}
+#endif // CONFIG_LOG_DEFERRED
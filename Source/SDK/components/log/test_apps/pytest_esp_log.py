@@ -7,5 +7,6 @@ from pytest_embedded import Dut
 
 @pytest.mark.esp32
 @pytest.mark.generic
+@pytest.mark.parametrize('config', ['default', 'deferred'], indirect=True)
 def test_esp_log(dut: Dut) -> None:
     dut.run_all_single_board_cases()
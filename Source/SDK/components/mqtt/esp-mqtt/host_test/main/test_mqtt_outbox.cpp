@@ -0,0 +1,294 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+
+extern "C" {
+#include "mqtt_config.h"
+#include "mqtt_msg.h"
+#include "mqtt_outbox.h"
+}
+
+#if CONFIG_MQTT_OUTBOX_SLAB
+namespace {
+
+struct outbox_deleter {
+    void operator()(outbox_handle_t outbox)
+    {
+        outbox_destroy(outbox);
+    }
+};
+using unique_outbox = std::unique_ptr<std::remove_pointer_t<outbox_handle_t>, outbox_deleter>;
+
+outbox_item_handle_t enqueue(outbox_handle_t outbox, int msg_id, int msg_type, std::vector<uint8_t> &data, outbox_tick_t tick = 0)
+{
+    outbox_message_t message = {};
+    message.data = data.data();
+    message.len = static_cast<int>(data.size());
+    message.msg_id = msg_id;
+    message.msg_qos = 1;
+    message.msg_type = msg_type;
+    return outbox_enqueue(outbox, &message, tick);
+}
+
+std::vector<int> pop_evicted(outbox_handle_t outbox)
+{
+    std::vector<int> evicted;
+    int msg_id = -1;
+    while (outbox_pop_evicted(outbox, &msg_id)) {
+        evicted.push_back(msg_id);
+    }
+    return evicted;
+}
+
+std::vector<uint8_t> payload(int msg_id, size_t len)
+{
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = static_cast<uint8_t>(msg_id + i);
+    }
+    return data;
+}
+
+bool holds(outbox_handle_t outbox, int msg_id, size_t len)
+{
+    size_t item_len = 0;
+    uint16_t item_msg_id = 0;
+    int msg_type = 0;
+    int qos = 0;
+    uint8_t *data = outbox_item_get_data(outbox_get(outbox, msg_id), &item_len, &item_msg_id, &msg_type, &qos);
+    auto expected = payload(msg_id, len);
+    return data != nullptr && item_msg_id == msg_id && item_len == len && std::equal(expected.begin(), expected.end(), data);
+}
+
+/*
+ * Stands in for the client task and the broker: sends queued messages like mqtt_task does, and the broker
+ * acknowledges the outstanding ones in random order.
+ */
+struct broker_stand_in {
+    std::deque<int> in_flight;
+    std::mt19937 random{42};
+
+    void transmit(outbox_handle_t outbox)
+    {
+        outbox_item_handle_t item;
+        while ((item = outbox_dequeue(outbox, QUEUED, nullptr)) != nullptr) {
+            size_t len = 0;
+            uint16_t msg_id = 0;
+            int msg_type = 0;
+            int qos = 0;
+            outbox_item_get_data(item, &len, &msg_id, &msg_type, &qos);
+            REQUIRE(outbox_set_pending(outbox, msg_id, TRANSMITTED) == ESP_OK);
+            in_flight.push_back(msg_id);
+        }
+    }
+
+    void puback_some(outbox_handle_t outbox, size_t count)
+    {
+        std::shuffle(in_flight.begin(), in_flight.end(), random);
+        for (size_t i = 0; i < count && !in_flight.empty(); i++) {
+            REQUIRE(outbox_delete(outbox, in_flight.front(), MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+            REQUIRE(outbox_get(outbox, in_flight.front()) == nullptr);
+            in_flight.pop_front();
+        }
+    }
+};
+
+} // namespace
+
+SCENARIO("Slab outbox")
+{
+    auto outbox = unique_outbox{outbox_init()};
+    REQUIRE(outbox != nullptr);
+
+    GIVEN("Messages that fit the slab") {
+        const size_t len = 20;
+        const int messages = OUTBOX_SLAB_SIZE / 128 - 1;
+        std::vector<std::vector<uint8_t>> data;
+        for (int msg_id = 1; msg_id <= messages; msg_id++) {
+            data.push_back(payload(msg_id, len));
+            REQUIRE(enqueue(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH, data.back()) != nullptr);
+        }
+        REQUIRE(outbox_get_size(outbox.get()) == messages * len);
+
+        SECTION("Every message is found by id") {
+            for (int msg_id = 1; msg_id <= messages; msg_id++) {
+                REQUIRE(holds(outbox.get(), msg_id, len));
+            }
+            REQUIRE(outbox_get(outbox.get(), messages + 1) == nullptr);
+            REQUIRE(pop_evicted(outbox.get()).empty());
+        }
+        SECTION("The broker acknowledges them out of order") {
+            broker_stand_in broker;
+            broker.transmit(outbox.get());
+            REQUIRE(outbox_dequeue(outbox.get(), QUEUED, nullptr) == nullptr);
+            while (!broker.in_flight.empty()) {
+                broker.puback_some(outbox.get(), 7);
+                for (int msg_id : broker.in_flight) {
+                    REQUIRE(holds(outbox.get(), msg_id, len));
+                }
+            }
+            REQUIRE(outbox_get_size(outbox.get()) == 0);
+            REQUIRE(outbox_dequeue(outbox.get(), TRANSMITTED, nullptr) == nullptr);
+        }
+        SECTION("Deleting needs the matching type") {
+            auto pubrel = payload(1, 4);
+            REQUIRE(enqueue(outbox.get(), 1, MQTT_MSG_TYPE_PUBREL, pubrel) != nullptr);
+            REQUIRE(outbox_delete(outbox.get(), 1, MQTT_MSG_TYPE_PUBREL) == ESP_OK);
+            REQUIRE(holds(outbox.get(), 1, len));
+            REQUIRE(outbox_delete(outbox.get(), 1, MQTT_MSG_TYPE_PUBREL) == ESP_FAIL);
+        }
+        SECTION("Expired messages are deleted") {
+            REQUIRE(outbox_set_tick(outbox.get(), 5, 1000) == ESP_OK);
+            REQUIRE(outbox_delete_expired(outbox.get(), 500, 100) == messages - 1);
+            REQUIRE(holds(outbox.get(), 5, len));
+            REQUIRE(outbox_delete_single_expired(outbox.get(), 2000, 100) == 5);
+            REQUIRE(outbox_get_size(outbox.get()) == 0);
+        }
+    }
+
+    GIVEN("A link outage longer than the slab can hold") {
+        // the item header and 150 bytes take a 256 byte chunk
+        const size_t len = 150;
+        const int fits = OUTBOX_SLAB_SIZE / 256;
+        const int messages = fits * 4;
+        broker_stand_in broker;
+        std::vector<uint8_t> data;
+        for (int msg_id = 1; msg_id <= messages; msg_id++) {
+            data = payload(msg_id, len);
+            REQUIRE(enqueue(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH, data) != nullptr);
+        }
+        REQUIRE(outbox_get_size(outbox.get()) == fits * len);
+
+        THEN("Exactly the oldest messages were evicted and reported in order") {
+            std::vector<int> expected(messages - fits);
+            std::iota(expected.begin(), expected.end(), 1);
+            REQUIRE(pop_evicted(outbox.get()) == expected);
+            for (int msg_id = 1; msg_id <= messages; msg_id++) {
+                if (msg_id <= messages - fits) {
+                    REQUIRE(outbox_get(outbox.get(), msg_id) == nullptr);
+                } else {
+                    REQUIRE(holds(outbox.get(), msg_id, len));
+                }
+            }
+        }
+        THEN("The link comes back and the rest is acknowledged") {
+            broker.transmit(outbox.get());
+            REQUIRE(broker.in_flight.size() == fits);
+            while (!broker.in_flight.empty()) {
+                broker.puback_some(outbox.get(), 3);
+            }
+            REQUIRE(outbox_get_size(outbox.get()) == 0);
+            AND_THEN("The whole slab is usable again") {
+                pop_evicted(outbox.get());
+                auto large = payload(1, OUTBOX_SLAB_SIZE / 2);
+                REQUIRE(enqueue(outbox.get(), 1, MQTT_MSG_TYPE_PUBLISH, large) != nullptr);
+                REQUIRE(holds(outbox.get(), 1, large.size()));
+                REQUIRE(pop_evicted(outbox.get()).empty());
+            }
+        }
+    }
+
+    GIVEN("A slab full of sent messages waiting for their acknowledgement") {
+        const size_t len = 150;
+        const int fits = OUTBOX_SLAB_SIZE / 256;
+        broker_stand_in broker;
+        std::vector<uint8_t> data;
+        for (int msg_id = 1; msg_id <= fits; msg_id++) {
+            data = payload(msg_id, len);
+            REQUIRE(enqueue(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH, data) != nullptr);
+        }
+        broker.transmit(outbox.get());
+
+        THEN("A new message is rejected instead of evicting them") {
+            data = payload(fits + 1, len);
+            REQUIRE(enqueue(outbox.get(), fits + 1, MQTT_MSG_TYPE_PUBLISH, data) == nullptr);
+            REQUIRE(pop_evicted(outbox.get()).empty());
+            for (int msg_id = 1; msg_id <= fits; msg_id++) {
+                REQUIRE(holds(outbox.get(), msg_id, len));
+            }
+        }
+        THEN("Only messages not sent yet are evicted") {
+            // acknowledge the first half, queue new messages in its place
+            for (int msg_id = 1; msg_id <= fits / 2; msg_id++) {
+                REQUIRE(outbox_delete(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+            }
+            for (int msg_id = fits + 1; msg_id <= fits + fits / 2 + 2; msg_id++) {
+                data = payload(msg_id, len);
+                REQUIRE(enqueue(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH, data) != nullptr);
+            }
+            REQUIRE((pop_evicted(outbox.get()) == std::vector<int> {fits + 1, fits + 2}));
+            for (int msg_id = fits / 2 + 1; msg_id <= fits; msg_id++) {
+                REQUIRE(holds(outbox.get(), msg_id, len));
+            }
+            for (int msg_id = fits + 3; msg_id <= fits + fits / 2 + 2; msg_id++) {
+                REQUIRE(holds(outbox.get(), msg_id, len));
+            }
+        }
+    }
+
+    GIVEN("A slab full of small messages") {
+        // the item header and 40 bytes take a 128 byte chunk
+        const size_t len = 40;
+        const int fits = OUTBOX_SLAB_SIZE / 128;
+        broker_stand_in broker;
+        std::vector<uint8_t> data;
+        for (int msg_id = 1; msg_id <= fits; msg_id++) {
+            data = payload(msg_id, len);
+            REQUIRE(enqueue(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH, data) != nullptr);
+        }
+        broker.transmit(outbox.get());
+        auto large = payload(fits + 1, OUTBOX_SLAB_SIZE / 2 - 128);
+
+        THEN("Freed neighbours are merged for a large message") {
+            for (int msg_id = 1; msg_id <= fits / 2; msg_id++) {
+                REQUIRE(outbox_delete(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+            }
+            REQUIRE(enqueue(outbox.get(), fits + 1, MQTT_MSG_TYPE_PUBLISH, large) != nullptr);
+            REQUIRE(holds(outbox.get(), fits + 1, large.size()));
+            REQUIRE(pop_evicted(outbox.get()).empty());
+            for (int msg_id = fits / 2 + 1; msg_id <= fits; msg_id++) {
+                REQUIRE(holds(outbox.get(), msg_id, len));
+            }
+        }
+        THEN("Scattered free chunks are not enough and nothing is evicted") {
+            for (int msg_id = 1; msg_id <= fits; msg_id += 2) {
+                REQUIRE(outbox_delete(outbox.get(), msg_id, MQTT_MSG_TYPE_PUBLISH) == ESP_OK);
+            }
+            REQUIRE(enqueue(outbox.get(), fits + 1, MQTT_MSG_TYPE_PUBLISH, large) == nullptr);
+            REQUIRE(pop_evicted(outbox.get()).empty());
+            for (int msg_id = 2; msg_id <= fits; msg_id += 2) {
+                REQUIRE(holds(outbox.get(), msg_id, len));
+            }
+        }
+    }
+
+    GIVEN("A QoS0 message without id") {
+        auto data = payload(0, 150);
+        REQUIRE(enqueue(outbox.get(), 0, MQTT_MSG_TYPE_PUBLISH, data) != nullptr);
+        THEN("Its eviction is reported too") {
+            auto large = payload(1, OUTBOX_SLAB_SIZE - 256);
+            REQUIRE(enqueue(outbox.get(), 1, MQTT_MSG_TYPE_PUBLISH, large) != nullptr);
+            REQUIRE((pop_evicted(outbox.get()) == std::vector<int> {0}));
+        }
+    }
+
+    GIVEN("A message larger than the slab") {
+        auto data = payload(1, OUTBOX_SLAB_SIZE);
+        THEN("It is rejected without evicting anything") {
+            auto small = payload(2, 10);
+            REQUIRE(enqueue(outbox.get(), 2, MQTT_MSG_TYPE_PUBLISH, small) != nullptr);
+            REQUIRE(enqueue(outbox.get(), 1, MQTT_MSG_TYPE_PUBLISH, data) == nullptr);
+            REQUIRE(holds(outbox.get(), 2, small.size()));
+            REQUIRE(pop_evicted(outbox.get()).empty());
+        }
+    }
+}
+#endif
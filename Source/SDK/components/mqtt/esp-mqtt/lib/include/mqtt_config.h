@@ -114,5 +114,11 @@
 #define MQTT_OUTBOX_MEMORY MALLOC_CAP_DEFAULT
 #endif
 
+#ifdef CONFIG_MQTT_OUTBOX_SLAB_SIZE
+#define OUTBOX_SLAB_SIZE            CONFIG_MQTT_OUTBOX_SLAB_SIZE
+#else
+#define OUTBOX_SLAB_SIZE            (16*1024)
+#endif
+
 #define OUTBOX_MAX_SIZE             (4*1024)
 #endif
@@ -6,6 +6,7 @@
 #ifndef _MQTT_OUTOBX_H_
 #define _MQTT_OUTOBX_H_
 #include "platform.h"
+#include <stdbool.h>
 #include "esp_err.h"
 
 #ifdef  __cplusplus
@@ -57,6 +58,16 @@ esp_err_t outbox_set_tick(outbox_handle_t outbox, int msg_id, outbox_tick_t tick
 uint64_t outbox_get_size(outbox_handle_t outbox);
 void outbox_destroy(outbox_handle_t outbox);
 void outbox_delete_all_items(outbox_handle_t outbox);
+#if CONFIG_MQTT_OUTBOX_SLAB
+/**
+ * @brief Takes the id of a message the slab outbox evicted to make room for a newer one, oldest first
+ *
+ * @param[out] msg_id msg id of the evicted message, 0 for QoS0 messages
+ *
+ * @return true if an evicted message was reported, false if there are no more evicted messages to report
+ */
+bool outbox_pop_evicted(outbox_handle_t outbox, int *msg_id);
+#endif
 
 #ifdef  __cplusplus
 }
@@ -7,7 +7,7 @@
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 
-#ifndef CONFIG_MQTT_CUSTOM_OUTBOX
+#if !defined(CONFIG_MQTT_CUSTOM_OUTBOX) && !defined(CONFIG_MQTT_OUTBOX_SLAB)
 static const char *TAG = "outbox";
 
 typedef struct outbox_item {
@@ -218,4 +218,4 @@ void outbox_destroy(outbox_handle_t outbox)
     free(outbox);
 }
 
-#endif /* CONFIG_MQTT_CUSTOM_OUTBOX */
+#endif /* !CONFIG_MQTT_CUSTOM_OUTBOX && !CONFIG_MQTT_OUTBOX_SLAB */
@@ -0,0 +1,489 @@
+#include "mqtt_outbox.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mqtt_config.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#if defined(CONFIG_MQTT_OUTBOX_SLAB) && !defined(CONFIG_MQTT_CUSTOM_OUTBOX)
+static const char *TAG = "outbox";
+
+/*
+ * All messages live in one region allocated by outbox_init. The region is cut into power of two chunks
+ * (OUTBOX_SLAB_MIN_CHUNK and up), each holding the item header followed by the message data. It is a buddy
+ * allocator: a chunk is aligned to its size, larger free chunks are split when a size runs out, and a freed chunk is
+ * merged with its buddy whenever the buddy is free too, so freeing small messages gives back room for large ones.
+ */
+#define OUTBOX_SLAB_MIN_CHUNK   64
+#define OUTBOX_SLAB_CLASSES     16
+/* Enough buckets for about one item per bucket when the region is full of 256 byte chunks */
+#define OUTBOX_SLAB_BUCKET_BYTES 256
+#define OUTBOX_SLAB_CHUNKS      (OUTBOX_SLAB_SIZE / OUTBOX_SLAB_MIN_CHUNK)
+/* Chunk state, per OUTBOX_SLAB_MIN_CHUNK of the region: CHUNK_NOT_FREE, or the size class + 1 of the free chunk
+ * starting there */
+#define CHUNK_NOT_FREE          0
+
+typedef struct outbox_item {
+    char *buffer;
+    int len;
+    int msg_id;
+    int msg_type;
+    int msg_qos;
+    outbox_tick_t tick;
+    pending_state_t pending;
+    int size_class;
+    struct outbox_item *older;
+    struct outbox_item *newer;
+    struct outbox_item *next_in_bucket;
+} outbox_item_t;
+
+typedef struct outbox_free_chunk {
+    struct outbox_free_chunk *next;
+    struct outbox_free_chunk *prev;
+} outbox_free_chunk_t;
+
+struct outbox_t {
+    _Atomic uint64_t size;
+    outbox_item_t *oldest;
+    outbox_item_t *newest;
+    int count;
+    uint8_t *slab;
+    uint8_t chunk_state[OUTBOX_SLAB_CHUNKS];
+    uint8_t eviction_state[OUTBOX_SLAB_CHUNKS];
+    outbox_free_chunk_t *free_chunks[OUTBOX_SLAB_CLASSES];
+    outbox_item_t **buckets;
+    unsigned bucket_mask;
+    int *evicted;
+    int evicted_first;
+    int evicted_count;
+    int evicted_capacity;
+};
+
+static size_t chunk_size(int size_class)
+{
+    return (size_t)OUTBOX_SLAB_MIN_CHUNK << size_class;
+}
+
+static int size_class_for(size_t size)
+{
+    for (int size_class = 0; size_class < OUTBOX_SLAB_CLASSES && chunk_size(size_class) <= OUTBOX_SLAB_CHUNKS * OUTBOX_SLAB_MIN_CHUNK; size_class++) {
+        if (size <= chunk_size(size_class)) {
+            return size_class;
+        }
+    }
+    return -1;
+}
+
+static size_t chunk_offset(outbox_handle_t outbox, void *chunk)
+{
+    return (size_t)((uint8_t *)chunk - outbox->slab);
+}
+
+static void free_list_push(outbox_handle_t outbox, size_t offset, int size_class)
+{
+    outbox_free_chunk_t *chunk = (outbox_free_chunk_t *)(outbox->slab + offset);
+    chunk->prev = NULL;
+    chunk->next = outbox->free_chunks[size_class];
+    if (chunk->next) {
+        chunk->next->prev = chunk;
+    }
+    outbox->free_chunks[size_class] = chunk;
+    outbox->chunk_state[offset / OUTBOX_SLAB_MIN_CHUNK] = size_class + 1;
+}
+
+static void free_list_remove(outbox_handle_t outbox, outbox_free_chunk_t *chunk, int size_class)
+{
+    if (chunk->prev) {
+        chunk->prev->next = chunk->next;
+    } else {
+        outbox->free_chunks[size_class] = chunk->next;
+    }
+    if (chunk->next) {
+        chunk->next->prev = chunk->prev;
+    }
+    outbox->chunk_state[chunk_offset(outbox, chunk) / OUTBOX_SLAB_MIN_CHUNK] = CHUNK_NOT_FREE;
+}
+
+/*
+ * Merges the free chunk at offset with its free buddies in state, returns the size class of the merged chunk.
+ * The free lists are updated when state is the outbox chunk state, a copy of it is used to try out evictions.
+ */
+static int chunk_merge(outbox_handle_t outbox, uint8_t *state, size_t *offset, int size_class)
+{
+    while (size_class + 1 < OUTBOX_SLAB_CLASSES) {
+        size_t buddy = *offset ^ chunk_size(size_class);
+        if (buddy + chunk_size(size_class) > OUTBOX_SLAB_CHUNKS * OUTBOX_SLAB_MIN_CHUNK ||
+                state[buddy / OUTBOX_SLAB_MIN_CHUNK] != size_class + 1) {
+            break;
+        }
+        if (state == outbox->chunk_state) {
+            free_list_remove(outbox, (outbox_free_chunk_t *)(outbox->slab + buddy), size_class);
+        } else {
+            state[buddy / OUTBOX_SLAB_MIN_CHUNK] = CHUNK_NOT_FREE;
+        }
+        if (buddy < *offset) {
+            *offset = buddy;
+        }
+        size_class++;
+    }
+    return size_class;
+}
+
+static void slab_init(outbox_handle_t outbox)
+{
+    // cut the region into the largest aligned chunks, they are never merged past its end
+    size_t offset = 0;
+    while (offset + OUTBOX_SLAB_MIN_CHUNK <= OUTBOX_SLAB_CHUNKS * OUTBOX_SLAB_MIN_CHUNK) {
+        int size_class = 0;
+        while (size_class + 1 < OUTBOX_SLAB_CLASSES && offset % chunk_size(size_class + 1) == 0 &&
+                offset + chunk_size(size_class + 1) <= OUTBOX_SLAB_CHUNKS * OUTBOX_SLAB_MIN_CHUNK) {
+            size_class++;
+        }
+        free_list_push(outbox, offset, size_class);
+        offset += chunk_size(size_class);
+    }
+}
+
+static outbox_item_t *slab_alloc(outbox_handle_t outbox, int size_class)
+{
+    for (int larger = size_class; larger < OUTBOX_SLAB_CLASSES; larger++) {
+        outbox_free_chunk_t *chunk = outbox->free_chunks[larger];
+        if (chunk) {
+            free_list_remove(outbox, chunk, larger);
+            // keep the lower half, return the upper halves to the smaller free lists
+            while (larger > size_class) {
+                larger--;
+                free_list_push(outbox, chunk_offset(outbox, chunk) + chunk_size(larger), larger);
+            }
+            return (outbox_item_t *)chunk;
+        }
+    }
+    return NULL;
+}
+
+static void slab_free(outbox_handle_t outbox, outbox_item_t *item)
+{
+    size_t offset = chunk_offset(outbox, item);
+    int size_class = chunk_merge(outbox, outbox->chunk_state, &offset, item->size_class);
+    free_list_push(outbox, offset, size_class);
+}
+
+static outbox_item_t **bucket_of(outbox_handle_t outbox, int msg_id)
+{
+    return &outbox->buckets[(unsigned)msg_id & outbox->bucket_mask];
+}
+
+static void outbox_link(outbox_handle_t outbox, outbox_item_t *item)
+{
+    item->older = outbox->newest;
+    item->newer = NULL;
+    if (outbox->newest) {
+        outbox->newest->newer = item;
+    } else {
+        outbox->oldest = item;
+    }
+    outbox->newest = item;
+
+    // append, so that lookups find the oldest item with a given id first, like a walk of the list would
+    outbox_item_t **link = bucket_of(outbox, item->msg_id);
+    while (*link) {
+        link = &(*link)->next_in_bucket;
+    }
+    item->next_in_bucket = NULL;
+    *link = item;
+
+    outbox->size += item->len;
+    outbox->count++;
+}
+
+static void outbox_unlink(outbox_handle_t outbox, outbox_item_t *item)
+{
+    if (item->older) {
+        item->older->newer = item->newer;
+    } else {
+        outbox->oldest = item->newer;
+    }
+    if (item->newer) {
+        item->newer->older = item->older;
+    } else {
+        outbox->newest = item->older;
+    }
+
+    outbox_item_t **link = bucket_of(outbox, item->msg_id);
+    while (*link != item) {
+        link = &(*link)->next_in_bucket;
+    }
+    *link = item->next_in_bucket;
+
+    outbox->size -= item->len;
+    outbox->count--;
+    slab_free(outbox, item);
+}
+
+/*
+ * Only messages which were not sent yet are evicted. Sent QoS1/2 messages wait for their acknowledgement and must
+ * not disappear from the outbox. Returns the newest message to evict, oldest first, so that a chunk of size_class
+ * becomes free, or NULL if evicting every message not sent yet isn't enough.
+ */
+static outbox_item_t *outbox_eviction_end(outbox_handle_t outbox, int size_class)
+{
+    memcpy(outbox->eviction_state, outbox->chunk_state, sizeof(outbox->eviction_state));
+    for (outbox_item_t *item = outbox->oldest; item; item = item->newer) {
+        if (item->pending != QUEUED) {
+            continue;
+        }
+        size_t offset = chunk_offset(outbox, item);
+        int merged_class = chunk_merge(outbox, outbox->eviction_state, &offset, item->size_class);
+        outbox->eviction_state[offset / OUTBOX_SLAB_MIN_CHUNK] = merged_class + 1;
+        if (merged_class >= size_class) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static bool outbox_report_evicted(outbox_handle_t outbox, int msg_id)
+{
+    if (outbox->evicted_count == outbox->evicted_capacity) {
+        int capacity = outbox->evicted_capacity ? outbox->evicted_capacity * 2 : 8;
+        int *evicted = malloc(capacity * sizeof(int));
+        if (evicted == NULL) {
+            return false;
+        }
+        for (int i = 0; i < outbox->evicted_count; i++) {
+            evicted[i] = outbox->evicted[(outbox->evicted_first + i) % outbox->evicted_capacity];
+        }
+        free(outbox->evicted);
+        outbox->evicted = evicted;
+        outbox->evicted_first = 0;
+        outbox->evicted_capacity = capacity;
+    }
+    outbox->evicted[(outbox->evicted_first + outbox->evicted_count) % outbox->evicted_capacity] = msg_id;
+    outbox->evicted_count++;
+    return true;
+}
+
+static void outbox_evict(outbox_handle_t outbox, outbox_item_t *item)
+{
+    ESP_LOGW(TAG, "EVICTED msgid=%d, msg_type=%d to make room", item->msg_id, item->msg_type);
+    if (!outbox_report_evicted(outbox, item->msg_id)) {
+        ESP_LOGE(TAG, "No memory to report the eviction of msgid=%d", item->msg_id);
+    }
+    outbox_unlink(outbox, item);
+}
+
+outbox_handle_t outbox_init(void)
+{
+    outbox_handle_t outbox = calloc(1, sizeof(struct outbox_t));
+    ESP_MEM_CHECK(TAG, outbox, return NULL);
+    unsigned buckets = 16;
+    while (buckets * OUTBOX_SLAB_BUCKET_BYTES < OUTBOX_SLAB_SIZE) {
+        buckets *= 2;
+    }
+    outbox->buckets = calloc(buckets, sizeof(outbox_item_t *));
+    ESP_MEM_CHECK(TAG, outbox->buckets, {free(outbox); return NULL;});
+    outbox->bucket_mask = buckets - 1;
+    outbox->slab = heap_caps_malloc(OUTBOX_SLAB_SIZE, MQTT_OUTBOX_MEMORY);
+    ESP_MEM_CHECK(TAG, outbox->slab, {free(outbox->buckets); free(outbox); return NULL;});
+    slab_init(outbox);
+    outbox->size = 0;
+    return outbox;
+}
+
+outbox_item_handle_t outbox_enqueue(outbox_handle_t outbox, outbox_message_handle_t message, outbox_tick_t tick)
+{
+    int len = message->len + message->remaining_len;
+    int size_class = size_class_for(sizeof(outbox_item_t) + len);
+    if (size_class < 0) {
+        ESP_LOGE(TAG, "Message of %d bytes doesn't fit the outbox slab of %d bytes", len, OUTBOX_SLAB_SIZE);
+        return NULL;
+    }
+    outbox_item_handle_t item = slab_alloc(outbox, size_class);
+    if (item == NULL) {
+        outbox_item_t *last = outbox_eviction_end(outbox, size_class);
+        if (last == NULL) {
+            ESP_LOGE(TAG, "No room for msgid=%d of %d bytes, the outbox is full of sent messages", message->msg_id, len);
+            return NULL;
+        }
+        outbox_item_t *evict = outbox->oldest;
+        while (evict != last) {
+            outbox_item_t *newer = evict->newer;
+            if (evict->pending == QUEUED) {
+                outbox_evict(outbox, evict);
+            }
+            evict = newer;
+        }
+        outbox_evict(outbox, last);
+        item = slab_alloc(outbox, size_class);
+        assert(item);
+    }
+    item->buffer = (char *)(item + 1);
+    item->len = len;
+    item->msg_id = message->msg_id;
+    item->msg_type = message->msg_type;
+    item->msg_qos = message->msg_qos;
+    item->tick = tick;
+    item->pending = QUEUED;
+    item->size_class = size_class;
+    memcpy(item->buffer, message->data, message->len);
+    if (message->remaining_data) {
+        memcpy(item->buffer + message->len, message->remaining_data, message->remaining_len);
+    }
+    outbox_link(outbox, item);
+    ESP_LOGD(TAG, "ENQUEUE msgid=%d, msg_type=%d, len=%d, size=%"PRIu64, message->msg_id, message->msg_type, len, outbox_get_size(outbox));
+    return item;
+}
+
+outbox_item_handle_t outbox_get(outbox_handle_t outbox, int msg_id)
+{
+    outbox_item_handle_t item;
+    for (item = *bucket_of(outbox, msg_id); item; item = item->next_in_bucket) {
+        if (item->msg_id == msg_id) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+outbox_item_handle_t outbox_dequeue(outbox_handle_t outbox, pending_state_t pending, outbox_tick_t *tick)
+{
+    outbox_item_handle_t item;
+    for (item = outbox->oldest; item; item = item->newer) {
+        if (item->pending == pending) {
+            if (tick) {
+                *tick = item->tick;
+            }
+            return item;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t outbox_delete_item(outbox_handle_t outbox, outbox_item_handle_t item_to_delete)
+{
+    outbox_item_handle_t item;
+    for (item = outbox_get(outbox, item_to_delete->msg_id); item; item = item->next_in_bucket) {
+        if (item == item_to_delete) {
+            outbox_unlink(outbox, item);
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+uint8_t *outbox_item_get_data(outbox_item_handle_t item,  size_t *len, uint16_t *msg_id, int *msg_type, int *qos)
+{
+    if (item) {
+        *len = item->len;
+        *msg_id = item->msg_id;
+        *msg_type = item->msg_type;
+        *qos = item->msg_qos;
+        return (uint8_t *)item->buffer;
+    }
+    return NULL;
+}
+
+esp_err_t outbox_delete(outbox_handle_t outbox, int msg_id, int msg_type)
+{
+    outbox_item_handle_t item;
+    for (item = *bucket_of(outbox, msg_id); item; item = item->next_in_bucket) {
+        if (item->msg_id == msg_id && (0xFF & (item->msg_type)) == msg_type) {
+            outbox_unlink(outbox, item);
+            ESP_LOGD(TAG, "DELETED msgid=%d, msg_type=%d, remain size=%"PRIu64, msg_id, msg_type, outbox_get_size(outbox));
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+esp_err_t outbox_set_pending(outbox_handle_t outbox, int msg_id, pending_state_t pending)
+{
+    outbox_item_handle_t item = outbox_get(outbox, msg_id);
+    if (item) {
+        item->pending = pending;
+        return ESP_OK;
+    }
+    return ESP_FAIL;
+}
+
+pending_state_t outbox_item_get_pending(outbox_item_handle_t item)
+{
+    if (item) {
+        return item->pending;
+    }
+    return QUEUED;
+}
+
+esp_err_t outbox_set_tick(outbox_handle_t outbox, int msg_id, outbox_tick_t tick)
+{
+    outbox_item_handle_t item = outbox_get(outbox, msg_id);
+    if (item) {
+        item->tick = tick;
+        return ESP_OK;
+    }
+    return ESP_FAIL;
+}
+
+int outbox_delete_single_expired(outbox_handle_t outbox, outbox_tick_t current_tick, outbox_tick_t timeout)
+{
+    outbox_item_handle_t item;
+    for (item = outbox->oldest; item; item = item->newer) {
+        if (current_tick - item->tick > timeout) {
+            int msg_id = item->msg_id;
+            outbox_unlink(outbox, item);
+            return msg_id;
+        }
+    }
+    return -1;
+}
+
+int outbox_delete_expired(outbox_handle_t outbox, outbox_tick_t current_tick, outbox_tick_t timeout)
+{
+    int deleted_items = 0;
+    outbox_item_handle_t item, tmp;
+    for (item = outbox->oldest; item; item = tmp) {
+        tmp = item->newer;
+        if (current_tick - item->tick > timeout) {
+            outbox_unlink(outbox, item);
+            deleted_items ++;
+        }
+    }
+    return deleted_items;
+}
+
+bool outbox_pop_evicted(outbox_handle_t outbox, int *msg_id)
+{
+    if (outbox->evicted_count == 0) {
+        return false;
+    }
+    *msg_id = outbox->evicted[outbox->evicted_first];
+    outbox->evicted_first = (outbox->evicted_first + 1) % outbox->evicted_capacity;
+    outbox->evicted_count--;
+    return true;
+}
+
+uint64_t outbox_get_size(outbox_handle_t outbox)
+{
+    return outbox->size;
+}
+
+void outbox_delete_all_items(outbox_handle_t outbox)
+{
+    while (outbox->oldest) {
+        outbox_unlink(outbox, outbox->oldest);
+    }
+}
+
+void outbox_destroy(outbox_handle_t outbox)
+{
+    outbox_delete_all_items(outbox);
+    heap_caps_free(outbox->slab);
+    free(outbox->buckets);
+    free(outbox->evicted);
+    free(outbox);
+}
+
+#endif /* CONFIG_MQTT_OUTBOX_SLAB */
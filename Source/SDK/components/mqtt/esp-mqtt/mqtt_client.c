@@ -1540,8 +1540,23 @@ static void mqtt_delete_expired_messages(esp_mqtt_client_handle_t client)
             ESP_LOGE(TAG, "Failed to post event on deleting message id=%d", msg_id);
         }
     }
+#if CONFIG_MQTT_OUTBOX_SLAB
+    while (outbox_pop_evicted(client->outbox, &msg_id)) {
+        client->event.event_id = MQTT_EVENT_DELETED;
+        client->event.msg_id = msg_id;
+        if (esp_mqtt_dispatch_event(client) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to post event on deleting message id=%d", msg_id);
+        }
+    }
+#endif
 #else
     outbox_delete_expired(client->outbox, platform_tick_get_ms(), OUTBOX_EXPIRED_TIMEOUT_MS);
+#if CONFIG_MQTT_OUTBOX_SLAB
+    // the evicted messages are not reported, drop their ids
+    int msg_id = 0;
+    while (outbox_pop_evicted(client->outbox, &msg_id)) {
+    }
+#endif
 #endif
 }
 
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <string>
 #include <random>
+#include <chrono>
 #include "test_fixtures.hpp"
 
 #define TEST_ESP_ERR(rc, res) CHECK((rc) == (res))
@@ -3408,6 +3409,99 @@ TEST_CASE("nvs find key tests", "[nvs]")
     nvs_close(handle_2);
     TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
 }
+
+TEST_CASE("benchmark nvs_get of existing and missing keys", "[nvs][perf]")
+{
+    const uint32_t NVS_FLASH_SECTOR = 0;
+    const uint32_t NVS_FLASH_SECTOR_COUNT = 20;
+    const size_t key_counts[] = {16, 128, 1024};
+#ifdef CONFIG_NVS_KEY_INDEX
+    const char *variant = "with key index";
+#else
+    const char *variant = "without key index";
+#endif
+
+    for (size_t key_count : key_counts) {
+        PartitionEmulationFixture f(0, NVS_FLASH_SECTOR_COUNT);
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(),
+                    NVS_FLASH_SECTOR,
+                    NVS_FLASH_SECTOR_COUNT));
+
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("bench", NVS_READWRITE, &handle));
+        char key[16];
+        for (size_t i = 0; i < key_count; ++i) {
+            snprintf(key, sizeof(key), "key%u", (unsigned) i);
+            TEST_ESP_OK(nvs_set_i32(handle, key, (int32_t) i));
+        }
+
+        // CHECK is kept out of the timed loops, count failures instead
+        size_t failures = 0;
+        int32_t value;
+        esp_partition_clear_stats();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < key_count; ++i) {
+            snprintf(key, sizeof(key), "key%u", (unsigned) i);
+            if (nvs_get_i32(handle, key, &value) != ESP_OK || value != (int32_t) i) {
+                ++failures;
+            }
+        }
+        auto hit_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        size_t hit_reads = esp_partition_get_read_ops();
+
+        esp_partition_clear_stats();
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < key_count; ++i) {
+            snprintf(key, sizeof(key), "miss%u", (unsigned) i);
+            if (nvs_get_i32(handle, key, &value) != ESP_ERR_NVS_NOT_FOUND) {
+                ++failures;
+            }
+        }
+        auto miss_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        size_t miss_reads = esp_partition_get_read_ops();
+        CHECK(failures == 0);
+
+        s_perf << "nvs_get_i32 " << variant << ", " << key_count << " keys: existing key "
+               << hit_ns / key_count << " ns (" << (double) hit_reads / key_count << " reads), missing key "
+               << miss_ns / key_count << " ns (" << (double) miss_reads / key_count << " reads)" << std::endl;
+
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+}
+
+TEST_CASE("storage finds keys after garbage collection, reinit and namespace erase", "[nvs]")
+{
+    PartitionEmulationFixture f(0, 8);
+    nvs::Storage storage(f.part());
+    TEST_ESP_OK(storage.init(4, 4));
+
+    // Overwrite one key until its page and the pages around it have been reclaimed
+    int32_t value = 0;
+    TEST_ESP_OK(storage.writeItem(1, "stable", static_cast<int32_t>(42)));
+    for (size_t i = 0; i < nvs::Page::ENTRY_COUNT * 4 * 2; ++i) {
+        TEST_ESP_OK(storage.writeItem(1, "moving", static_cast<int32_t>(i)));
+    }
+    TEST_ESP_OK(storage.readItem(1, "stable", value));
+    CHECK(value == 42);
+    TEST_ESP_OK(storage.readItem(1, "moving", value));
+    CHECK(value == static_cast<int32_t>(nvs::Page::ENTRY_COUNT * 4 * 2 - 1));
+    TEST_ESP_ERR(storage.readItem(1, "missing", value), ESP_ERR_NVS_NOT_FOUND);
+
+    TEST_ESP_OK(storage.writeItem(2, "other", static_cast<int32_t>(7)));
+    TEST_ESP_OK(storage.eraseNamespace(1));
+    TEST_ESP_ERR(storage.readItem(1, "stable", value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_ERR(storage.readItem(1, "moving", value), ESP_ERR_NVS_NOT_FOUND);
+
+    nvs::Storage storage2(f.part());
+    TEST_ESP_OK(storage2.init(4, 4));
+    TEST_ESP_OK(storage2.readItem(2, "other", value));
+    CHECK(value == 7);
+    TEST_ESP_ERR(storage2.readItem(1, "moving", value), ESP_ERR_NVS_NOT_FOUND);
+    TEST_ESP_OK(storage2.eraseItem(2, "other"));
+    TEST_ESP_ERR(storage2.readItem(2, "other", value), ESP_ERR_NVS_NOT_FOUND);
+}
+
 /* Add new tests above */
 /* This test has to be the final one */
 
@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <catch2/catch_test_macros.hpp>
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "nvs_counter.h"
+#include "nvs_partition_manager.hpp"
+#include "test_fixtures.hpp"
+#include <iostream>
+#include <random>
+
+#define TEST_ESP_OK(rc) CHECK((rc) == ESP_OK)
+
+TEST_CASE("nvs_counter keeps its value across reopen and sector changes", "[nvs_counter]")
+{
+    PartitionEmulationFixture f(0, 4);
+    nvs_counter_config_t config = {f.get_esp_partition(), 1, 3};
+    nvs_counter_handle_t counter;
+    uint64_t value;
+
+    TEST_ESP_OK(nvs_counter_open(&config, &counter));
+    TEST_ESP_OK(nvs_counter_get(counter, &value));
+    CHECK(value == 0);
+
+    // Mix of tally increments, delta words and a value which needs several words,
+    // enough to go around the ring of sectors more than once
+    std::mt19937 gen(42);
+    uint64_t expected = 0;
+    for (int i = 0; i < 20000; ++i) {
+        uint32_t delta = (i % 3 == 0) ? 1 : (i % 3 == 1) ? gen() % 32 : gen() % 100000;
+        TEST_ESP_OK(nvs_counter_add(counter, delta));
+        expected += delta;
+    }
+    TEST_ESP_OK(nvs_counter_add(counter, 10000000));
+    expected += 10000000;
+    TEST_ESP_OK(nvs_counter_add(counter, 3));
+    expected += 3;
+
+    TEST_ESP_OK(nvs_counter_get(counter, &value));
+    CHECK(value == expected);
+    nvs_counter_close(counter);
+
+    TEST_ESP_OK(nvs_counter_open(&config, &counter));
+    TEST_ESP_OK(nvs_counter_get(counter, &value));
+    CHECK(value == expected);
+    TEST_ESP_OK(nvs_counter_add(counter, 7));
+    nvs_counter_close(counter);
+
+    TEST_ESP_OK(nvs_counter_open(&config, &counter));
+    TEST_ESP_OK(nvs_counter_get(counter, &value));
+    CHECK(value == expected + 7);
+    nvs_counter_close(counter);
+}
+
+TEST_CASE("nvs_counter ignores a word torn by power loss", "[nvs_counter]")
+{
+    PartitionEmulationFixture f(0, 2);
+    nvs_counter_config_t config = {f.get_esp_partition(), 0, 2};
+    nvs_counter_handle_t counter;
+    uint64_t value;
+
+    TEST_ESP_OK(nvs_counter_open(&config, &counter));
+    TEST_ESP_OK(nvs_counter_add(counter, 1000));
+    nvs_counter_close(counter);
+
+    // Delta word which lost some of its cleared bits, right after the 32-byte header and the first word
+    const uint32_t torn = 0xc00003e8;
+    TEST_ESP_OK(esp_partition_write(f.get_esp_partition(), 32 + 4, &torn, sizeof(torn)));
+
+    TEST_ESP_OK(nvs_counter_open(&config, &counter));
+    TEST_ESP_OK(nvs_counter_get(counter, &value));
+    CHECK(value == 1000);
+    TEST_ESP_OK(nvs_counter_add(counter, 5));
+    nvs_counter_close(counter);
+
+    TEST_ESP_OK(nvs_counter_open(&config, &counter));
+    TEST_ESP_OK(nvs_counter_get(counter, &value));
+    CHECK(value == 1005);
+    nvs_counter_close(counter);
+}
+
+TEST_CASE("nvs_counter rejects invalid regions", "[nvs_counter]")
+{
+    PartitionEmulationFixture f(0, 4);
+    nvs_counter_handle_t counter;
+
+    nvs_counter_config_t too_short = {f.get_esp_partition(), 0, 1};
+    CHECK(nvs_counter_open(&too_short, &counter) == ESP_ERR_INVALID_ARG);
+    nvs_counter_config_t too_long = {f.get_esp_partition(), 2, 3};
+    CHECK(nvs_counter_open(&too_long, &counter) == ESP_ERR_INVALID_ARG);
+    CHECK(nvs_counter_open(nullptr, &counter) == ESP_ERR_INVALID_ARG);
+}
+
+TEST_CASE("nvs_counter wear compared to nvs_set_u32", "[nvs_counter][perf]")
+{
+    const uint32_t INCREMENTS = 1000000;
+    const uint32_t SECTOR_COUNT = 4;
+
+    size_t nvs_erases;
+    {
+        PartitionEmulationFixture f(0, SECTOR_COUNT);
+        TEST_ESP_OK(nvs::NVSPartitionManager::get_instance()->init_custom(f.part(), 0, SECTOR_COUNT));
+        nvs_handle_t handle;
+        TEST_ESP_OK(nvs_open("counter", NVS_READWRITE, &handle));
+
+        esp_partition_clear_stats();
+        size_t failures = 0;
+        for (uint32_t i = 1; i <= INCREMENTS; ++i) {
+            if (nvs_set_u32(handle, "energy", i) != ESP_OK) {
+                ++failures;
+            }
+        }
+        nvs_erases = esp_partition_get_erase_ops();
+        CHECK(failures == 0);
+
+        nvs_close(handle);
+        TEST_ESP_OK(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME));
+    }
+
+    size_t counter_erases[2];
+    const char *variants[] = {"+1", "+1..20"};
+    for (int variant = 0; variant < 2; ++variant) {
+        PartitionEmulationFixture f(0, SECTOR_COUNT);
+        nvs_counter_config_t config = {f.get_esp_partition(), 0, SECTOR_COUNT};
+        nvs_counter_handle_t counter;
+        TEST_ESP_OK(nvs_counter_open(&config, &counter));
+
+        std::mt19937 gen(variant);
+        uint64_t expected = 0;
+        size_t failures = 0;
+        esp_partition_clear_stats();
+        for (uint32_t i = 0; i < INCREMENTS; ++i) {
+            uint32_t delta = (variant == 0) ? 1 : 1 + gen() % 20;
+            if (nvs_counter_add(counter, delta) != ESP_OK) {
+                ++failures;
+            }
+            expected += delta;
+        }
+        counter_erases[variant] = esp_partition_get_erase_ops();
+        CHECK(failures == 0);
+
+        uint64_t value;
+        TEST_ESP_OK(nvs_counter_get(counter, &value));
+        CHECK(value == expected);
+        nvs_counter_close(counter);
+    }
+
+    std::cout << "Sector erases for " << INCREMENTS << " counter updates: nvs_set_u32 " << nvs_erases;
+    for (int variant = 0; variant < 2; ++variant) {
+        std::cout << ", nvs_counter_add(" << variants[variant] << ") " << counter_erases[variant];
+        CHECK(counter_erases[variant] * 10 <= nvs_erases);
+    }
+    std::cout << std::endl;
+}
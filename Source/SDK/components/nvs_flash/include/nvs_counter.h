@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef nvs_counter_h
+#define nvs_counter_h
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opaque pointer type representing an open counter
+ */
+typedef struct nvs_counter *nvs_counter_handle_t;
+
+/**
+ * @brief Location of a counter in flash
+ *
+ * A counter occupies a region of whole sectors in a data partition. The region
+ * must not be used by anything else, in particular it must not overlap an NVS
+ * partition initialized with nvs_flash_init_partition().
+ */
+typedef struct {
+    const esp_partition_t *partition;   /*!< Partition holding the counter region, must not be encrypted */
+    uint32_t first_sector;              /*!< First sector of the region, relative to the start of the partition */
+    uint32_t sector_count;              /*!< Number of sectors in the region, at least 2 */
+} nvs_counter_config_t;
+
+/**
+ * @brief      Open a counter and restore its value from flash
+ *
+ * If the region holds no valid counter data, e.g. because it has never been
+ * used, the first sector of the region is erased and the counter starts at 0.
+ *
+ * @param[in]  config      Location of the counter.
+ * @param[out] out_handle  If successful (return code is zero), handle will be
+ *                         returned in this argument.
+ *
+ * @return
+ *             - ESP_OK if the counter was opened successfully
+ *             - ESP_ERR_INVALID_ARG if config or out_handle is NULL, or the region
+ *               does not fit into the partition or is shorter than 2 sectors
+ *             - ESP_ERR_NOT_SUPPORTED if the partition is encrypted
+ *             - ESP_ERR_NO_MEM in case memory could not be allocated for the internal structures
+ *             - other error codes from the esp_partition API
+ */
+esp_err_t nvs_counter_open(const nvs_counter_config_t *config, nvs_counter_handle_t *out_handle);
+
+/**
+ * @brief      Add a value to a counter
+ *
+ * Increments by up to 31 are stored by clearing bits of a 32-bit word which
+ * already holds the previous increments, larger ones take a 32-bit word each.
+ * When the current sector is full, the total is written to the header of the
+ * next sector of the region, which is the only time a sector is erased.
+ *
+ * Values larger than 4194303 are stored as several words. If power is lost
+ * while this function runs, the value added may be missing or only partially
+ * recorded after the next nvs_counter_open(), the value before the call is
+ * always kept.
+ *
+ * @param[in]  handle  Handle obtained from nvs_counter_open().
+ * @param[in]  delta   Value to add.
+ *
+ * @return
+ *             - ESP_OK if the value was stored
+ *             - ESP_ERR_INVALID_ARG if handle is NULL
+ *             - other error codes from the esp_partition API
+ */
+esp_err_t nvs_counter_add(nvs_counter_handle_t handle, uint32_t delta);
+
+/**
+ * @brief      Get the current value of a counter
+ *
+ * The value is kept in RAM, this function does not access flash.
+ *
+ * @param[in]  handle     Handle obtained from nvs_counter_open().
+ * @param[out] out_value  Current value of the counter.
+ *
+ * @return
+ *             - ESP_OK if the value was returned
+ *             - ESP_ERR_INVALID_ARG if handle or out_value is NULL
+ */
+esp_err_t nvs_counter_get(nvs_counter_handle_t handle, uint64_t *out_value);
+
+/**
+ * @brief      Close a counter and free the memory it uses
+ *
+ * All values added with nvs_counter_add() are already in flash, so closing
+ * a counter is not required before power off.
+ *
+ * @param[in]  handle  Handle obtained from nvs_counter_open(), may be NULL.
+ */
+void nvs_counter_close(nvs_counter_handle_t handle);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif //nvs_counter_h
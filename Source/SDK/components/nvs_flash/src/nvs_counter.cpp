@@ -0,0 +1,321 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "nvs_counter.h"
+#include <new>
+#include <cstring>
+#include <cinttypes>
+#include <algorithm>
+#include <esp_rom_crc.h>
+#include "spi_flash_mmap.h"
+#include "nvs_platform.hpp"
+#include "nvs_memory_management.hpp"
+
+// Uncomment this line to force output from this module
+// #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
+#include "esp_log.h"
+static const char* TAG = "nvs_counter";
+
+using namespace nvs;
+
+/*
+ * A counter region is a ring of sectors. Only one sector is active at a time.
+ * It starts with a header holding the counter value at the time the sector was
+ * started, followed by 32-bit words recording what was added since:
+ *
+ *  - 0xffffffff: empty word, the first one ends the log
+ *  - bit 31 clear: tally word, each other cleared bit adds one. The word is
+ *    started with bit 31 and the first increments cleared in one write, and
+ *    later increments clear further bits of the same word, lowest bits first.
+ *  - bits 31..30 = 10: delta word, bits 21..0 hold the value added and
+ *    bits 29..22 a check value, so that a word torn by a power loss is ignored.
+ *  - bits 31..30 = 11: torn write, ignored.
+ *
+ * When the active sector is full, the next sector of the ring is erased and
+ * started with the current value. The header is written last and protected
+ * by a CRC, so until it is complete, the previous sector stays the active one.
+ */
+
+namespace
+{
+
+const uint32_t SEC_SIZE = SPI_FLASH_SEC_SIZE;
+const uint32_t HEADER_MAGIC = 0x434e5643; // "CVNC"
+const uint32_t EMPTY_WORD = 0xffffffff;
+
+const uint32_t TALLY_FLAG = 0x80000000;
+const uint32_t TALLY_UNITS = 31;
+
+const uint32_t DELTA_TAG = 0x80000000;
+const uint32_t DELTA_CHECK_SHIFT = 22;
+const uint32_t DELTA_MAX = (1u << DELTA_CHECK_SHIFT) - 1;
+
+struct CounterHeader {
+    uint32_t mMagic;
+    uint32_t mSeqNumber;
+    uint64_t mBase;
+    uint32_t mCrc32;
+    uint8_t mReserved[12];
+
+    uint32_t calculateCrc32() const
+    {
+        return esp_rom_crc32_le(0xffffffff, reinterpret_cast<const uint8_t*>(this), offsetof(CounterHeader, mCrc32));
+    }
+};
+
+static_assert(sizeof(CounterHeader) == 32, "counter header size must be 32 bytes");
+
+const size_t WORD_COUNT = (SEC_SIZE - sizeof(CounterHeader)) / sizeof(uint32_t);
+
+uint32_t deltaCheck(uint32_t delta)
+{
+    return ((delta * 2654435761u) >> 24) & 0xff;
+}
+
+uint32_t makeDeltaWord(uint32_t delta)
+{
+    return DELTA_TAG | (deltaCheck(delta) << DELTA_CHECK_SHIFT) | delta;
+}
+
+// Number of units recorded in a tally word
+uint32_t tallyUnits(uint32_t word)
+{
+    return TALLY_UNITS - __builtin_popcount(word & ~TALLY_FLAG);
+}
+
+// Adds units to a tally word by clearing its lowest set bits
+uint32_t addTallyUnits(uint32_t word, uint32_t units)
+{
+    for (; units > 0; --units) {
+        word &= word - 1;
+    }
+    return word;
+}
+
+} // namespace
+
+struct nvs_counter : public ExceptionlessAllocatable {
+    const esp_partition_t* mPartition;
+    uint32_t mFirstSector;
+    uint32_t mSectorCount;
+
+    uint32_t mActiveSector;     // index of the active sector within the region
+    uint32_t mSeqNumber;        // sequence number of the active sector
+    uint64_t mBase;             // value at the start of the active sector
+    uint64_t mSum;              // value added in the active sector
+    size_t mNextWord;           // index of the first empty word in the active sector
+    bool mTallyOpen;            // the word before mNextWord is a tally word with free units
+    uint32_t mTallyWord;        // value of that tally word
+
+    size_t sectorOffset(uint32_t sector) const
+    {
+        return (mFirstSector + sector) * SEC_SIZE;
+    }
+
+    size_t wordOffset(size_t word) const
+    {
+        return sectorOffset(mActiveSector) + sizeof(CounterHeader) + word * sizeof(uint32_t);
+    }
+
+    esp_err_t readHeader(uint32_t sector, CounterHeader& header, bool& valid)
+    {
+        esp_err_t err = esp_partition_read(mPartition, sectorOffset(sector), &header, sizeof(header));
+        if (err != ESP_OK) {
+            return err;
+        }
+        valid = header.mMagic == HEADER_MAGIC && header.mCrc32 == header.calculateCrc32();
+        return ESP_OK;
+    }
+
+    esp_err_t startSector(uint32_t sector, uint32_t seqNumber, uint64_t base)
+    {
+        esp_err_t err = esp_partition_erase_range(mPartition, sectorOffset(sector), SEC_SIZE);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        CounterHeader header;
+        memset(&header, 0xff, sizeof(header));
+        header.mMagic = HEADER_MAGIC;
+        header.mSeqNumber = seqNumber;
+        header.mBase = base;
+        header.mCrc32 = header.calculateCrc32();
+        err = esp_partition_write(mPartition, sectorOffset(sector), &header, sizeof(header));
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        mActiveSector = sector;
+        mSeqNumber = seqNumber;
+        mBase = base;
+        mSum = 0;
+        mNextWord = 0;
+        mTallyOpen = false;
+        return ESP_OK;
+    }
+
+    esp_err_t load()
+    {
+        bool found = false;
+        for (uint32_t sector = 0; sector < mSectorCount; ++sector) {
+            CounterHeader header;
+            bool valid;
+            esp_err_t err = readHeader(sector, header, valid);
+            if (err != ESP_OK) {
+                return err;
+            }
+            if (valid && (!found || header.mSeqNumber > mSeqNumber)) {
+                found = true;
+                mActiveSector = sector;
+                mSeqNumber = header.mSeqNumber;
+                mBase = header.mBase;
+            }
+        }
+        if (!found) {
+            ESP_LOGD(TAG, "no counter found in partition %s at sector %" PRIu32 ", starting at 0",
+                     mPartition->label, mFirstSector);
+            return startSector(0, 1, 0);
+        }
+
+        mSum = 0;
+        mNextWord = 0;
+        mTallyOpen = false;
+        uint32_t words[64];
+        while (mNextWord < WORD_COUNT) {
+            size_t count = std::min(WORD_COUNT - mNextWord, sizeof(words) / sizeof(words[0]));
+            esp_err_t err = esp_partition_read(mPartition, wordOffset(mNextWord), words, count * sizeof(uint32_t));
+            if (err != ESP_OK) {
+                return err;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t word = words[i];
+                if (word == EMPTY_WORD) {
+                    return ESP_OK;
+                }
+                ++mNextWord;
+                mTallyOpen = false;
+                if ((word & TALLY_FLAG) == 0) {
+                    mTallyWord = word;
+                    mTallyOpen = tallyUnits(word) < TALLY_UNITS;
+                    mSum += tallyUnits(word);
+                } else if ((word & ~DELTA_MAX) == (DELTA_TAG | (deltaCheck(word & DELTA_MAX) << DELTA_CHECK_SHIFT))) {
+                    mSum += word & DELTA_MAX;
+                } else {
+                    ESP_LOGW(TAG, "ignoring invalid word 0x%08" PRIx32 " in partition %s", word, mPartition->label);
+                }
+            }
+        }
+        return ESP_OK;
+    }
+
+    esp_err_t writeWord(size_t index, uint32_t word)
+    {
+        return esp_partition_write(mPartition, wordOffset(index), &word, sizeof(word));
+    }
+
+    esp_err_t add(uint32_t delta)
+    {
+        // Add to the open tally word by clearing further bits of it
+        if (mTallyOpen && tallyUnits(mTallyWord) + delta <= TALLY_UNITS) {
+            uint32_t word = addTallyUnits(mTallyWord, delta);
+            esp_err_t err = writeWord(mNextWord - 1, word);
+            if (err != ESP_OK) {
+                return err;
+            }
+            mSum += delta;
+            mTallyWord = word;
+            mTallyOpen = tallyUnits(word) < TALLY_UNITS;
+            return ESP_OK;
+        }
+
+        if (mNextWord == WORD_COUNT) {
+            esp_err_t err = startSector((mActiveSector + 1) % mSectorCount, mSeqNumber + 1, mBase + mSum);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+
+        bool tally = delta <= TALLY_UNITS;
+        uint32_t word = tally ? addTallyUnits(~TALLY_FLAG, delta) : makeDeltaWord(delta);
+        esp_err_t err = writeWord(mNextWord, word);
+        if (err != ESP_OK) {
+            return err;
+        }
+        ++mNextWord;
+        mSum += delta;
+        mTallyWord = word;
+        mTallyOpen = tally && delta < TALLY_UNITS;
+        return ESP_OK;
+    }
+};
+
+extern "C" esp_err_t nvs_counter_open(const nvs_counter_config_t *config, nvs_counter_handle_t *out_handle)
+{
+    if (config == nullptr || config->partition == nullptr || out_handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->sector_count < 2
+            || config->first_sector + config->sector_count < config->first_sector
+            || (config->first_sector + config->sector_count) * SEC_SIZE > config->partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Tally words are written several times, which flash encryption does not allow
+    if (config->partition->encrypted) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    nvs_counter* counter = new (std::nothrow) nvs_counter();
+    if (counter == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+    counter->mPartition = config->partition;
+    counter->mFirstSector = config->first_sector;
+    counter->mSectorCount = config->sector_count;
+
+    Lock lock;
+    esp_err_t err = counter->load();
+    if (err != ESP_OK) {
+        delete counter;
+        return err;
+    }
+
+    *out_handle = counter;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_counter_add(nvs_counter_handle_t handle, uint32_t delta)
+{
+    if (handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    Lock lock;
+    while (delta > 0) {
+        uint32_t part = std::min(delta, DELTA_MAX);
+        esp_err_t err = handle->add(part);
+        if (err != ESP_OK) {
+            return err;
+        }
+        delta -= part;
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_counter_get(nvs_counter_handle_t handle, uint64_t *out_value)
+{
+    if (handle == nullptr || out_value == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    Lock lock;
+    *out_value = handle->mBase + handle->mSum;
+    return ESP_OK;
+}
+
+extern "C" void nvs_counter_close(nvs_counter_handle_t handle)
+{
+    Lock lock;
+    delete handle;
+}
@@ -0,0 +1,152 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "nvs_key_index.hpp"
+#include "nvs_page.hpp"
+#include <new>
+#include <cstring>
+
+namespace nvs
+{
+
+KeyIndex::KeyIndex()
+{
+}
+
+KeyIndex::~KeyIndex()
+{
+    delete[] mEntries;
+}
+
+void KeyIndex::clear()
+{
+    delete[] mEntries;
+    mEntries = nullptr;
+    mCapacity = 0;
+    mCount = 0;
+    mComplete = true;
+}
+
+size_t KeyIndex::slotOf(uint8_t nsIndex, const char* key) const
+{
+    // FNV-1a over the namespace index and the key
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ nsIndex) * 16777619u;
+    for (size_t i = 0; i < Item::MAX_KEY_LENGTH && key[i] != '\0'; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(key[i])) * 16777619u;
+    }
+    return hash & (mCapacity - 1);
+}
+
+KeyIndex::Entry* KeyIndex::findSlot(uint8_t nsIndex, const char* key)
+{
+    size_t slot = slotOf(nsIndex, key);
+    while (mEntries[slot].mNsIndex != Page::NS_ANY) {
+        Entry& e = mEntries[slot];
+        if (e.mNsIndex == nsIndex && strncmp(key, e.mKey, Item::MAX_KEY_LENGTH) == 0) {
+            return &e;
+        }
+        slot = (slot + 1) & (mCapacity - 1);
+    }
+    return &mEntries[slot];
+}
+
+KeyIndex::Entry* KeyIndex::find(uint8_t nsIndex, const char* key)
+{
+    if (mCount == 0) {
+        return nullptr;
+    }
+    Entry* e = findSlot(nsIndex, key);
+    return (e->mNsIndex == Page::NS_ANY) ? nullptr : e;
+}
+
+bool KeyIndex::grow()
+{
+    size_t newCapacity = (mCapacity == 0) ? INITIAL_CAPACITY : mCapacity * 2;
+    Entry* newEntries = new (std::nothrow) Entry[newCapacity];
+    if (!newEntries) {
+        return false;
+    }
+    for (size_t i = 0; i < newCapacity; ++i) {
+        newEntries[i].mNsIndex = Page::NS_ANY;
+    }
+
+    Entry* oldEntries = mEntries;
+    size_t oldCapacity = mCapacity;
+    mEntries = newEntries;
+    mCapacity = newCapacity;
+    for (size_t i = 0; i < oldCapacity; ++i) {
+        if (oldEntries[i].mNsIndex != Page::NS_ANY) {
+            *findSlot(oldEntries[i].mNsIndex, oldEntries[i].mKey) = oldEntries[i];
+        }
+    }
+    delete[] oldEntries;
+    return true;
+}
+
+void KeyIndex::set(uint8_t nsIndex, const char* key, Page* page, size_t entryIndex)
+{
+    // Keep the load factor at or below 3/4 so that probe sequences stay short
+    if ((mCount + 1) * 4 > mCapacity * 3 && !grow()) {
+        Entry* e = (mCapacity != 0) ? find(nsIndex, key) : nullptr;
+        if (e) {
+            e->mPage = page;
+            e->mEntryIndex = static_cast<uint8_t>(entryIndex);
+        } else {
+            // A key is missing from the index from now on, a miss no longer proves that it does not exist
+            mComplete = false;
+        }
+        return;
+    }
+
+    Entry* e = findSlot(nsIndex, key);
+    if (e->mNsIndex == Page::NS_ANY) {
+        e->mNsIndex = nsIndex;
+        strncpy(e->mKey, key, sizeof(e->mKey) - 1);
+        e->mKey[sizeof(e->mKey) - 1] = 0;
+        ++mCount;
+    }
+    e->mPage = page;
+    e->mEntryIndex = static_cast<uint8_t>(entryIndex);
+}
+
+void KeyIndex::eraseSlot(Entry* slot)
+{
+    // Backward shift deletion, entries following the erased one are moved closer to their home slot
+    size_t hole = slot - mEntries;
+    size_t next = (hole + 1) & (mCapacity - 1);
+    while (mEntries[next].mNsIndex != Page::NS_ANY) {
+        size_t home = slotOf(mEntries[next].mNsIndex, mEntries[next].mKey);
+        if (((next - home) & (mCapacity - 1)) >= ((next - hole) & (mCapacity - 1))) {
+            mEntries[hole] = mEntries[next];
+            hole = next;
+        }
+        next = (next + 1) & (mCapacity - 1);
+    }
+    mEntries[hole].mNsIndex = Page::NS_ANY;
+    --mCount;
+}
+
+void KeyIndex::erase(uint8_t nsIndex, const char* key)
+{
+    Entry* e = find(nsIndex, key);
+    if (e) {
+        eraseSlot(e);
+    }
+}
+
+void KeyIndex::eraseNamespace(uint8_t nsIndex)
+{
+    for (size_t i = 0; i < mCapacity;) {
+        if (mEntries[i].mNsIndex == nsIndex) {
+            // The slot may be refilled by a shifted entry, check it again
+            eraseSlot(&mEntries[i]);
+        } else {
+            ++i;
+        }
+    }
+}
+
+} // namespace nvs
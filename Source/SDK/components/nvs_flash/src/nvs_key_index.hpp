@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef nvs_key_index_hpp
+#define nvs_key_index_hpp
+
+#include "nvs.h"
+#include "nvs_types.hpp"
+
+namespace nvs
+{
+
+class Page;
+
+/**
+ * Storage level index from <namespace, key> to the page holding the item.
+ *
+ * The index is a lookup hint: the page it returns is always checked by the
+ * caller, and a failed check falls back to a search over all pages. As long as
+ * the index is complete, i.e. every key present in flash has an entry, a key
+ * which is not in the index is known not to exist.
+ */
+class KeyIndex
+{
+public:
+    KeyIndex();
+    ~KeyIndex();
+
+    struct Entry {
+        Page* mPage;            // page holding the item, nullptr if not known
+        uint8_t mNsIndex;       // Page::NS_ANY marks an empty slot
+        uint8_t mEntryIndex;    // index of the item within mPage
+        char mKey[Item::MAX_KEY_LENGTH + 1];
+    };
+
+    Entry* find(uint8_t nsIndex, const char* key);
+
+    // Adds or updates the entry for <nsIndex, key>. On allocation failure the index is marked incomplete.
+    void set(uint8_t nsIndex, const char* key, Page* page, size_t entryIndex);
+
+    void erase(uint8_t nsIndex, const char* key);
+
+    void eraseNamespace(uint8_t nsIndex);
+
+    void clear();
+
+    bool isComplete() const
+    {
+        return mComplete;
+    }
+
+    size_t size() const
+    {
+        return mCount;
+    }
+
+private:
+    KeyIndex(const KeyIndex& other);
+    const KeyIndex& operator= (const KeyIndex& rhs);
+
+    static const size_t INITIAL_CAPACITY = 32;
+
+    size_t slotOf(uint8_t nsIndex, const char* key) const;
+    Entry* findSlot(uint8_t nsIndex, const char* key);
+    void eraseSlot(Entry* slot);
+    bool grow();
+
+    Entry* mEntries = nullptr;
+    size_t mCapacity = 0;
+    size_t mCount = 0;
+    bool mComplete = true;
+}; // class KeyIndex
+
+} // namespace nvs
+
+#endif /* nvs_key_index_hpp */
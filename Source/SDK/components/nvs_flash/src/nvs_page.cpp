@@ -148,6 +148,12 @@ esp_err_t Page::writeEntryData(const uint8_t* data, size_t size)
 }
 
 esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx)
+{
+    size_t itemIndex;
+    return writeItem(nsIndex, datatype, key, data, dataSize, chunkIdx, itemIndex);
+}
+
+esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, const void* data, size_t dataSize, uint8_t chunkIdx, size_t &itemIndex)
 {
     Item item;
     esp_err_t err;
@@ -200,6 +206,7 @@ esp_err_t Page::writeItem(uint8_t nsIndex, ItemType datatype, const char* key, c
     // write first item
     size_t span = (totalSize + ENTRY_SIZE - 1) / ENTRY_SIZE;
     item = Item(nsIndex, datatype, span, key, chunkIdx);
+    itemIndex = mNextFreeEntry;
     err = mHashList.insert(item, mNextFreeEntry);
 
     if (err != ESP_OK) {
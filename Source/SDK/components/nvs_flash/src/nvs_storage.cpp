@@ -179,8 +179,37 @@ void Storage::eraseOrphanDataBlobs(TBlobIndexList& blobIdxList)
     }
 }
 
+#ifdef CONFIG_NVS_KEY_INDEX
+void Storage::buildKeyIndex()
+{
+    mKeyIndex.clear();
+    for (auto it = mPageManager.begin(); it != mPageManager.end(); ++it) {
+        Page& p = *it;
+        size_t itemIndex = 0;
+        Item item;
+        while (p.findItem(Page::NS_ANY, ItemType::ANY, nullptr, itemIndex, item) == ESP_OK) {
+            // Blob data chunks only make their key known, the page hint points to the blob index.
+            // If a key is present in several pages, the first one is kept, as with a search over all pages.
+            KeyIndex::Entry* entry = mKeyIndex.find(item.nsIndex, item.key);
+            if (item.datatype == ItemType::BLOB_DATA) {
+                if (!entry) {
+                    mKeyIndex.set(item.nsIndex, item.key, nullptr, 0);
+                }
+            } else if (!entry || entry->mPage == nullptr) {
+                mKeyIndex.set(item.nsIndex, item.key, &p, itemIndex);
+            }
+            itemIndex += item.span;
+        }
+    }
+}
+#endif
+
 esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
 {
+#ifdef CONFIG_NVS_KEY_INDEX
+    // Page objects are reallocated by the page manager, drop all references to them
+    mKeyIndex.clear();
+#endif
     auto err = mPageManager.load(mPartition, baseSector, sectorCount);
     if (err != ESP_OK) {
         mState = StorageState::INVALID;
@@ -240,6 +269,10 @@ esp_err_t Storage::init(uint32_t baseSector, uint32_t sectorCount)
     // Purge the blob index list
     blobIdxList.clearAndFreeNodes();
 
+#ifdef CONFIG_NVS_KEY_INDEX
+    buildKeyIndex();
+#endif
+
     mState = StorageState::ACTIVE;
 
 #ifdef DEBUG_STORAGE
@@ -255,18 +288,43 @@ bool Storage::isValid() const
 
 esp_err_t Storage::findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx, VerOffset chunkStart)
 {
+#ifdef CONFIG_NVS_KEY_INDEX
+    // The key index can only be used for lookups by namespace and key. Blob data chunks
+    // are searched in all pages, but only if the key is known.
+    const bool useKeyIndex = (nsIndex != Page::NS_ANY && key != nullptr);
+    if (useKeyIndex) {
+        KeyIndex::Entry* entry = mKeyIndex.find(nsIndex, key);
+        if (!entry) {
+            if (mKeyIndex.isComplete()) {
+                return ESP_ERR_NVS_NOT_FOUND;
+            }
+        } else if (entry->mPage != nullptr && datatype != ItemType::BLOB_DATA) {
+            // The page is only a hint, e.g. the item may have been moved by page garbage collection
+            size_t itemIndex = entry->mEntryIndex;
+            if (entry->mPage->findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx, chunkStart) == ESP_OK) {
+                page = entry->mPage;
+                return ESP_OK;
+            }
+        }
+    }
+#endif
     for (auto it = std::begin(mPageManager); it != std::end(mPageManager); ++it) {
         size_t itemIndex = 0;
         auto err = it->findItem(nsIndex, datatype, key, itemIndex, item, chunkIdx, chunkStart);
         if (err == ESP_OK) {
             page = it;
+#ifdef CONFIG_NVS_KEY_INDEX
+            if (useKeyIndex && datatype != ItemType::BLOB_DATA) {
+                mKeyIndex.set(nsIndex, key, page, itemIndex);
+            }
+#endif
             return ESP_OK;
         }
     }
     return ESP_ERR_NVS_NOT_FOUND;
 }
 
-esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart)
+esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart, Page* &indexPage, size_t &indexEntry)
 {
     uint8_t chunkCount = 0;
     TUsedPageList usedPages;
@@ -354,7 +412,8 @@ esp_err_t Storage::writeMultiPageBlob(uint8_t nsIndex, const char* key, const vo
             item.blobIndex.chunkCount = chunkCount;
             item.blobIndex.chunkStart = chunkStart;
 
-            err = getCurrentPage().writeItem(nsIndex, ItemType::BLOB_IDX, key, item.data, sizeof(item.data));
+            indexPage = &getCurrentPage();
+            err = indexPage->writeItem(nsIndex, ItemType::BLOB_IDX, key, item.data, sizeof(item.data), Page::CHUNK_ANY, indexEntry);
             NVS_ASSERT_OR_RETURN(err != ESP_ERR_NVS_PAGE_FULL, err);
             break;
         }
@@ -405,6 +464,10 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
         return err;
     }
 
+    // Page and entry of the item written
+    Page* writtenPage = nullptr;
+    size_t writtenIndex = 0;
+
     if (datatype == ItemType::BLOB) {
         VerOffset prevStart,  nextStart;
         prevStart = nextStart = VerOffset::VER_0_OFFSET;
@@ -433,7 +496,7 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
                 = (prevStart == VerOffset::VER_1_OFFSET) ? VerOffset::VER_0_OFFSET : VerOffset::VER_1_OFFSET;
         }
         /* Write the blob with new version*/
-        err = writeMultiPageBlob(nsIndex, key, data, dataSize, nextStart);
+        err = writeMultiPageBlob(nsIndex, key, data, dataSize, nextStart, writtenPage, writtenIndex);
 
         if (err == ESP_ERR_NVS_PAGE_FULL) {
             return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
@@ -441,6 +504,12 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
         if (err != ESP_OK) {
             return err;
         }
+#ifdef CONFIG_NVS_KEY_INDEX
+        if (!matchedTypePageFound) {
+            // The new key is in flash, make it known before the search for a legacy blob can fail
+            mKeyIndex.set(nsIndex, key, writtenPage, writtenIndex);
+        }
+#endif
 
         if (matchedTypePageFound) {
             /* Erase the blob with earlier version*/
@@ -471,7 +540,8 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
         }
 
         Page& page = getCurrentPage();
-        err = page.writeItem(nsIndex, datatype, key, data, dataSize);
+        writtenPage = &page;
+        err = page.writeItem(nsIndex, datatype, key, data, dataSize, Page::CHUNK_ANY, writtenIndex);
         if (err == ESP_ERR_NVS_PAGE_FULL) {
             if (page.state() != Page::PageState::FULL) {
                 err = page.markFull();
@@ -484,7 +554,8 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
                 return err;
             }
 
-            err = getCurrentPage().writeItem(nsIndex, datatype, key, data, dataSize);
+            writtenPage = &getCurrentPage();
+            err = writtenPage->writeItem(nsIndex, datatype, key, data, dataSize, Page::CHUNK_ANY, writtenIndex);
             if (err == ESP_ERR_NVS_PAGE_FULL) {
                 return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
             }
@@ -520,6 +591,10 @@ esp_err_t Storage::writeItem(uint8_t nsIndex, ItemType datatype, const char* key
             return err;
         }
     }
+#ifdef CONFIG_NVS_KEY_INDEX
+    // The previous item has been erased, point the index to the new one
+    mKeyIndex.set(nsIndex, key, writtenPage, writtenIndex);
+#endif
 #ifdef DEBUG_STORAGE
     debugCheck();
 #endif
@@ -759,6 +834,19 @@ esp_err_t Storage::eraseMultiPageBlob(uint8_t nsIndex, const char* key, VerOffse
         } while (err == ESP_OK && itemIndex < Page::ENTRY_COUNT);
     }
 
+#ifdef CONFIG_NVS_KEY_INDEX
+    if (chunkStart == VerOffset::VER_ANY) {
+        // Drop the key unless an item stored in the format without blob index is still present
+        bool keyFound = false;
+        for (auto it = std::begin(mPageManager); it != std::end(mPageManager) && !keyFound; ++it) {
+            size_t itemIndex = 0;
+            keyFound = (it->findItem(nsIndex, ItemType::ANY, key, itemIndex, item) == ESP_OK);
+        }
+        if (!keyFound) {
+            mKeyIndex.erase(nsIndex, key);
+        }
+    }
+#endif
     return ESP_OK;
 }
 
@@ -783,7 +871,13 @@ esp_err_t Storage::eraseItem(uint8_t nsIndex, ItemType datatype, const char* key
         return eraseMultiPageBlob(nsIndex, key);
     }
 
-    return findPage->eraseItem(nsIndex, datatype, key);
+    err = findPage->eraseItem(nsIndex, datatype, key);
+#ifdef CONFIG_NVS_KEY_INDEX
+    if (err == ESP_OK) {
+        mKeyIndex.erase(nsIndex, key);
+    }
+#endif
+    return err;
 }
 
 esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
@@ -803,6 +897,9 @@ esp_err_t Storage::eraseNamespace(uint8_t nsIndex)
             }
         }
     }
+#ifdef CONFIG_NVS_KEY_INDEX
+    mKeyIndex.eraseNamespace(nsIndex);
+#endif
     return ESP_OK;
 
 }
@@ -13,6 +13,7 @@
 #include "nvs_types.hpp"
 #include "nvs_page.hpp"
 #include "nvs_pagemanager.hpp"
+#include "nvs_key_index.hpp"
 #include "nvs_memory_management.hpp"
 #include "partition.hpp"
 
@@ -114,7 +115,7 @@ public:
         return mPageManager.getBaseSector();
     }
 
-    esp_err_t writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart);
+    esp_err_t writeMultiPageBlob(uint8_t nsIndex, const char* key, const void* data, size_t dataSize, VerOffset chunkStart, Page* &indexPage, size_t &indexEntry);
 
     esp_err_t readMultiPageBlob(uint8_t nsIndex, const char* key, void* data, size_t dataSize);
 
@@ -155,6 +156,10 @@ protected:
 
     esp_err_t findItem(uint8_t nsIndex, ItemType datatype, const char* key, Page* &page, Item& item, uint8_t chunkIdx = Page::CHUNK_ANY, VerOffset chunkStart = VerOffset::VER_ANY);
 
+#ifdef CONFIG_NVS_KEY_INDEX
+    void buildKeyIndex();
+#endif
+
 protected:
     Partition *mPartition;
     size_t mPageCount;
@@ -162,6 +167,9 @@ protected:
     TNamespaces mNamespaces;
     CompressedEnumTable<bool, 1, 256> mNamespaceUsage;
     StorageState mState = StorageState::INVALID;
+#ifdef CONFIG_NVS_KEY_INDEX
+    KeyIndex mKeyIndex;
+#endif
 };
 
 } // namespace nvs
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#include "esp_rom_gpio.h"
+#include "hal/gpio_ll.h"
+#include "soc/gpio_sig_map.h"
+
+#include "hardwareInterface.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+#if CONFIG_FAST_BOOT
+static void BOOT_HOOKS_DriveOutput(uint32_t io_num, uint32_t level);
+#endif
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+#if CONFIG_FAST_BOOT
+/***************************************************************************//*!
+*  \brief Drive an output from the bootloader
+*
+*   This function is used to route an IO to the GPIO output register and
+*   enable its output at the given level. The level is written first, the
+*   IO never drives the opposite level.
+*
+*   Preconditions: None, only ROM functions and registers are used.
+*
+*   Side Effects: None.
+*
+*   \param[in]  io_num              IO number
+*   \param[in]  level               Level to drive
+*
+*******************************************************************************/
+static void BOOT_HOOKS_DriveOutput(uint32_t io_num, uint32_t level){
+
+    gpio_ll_set_level(&GPIO, io_num, level);
+    esp_rom_gpio_connect_out_signal(io_num, SIG_GPIO_OUT_IDX, false, false);
+    esp_rom_gpio_pad_select_gpio(io_num);
+    gpio_ll_output_enable(&GPIO, io_num);
+}
+#endif
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Bootloader hooks linker anchor
+*
+*   This function is used by the bootloader link to pull this component in,
+*   the hooks themselves are weak symbols.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+void bootloader_hooks_include(void){
+}
+
+/***************************************************************************//*!
+*  \brief Bootloader before init hook
+*
+*   This function is called by the bootloader before its own initialization.
+*   With the fast boot profile, the rail outputs are driven to their inactive
+*   level here, a few milliseconds after reset, instead of floating until
+*   SOFT_InitModule configures them. SOFT_InitModule keeps the output level
+*   register, the rails do not glitch when the app takes them over.
+*
+*   Preconditions: None. BSS, flash and clocks are not initialized yet.
+*
+*   Side Effects: The rail outputs are enabled.
+*
+*******************************************************************************/
+void bootloader_before_init(void){
+
+#if CONFIG_FAST_BOOT
+    BOOT_HOOKS_DriveOutput(HWI_PWR_OUT, !HWI_PWR_ACTIVE_LEVEL);
+    BOOT_HOOKS_DriveOutput(HWI_CHARGE_OUT, !HWI_CHARGE_ACTIVE_LEVEL);
+#endif
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
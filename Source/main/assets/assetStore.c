@@ -0,0 +1,663 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "esp_rom_crc.h"
+
+#include "assetStore.h"
+#include "stackMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define ASSET_STORE_TASK_STACK          (CONFIG_ASSET_STORE_TASK_STACK_SIZE)
+#define ASSET_STORE_TASK_PRIORITY       (2)
+
+#define ASSET_STORE_MAX_TABLES          (CONFIG_ASSET_STORE_MAX_TABLES)
+#define ASSET_STORE_CACHE_MAX_SIZE      (CONFIG_ASSET_STORE_CACHE_MAX_SIZE)
+#define ASSET_STORE_POLL_PERIOD_MS      (CONFIG_ASSET_STORE_POLL_PERIOD_MS)
+#define ASSET_STORE_MAX_CALLBACKS       (4)
+
+//The directory of a scan, the file being loaded and the file read in place
+#define ASSET_STORE_MAX_FILES           (3)
+#define ASSET_STORE_PATH_SIZE           (sizeof(ASSET_STORE_BASE_PATH) + ASSET_STORE_NAME_SIZE)
+//Stack buffer of the CRC check of the tables read in place
+#define ASSET_STORE_CRC_CHUNK           (256)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+//The public table is the first member of its slot
+#define ASSET_STORE_SLOT(pTable)        ((ASSET_STORE_Slot_t *)(pTable))
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct ASSET_STORE_Slot_s{
+    ASSET_STORE_Table_t table;
+    uint16_t refs;                          //Users, plus one while in the index
+    bool stale;                             //Replaced or removed from the index
+    bool invalid;                           //Rejected file, indexed to remember its state
+    time_t mtime;                           //File state when loaded
+    off_t size;
+    uint8_t entries[];                      //Cached entries
+}ASSET_STORE_Slot_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static void tAssetStoreTask(void *pvParameters);
+static void ASSET_STORE_GetPath(const char *pName, char *pPath);
+static int ASSET_STORE_Find(const char *pName);
+static ASSET_STORE_Slot_t * ASSET_STORE_Load(const char *pName, const struct stat *pStat);
+static void ASSET_STORE_Drop(ASSET_STORE_Slot_t *pSlot);
+static bool ASSET_STORE_Publish(int index, const char *pName, ASSET_STORE_Slot_t *pSlot);
+static void ASSET_STORE_Notify(const char *pName);
+static void ASSET_STORE_Scan(bool force);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static bool mounted = false;
+
+//Written by the asset store task only, under the mutex
+static ASSET_STORE_Slot_t *asset_index[ASSET_STORE_MAX_TABLES];
+static uint32_t generation = 0;
+
+//File of the last table read in place, kept open between reads
+static FILE *pRead_file = NULL;
+static const ASSET_STORE_Slot_t *pRead_slot = NULL;
+
+static ASSET_STORE_Callback_t callbacks[ASSET_STORE_MAX_CALLBACKS];
+static bool force_requested = false;
+static ASSET_STORE_Stats_t asset_stats;
+
+static SemaphoreHandle_t asset_store_mutex_handle = NULL;
+static TaskHandle_t asset_store_task_handle = NULL;
+
+static const char * TAG = "ASSET_STORE";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static void tAssetStoreTask(void *pvParameters){
+
+    TickType_t period = (ASSET_STORE_POLL_PERIOD_MS > 0) ? pdMS_TO_TICKS(ASSET_STORE_POLL_PERIOD_MS) : portMAX_DELAY;
+
+    for(;;){
+        ulTaskNotifyTake(pdTRUE, period);
+
+        xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+        bool force = force_requested;
+        force_requested = false;
+        xSemaphoreGive(asset_store_mutex_handle);
+
+        ASSET_STORE_Scan(force);
+    }
+    vTaskDelete(NULL);
+}
+
+static void ASSET_STORE_GetPath(const char *pName, char *pPath){
+
+    snprintf(pPath, ASSET_STORE_PATH_SIZE, "%s/%.*s", ASSET_STORE_BASE_PATH, ASSET_STORE_NAME_SIZE - 1, pName);
+}
+
+//Index of a name, -1 if not indexed
+static int ASSET_STORE_Find(const char *pName){
+
+    for(int i=0; i<ASSET_STORE_MAX_TABLES; i++){
+        if(asset_index[i] != NULL && strcmp(asset_index[i]->table.name, pName) == 0){
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//Reads and checks a file, the entries are cached if small enough. NULL if the file can not be read
+static ASSET_STORE_Slot_t * ASSET_STORE_Load(const char *pName, const struct stat *pStat){
+
+    char path[ASSET_STORE_PATH_SIZE];
+    ASSET_STORE_Header_t header = {0};
+
+    ASSET_STORE_GetPath(pName, path);
+    FILE *pFile = fopen(path, "rb");
+    if(pFile == NULL){
+        return NULL;
+    }
+
+    bool valid = (fread(&header, sizeof(header), 1, pFile) == 1 &&
+                  header.magic == ASSET_STORE_MAGIC &&
+                  header.entry_size > 0 &&
+                  pStat->st_size == (off_t)(sizeof(header) + (uint32_t)header.entry_size * header.entry_count));
+    uint32_t size = valid ? (uint32_t)header.entry_size * header.entry_count : 0;
+    bool cached = valid && (size <= ASSET_STORE_CACHE_MAX_SIZE);
+
+    ASSET_STORE_Slot_t *pSlot = calloc(1, sizeof(ASSET_STORE_Slot_t) + (cached ? size : 0));
+    if(pSlot == NULL){
+        fclose(pFile);
+        return NULL;
+    }
+
+    if(valid){
+        uint32_t crc = 0;
+
+        if(cached){
+            valid = (fread(pSlot->entries, 1, size, pFile) == size);
+            crc = esp_rom_crc32_le(0, pSlot->entries, size);
+        }
+        else{
+            uint8_t chunk[ASSET_STORE_CRC_CHUNK];
+            size_t count;
+            uint32_t total = 0;
+
+            while((count = fread(chunk, 1, sizeof(chunk), pFile)) > 0){
+                crc = esp_rom_crc32_le(crc, chunk, count);
+                total += count;
+            }
+            valid = (total == size);
+        }
+        valid = valid && (crc == header.crc);
+    }
+    fclose(pFile);
+
+    strlcpy(pSlot->table.name, pName, sizeof(pSlot->table.name));
+    pSlot->table.header = header;
+    pSlot->table.pEntries = (valid && cached) ? pSlot->entries : NULL;
+    pSlot->refs = 1;
+    pSlot->invalid = !valid;
+    pSlot->mtime = pStat->st_mtime;
+    pSlot->size = pStat->st_size;
+
+    return pSlot;
+}
+
+//Removes the index reference, called with the mutex taken
+static void ASSET_STORE_Drop(ASSET_STORE_Slot_t *pSlot){
+
+    pSlot->stale = true;
+    pSlot->refs--;
+
+    if(pRead_slot == pSlot){
+        fclose(pRead_file);
+        pRead_file = NULL;
+        pRead_slot = NULL;
+    }
+    if(pSlot->refs == 0){
+        free(pSlot);
+    }
+}
+
+//Replaces or removes the slot of a name, returns false if the index is full
+static bool ASSET_STORE_Publish(int index, const char *pName, ASSET_STORE_Slot_t *pSlot){
+
+    if(index < 0){
+        for(int i=0; i<ASSET_STORE_MAX_TABLES && index<0; i++){
+            if(asset_index[i] == NULL){
+                index = i;
+            }
+        }
+        if(index < 0){
+            ESP_LOGW(TAG, "Failed to index %s -> Index full", pName);
+            free(pSlot);
+            return false;
+        }
+    }
+
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    if(asset_index[index] != NULL){
+        ASSET_STORE_Drop(asset_index[index]);
+    }
+    if(pSlot != NULL){
+        pSlot->table.generation = ++generation;
+    }
+    asset_index[index] = pSlot;
+    xSemaphoreGive(asset_store_mutex_handle);
+
+    return true;
+}
+
+static void ASSET_STORE_Notify(const char *pName){
+
+    ASSET_STORE_Callback_t copy[ASSET_STORE_MAX_CALLBACKS];
+
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    memcpy(copy, callbacks, sizeof(copy));
+    asset_stats.reloads++;
+    xSemaphoreGive(asset_store_mutex_handle);
+
+    for(uint8_t i=0; i<ASSET_STORE_MAX_CALLBACKS; i++){
+        if(copy[i] != NULL){
+            copy[i](pName);
+        }
+    }
+}
+
+/*
+ * Loads the new and changed files and removes the deleted ones. A file is
+ * considered changed when its size or time differs, a forced scan loads
+ * every file and compares the CRC instead.
+ */
+static void ASSET_STORE_Scan(bool force){
+
+    bool seen[ASSET_STORE_MAX_TABLES] = {0};
+    char path[ASSET_STORE_PATH_SIZE];
+    struct stat st;
+
+    DIR *pDir = opendir(ASSET_STORE_BASE_PATH);
+    if(pDir == NULL){
+        ESP_LOGW(TAG, "Failed to open %s", ASSET_STORE_BASE_PATH);
+        return;
+    }
+
+    struct dirent *pEntry;
+    while((pEntry = readdir(pDir)) != NULL){
+        if(strlen(pEntry->d_name) >= ASSET_STORE_NAME_SIZE){
+            continue;
+        }
+
+        ASSET_STORE_GetPath(pEntry->d_name, path);
+        if(stat(path, &st) != 0 || !S_ISREG(st.st_mode)){
+            continue;
+        }
+
+        int index = ASSET_STORE_Find(pEntry->d_name);
+        ASSET_STORE_Slot_t *pOld = (index >= 0) ? asset_index[index] : NULL;
+        if(index >= 0){
+            seen[index] = true;
+        }
+        if(pOld != NULL && !force && pOld->mtime == st.st_mtime && pOld->size == st.st_size){
+            continue;
+        }
+
+        //Retried on the next scan
+        ASSET_STORE_Slot_t *pSlot = ASSET_STORE_Load(pEntry->d_name, &st);
+        if(pSlot == NULL){
+            continue;
+        }
+
+        bool was_valid = (pOld != NULL && !pOld->invalid);
+        bool is_valid = !pSlot->invalid;
+        if(pOld != NULL && was_valid == is_valid &&
+           (!is_valid || (pOld->table.header.crc == pSlot->table.header.crc && pOld->size == pSlot->size))){
+            //Same content, or still invalid
+            xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+            pOld->mtime = pSlot->mtime;
+            pOld->size = pSlot->size;
+            xSemaphoreGive(asset_store_mutex_handle);
+            free(pSlot);
+            continue;
+        }
+
+        if(!is_valid){
+            ESP_LOGW(TAG, "Invalid asset %s", pEntry->d_name);
+            xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+            asset_stats.invalid_files++;
+            xSemaphoreGive(asset_store_mutex_handle);
+        }
+        if(ASSET_STORE_Publish(index, pEntry->d_name, pSlot)){
+            if(index < 0){
+                seen[ASSET_STORE_Find(pEntry->d_name)] = true;
+            }
+            if(was_valid || is_valid){
+                ESP_LOGI(TAG, "%s %s", !is_valid ? "Removed" : (was_valid ? "Reloaded" : "Loaded"), pEntry->d_name);
+                ASSET_STORE_Notify(pEntry->d_name);
+            }
+        }
+    }
+    closedir(pDir);
+
+    //Deleted files
+    for(int i=0; i<ASSET_STORE_MAX_TABLES; i++){
+        if(asset_index[i] != NULL && !seen[i]){
+            char name[ASSET_STORE_NAME_SIZE];
+            bool was_valid = !asset_index[i]->invalid;
+            strlcpy(name, asset_index[i]->table.name, sizeof(name));
+            ASSET_STORE_Publish(i, name, NULL);
+            if(was_valid){
+                ESP_LOGI(TAG, "Removed %s", name);
+                ASSET_STORE_Notify(name);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Asset store initialization
+*
+*   This function is used to mount the SPIFFS partition, format it on first
+*   use, index every asset file and start the task watching them. Tables up
+*   to CONFIG_ASSET_STORE_CACHE_MAX_SIZE bytes are cached in RAM, larger
+*   ones are read in place with ASSET_STORE_ReadEntries.
+*
+*   Preconditions: None.
+*
+*   Side Effects: Formats the partition if it can not be mounted.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_InitModule(void){
+
+    if(asset_store_task_handle != NULL){
+        ESP_LOGW(TAG, "Already initialized");
+        return ASSET_STORE_STATUS_FAIL;
+    }
+
+    //Create mutex
+    if(asset_store_mutex_handle == NULL){
+        asset_store_mutex_handle = xSemaphoreCreateMutex();
+        if(asset_store_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Asset Store mutex");
+            return ASSET_STORE_STATUS_FAIL;
+        }
+    }
+
+    if(!mounted){
+        const esp_vfs_spiffs_conf_t conf = {
+            .base_path = ASSET_STORE_BASE_PATH,
+            .partition_label = ASSET_STORE_PARTITION_LABEL,
+            .max_files = ASSET_STORE_MAX_FILES,
+            .format_if_mount_failed = true,
+        };
+
+        esp_err_t err = esp_vfs_spiffs_register(&conf);
+        if(err != ESP_OK){
+            ESP_LOGW(TAG, "Failed to mount partition %s -> %s", ASSET_STORE_PARTITION_LABEL, esp_err_to_name(err));
+            return ASSET_STORE_STATUS_FAIL;
+        }
+        mounted = true;
+    }
+
+    memset(&asset_stats, 0, sizeof(asset_stats));
+    ASSET_STORE_Scan(false);
+
+    ASSET_STORE_Stats_t stats;
+    ASSET_STORE_GetStats(&stats);
+    ESP_LOGI(TAG, "%u tables, %lu bytes cached", stats.tables, (unsigned long)stats.cache_bytes);
+
+    if(pdTRUE != xTaskCreate(tAssetStoreTask,
+                             "Asset store task",
+                             ASSET_STORE_TASK_STACK,
+                             NULL,
+                             ASSET_STORE_TASK_PRIORITY,
+                             &asset_store_task_handle)){
+
+        ESP_LOGW(TAG, "Failed to create Asset Store task");
+        return ASSET_STORE_STATUS_FAIL;
+    }
+    STACK_MON_RegisterTask(asset_store_task_handle, ASSET_STORE_TASK_STACK);
+
+    return ASSET_STORE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Asset store acquire
+*
+*   This function is used to get a table by file name. The table stays valid
+*   until released, a reload in between publishes a new table without
+*   changing this one.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pName               File name, e.g. "boot.seq"
+*   \param[out] ppTable             Pointer to store the table
+*
+*   \return     operation status, fail if no valid file has this name
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_Acquire(const char *pName, const ASSET_STORE_Table_t **ppTable){
+
+    if(asset_store_mutex_handle == NULL || pName == NULL || ppTable == NULL){
+        return ASSET_STORE_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    int index = ASSET_STORE_Find(pName);
+    if(index >= 0 && asset_index[index]->invalid){
+        index = -1;
+    }
+    if(index >= 0){
+        asset_index[index]->refs++;
+        *ppTable = &asset_index[index]->table;
+    }
+    xSemaphoreGive(asset_store_mutex_handle);
+
+    return (index >= 0) ? ASSET_STORE_STATUS_SUCCESS : ASSET_STORE_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Asset store release
+*
+*   This function is used to release a table got from ASSET_STORE_Acquire.
+*
+*   Preconditions: ASSET_STORE_Acquire succeeded.
+*
+*   Side Effects: Frees the table if it was replaced and this was its last
+*                 user.
+*
+*   \param[in]  pTable              Table to release
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_Release(const ASSET_STORE_Table_t *pTable){
+
+    if(asset_store_mutex_handle == NULL || pTable == NULL){
+        return ASSET_STORE_STATUS_FAIL;
+    }
+
+    ASSET_STORE_Slot_t *pSlot = ASSET_STORE_SLOT(pTable);
+
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    pSlot->refs--;
+    if(pSlot->refs == 0){
+        free(pSlot);
+    }
+    xSemaphoreGive(asset_store_mutex_handle);
+
+    return ASSET_STORE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Asset store read entries
+*
+*   This function is used to copy entries of a table, from the cache or from
+*   the file for tables read in place.
+*
+*   Preconditions: ASSET_STORE_Acquire succeeded.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTable              Table
+*   \param[in]  first               Index of the first entry
+*   \param[in]  count               Number of entries
+*   \param[out] pBuffer             Buffer of count * entry_size bytes
+*
+*   \return     operation status, fail if the size or time of the file
+*               changed since the table was loaded
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_ReadEntries(const ASSET_STORE_Table_t *pTable, uint16_t first, uint16_t count, void *pBuffer){
+
+    if(asset_store_mutex_handle == NULL || pTable == NULL || pBuffer == NULL ||
+       (uint32_t)first + count > pTable->header.entry_count){
+        return ASSET_STORE_STATUS_FAIL;
+    }
+
+    size_t offset = (size_t)first * pTable->header.entry_size;
+    size_t size = (size_t)count * pTable->header.entry_size;
+
+    if(pTable->pEntries != NULL){
+        memcpy(pBuffer, (const uint8_t *)pTable->pEntries + offset, size);
+        return ASSET_STORE_STATUS_SUCCESS;
+    }
+
+    ASSET_STORE_Slot_t *pSlot = ASSET_STORE_SLOT(pTable);
+    char path[ASSET_STORE_PATH_SIZE];
+    struct stat st;
+    bool read = false;
+
+    ASSET_STORE_GetPath(pTable->name, path);
+
+    //Under the mutex, a reload closes the file
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    //The file may have changed before the next scan, the entries would not match the CRC checked
+    bool same = (stat(path, &st) == 0 && st.st_mtime == pSlot->mtime && st.st_size == pSlot->size);
+    if(!pSlot->stale && !same && pRead_slot == pSlot){
+        fclose(pRead_file);
+        pRead_file = NULL;
+        pRead_slot = NULL;
+    }
+    if(!pSlot->stale && same){
+        if(pRead_slot != pSlot){
+            if(pRead_file != NULL){
+                fclose(pRead_file);
+            }
+            pRead_file = fopen(path, "rb");
+            pRead_slot = (pRead_file != NULL) ? pSlot : NULL;
+        }
+        read = pRead_file != NULL &&
+               fseek(pRead_file, sizeof(ASSET_STORE_Header_t) + offset, SEEK_SET) == 0 &&
+               fread(pBuffer, 1, size, pRead_file) == size;
+    }
+    xSemaphoreGive(asset_store_mutex_handle);
+
+    return read ? ASSET_STORE_STATUS_SUCCESS : ASSET_STORE_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Asset store reload
+*
+*   This function is used to check the files for changes now, e.g. once a
+*   file was written, instead of waiting for the poll period.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_Reload(void){
+
+    if(asset_store_task_handle == NULL){
+        return ASSET_STORE_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    force_requested = true;
+    xSemaphoreGive(asset_store_mutex_handle);
+    xTaskNotifyGive(asset_store_task_handle);
+
+    return ASSET_STORE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Asset store register callback
+*
+*   This function is used to be notified of the tables loaded, changed or
+*   removed after initialization, to acquire them again.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  callback            Function called with the file name
+*
+*   \return     operation status, fail if every callback slot is used
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_RegisterCallback(ASSET_STORE_Callback_t callback){
+
+    if(asset_store_mutex_handle == NULL || callback == NULL){
+        return ASSET_STORE_STATUS_FAIL;
+    }
+
+    ASSET_STORE_Ret_t ret = ASSET_STORE_STATUS_FAIL;
+
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    for(uint8_t i=0; i<ASSET_STORE_MAX_CALLBACKS; i++){
+        if(callbacks[i] == NULL){
+            callbacks[i] = callback;
+            ret = ASSET_STORE_STATUS_SUCCESS;
+            break;
+        }
+    }
+    xSemaphoreGive(asset_store_mutex_handle);
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Asset store statistics
+*
+*   This function is used to read the asset store counters.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_GetStats(ASSET_STORE_Stats_t *pStats){
+
+    if(asset_store_mutex_handle == NULL || pStats == NULL){
+        return ASSET_STORE_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(asset_store_mutex_handle, portMAX_DELAY);
+    *pStats = asset_stats;
+    pStats->tables = 0;
+    pStats->cached = 0;
+    pStats->cache_bytes = 0;
+    for(int i=0; i<ASSET_STORE_MAX_TABLES; i++){
+        if(asset_index[i] == NULL || asset_index[i]->invalid){
+            continue;
+        }
+        pStats->tables++;
+        if(asset_index[i]->table.pEntries != NULL){
+            pStats->cached++;
+            pStats->cache_bytes += (uint32_t)asset_index[i]->table.header.entry_size * asset_index[i]->table.header.entry_count;
+        }
+    }
+    xSemaphoreGive(asset_store_mutex_handle);
+
+    return ASSET_STORE_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
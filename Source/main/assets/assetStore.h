@@ -0,0 +1,207 @@
+#ifndef _ASSET_STORE_H
+#define _ASSET_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define ASSET_STORE_PARTITION_LABEL         "assets"
+#ifndef ASSET_STORE_BASE_PATH
+#define ASSET_STORE_BASE_PATH               "/assets"       //Set by the host test, a host directory
+#endif
+
+#define ASSET_STORE_MAGIC                   (0x31545341)    //"AST1"
+//File name without the base path, SPIFFS names are limited to CONFIG_SPIFFS_OBJ_NAME_LEN
+#define ASSET_STORE_NAME_SIZE               (24)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum ASSET_STORE_Type_e{
+    ASSET_STORE_TYPE_LED_PATTERN = 1,
+    ASSET_STORE_TYPE_POWER_SEQUENCE,
+    ASSET_STORE_TYPE_CONFIG,
+}ASSET_STORE_Type_t;
+
+/*
+ * Asset files are a header followed by entry_count entries of entry_size
+ * bytes, little endian. The layout of an entry belongs to the table type,
+ * tools/asset_pack.py builds the files.
+ */
+typedef struct __attribute__((packed)) ASSET_STORE_Header_s{
+    uint32_t magic;                         //ASSET_STORE_MAGIC
+    uint16_t type;                          //ASSET_STORE_Type_t
+    uint16_t version;                       //Table layout version, checked by the user
+    uint16_t entry_size;
+    uint16_t entry_count;
+    uint32_t crc;                           //CRC32 of the entries
+}ASSET_STORE_Header_t;
+
+//Read-only table, valid until released
+typedef struct ASSET_STORE_Table_s{
+    char name[ASSET_STORE_NAME_SIZE];
+    ASSET_STORE_Header_t header;
+    const void *pEntries;                   //Cached entries, NULL if the table is read in place
+    uint32_t generation;                    //Incremented every time a file is loaded
+}ASSET_STORE_Table_t;
+
+//Called on the asset store task when a table was loaded, changed or removed
+typedef void (*ASSET_STORE_Callback_t)(const char *pName);
+
+typedef struct ASSET_STORE_Stats_s{
+    uint16_t tables;                        //Tables in the index
+    uint16_t cached;                        //Tables with their entries in RAM
+    uint32_t cache_bytes;
+    uint32_t reloads;                       //Files loaded after a change
+    uint32_t invalid_files;                 //Files rejected by the header or CRC check
+}ASSET_STORE_Stats_t;
+
+typedef enum ASSET_STORE_Ret_e{
+    ASSET_STORE_STATUS_FAIL,
+    ASSET_STORE_STATUS_SUCCESS,
+}ASSET_STORE_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Asset store initialization
+*
+*   This function is used to mount the SPIFFS partition, format it on first
+*   use, index every asset file and start the task watching them. Tables up
+*   to CONFIG_ASSET_STORE_CACHE_MAX_SIZE bytes are cached in RAM, larger
+*   ones are read in place with ASSET_STORE_ReadEntries.
+*
+*   Preconditions: None.
+*
+*   Side Effects: Formats the partition if it can not be mounted.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Asset store acquire
+*
+*   This function is used to get a table by file name. The table stays valid
+*   until released, a reload in between publishes a new table without
+*   changing this one.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pName               File name, e.g. "boot.seq"
+*   \param[out] ppTable             Pointer to store the table
+*
+*   \return     operation status, fail if no valid file has this name
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_Acquire(const char *pName, const ASSET_STORE_Table_t **ppTable);
+
+/***************************************************************************//*!
+*  \brief Asset store release
+*
+*   This function is used to release a table got from ASSET_STORE_Acquire.
+*
+*   Preconditions: ASSET_STORE_Acquire succeeded.
+*
+*   Side Effects: Frees the table if it was replaced and this was its last
+*                 user.
+*
+*   \param[in]  pTable              Table to release
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_Release(const ASSET_STORE_Table_t *pTable);
+
+/***************************************************************************//*!
+*  \brief Asset store read entries
+*
+*   This function is used to copy entries of a table, from the cache or from
+*   the file for tables read in place.
+*
+*   Preconditions: ASSET_STORE_Acquire succeeded.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTable              Table
+*   \param[in]  first               Index of the first entry
+*   \param[in]  count               Number of entries
+*   \param[out] pBuffer             Buffer of count * entry_size bytes
+*
+*   \return     operation status, fail if the size or time of the file
+*               changed since the table was loaded
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_ReadEntries(const ASSET_STORE_Table_t *pTable, uint16_t first, uint16_t count, void *pBuffer);
+
+/***************************************************************************//*!
+*  \brief Asset store reload
+*
+*   This function is used to check the files for changes now, e.g. once a
+*   file was written, instead of waiting for the poll period.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_Reload(void);
+
+/***************************************************************************//*!
+*  \brief Asset store register callback
+*
+*   This function is used to be notified of the tables loaded, changed or
+*   removed after initialization, to acquire them again.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  callback            Function called with the file name
+*
+*   \return     operation status, fail if every callback slot is used
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_RegisterCallback(ASSET_STORE_Callback_t callback);
+
+/***************************************************************************//*!
+*  \brief Asset store statistics
+*
+*   This function is used to read the asset store counters.
+*
+*   Preconditions: ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+ASSET_STORE_Ret_t ASSET_STORE_GetStats(ASSET_STORE_Stats_t *pStats);
+
+#endif//_ASSET_STORE_H
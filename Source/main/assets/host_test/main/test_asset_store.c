@@ -0,0 +1,345 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Linux host asset store test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_spiffs.h"
+#include "esp_rom_crc.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "assetStore.h"
+
+#define TEST_CACHE_MAX_SIZE (64)        //CONFIG_ASSET_STORE_CACHE_MAX_SIZE
+#define TEST_WAIT           (pdMS_TO_TICKS(2000))
+#define TEST_PATTERN_NAME   "leds.pat"  //Cached
+#define TEST_SEQUENCE_NAME  "boot.seq"  //Read in place
+#define TEST_INVALID_NAME   "bad.pat"
+#define TEST_PATTERN_COUNT  (4)
+#define TEST_SEQUENCE_COUNT (32)
+
+static bool initialized;
+//Written by the asset store task
+static uint32_t notified;
+static char notified_name[ASSET_STORE_NAME_SIZE];
+static SemaphoreHandle_t notified_mutex;
+
+/* The SPIFFS VFS is not built for linux, the store reads the host directory instead */
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf)
+{
+    mkdir(conf->base_path, 0755);
+    return ESP_OK;
+}
+
+static void test_path(const char *pName, char *pPath)
+{
+    snprintf(pPath, sizeof(ASSET_STORE_BASE_PATH) + ASSET_STORE_NAME_SIZE, "%s/%s", ASSET_STORE_BASE_PATH, pName);
+}
+
+/* Writes a table as tools/asset_pack.py does, the header can be corrupted after */
+static void test_write(const char *pName, ASSET_STORE_Type_t type, uint8_t seed, uint16_t entry_size, uint16_t count, size_t size)
+{
+    uint8_t entries[TEST_SEQUENCE_COUNT * 4];
+    char path[sizeof(ASSET_STORE_BASE_PATH) + ASSET_STORE_NAME_SIZE];
+
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(entries), size);
+    for (size_t i = 0; i < size; i++) {
+        entries[i] = (uint8_t)(seed + i);
+    }
+    ASSET_STORE_Header_t header = {
+        .magic = ASSET_STORE_MAGIC,
+        .type = type,
+        .version = 1,
+        .entry_size = entry_size,
+        .entry_count = count,
+        .crc = esp_rom_crc32_le(0, entries, size),
+    };
+
+    test_path(pName, path);
+    FILE *pFile = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(pFile);
+    TEST_ASSERT_EQUAL(1, fwrite(&header, sizeof(header), 1, pFile));
+    TEST_ASSERT_EQUAL(size, fwrite(entries, 1, size, pFile));
+    fclose(pFile);
+}
+
+static void test_write_pattern(uint8_t seed)
+{
+    test_write(TEST_PATTERN_NAME, ASSET_STORE_TYPE_LED_PATTERN, seed, 7, TEST_PATTERN_COUNT, 7 * TEST_PATTERN_COUNT);
+}
+
+static void test_write_sequence(uint8_t seed)
+{
+    test_write(TEST_SEQUENCE_NAME, ASSET_STORE_TYPE_POWER_SEQUENCE, seed, 4, TEST_SEQUENCE_COUNT, 4 * TEST_SEQUENCE_COUNT);
+}
+
+/* Entry as written by test_write */
+static void test_check_entry(const ASSET_STORE_Table_t *pTable, uint16_t index, uint8_t seed)
+{
+    uint8_t entry[8];
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_ReadEntries(pTable, index, 1, entry));
+    for (uint16_t i = 0; i < pTable->header.entry_size; i++) {
+        TEST_ASSERT_EQUAL_HEX8((uint8_t)(seed + index * pTable->header.entry_size + i), entry[i]);
+    }
+}
+
+static void test_callback(const char *pName)
+{
+    xSemaphoreTake(notified_mutex, portMAX_DELAY);
+    strlcpy(notified_name, pName, sizeof(notified_name));
+    notified++;
+    xSemaphoreGive(notified_mutex);
+}
+
+/* Asks for a reload, waits for the callbacks to reach the count and checks the last name */
+static void test_reload(uint32_t count, const char *pName)
+{
+    TickType_t start = xTaskGetTickCount();
+    uint32_t current;
+    char name[ASSET_STORE_NAME_SIZE];
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Reload());
+    do {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        xSemaphoreTake(notified_mutex, portMAX_DELAY);
+        current = notified;
+        xSemaphoreGive(notified_mutex);
+    } while (current < count && (xTaskGetTickCount() - start) < TEST_WAIT);
+
+    /* The scan is done once the callbacks ran, give it time for files without one */
+    vTaskDelay(pdMS_TO_TICKS(50));
+    xSemaphoreTake(notified_mutex, portMAX_DELAY);
+    current = notified;
+    strlcpy(name, notified_name, sizeof(name));
+    xSemaphoreGive(notified_mutex);
+    TEST_ASSERT_EQUAL(count, current);
+    if (pName != NULL) {
+        TEST_ASSERT_EQUAL_STRING(pName, name);
+    }
+}
+
+TEST_GROUP(asset_store);
+
+TEST_SETUP(asset_store)
+{
+    if (!initialized) {
+        char path[sizeof(ASSET_STORE_BASE_PATH) + ASSET_STORE_NAME_SIZE];
+        struct dirent *pEntry;
+
+        /* Files of a previous run */
+        mkdir(ASSET_STORE_BASE_PATH, 0755);
+        DIR *pDir = opendir(ASSET_STORE_BASE_PATH);
+        TEST_ASSERT_NOT_NULL(pDir);
+        while ((pEntry = readdir(pDir)) != NULL) {
+            if (pEntry->d_name[0] != '.') {
+                test_path(pEntry->d_name, path);
+                remove(path);
+            }
+        }
+        closedir(pDir);
+
+        test_write_pattern(0x10);
+        test_write_sequence(0x20);
+        /* CRC of other entries */
+        test_write(TEST_INVALID_NAME, ASSET_STORE_TYPE_LED_PATTERN, 0x30, 7, 1, 7);
+        test_path(TEST_INVALID_NAME, path);
+        FILE *pFile = fopen(path, "r+b");
+        TEST_ASSERT_NOT_NULL(pFile);
+        fseek(pFile, sizeof(ASSET_STORE_Header_t), SEEK_SET);
+        fputc(0xFF, pFile);
+        fclose(pFile);
+
+        notified_mutex = xSemaphoreCreateMutex();
+        TEST_ASSERT_NOT_NULL(notified_mutex);
+        TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_InitModule());
+        TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_RegisterCallback(test_callback));
+        initialized = true;
+    }
+}
+
+TEST_TEAR_DOWN(asset_store)
+{
+}
+
+TEST(asset_store, test_load)
+{
+    ASSET_STORE_Stats_t stats;
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(2, stats.tables);
+    TEST_ASSERT_EQUAL(1, stats.cached);
+    TEST_ASSERT_EQUAL(7 * TEST_PATTERN_COUNT, stats.cache_bytes);
+    TEST_ASSERT_EQUAL(1, stats.invalid_files);
+
+    /* Small tables are cached */
+    const ASSET_STORE_Table_t *pTable = NULL;
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pTable));
+    TEST_ASSERT_NOT_NULL(pTable->pEntries);
+    TEST_ASSERT_EQUAL(ASSET_STORE_TYPE_LED_PATTERN, pTable->header.type);
+    TEST_ASSERT_EQUAL(TEST_PATTERN_COUNT, pTable->header.entry_count);
+    test_check_entry(pTable, TEST_PATTERN_COUNT - 1, 0x10);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pTable));
+
+    /* Larger ones are read in place */
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_SEQUENCE_NAME, &pTable));
+    TEST_ASSERT_NULL(pTable->pEntries);
+    TEST_ASSERT_GREATER_THAN(TEST_CACHE_MAX_SIZE, pTable->header.entry_size * pTable->header.entry_count);
+    test_check_entry(pTable, 0, 0x20);
+    test_check_entry(pTable, TEST_SEQUENCE_COUNT - 1, 0x20);
+    uint8_t entries[4 * 2];
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_ReadEntries(pTable, TEST_SEQUENCE_COUNT - 1, 2, entries));
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pTable));
+
+    /* Rejected by the CRC check */
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_Acquire(TEST_INVALID_NAME, &pTable));
+}
+
+TEST(asset_store, test_reload_acquired)
+{
+    const ASSET_STORE_Table_t *pOld = NULL;
+    const ASSET_STORE_Table_t *pNew = NULL;
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pOld));
+    uint32_t generation = pOld->generation;
+
+    test_write_pattern(0x40);
+    test_reload(1, TEST_PATTERN_NAME);
+
+    /* The acquired table is not changed by the reload */
+    TEST_ASSERT_EQUAL(generation, pOld->generation);
+    test_check_entry(pOld, 0, 0x10);
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pNew));
+    TEST_ASSERT_NOT_EQUAL(pOld, pNew);
+    TEST_ASSERT_GREATER_THAN(generation, pNew->generation);
+    test_check_entry(pNew, 0, 0x40);
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pOld));
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pNew));
+
+    /* Unchanged files are not reported again */
+    ASSET_STORE_Stats_t stats;
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_GetStats(&stats));
+    uint32_t reloads = stats.reloads;
+    test_reload(1, NULL);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(reloads, stats.reloads);
+}
+
+TEST(asset_store, test_read_changed)
+{
+    char path[sizeof(ASSET_STORE_BASE_PATH) + ASSET_STORE_NAME_SIZE];
+    struct stat st;
+    const ASSET_STORE_Table_t *pOld = NULL;
+    const ASSET_STORE_Table_t *pNew = NULL;
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_SEQUENCE_NAME, &pOld));
+    test_check_entry(pOld, 1, 0x20);
+
+    /* Same size, only the time tells the entries changed */
+    test_path(TEST_SEQUENCE_NAME, path);
+    TEST_ASSERT_EQUAL(0, stat(path, &st));
+    test_write_sequence(0x50);
+    struct utimbuf times = {.actime = st.st_mtime + 10, .modtime = st.st_mtime + 10};
+    TEST_ASSERT_EQUAL(0, utime(path, &times));
+
+    /* Before the scan, the entries of the new file are not returned for the old table */
+    uint8_t entry[4];
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_ReadEntries(pOld, 1, 1, entry));
+
+    test_reload(2, TEST_SEQUENCE_NAME);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_ReadEntries(pOld, 1, 1, entry));
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_SEQUENCE_NAME, &pNew));
+    test_check_entry(pNew, 1, 0x50);
+    test_check_entry(pNew, TEST_SEQUENCE_COUNT - 1, 0x50);
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pOld));
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pNew));
+}
+
+TEST(asset_store, test_remove)
+{
+    char path[sizeof(ASSET_STORE_BASE_PATH) + ASSET_STORE_NAME_SIZE];
+    const ASSET_STORE_Table_t *pTable = NULL;
+
+    /* Acquired before the removal, still readable from the cache */
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pTable));
+
+    test_path(TEST_PATTERN_NAME, path);
+    TEST_ASSERT_EQUAL(0, remove(path));
+    test_reload(3, TEST_PATTERN_NAME);
+
+    test_check_entry(pTable, 0, 0x40);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pTable));
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pTable));
+    ASSET_STORE_Stats_t stats;
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(1, stats.tables);
+    TEST_ASSERT_EQUAL(0, stats.cached);
+}
+
+TEST(asset_store, test_invalid_file)
+{
+    char path[sizeof(ASSET_STORE_BASE_PATH) + ASSET_STORE_NAME_SIZE];
+    const ASSET_STORE_Table_t *pTable = NULL;
+    ASSET_STORE_Stats_t stats;
+
+    /* Header of more entries than the file holds, never reported */
+    test_write(TEST_PATTERN_NAME, ASSET_STORE_TYPE_LED_PATTERN, 0x60, 7, TEST_PATTERN_COUNT + 1, 7 * TEST_PATTERN_COUNT);
+    test_reload(3, NULL);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pTable));
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(2, stats.invalid_files);
+
+    /* Wrong magic */
+    test_write(TEST_PATTERN_NAME, ASSET_STORE_TYPE_LED_PATTERN, 0x60, 7, TEST_PATTERN_COUNT, 7 * TEST_PATTERN_COUNT);
+    test_path(TEST_PATTERN_NAME, path);
+    FILE *pFile = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(pFile);
+    fputc('X', pFile);
+    fclose(pFile);
+    test_reload(3, NULL);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pTable));
+
+    /* Loaded once fixed */
+    test_write_pattern(0x70);
+    test_reload(4, TEST_PATTERN_NAME);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Acquire(TEST_PATTERN_NAME, &pTable));
+    test_check_entry(pTable, TEST_PATTERN_COUNT - 1, 0x70);
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_Release(pTable));
+
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_FAIL, ASSET_STORE_Acquire(TEST_INVALID_NAME, &pTable));
+    TEST_ASSERT_EQUAL(ASSET_STORE_STATUS_SUCCESS, ASSET_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(2, stats.tables);
+}
+
+TEST_GROUP_RUNNER(asset_store)
+{
+    RUN_TEST_CASE(asset_store, test_load);
+    RUN_TEST_CASE(asset_store, test_reload_acquired);
+    RUN_TEST_CASE(asset_store, test_read_changed);
+    RUN_TEST_CASE(asset_store, test_remove);
+    RUN_TEST_CASE(asset_store, test_invalid_file);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(asset_store);
+}
+
+void app_main(void)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+}
@@ -0,0 +1,266 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "bootTrace.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct BOOT_TRACE_Marker_s{
+    const char *pName;
+    uint32_t time_us;
+}BOOT_TRACE_Marker_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static uint32_t BOOT_TRACE_Now(void);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const char * const boot_marker_names[ESP_BOOT_TRACE_MAX] = {
+    [ESP_BOOT_TRACE_BOOTLOADER_START]   = "bootloader start",
+    [ESP_BOOT_TRACE_BOOTLOADER_CLOCK]   = "bootloader clock",
+    [ESP_BOOT_TRACE_BOOTLOADER_FLASH]   = "bootloader flash",
+    [ESP_BOOT_TRACE_BOOTLOADER_INIT]    = "bootloader init",
+    [ESP_BOOT_TRACE_PARTITION_SELECTED] = "partition selected",
+    [ESP_BOOT_TRACE_IMAGE_LOAD]         = "image header",
+    [ESP_BOOT_TRACE_IMAGE_SEGMENTS]     = "image segments",
+    [ESP_BOOT_TRACE_IMAGE_VERIFIED]     = "image verified",
+    [ESP_BOOT_TRACE_APP_START]          = "app start",
+    [ESP_BOOT_TRACE_APP_CLOCK]          = "app clock",
+    [ESP_BOOT_TRACE_CORE_INIT]          = "core init",
+    [ESP_BOOT_TRACE_GLOBAL_CTORS]       = "constructors",
+    [ESP_BOOT_TRACE_SECONDARY_INIT]     = "component init",
+};
+
+//Copy of the bootloader and startup markers, 0 when not reached
+static uint32_t boot_time_us[ESP_BOOT_TRACE_MAX];
+static bool bootloader_trace = false;
+//Added to the app timer to get the time since the bootloader started
+static uint32_t app_offset_us = 0;
+
+static BOOT_TRACE_Marker_t app_markers[BOOT_TRACE_MAX_APP_MARKERS];
+static uint8_t app_marker_count = 0;
+
+static SemaphoreHandle_t boot_trace_mutex_handle = NULL;
+
+static const char * TAG = "BOOT_TRACE";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Boot trace time
+*
+*   This function is used to read the time since the bootloader started. The
+*   app timer is used rather than the RTC time, it can be read from both
+*   cores.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     time in microseconds
+*
+*******************************************************************************/
+static uint32_t BOOT_TRACE_Now(void){
+
+    return (uint32_t)esp_timer_get_time() + app_offset_us;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Boot trace initialization
+*
+*   This function is used to initialize the boot trace module. It takes a
+*   copy of the markers recorded by the bootloader and the startup code and
+*   records the "app_main" marker.
+*
+*   Preconditions: Called first thing in app_main, on the PRO_CPU.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_InitModule(void){
+
+    memset(boot_time_us, 0, sizeof(boot_time_us));
+    bootloader_trace = false;
+    app_offset_us = 0;
+
+#if CONFIG_BOOTLOADER_BOOT_TRACE
+    if(esp_boot_trace_get(boot_time_us) == ESP_OK){
+        bootloader_trace = true;
+        app_offset_us = esp_boot_trace_elapsed_us() - (uint32_t)esp_timer_get_time();
+    }
+    else{
+        ESP_LOGW(TAG, "No bootloader trace");
+    }
+#endif
+
+    app_marker_count = 0;
+
+    //Create mutex
+    boot_trace_mutex_handle = xSemaphoreCreateMutex();
+    if(boot_trace_mutex_handle == NULL){
+        ESP_LOGW(TAG, "Failed to create Boot Trace mutex");
+        return BOOT_TRACE_STATUS_FAIL;
+    }
+
+    return BOOT_TRACE_Mark("app_main");
+}
+
+/***************************************************************************//*!
+*  \brief Boot trace mark
+*
+*   This function is used to record the time an application init step is
+*   done, on the time base of the bootloader markers. Markers past
+*   BOOT_TRACE_MAX_APP_MARKERS are dropped.
+*
+*   Preconditions: BOOT_TRACE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pName               Marker name, must stay valid
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_Mark(const char *pName){
+
+    uint32_t now = BOOT_TRACE_Now();
+
+    if(boot_trace_mutex_handle == NULL || pName == NULL){
+        return BOOT_TRACE_STATUS_FAIL;
+    }
+
+    BOOT_TRACE_Ret_t ret = BOOT_TRACE_STATUS_FAIL;
+
+    xSemaphoreTake(boot_trace_mutex_handle, portMAX_DELAY);
+    if(app_marker_count < BOOT_TRACE_MAX_APP_MARKERS){
+        app_markers[app_marker_count].pName = pName;
+        app_markers[app_marker_count].time_us = now;
+        app_marker_count++;
+        ret = BOOT_TRACE_STATUS_SUCCESS;
+    }
+    xSemaphoreGive(boot_trace_mutex_handle);
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Boot trace report
+*
+*   This function is used to read the boot markers reached so far, in boot
+*   order, with the time spent since the previous marker.
+*
+*   Preconditions: BOOT_TRACE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pReport             Pointer to store the report
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_GetReport(BOOT_TRACE_Report_t *pReport){
+
+    if(boot_trace_mutex_handle == NULL || pReport == NULL){
+        return BOOT_TRACE_STATUS_FAIL;
+    }
+
+    memset(pReport, 0, sizeof(BOOT_TRACE_Report_t));
+    pReport->bootloader_trace = bootloader_trace;
+
+    //The bootloader start is the time origin, it is always reached
+    for(uint8_t i=0; i<ESP_BOOT_TRACE_MAX; i++){
+        if(bootloader_trace && (i == ESP_BOOT_TRACE_BOOTLOADER_START || boot_time_us[i] != 0)){
+            pReport->entries[pReport->count].pName = boot_marker_names[i];
+            pReport->entries[pReport->count].time_us = boot_time_us[i];
+            pReport->count++;
+        }
+    }
+
+    xSemaphoreTake(boot_trace_mutex_handle, portMAX_DELAY);
+    for(uint8_t i=0; i<app_marker_count; i++){
+        pReport->entries[pReport->count].pName = app_markers[i].pName;
+        pReport->entries[pReport->count].time_us = app_markers[i].time_us;
+        pReport->count++;
+    }
+    xSemaphoreGive(boot_trace_mutex_handle);
+
+    for(uint8_t i=1; i<pReport->count; i++){
+        pReport->entries[i].delta_us = pReport->entries[i].time_us - pReport->entries[i-1].time_us;
+    }
+
+    return BOOT_TRACE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Boot trace print
+*
+*   This function is used to log the boot report, one line per marker.
+*
+*   Preconditions: BOOT_TRACE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_PrintReport(void){
+
+    BOOT_TRACE_Report_t report;
+
+    if(BOOT_TRACE_GetReport(&report) != BOOT_TRACE_STATUS_SUCCESS){
+        return BOOT_TRACE_STATUS_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Boot report, times since %s:", report.bootloader_trace ? "bootloader start" : "app timer start");
+    for(uint8_t i=0; i<report.count; i++){
+        ESP_LOGI(TAG, "  %-20s %8lu us  +%lu us",
+                 report.entries[i].pName,
+                 (unsigned long)report.entries[i].time_us,
+                 (unsigned long)report.entries[i].delta_us);
+    }
+
+    return BOOT_TRACE_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,120 @@
+#ifndef _BOOT_TRACE_H
+#define _BOOT_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_boot_trace.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+//Markers recorded by the application with BOOT_TRACE_Mark
+#define BOOT_TRACE_MAX_APP_MARKERS          (8)
+//Bootloader and startup markers, then the application markers
+#define BOOT_TRACE_MAX_ENTRIES              (ESP_BOOT_TRACE_MAX + BOOT_TRACE_MAX_APP_MARKERS)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef struct BOOT_TRACE_Entry_s{
+    const char *pName;
+    uint32_t time_us;                       //Time since the bootloader started
+    uint32_t delta_us;                      //Time since the previous entry
+}BOOT_TRACE_Entry_t;
+
+typedef struct BOOT_TRACE_Report_s{
+    BOOT_TRACE_Entry_t entries[BOOT_TRACE_MAX_ENTRIES];
+    uint8_t count;
+    bool bootloader_trace;                  //False when the bootloader recorded no trace, times start at the app timer
+}BOOT_TRACE_Report_t;
+
+typedef enum BOOT_TRACE_Ret_e{
+    BOOT_TRACE_STATUS_FAIL,
+    BOOT_TRACE_STATUS_SUCCESS,
+}BOOT_TRACE_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Boot trace initialization
+*
+*   This function is used to initialize the boot trace module. It takes a
+*   copy of the markers recorded by the bootloader and the startup code and
+*   records the "app_main" marker.
+*
+*   Preconditions: Called first thing in app_main, on the PRO_CPU.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Boot trace mark
+*
+*   This function is used to record the time an application init step is
+*   done, on the time base of the bootloader markers. Markers past
+*   BOOT_TRACE_MAX_APP_MARKERS are dropped.
+*
+*   Preconditions: BOOT_TRACE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pName               Marker name, must stay valid
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_Mark(const char *pName);
+
+/***************************************************************************//*!
+*  \brief Boot trace report
+*
+*   This function is used to read the boot markers reached so far, in boot
+*   order, with the time spent since the previous marker.
+*
+*   Preconditions: BOOT_TRACE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pReport             Pointer to store the report
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_GetReport(BOOT_TRACE_Report_t *pReport);
+
+/***************************************************************************//*!
+*  \brief Boot trace print
+*
+*   This function is used to log the boot report, one line per marker.
+*
+*   Preconditions: BOOT_TRACE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+BOOT_TRACE_Ret_t BOOT_TRACE_PrintReport(void);
+
+#endif//_BOOT_TRACE_H
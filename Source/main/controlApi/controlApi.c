@@ -0,0 +1,480 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_http_server.h"
+#include "http_parser.h"
+#include "esp_log.h"
+
+#include "controlApi.h"
+#include "sensorStream.h"
+#include "softSwitcher.h"
+#include "buttonController.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define CTRL_API_RAILS_URI              "/rails"
+//API endpoints and the sensor stream
+#define CTRL_API_MAX_URI_HANDLERS       (6)
+#define CTRL_API_QUERY_SIZE             (32)
+#define CTRL_API_STATE_SIZE             (8)
+#define CTRL_API_AUTH_SIZE              (80)
+
+#if CONFIG_CONTROL_API_RAIL_WRITE
+#define CTRL_API_TOKEN                  (CONFIG_CONTROL_API_TOKEN)
+#else
+#define CTRL_API_TOKEN                  ""
+#endif
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct CTRL_API_Rail_s{
+    const char *pName;
+    SOFT_IO_Id_t id;
+}CTRL_API_Rail_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static bool CTRL_API_Append(char *pBuf, size_t *pLen, const char *pFormat, ...);
+static bool CTRL_API_AppendRail(char *pBuf, size_t *pLen, const CTRL_API_Rail_t *pRail);
+static const CTRL_API_Rail_t * CTRL_API_FindRail(httpd_req_t *req);
+static bool CTRL_API_CheckToken(httpd_req_t *req);
+static esp_err_t CTRL_API_SendJson(httpd_req_t *req, const char *pJson, size_t len);
+
+static esp_err_t CTRL_API_GetRails(httpd_req_t *req);
+static esp_err_t CTRL_API_GetRail(httpd_req_t *req);
+static esp_err_t CTRL_API_PutRail(httpd_req_t *req);
+static esp_err_t CTRL_API_GetSensors(httpd_req_t *req);
+static esp_err_t CTRL_API_GetButtons(httpd_req_t *req);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const CTRL_API_Rail_t rail_table[] = {
+    {"pwr",         SOFT_SWITCHER_PWR_ID},
+    {"charging",    SOFT_SWITCHER_CHARGING_ID},
+};
+
+static const httpd_uri_t uri_table[] = {
+    {.uri = CTRL_API_RAILS_URI,         .method = HTTP_GET,     .handler = CTRL_API_GetRails},
+    {.uri = CTRL_API_RAILS_URI "/*",    .method = HTTP_GET,     .handler = CTRL_API_GetRail},
+    {.uri = CTRL_API_RAILS_URI "/*",    .method = HTTP_PUT,     .handler = CTRL_API_PutRail},
+    {.uri = "/sensors",                 .method = HTTP_GET,     .handler = CTRL_API_GetSensors},
+    {.uri = "/buttons",                 .method = HTTP_GET,     .handler = CTRL_API_GetButtons},
+};
+
+static CTRL_API_Sensors_t sensors_snapshot;
+static TickType_t sensors_tick = 0;
+static bool sensors_valid = false;
+
+static httpd_handle_t server_handle = NULL;
+static SemaphoreHandle_t ctrl_api_mutex_handle = NULL;
+
+static const char * TAG = "CTRL_API";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static bool CTRL_API_Append(char *pBuf, size_t *pLen, const char *pFormat, ...){
+
+    va_list args;
+    va_start(args, pFormat);
+    int written = vsnprintf(&pBuf[*pLen], CTRL_API_RESP_SIZE - *pLen, pFormat, args);
+    va_end(args);
+
+    if(written < 0 || (size_t)written >= CTRL_API_RESP_SIZE - *pLen){
+        return false;
+    }
+    *pLen += written;
+
+    return true;
+}
+
+static bool CTRL_API_AppendRail(char *pBuf, size_t *pLen, const CTRL_API_Rail_t *pRail){
+
+    uint8_t level = 0;
+    if(SOFT_GetIOState(pRail->id, &level) != SOFT_SWITCHER_STATUS_SUCCESS){
+        return false;
+    }
+
+    return CTRL_API_Append(pBuf, pLen, "{\"name\":\"%s\",\"on\":%s}", pRail->pName, level ? "true" : "false");
+}
+
+static const CTRL_API_Rail_t * CTRL_API_FindRail(httpd_req_t *req){
+
+    //The URI may be in absolute form, the name is the path segment after "/rails/"
+    struct http_parser_url url;
+    http_parser_url_init(&url);
+    if(http_parser_parse_url(req->uri, strlen(req->uri), 0, &url) != 0 || (url.field_set & (1 << UF_PATH)) == 0){
+        return NULL;
+    }
+
+    const char *pPath = req->uri + url.field_data[UF_PATH].off;
+    size_t path_len = url.field_data[UF_PATH].len;
+    size_t prefix_len = strlen(CTRL_API_RAILS_URI "/");
+    if(path_len <= prefix_len || strncmp(pPath, CTRL_API_RAILS_URI "/", prefix_len) != 0){
+        return NULL;
+    }
+
+    const char *pName = pPath + prefix_len;
+    size_t name_len = path_len - prefix_len;
+
+    for(uint8_t i=0; i<sizeof(rail_table)/sizeof(rail_table[0]); i++){
+        if(strlen(rail_table[i].pName) == name_len && strncmp(rail_table[i].pName, pName, name_len) == 0){
+            return &rail_table[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool CTRL_API_CheckToken(httpd_req_t *req){
+
+    char auth[CTRL_API_AUTH_SIZE];
+    const char *pToken = CTRL_API_TOKEN;
+    size_t token_len = strlen(pToken);
+    size_t prefix_len = strlen("Bearer ");
+
+    if(token_len == 0 || httpd_req_get_hdr_value_str(req, "Authorization", auth, sizeof(auth)) != ESP_OK ||
+       strncmp(auth, "Bearer ", prefix_len) != 0 || strlen(&auth[prefix_len]) != token_len){
+        return false;
+    }
+
+    //Compared in constant time, the timing does not tell how many characters match
+    uint8_t diff = 0;
+    for(size_t i=0; i<token_len; i++){
+        diff |= (uint8_t)(auth[prefix_len + i] ^ pToken[i]);
+    }
+
+    return (diff == 0);
+}
+
+static esp_err_t CTRL_API_SendJson(httpd_req_t *req, const char *pJson, size_t len){
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    return httpd_resp_send(req, pJson, len);
+}
+
+static esp_err_t CTRL_API_GetRails(httpd_req_t *req){
+
+    char json[CTRL_API_RESP_SIZE];
+    size_t len = 0;
+    bool ok = CTRL_API_Append(json, &len, "{\"rails\":[");
+
+    for(uint8_t i=0; ok && i<sizeof(rail_table)/sizeof(rail_table[0]); i++){
+        ok = (i == 0 || CTRL_API_Append(json, &len, ",")) && CTRL_API_AppendRail(json, &len, &rail_table[i]);
+    }
+    ok = ok && CTRL_API_Append(json, &len, "]}");
+
+    if(!ok){
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read rails");
+    }
+
+    return CTRL_API_SendJson(req, json, len);
+}
+
+static esp_err_t CTRL_API_GetRail(httpd_req_t *req){
+
+    const CTRL_API_Rail_t *pRail = CTRL_API_FindRail(req);
+    if(pRail == NULL){
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown rail");
+    }
+
+    char json[CTRL_API_RESP_SIZE];
+    size_t len = 0;
+    if(!CTRL_API_AppendRail(json, &len, pRail)){
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read rail");
+    }
+
+    return CTRL_API_SendJson(req, json, len);
+}
+
+static esp_err_t CTRL_API_PutRail(httpd_req_t *req){
+
+    if(strlen(CTRL_API_TOKEN) == 0){
+        return httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "Rail control disabled");
+    }
+    if(!CTRL_API_CheckToken(req)){
+        httpd_resp_set_hdr(req, "WWW-Authenticate", "Bearer");
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Invalid token");
+    }
+
+    const CTRL_API_Rail_t *pRail = CTRL_API_FindRail(req);
+    if(pRail == NULL){
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown rail");
+    }
+
+    char query[CTRL_API_QUERY_SIZE];
+    char state[CTRL_API_STATE_SIZE];
+    if(httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+       httpd_query_key_value(query, "state", state, sizeof(state)) != ESP_OK){
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Expected state=on or state=off");
+    }
+
+    SOFT_Switcher_Ret_t ret;
+    if(strcmp(state, "on") == 0 || strcmp(state, "1") == 0){
+        ret = SOFT_SetOutput(pRail->id);
+    }
+    else if(strcmp(state, "off") == 0 || strcmp(state, "0") == 0){
+        ret = SOFT_ClearOutput(pRail->id);
+    }
+    else{
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Expected state=on or state=off");
+    }
+
+    char json[CTRL_API_RESP_SIZE];
+    size_t len = 0;
+    if(ret != SOFT_SWITCHER_STATUS_SUCCESS || !CTRL_API_AppendRail(json, &len, pRail)){
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to switch rail");
+    }
+
+    ESP_LOGI(TAG, "Rail '%s' switched %s", pRail->pName, state);
+
+    return CTRL_API_SendJson(req, json, len);
+}
+
+static esp_err_t CTRL_API_GetSensors(httpd_req_t *req){
+
+    CTRL_API_Sensors_t sensors;
+    TickType_t tick;
+    bool valid;
+
+    xSemaphoreTake(ctrl_api_mutex_handle, portMAX_DELAY);
+    sensors = sensors_snapshot;
+    tick = sensors_tick;
+    valid = sensors_valid;
+    xSemaphoreGive(ctrl_api_mutex_handle);
+
+    if(!valid){
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_sendstr(req, "No sensor data yet");
+    }
+
+    char json[CTRL_API_RESP_SIZE];
+    size_t len = 0;
+    CTRL_API_Append(json, &len,
+                    "{\"pwr_voltage_mv\":%ld,\"batt_voltage_mv\":%ld,\"current_ma\":%ld,"
+                    "\"temperature_dc\":%ld,\"age_ms\":%lu}",
+                    (long)sensors.pwr_voltage,
+                    (long)sensors.batt_voltage,
+                    (long)sensors.current,
+                    (long)sensors.temperature,
+                    (unsigned long)pdTICKS_TO_MS(xTaskGetTickCount() - tick));
+
+    return CTRL_API_SendJson(req, json, len);
+}
+
+static esp_err_t CTRL_API_GetButtons(httpd_req_t *req){
+
+    char json[CTRL_API_RESP_SIZE];
+    size_t len = 0;
+    bool ok = CTRL_API_Append(json, &len, "{\"buttons\":[");
+    bool first = true;
+
+    for(uint8_t i=0; ok && i<BTN_MAX_NUMBER_OF_BUTTON; i++){
+        uint8_t io;
+        bool pressed;
+        if(BTN_GetButtonState(i, &io, &pressed) != BTN_CTRL_STATUS_SUCCESS){
+            continue;
+        }
+        ok = CTRL_API_Append(json, &len, "%s{\"id\":%u,\"io\":%u,\"pressed\":%s}",
+                             first ? "" : ",", i, io, pressed ? "true" : "false");
+        first = false;
+    }
+    ok = ok && CTRL_API_Append(json, &len, "]}");
+
+    if(!ok){
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read buttons");
+    }
+
+    return CTRL_API_SendJson(req, json, len);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Control API initialization
+*
+*   This function is used to initialize the control API module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_InitModule(void){
+
+    //Create mutex, once
+    if(ctrl_api_mutex_handle == NULL){
+        ctrl_api_mutex_handle = xSemaphoreCreateMutex();
+        if(ctrl_api_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Control API mutex");
+            return CTRL_API_STATUS_FAIL;
+        }
+    }
+
+    sensors_valid = false;
+
+    return (SENSOR_STREAM_InitModule() == SENSOR_STREAM_STATUS_SUCCESS) ? CTRL_API_STATUS_SUCCESS : CTRL_API_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Control API start
+*
+*   This function is used to start the HTTP server and register the API
+*   endpoints:
+*
+*       GET /rails                  State of every rail
+*       GET /rails/<name>           State of one rail
+*       PUT /rails/<name>?state=on  Turn a rail on or off
+*       GET /sensors                Last sensor snapshot
+*       GET /buttons                Debounced state of every button
+*       GET /stream                 WebSocket sensor stream, see sensorStream.h
+*
+*   Responses are JSON, formatted in a fixed buffer without allocation.
+*   PUT requests are refused unless CONFIG_CONTROL_API_RAIL_WRITE is set,
+*   and must carry "Authorization: Bearer <CONFIG_CONTROL_API_TOKEN>".
+*
+*   Preconditions: CTRL_API_InitModule called, network interface up.
+*
+*   Side Effects: Starts the HTTP server task.
+*
+*   \param[in]  port                TCP port to listen on
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_Start(uint16_t port){
+
+    if(ctrl_api_mutex_handle == NULL || server_handle != NULL){
+        return CTRL_API_STATUS_FAIL;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = port;
+    config.max_uri_handlers = CTRL_API_MAX_URI_HANDLERS;
+    //Routed through the server URI trie, "/rails/*" covers every rail
+    config.uri_match_fn = httpd_uri_match_wildcard;
+
+    if(httpd_start(&server_handle, &config) != ESP_OK){
+        ESP_LOGE(TAG, "Failed to start HTTP server on port %u", port);
+        server_handle = NULL;
+        return CTRL_API_STATUS_FAIL;
+    }
+
+    for(uint8_t i=0; i<sizeof(uri_table)/sizeof(uri_table[0]); i++){
+        if(httpd_register_uri_handler(server_handle, &uri_table[i]) != ESP_OK){
+            ESP_LOGE(TAG, "Failed to register %s", uri_table[i].uri);
+            CTRL_API_Stop();
+            return CTRL_API_STATUS_FAIL;
+        }
+    }
+
+    if(SENSOR_STREAM_Attach(server_handle) != SENSOR_STREAM_STATUS_SUCCESS){
+        CTRL_API_Stop();
+        return CTRL_API_STATUS_FAIL;
+    }
+
+    if(strlen(CTRL_API_TOKEN) == 0){
+        ESP_LOGI(TAG, "Rail control disabled, rails are read only");
+    }
+    ESP_LOGI(TAG, "Control API listening on port %u", port);
+
+    return CTRL_API_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Control API stop
+*
+*   This function is used to stop the HTTP server.
+*
+*   Preconditions: CTRL_API_Start called.
+*
+*   Side Effects: Stops the HTTP server task.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_Stop(void){
+
+    if(server_handle == NULL){
+        return CTRL_API_STATUS_FAIL;
+    }
+
+    SENSOR_STREAM_Detach();
+    esp_err_t err = httpd_stop(server_handle);
+    server_handle = NULL;
+
+    return (err == ESP_OK) ? CTRL_API_STATUS_SUCCESS : CTRL_API_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Control API update sensors
+*
+*   This function is used to store the snapshot served by GET /sensors and
+*   to add it to the sensor stream.
+*
+*   Preconditions: CTRL_API_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pSensors            Latest sensor values
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_UpdateSensors(const CTRL_API_Sensors_t *pSensors){
+
+    if(ctrl_api_mutex_handle == NULL || pSensors == NULL){
+        return CTRL_API_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(ctrl_api_mutex_handle, portMAX_DELAY);
+    sensors_snapshot = *pSensors;
+    sensors_tick = xTaskGetTickCount();
+    sensors_valid = true;
+    xSemaphoreGive(ctrl_api_mutex_handle);
+
+    //Never blocks on a streaming client
+    SENSOR_STREAM_AddSample(pSensors);
+
+    return CTRL_API_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
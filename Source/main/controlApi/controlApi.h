@@ -0,0 +1,121 @@
+#ifndef _CONTROL_API_H
+#define _CONTROL_API_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define CTRL_API_DEFAULT_PORT               (80)
+
+//Largest response body, formatted on the HTTP server task stack
+#define CTRL_API_RESP_SIZE                  (320)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef struct CTRL_API_Sensors_s{
+    int32_t pwr_voltage;                    //mV
+    int32_t batt_voltage;                   //mV
+    int32_t current;                        //mA
+    int32_t temperature;                    //Tenths of a degree Celsius
+}CTRL_API_Sensors_t;
+
+typedef enum CTRL_API_Ret_e{
+    CTRL_API_STATUS_FAIL,
+    CTRL_API_STATUS_SUCCESS,
+}CTRL_API_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Control API initialization
+*
+*   This function is used to initialize the control API module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Control API start
+*
+*   This function is used to start the HTTP server and register the API
+*   endpoints:
+*
+*       GET /rails                  State of every rail
+*       GET /rails/<name>           State of one rail
+*       PUT /rails/<name>?state=on  Turn a rail on or off
+*       GET /sensors                Last sensor snapshot
+*       GET /buttons                Debounced state of every button
+*       GET /stream                 WebSocket sensor stream, see sensorStream.h
+*
+*   Responses are JSON, formatted in a fixed buffer without allocation.
+*   PUT requests are refused unless CONFIG_CONTROL_API_RAIL_WRITE is set,
+*   and must carry "Authorization: Bearer <CONFIG_CONTROL_API_TOKEN>".
+*
+*   Preconditions: CTRL_API_InitModule called, network interface up.
+*
+*   Side Effects: Starts the HTTP server task.
+*
+*   \param[in]  port                TCP port to listen on
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_Start(uint16_t port);
+
+/***************************************************************************//*!
+*  \brief Control API stop
+*
+*   This function is used to stop the HTTP server.
+*
+*   Preconditions: CTRL_API_Start called.
+*
+*   Side Effects: Stops the HTTP server task.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_Stop(void);
+
+/***************************************************************************//*!
+*  \brief Control API update sensors
+*
+*   This function is used to store the snapshot served by GET /sensors and
+*   to add it to the sensor stream.
+*
+*   Preconditions: CTRL_API_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pSensors            Latest sensor values
+*
+*   \return     operation status
+*
+*******************************************************************************/
+CTRL_API_Ret_t CTRL_API_UpdateSensors(const CTRL_API_Sensors_t *pSensors);
+
+#endif//_CONTROL_API_H
@@ -0,0 +1,418 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Linux host control API test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "unity_fixture.h"
+#include "Mockgpio.h"
+
+#include "controlApi.h"
+#include "sensorStream.h"
+#include "softSwitcher.h"
+#include "buttonController.h"
+
+// Port 80 can only be used by a privileged user on linux
+#define TEST_PORT           (8001)
+#define TEST_RESP_SIZE      (1024)
+#define TEST_FRAME_SIZE     (sizeof(SENSOR_STREAM_Header_t) + SENSOR_STREAM_FRAME_SAMPLES * sizeof(SENSOR_STREAM_Sample_t))
+#define TEST_GPIO_COUNT     (32)
+// Pwr is active high and charging active low, so both polarities go through the switcher
+#define TEST_PWR_IO         (10)
+#define TEST_CHARGING_IO    (11)
+#define TEST_AUTH           "Authorization: Bearer " CONFIG_CONTROL_API_TOKEN "\r\n"
+
+static uint32_t gpio_level[TEST_GPIO_COUNT];
+
+static const struct {
+    uint8_t io;
+    bool pressed;
+} test_buttons[] = {
+    {4, false},
+    {5, true},
+};
+
+/* The rails go through the real soft switcher, the GPIO driver mock keeps the pin levels */
+static esp_err_t test_gpio_set_level(gpio_num_t gpio_num, uint32_t level, int cmock_num_calls)
+{
+    TEST_ASSERT_LESS_THAN(TEST_GPIO_COUNT, gpio_num);
+    gpio_level[gpio_num] = level;
+    return ESP_OK;
+}
+
+static int test_gpio_get_level(gpio_num_t gpio_num, int cmock_num_calls)
+{
+    TEST_ASSERT_LESS_THAN(TEST_GPIO_COUNT, gpio_num);
+    return gpio_level[gpio_num];
+}
+
+/* Fake of the button controller, the API only sees its interface */
+BTN_Ctrl_Ret_t BTN_GetButtonState(uint8_t index, uint8_t *pIo, bool *pPressed)
+{
+    if (index >= sizeof(test_buttons) / sizeof(test_buttons[0])) {
+        return BTN_CTRL_STATUS_FAIL;
+    }
+    *pIo = test_buttons[index].io;
+    *pPressed = test_buttons[index].pressed;
+    return BTN_CTRL_STATUS_SUCCESS;
+}
+
+static int test_connect(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(TEST_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    TEST_ASSERT_EQUAL(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+
+    /* Never hang on a frame that does not come */
+    struct timeval timeout = { .tv_sec = 3 };
+    TEST_ASSERT_EQUAL(0, setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)));
+    return fd;
+}
+
+/* Open the sensor stream, return the socket */
+static int ws_open(void)
+{
+    int fd = test_connect();
+    const char *handshake = "GET " SENSOR_STREAM_URI " HTTP/1.1\r\nHost: localhost\r\n"
+                            "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    TEST_ASSERT_EQUAL(strlen(handshake), send(fd, handshake, strlen(handshake), 0));
+
+    /* Read the response up to the end of the headers, not into the first frame */
+    char resp[TEST_RESP_SIZE] = {0};
+    for (int len = 0; strstr(resp, "\r\n\r\n") == NULL; len++) {
+        TEST_ASSERT_LESS_THAN(sizeof(resp) - 1, len);
+        TEST_ASSERT_EQUAL(1, recv(fd, &resp[len], 1, 0));
+    }
+    TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 101", resp, strlen("HTTP/1.1 101"));
+    return fd;
+}
+
+/* Receive one unfragmented frame, return its payload length */
+static size_t ws_recv(int fd, uint8_t *type, uint8_t *payload, size_t size)
+{
+    uint8_t header[4];
+    TEST_ASSERT_EQUAL(2, recv(fd, header, 2, MSG_WAITALL));
+    size_t len = header[1] & 0x7f;
+    if (len == 126) {
+        TEST_ASSERT_EQUAL(2, recv(fd, &header[2], 2, MSG_WAITALL));
+        len = (header[2] << 8) | header[3];
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(size, len);
+    TEST_ASSERT_EQUAL(len, recv(fd, payload, len, MSG_WAITALL));
+    *type = header[0] & 0x0f;
+    return len;
+}
+
+/* Send a text command, masked with a zero key, and return the reply */
+static void ws_command(int fd, const char *cmd, const char *expected)
+{
+    uint8_t frame[64] = {0x80 | HTTPD_WS_TYPE_TEXT, 0x80 | strlen(cmd), 0, 0, 0, 0};
+    memcpy(&frame[6], cmd, strlen(cmd));
+    TEST_ASSERT_EQUAL(6 + strlen(cmd), send(fd, frame, 6 + strlen(cmd), 0));
+
+    uint8_t type;
+    char reply[16] = {0};
+    ws_recv(fd, &type, (uint8_t *)reply, sizeof(reply) - 1);
+    TEST_ASSERT_EQUAL(HTTPD_WS_TYPE_TEXT, type);
+    TEST_ASSERT_EQUAL_STRING(expected, reply);
+}
+
+/* Add whole frames of samples, the current reading is the sample number */
+static void add_frames(uint32_t frames)
+{
+    static int32_t sample_number = 0;
+    for (uint32_t i = 0; i < frames * SENSOR_STREAM_FRAME_SAMPLES; i++) {
+        CTRL_API_Sensors_t sensors = { .current = sample_number++ };
+        TEST_ASSERT_EQUAL(CTRL_API_STATUS_SUCCESS, CTRL_API_UpdateSensors(&sensors));
+    }
+}
+
+static void ws_recv_sensor_frame(int fd, SENSOR_STREAM_Header_t *pHeader, SENSOR_STREAM_Sample_t *pSamples)
+{
+    uint8_t frame[TEST_FRAME_SIZE];
+    uint8_t type;
+    TEST_ASSERT_EQUAL(TEST_FRAME_SIZE, ws_recv(fd, &type, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL(HTTPD_WS_TYPE_BINARY, type);
+    memcpy(pHeader, frame, sizeof(*pHeader));
+    memcpy(pSamples, &frame[sizeof(*pHeader)], SENSOR_STREAM_FRAME_SAMPLES * sizeof(SENSOR_STREAM_Sample_t));
+    TEST_ASSERT_EQUAL(SENSOR_STREAM_VERSION, pHeader->version);
+    TEST_ASSERT_EQUAL(SENSOR_STREAM_FRAME_SAMPLES, pHeader->sample_count);
+}
+
+/* Send one request with extra header lines on a new connection, return the status code and copy the body */
+static int http_request_hdr(const char *method, const char *uri, const char *headers, char *body)
+{
+    int fd = test_connect();
+
+    char buf[TEST_RESP_SIZE];
+    int len = snprintf(buf, sizeof(buf), "%s %s HTTP/1.1\r\nHost: localhost\r\n%sContent-Length: 0\r\n\r\n", method, uri, headers);
+    TEST_ASSERT_EQUAL(len, send(fd, buf, len, 0));
+
+    /* Read until the whole body announced by Content-Length is in */
+    int total = 0;
+    char *header_end = NULL;
+    int content_length = -1;
+    while (total < (int)sizeof(buf) - 1) {
+        int n = recv(fd, &buf[total], sizeof(buf) - 1 - total, 0);
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+        buf[total] = '\0';
+        if (header_end == NULL && (header_end = strstr(buf, "\r\n\r\n")) != NULL) {
+            const char *cl = strstr(buf, "Content-Length:");
+            TEST_ASSERT_NOT_NULL(cl);
+            content_length = atoi(cl + strlen("Content-Length:"));
+        }
+        if (header_end != NULL && total - (header_end + 4 - buf) >= content_length) {
+            break;
+        }
+    }
+    close(fd);
+
+    TEST_ASSERT_NOT_NULL(header_end);
+    strcpy(body, header_end + 4);
+
+    int status = 0;
+    TEST_ASSERT_EQUAL(1, sscanf(buf, "HTTP/1.1 %d", &status));
+    return status;
+}
+
+static int http_request(const char *method, const char *uri, char *body)
+{
+    return http_request_hdr(method, uri, "", body);
+}
+
+TEST_GROUP(control_api);
+
+TEST_SETUP(control_api)
+{
+    memset(gpio_level, 0, sizeof(gpio_level));
+    gpio_config_IgnoreAndReturn(ESP_OK);
+    gpio_set_level_Stub(test_gpio_set_level);
+    gpio_get_level_Stub(test_gpio_get_level);
+
+    SOFT_IO_Config_t pwr_io = {.io_num = TEST_PWR_IO, .active_level = SOFT_IO_LEVEL_HIGH};
+    SOFT_IO_Config_t charging_io = {.io_num = TEST_CHARGING_IO, .active_level = SOFT_IO_LEVEL_LOW};
+    TEST_ASSERT_EQUAL(SOFT_SWITCHER_STATUS_SUCCESS, SOFT_InitModule(pwr_io, charging_io));
+    TEST_ASSERT_EQUAL(0, gpio_level[TEST_PWR_IO]);
+    TEST_ASSERT_EQUAL(1, gpio_level[TEST_CHARGING_IO]);
+
+    TEST_ASSERT_EQUAL(CTRL_API_STATUS_SUCCESS, CTRL_API_InitModule());
+    TEST_ASSERT_EQUAL(CTRL_API_STATUS_SUCCESS, CTRL_API_Start(TEST_PORT));
+}
+
+TEST_TEAR_DOWN(control_api)
+{
+    TEST_ASSERT_EQUAL(CTRL_API_STATUS_SUCCESS, CTRL_API_Stop());
+}
+
+TEST(control_api, test_get_rails)
+{
+    char body[TEST_RESP_SIZE];
+
+    gpio_level[TEST_CHARGING_IO] = 0;
+    TEST_ASSERT_EQUAL(200, http_request("GET", "/rails", body));
+    TEST_ASSERT_EQUAL_STRING("{\"rails\":[{\"name\":\"pwr\",\"on\":false},{\"name\":\"charging\",\"on\":true}]}", body);
+
+    TEST_ASSERT_EQUAL(200, http_request("GET", "/rails/charging", body));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"charging\",\"on\":true}", body);
+}
+
+TEST(control_api, test_switch_rail)
+{
+    char body[TEST_RESP_SIZE];
+
+    TEST_ASSERT_EQUAL(200, http_request_hdr("PUT", "/rails/pwr?state=on", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"pwr\",\"on\":true}", body);
+    TEST_ASSERT_EQUAL(1, gpio_level[TEST_PWR_IO]);
+
+    TEST_ASSERT_EQUAL(200, http_request_hdr("PUT", "/rails/pwr?state=0", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"pwr\",\"on\":false}", body);
+    TEST_ASSERT_EQUAL(0, gpio_level[TEST_PWR_IO]);
+
+    TEST_ASSERT_EQUAL(200, http_request_hdr("PUT", "/rails/charging?state=on", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"charging\",\"on\":true}", body);
+    TEST_ASSERT_EQUAL(0, gpio_level[TEST_CHARGING_IO]);
+
+    TEST_ASSERT_EQUAL(200, http_request_hdr("PUT", "/rails/charging?state=off", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"charging\",\"on\":false}", body);
+    TEST_ASSERT_EQUAL(1, gpio_level[TEST_CHARGING_IO]);
+
+    TEST_ASSERT_EQUAL(400, http_request_hdr("PUT", "/rails/pwr?state=maybe", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL(400, http_request_hdr("PUT", "/rails/pwr", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL(404, http_request_hdr("PUT", "/rails/pwrx?state=on", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL(0, gpio_level[TEST_PWR_IO]);
+}
+
+TEST(control_api, test_switch_rail_absolute_uri)
+{
+    char body[TEST_RESP_SIZE];
+
+    TEST_ASSERT_EQUAL(200, http_request_hdr("PUT", "http://localhost/rails/pwr?state=on", TEST_AUTH, body));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"pwr\",\"on\":true}", body);
+    TEST_ASSERT_EQUAL(1, gpio_level[TEST_PWR_IO]);
+
+    TEST_ASSERT_EQUAL(200, http_request("GET", "http://localhost:8001/rails/pwr", body));
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"pwr\",\"on\":true}", body);
+}
+
+TEST(control_api, test_switch_rail_token)
+{
+    char body[TEST_RESP_SIZE];
+
+    TEST_ASSERT_EQUAL(401, http_request("PUT", "/rails/pwr?state=on", body));
+    TEST_ASSERT_EQUAL(401, http_request_hdr("PUT", "/rails/pwr?state=on", "Authorization: Bearer wrong-token\r\n", body));
+    TEST_ASSERT_EQUAL(401, http_request_hdr("PUT", "/rails/pwr?state=on", "Authorization: Bearer " CONFIG_CONTROL_API_TOKEN "x\r\n", body));
+    TEST_ASSERT_EQUAL(401, http_request_hdr("PUT", "/rails/pwr?state=on", "Authorization: " CONFIG_CONTROL_API_TOKEN "\r\n", body));
+    TEST_ASSERT_EQUAL(0, gpio_level[TEST_PWR_IO]);
+
+    // Reading the rails needs no token
+    TEST_ASSERT_EQUAL(200, http_request("GET", "/rails/pwr", body));
+}
+
+TEST(control_api, test_routing_errors)
+{
+    char body[TEST_RESP_SIZE];
+
+    TEST_ASSERT_EQUAL(404, http_request("GET", "/", body));
+    TEST_ASSERT_EQUAL(404, http_request("GET", "/railsx", body));
+    TEST_ASSERT_EQUAL(404, http_request("GET", "/rails/unknown", body));
+    TEST_ASSERT_EQUAL(404, http_request("GET", "/sensors/", body));
+    TEST_ASSERT_EQUAL(405, http_request("POST", "/sensors", body));
+    TEST_ASSERT_EQUAL(405, http_request("DELETE", "/rails/pwr", body));
+    TEST_ASSERT_EQUAL(405, http_request("PUT", "/rails", body));
+}
+
+TEST(control_api, test_get_sensors)
+{
+    char body[TEST_RESP_SIZE];
+
+    TEST_ASSERT_EQUAL(503, http_request("GET", "/sensors", body));
+
+    CTRL_API_Sensors_t sensors = {
+        .pwr_voltage = 12050,
+        .batt_voltage = 3700,
+        .current = -150,
+        .temperature = 231,
+    };
+    TEST_ASSERT_EQUAL(CTRL_API_STATUS_SUCCESS, CTRL_API_UpdateSensors(&sensors));
+
+    TEST_ASSERT_EQUAL(200, http_request("GET", "/sensors?x=1", body));
+    TEST_ASSERT_NOT_NULL(strstr(body, "{\"pwr_voltage_mv\":12050,\"batt_voltage_mv\":3700,\"current_ma\":-150,\"temperature_dc\":231,\"age_ms\":"));
+}
+
+TEST(control_api, test_get_buttons)
+{
+    char body[TEST_RESP_SIZE];
+
+    TEST_ASSERT_EQUAL(200, http_request("GET", "/buttons", body));
+    TEST_ASSERT_EQUAL_STRING("{\"buttons\":[{\"id\":0,\"io\":4,\"pressed\":false},{\"id\":1,\"io\":5,\"pressed\":true}]}", body);
+}
+
+TEST(control_api, test_stream_frames)
+{
+    int fd = ws_open();
+    ws_command(fd, "rate 0", "ok");
+    ws_command(fd, "speed 3", "error");
+    ws_command(fd, "backlog 0", "error");
+
+    SENSOR_STREAM_Header_t header;
+    SENSOR_STREAM_Sample_t samples[SENSOR_STREAM_FRAME_SAMPLES];
+
+    add_frames(1);
+    ws_recv_sensor_frame(fd, &header, samples);
+    TEST_ASSERT_EQUAL(0, header.sequence);
+    TEST_ASSERT_EQUAL(0, header.dropped);
+
+    add_frames(1);
+    ws_recv_sensor_frame(fd, &header, samples);
+    TEST_ASSERT_EQUAL(1, header.sequence);
+    TEST_ASSERT_EQUAL(0, header.dropped);
+    for (int i = 1; i < SENSOR_STREAM_FRAME_SAMPLES; i++) {
+        TEST_ASSERT_EQUAL(samples[0].sensors.current + i, samples[i].sensors.current);
+    }
+
+    /* The reply comes from the server task, once the flush is over */
+    ws_command(fd, "rate 0", "ok");
+    SENSOR_STREAM_Stats_t stats;
+    TEST_ASSERT_EQUAL(SENSOR_STREAM_STATUS_SUCCESS, SENSOR_STREAM_GetStats(&stats));
+    TEST_ASSERT_EQUAL(1, stats.clients);
+    TEST_ASSERT_EQUAL(2, stats.frames_sealed);
+    TEST_ASSERT_EQUAL(2, stats.frames_sent);
+    close(fd);
+}
+
+TEST(control_api, test_stream_drops_oldest)
+{
+    int fd = ws_open();
+    ws_command(fd, "backlog 2", "ok");
+    ws_command(fd, "rate 1", "ok");
+
+    /* Rate limited, the frames queue up and the oldest are dropped */
+    add_frames(6);
+    vTaskDelay(pdMS_TO_TICKS(1100));
+    add_frames(1);
+
+    SENSOR_STREAM_Header_t header;
+    SENSOR_STREAM_Sample_t samples[SENSOR_STREAM_FRAME_SAMPLES];
+
+    ws_recv_sensor_frame(fd, &header, samples);
+    TEST_ASSERT_EQUAL(5, header.sequence);
+    TEST_ASSERT_EQUAL(5, header.dropped);
+    ws_recv_sensor_frame(fd, &header, samples);
+    TEST_ASSERT_EQUAL(6, header.sequence);
+    TEST_ASSERT_EQUAL(0, header.dropped);
+
+    /* The reply comes from the server task, once the flush is over */
+    ws_command(fd, "rate 0", "ok");
+    SENSOR_STREAM_Stats_t stats;
+    TEST_ASSERT_EQUAL(SENSOR_STREAM_STATUS_SUCCESS, SENSOR_STREAM_GetStats(&stats));
+    TEST_ASSERT_EQUAL(7, stats.frames_sealed);
+    TEST_ASSERT_EQUAL(2, stats.frames_sent);
+    TEST_ASSERT_EQUAL(5, stats.frames_dropped);
+    close(fd);
+}
+
+TEST_GROUP_RUNNER(control_api)
+{
+    RUN_TEST_CASE(control_api, test_get_rails);
+    RUN_TEST_CASE(control_api, test_switch_rail);
+    RUN_TEST_CASE(control_api, test_switch_rail_absolute_uri);
+    RUN_TEST_CASE(control_api, test_switch_rail_token);
+    RUN_TEST_CASE(control_api, test_routing_errors);
+    RUN_TEST_CASE(control_api, test_get_sensors);
+    RUN_TEST_CASE(control_api, test_get_buttons);
+    RUN_TEST_CASE(control_api, test_stream_frames);
+    RUN_TEST_CASE(control_api, test_stream_drops_oldest);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(control_api);
+}
+
+void app_main(void)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+}
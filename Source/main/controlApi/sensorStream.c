@@ -0,0 +1,508 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_http_server.h"
+#include "esp_log.h"
+
+#include "sensorStream.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define SENSOR_STREAM_CMD_SIZE          (24)
+#define SENSOR_STREAM_NO_CLIENT         (-1)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct __attribute__((packed)) SENSOR_STREAM_Frame_s{
+    SENSOR_STREAM_Header_t header;
+    SENSOR_STREAM_Sample_t samples[SENSOR_STREAM_FRAME_SAMPLES];
+}SENSOR_STREAM_Frame_t;
+
+typedef struct SENSOR_STREAM_Client_s{
+    int fd;                                 //SENSOR_STREAM_NO_CLIENT when the slot is free
+    uint32_t next_sequence;                 //Next frame to send
+    uint32_t dropped;                       //Frames dropped since the last one sent
+    uint32_t interval_ms;                   //Minimum time between bursts, 0 for no limit
+    TickType_t last_burst;
+    uint8_t backlog;
+}SENSOR_STREAM_Client_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static bool SENSOR_STREAM_AddClient(int fd);
+static void SENSOR_STREAM_DropOldest(SENSOR_STREAM_Client_t *pClient);
+static bool SENSOR_STREAM_Command(int fd, char *pCmd);
+static void SENSOR_STREAM_Flush(void *arg);
+static esp_err_t SENSOR_STREAM_Handler(httpd_req_t *req);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const httpd_uri_t stream_uri = {
+    .uri = SENSOR_STREAM_URI,
+    .method = HTTP_GET,
+    .handler = SENSOR_STREAM_Handler,
+    .is_websocket = true,
+};
+
+//Sealed frames, frame n is at index n % SENSOR_STREAM_RING_FRAMES
+static SENSOR_STREAM_Frame_t frame_ring[SENSOR_STREAM_RING_FRAMES];
+static SENSOR_STREAM_Frame_t current_frame;
+static TickType_t current_first_tick = 0;
+static uint32_t sealed_count = 0;
+
+//Only used by the HTTP server task
+static SENSOR_STREAM_Frame_t send_frame;
+
+static SENSOR_STREAM_Client_t client_table[SENSOR_STREAM_MAX_CLIENTS];
+static SENSOR_STREAM_Stats_t stream_stats;
+static bool flush_queued = false;
+
+static httpd_handle_t stream_server = NULL;
+static SemaphoreHandle_t stream_mutex_handle = NULL;
+
+static const char * TAG = "SENSOR_STREAM";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+//Called with the mutex taken
+static bool SENSOR_STREAM_AddClient(int fd){
+
+    SENSOR_STREAM_Client_t *pFree = NULL;
+
+    for(uint8_t i=0; i<SENSOR_STREAM_MAX_CLIENTS; i++){
+        if(client_table[i].fd == fd){
+            //Socket reused by a new connection
+            pFree = &client_table[i];
+            break;
+        }
+        if(pFree == NULL && client_table[i].fd == SENSOR_STREAM_NO_CLIENT){
+            pFree = &client_table[i];
+        }
+    }
+
+    if(pFree == NULL){
+        return false;
+    }
+
+    //Start with the next sealed frame
+    pFree->fd = fd;
+    pFree->next_sequence = sealed_count;
+    pFree->dropped = 0;
+    pFree->interval_ms = 0;
+    pFree->last_burst = xTaskGetTickCount();
+    pFree->backlog = SENSOR_STREAM_DEFAULT_BACKLOG;
+
+    return true;
+}
+
+//Called with the mutex taken
+static void SENSOR_STREAM_DropOldest(SENSOR_STREAM_Client_t *pClient){
+
+    uint32_t queued = sealed_count - pClient->next_sequence;
+
+    if(queued > pClient->backlog){
+        uint32_t drop = queued - pClient->backlog;
+        pClient->next_sequence += drop;
+        pClient->dropped += drop;
+        stream_stats.frames_dropped += drop;
+    }
+}
+
+static bool SENSOR_STREAM_Command(int fd, char *pCmd){
+
+    char *pArg = strchr(pCmd, ' ');
+    if(pArg == NULL){
+        return false;
+    }
+    *pArg++ = '\0';
+
+    char *pEnd;
+    unsigned long value = strtoul(pArg, &pEnd, 10);
+    if(pEnd == pArg || *pEnd != '\0'){
+        return false;
+    }
+
+    bool ok = false;
+
+    xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+
+    for(uint8_t i=0; i<SENSOR_STREAM_MAX_CLIENTS; i++){
+        SENSOR_STREAM_Client_t *pClient = &client_table[i];
+        if(pClient->fd != fd){
+            continue;
+        }
+        if(strcmp(pCmd, "rate") == 0 && value <= 1000){
+            pClient->interval_ms = (value == 0) ? 0 : (1000 / value);
+            ok = true;
+        }
+        else if(strcmp(pCmd, "backlog") == 0 && value >= 1 && value <= SENSOR_STREAM_RING_FRAMES){
+            pClient->backlog = value;
+            ok = true;
+        }
+        break;
+    }
+
+    xSemaphoreGive(stream_mutex_handle);
+
+    return ok;
+}
+
+//Runs on the HTTP server task, queued when a frame is sealed
+static void SENSOR_STREAM_Flush(void *arg){
+
+    xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+
+    flush_queued = false;
+    httpd_handle_t server = stream_server;
+
+    for(uint8_t i=0; server != NULL && i<SENSOR_STREAM_MAX_CLIENTS; i++){
+        SENSOR_STREAM_Client_t *pClient = &client_table[i];
+        int fd = pClient->fd;
+
+        if(fd == SENSOR_STREAM_NO_CLIENT){
+            continue;
+        }
+        if(httpd_ws_get_fd_info(server, fd) != HTTPD_WS_CLIENT_WEBSOCKET){
+            ESP_LOGI(TAG, "Client %d left", fd);
+            pClient->fd = SENSOR_STREAM_NO_CLIENT;
+            continue;
+        }
+
+        //Rate limited clients get their queued frames on a later flush
+        TickType_t now = xTaskGetTickCount();
+        if(pClient->interval_ms != 0 && pdTICKS_TO_MS(now - pClient->last_burst) < pClient->interval_ms){
+            continue;
+        }
+
+        bool sent = false;
+        while(pClient->fd == fd && pClient->next_sequence != sealed_count){
+            SENSOR_STREAM_DropOldest(pClient);
+
+            //Copy out, the ring may be written while the frame is sent
+            send_frame = frame_ring[pClient->next_sequence % SENSOR_STREAM_RING_FRAMES];
+            send_frame.header.dropped = (pClient->dropped > UINT16_MAX) ? UINT16_MAX : pClient->dropped;
+            pClient->dropped = 0;
+            pClient->next_sequence++;
+
+            xSemaphoreGive(stream_mutex_handle);
+
+            httpd_ws_frame_t ws_frame = {
+                .type = HTTPD_WS_TYPE_BINARY,
+                .payload = (uint8_t *)&send_frame,
+                .len = sizeof(SENSOR_STREAM_Header_t) + send_frame.header.sample_count * sizeof(SENSOR_STREAM_Sample_t),
+            };
+            esp_err_t err = httpd_ws_send_frame_async(server, fd, &ws_frame);
+
+            xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+
+            if(stream_server != server){
+                //Detached while sending
+                break;
+            }
+            if(err != ESP_OK){
+                ESP_LOGW(TAG, "Failed to send to client %d, closing", fd);
+                pClient->fd = SENSOR_STREAM_NO_CLIENT;
+                httpd_sess_trigger_close(server, fd);
+                break;
+            }
+            stream_stats.frames_sent++;
+            sent = true;
+        }
+
+        if(sent){
+            pClient->last_burst = now;
+        }
+        if(stream_server != server){
+            break;
+        }
+    }
+
+    xSemaphoreGive(stream_mutex_handle);
+}
+
+static esp_err_t SENSOR_STREAM_Handler(httpd_req_t *req){
+
+    int fd = httpd_req_to_sockfd(req);
+
+    if(req->method == HTTP_GET){
+        //Handshake done, subscribe the client
+        if(httpd_ws_get_fd_info(req->handle, fd) != HTTPD_WS_CLIENT_WEBSOCKET){
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "WebSocket only");
+        }
+
+        xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+        bool added = SENSOR_STREAM_AddClient(fd);
+        xSemaphoreGive(stream_mutex_handle);
+
+        if(!added){
+            ESP_LOGW(TAG, "Failed to add client %d -> Table full", fd);
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "Client %d subscribed", fd);
+        return ESP_OK;
+    }
+
+    char cmd[SENSOR_STREAM_CMD_SIZE];
+    httpd_ws_frame_t frame = {
+        .payload = (uint8_t *)cmd,
+    };
+    if(httpd_ws_recv_frame(req, &frame, sizeof(cmd) - 1) != ESP_OK){
+        return ESP_FAIL;
+    }
+    if(frame.type != HTTPD_WS_TYPE_TEXT){
+        return ESP_OK;
+    }
+    cmd[frame.len] = '\0';
+
+    const char *pReply = SENSOR_STREAM_Command(fd, cmd) ? "ok" : "error";
+    httpd_ws_frame_t reply = {
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)pReply,
+        .len = strlen(pReply),
+    };
+
+    return httpd_ws_send_frame(req, &reply);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Sensor stream initialization
+*
+*   This function is used to initialize the sensor stream module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_InitModule(void){
+
+    //Create mutex, once
+    if(stream_mutex_handle == NULL){
+        stream_mutex_handle = xSemaphoreCreateMutex();
+        if(stream_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Sensor Stream mutex");
+            return SENSOR_STREAM_STATUS_FAIL;
+        }
+    }
+
+    for(uint8_t i=0; i<SENSOR_STREAM_MAX_CLIENTS; i++){
+        client_table[i].fd = SENSOR_STREAM_NO_CLIENT;
+    }
+    memset(&current_frame, 0, sizeof(current_frame));
+    memset(&stream_stats, 0, sizeof(stream_stats));
+    sealed_count = 0;
+    flush_queued = false;
+    stream_server = NULL;
+
+    return SENSOR_STREAM_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Sensor stream attach
+*
+*   This function is used to register the WebSocket endpoint on a running
+*   HTTP server. A client subscribes by opening SENSOR_STREAM_URI and then
+*   receives one binary message per frame. It can send text commands,
+*   answered with "ok" or "error":
+*
+*       rate <n>        At most n bursts of frames per second, 0 for no limit
+*       backlog <n>     Frames queued before the oldest are dropped
+*
+*   Preconditions: SENSOR_STREAM_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  server              HTTP server handle
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_Attach(httpd_handle_t server){
+
+    if(stream_mutex_handle == NULL || server == NULL){
+        return SENSOR_STREAM_STATUS_FAIL;
+    }
+
+    if(httpd_register_uri_handler(server, &stream_uri) != ESP_OK){
+        ESP_LOGE(TAG, "Failed to register %s", stream_uri.uri);
+        return SENSOR_STREAM_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+    stream_server = server;
+    xSemaphoreGive(stream_mutex_handle);
+
+    return SENSOR_STREAM_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Sensor stream detach
+*
+*   This function is used to forget the HTTP server and every client before
+*   the server is stopped.
+*
+*   Preconditions: SENSOR_STREAM_Attach called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_Detach(void){
+
+    if(stream_mutex_handle == NULL){
+        return SENSOR_STREAM_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+
+    stream_server = NULL;
+    for(uint8_t i=0; i<SENSOR_STREAM_MAX_CLIENTS; i++){
+        client_table[i].fd = SENSOR_STREAM_NO_CLIENT;
+    }
+
+    xSemaphoreGive(stream_mutex_handle);
+
+    return SENSOR_STREAM_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Sensor stream add sample
+*
+*   This function is used by the sampling pipeline to add a sample to the
+*   current frame. It never waits on a client: sealed frames are sent from
+*   the HTTP server task, and a client falling behind loses its oldest
+*   frames.
+*
+*   Preconditions: SENSOR_STREAM_InitModule called.
+*
+*   Side Effects: May queue a send on the HTTP server task.
+*
+*   \param[in]  pSensors            Sample to add
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_AddSample(const CTRL_API_Sensors_t *pSensors){
+
+    if(stream_mutex_handle == NULL || pSensors == NULL){
+        return SENSOR_STREAM_STATUS_FAIL;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    httpd_handle_t server = NULL;
+
+    xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+
+    if(current_frame.header.sample_count == 0){
+        current_first_tick = now;
+    }
+    SENSOR_STREAM_Sample_t *pSample = &current_frame.samples[current_frame.header.sample_count++];
+    pSample->timestamp_ms = pdTICKS_TO_MS(now);
+    pSample->sensors = *pSensors;
+
+    if(current_frame.header.sample_count == SENSOR_STREAM_FRAME_SAMPLES ||
+       pdTICKS_TO_MS(now - current_first_tick) >= SENSOR_STREAM_FRAME_MAX_AGE_MS){
+
+        current_frame.header.version = SENSOR_STREAM_VERSION;
+        current_frame.header.dropped = 0;
+        current_frame.header.sequence = sealed_count;
+        frame_ring[sealed_count % SENSOR_STREAM_RING_FRAMES] = current_frame;
+        sealed_count++;
+        stream_stats.frames_sealed++;
+        current_frame.header.sample_count = 0;
+
+        if(stream_server != NULL && !flush_queued){
+            flush_queued = true;
+            server = stream_server;
+        }
+    }
+
+    xSemaphoreGive(stream_mutex_handle);
+
+    //Sending is left to the server task
+    if(server != NULL && httpd_queue_work(server, SENSOR_STREAM_Flush, NULL) != ESP_OK){
+        xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+        flush_queued = false;
+        xSemaphoreGive(stream_mutex_handle);
+        return SENSOR_STREAM_STATUS_FAIL;
+    }
+
+    return SENSOR_STREAM_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Sensor stream statistics
+*
+*   This function is used to read the stream statistics.
+*
+*   Preconditions: SENSOR_STREAM_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the statistics
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_GetStats(SENSOR_STREAM_Stats_t *pStats){
+
+    if(stream_mutex_handle == NULL || pStats == NULL){
+        return SENSOR_STREAM_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(stream_mutex_handle, portMAX_DELAY);
+
+    *pStats = stream_stats;
+    pStats->clients = 0;
+    for(uint8_t i=0; i<SENSOR_STREAM_MAX_CLIENTS; i++){
+        if(client_table[i].fd != SENSOR_STREAM_NO_CLIENT){
+            pStats->clients++;
+        }
+    }
+
+    xSemaphoreGive(stream_mutex_handle);
+
+    return SENSOR_STREAM_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
@@ -0,0 +1,161 @@
+#ifndef _SENSOR_STREAM_H
+#define _SENSOR_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+#include "esp_http_server.h"
+
+#include "controlApi.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define SENSOR_STREAM_URI                   "/stream"
+#define SENSOR_STREAM_VERSION               (1)
+
+#define SENSOR_STREAM_MAX_CLIENTS           (4)
+//A frame is sealed once it holds this many samples or its first sample is this old
+#define SENSOR_STREAM_FRAME_SAMPLES         (16)
+#define SENSOR_STREAM_FRAME_MAX_AGE_MS      (250)
+//Sealed frames kept for the clients falling behind
+#define SENSOR_STREAM_RING_FRAMES           (8)
+//Frames a client may have queued before the oldest are dropped, changed with "backlog <n>"
+#define SENSOR_STREAM_DEFAULT_BACKLOG       (4)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+//Binary frame layout, little endian: header followed by sample_count samples
+typedef struct __attribute__((packed)) SENSOR_STREAM_Header_s{
+    uint8_t version;                        //SENSOR_STREAM_VERSION
+    uint8_t sample_count;
+    uint16_t dropped;                       //Frames dropped for this client before this one
+    uint32_t sequence;                      //Frame number, consecutive for a client that drops nothing
+}SENSOR_STREAM_Header_t;
+
+typedef struct __attribute__((packed)) SENSOR_STREAM_Sample_s{
+    uint32_t timestamp_ms;                  //Time the sample was added
+    CTRL_API_Sensors_t sensors;
+}SENSOR_STREAM_Sample_t;
+
+typedef struct SENSOR_STREAM_Stats_s{
+    uint8_t clients;                        //Subscribed clients
+    uint32_t frames_sealed;
+    uint32_t frames_sent;                   //Frames sent, all clients together
+    uint32_t frames_dropped;                //Frames dropped, all clients together
+}SENSOR_STREAM_Stats_t;
+
+typedef enum SENSOR_STREAM_Ret_e{
+    SENSOR_STREAM_STATUS_FAIL,
+    SENSOR_STREAM_STATUS_SUCCESS,
+}SENSOR_STREAM_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if !CONFIG_HTTPD_WS_SUPPORT
+#error "Sensor streaming needs CONFIG_HTTPD_WS_SUPPORT"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Sensor stream initialization
+*
+*   This function is used to initialize the sensor stream module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Sensor stream attach
+*
+*   This function is used to register the WebSocket endpoint on a running
+*   HTTP server. A client subscribes by opening SENSOR_STREAM_URI and then
+*   receives one binary message per frame. It can send text commands,
+*   answered with "ok" or "error":
+*
+*       rate <n>        At most n bursts of frames per second, 0 for no limit
+*       backlog <n>     Frames queued before the oldest are dropped
+*
+*   Preconditions: SENSOR_STREAM_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  server              HTTP server handle
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_Attach(httpd_handle_t server);
+
+/***************************************************************************//*!
+*  \brief Sensor stream detach
+*
+*   This function is used to forget the HTTP server and every client before
+*   the server is stopped.
+*
+*   Preconditions: SENSOR_STREAM_Attach called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_Detach(void);
+
+/***************************************************************************//*!
+*  \brief Sensor stream add sample
+*
+*   This function is used by the sampling pipeline to add a sample to the
+*   current frame. It never waits on a client: sealed frames are sent from
+*   the HTTP server task, and a client falling behind loses its oldest
+*   frames.
+*
+*   Preconditions: SENSOR_STREAM_InitModule called.
+*
+*   Side Effects: May queue a send on the HTTP server task.
+*
+*   \param[in]  pSensors            Sample to add
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_AddSample(const CTRL_API_Sensors_t *pSensors);
+
+/***************************************************************************//*!
+*  \brief Sensor stream statistics
+*
+*   This function is used to read the stream statistics.
+*
+*   Preconditions: SENSOR_STREAM_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the statistics
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SENSOR_STREAM_Ret_t SENSOR_STREAM_GetStats(SENSOR_STREAM_Stats_t *pStats);
+
+#endif//_SENSOR_STREAM_H
@@ -0,0 +1,339 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_system.h"
+#include "esp_log.h"
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+#include "esp_core_dump.h"
+#endif
+#if CONFIG_FLIGHT_RECORDER && CONFIG_ESP_COREDUMP_ENABLE
+#include "esp_private/panic_internal.h"
+#endif
+
+#include "flightRecorder.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define FLIGHT_REC_VERSION              (1)
+#define FLIGHT_REC_MASK                 (FLIGHT_REC_EVENTS - 1)
+#define FLIGHT_REC_CPU_MHZ              (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+//Kept across resets, in plain RAM on chips without RTC memory
+#if CONFIG_SOC_RTC_SLOW_MEM_SUPPORTED || CONFIG_SOC_RTC_FAST_MEM_SUPPORTED
+#define FLIGHT_REC_NOINIT_ATTR          RTC_NOINIT_ATTR
+#else
+#define FLIGHT_REC_NOINIT_ATTR          __NOINIT_ATTR
+#endif
+//Copied to the core dump by the panic handler, see CMakeLists.txt
+#define FLIGHT_REC_COREDUMP             (CONFIG_FLIGHT_RECORDER && CONFIG_ESP_COREDUMP_ENABLE)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+/*
+ * One ring per core, a core only writes its own ring so recording needs no
+ * lock. The layout is read from the core dump by tools/flight_recorder.py.
+ */
+typedef struct FLIGHT_REC_Ring_s{
+    uint32_t magic[2];
+    uint8_t version;
+    uint8_t core;
+    uint16_t events;                        //Ring size, a power of two
+    uint16_t event_size;
+    uint16_t cpu_mhz;                       //Cycles per microsecond
+    uint32_t head;                          //Sequence of the last event reserved
+    FLIGHT_REC_Event_t event[FLIGHT_REC_EVENTS];
+}FLIGHT_REC_Ring_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static const char * FLIGHT_REC_TypeName(uint8_t type);
+#if FLIGHT_REC_COREDUMP
+void __real_esp_panic_handler(panic_info_t *pInfo);
+#endif
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+//Not cleared by a reset, the events before a crash or watchdog are printed on the next boot
+static FLIGHT_REC_NOINIT_ATTR FLIGHT_REC_Ring_t flight_rings[portNUM_PROCESSORS];
+//Last event of the previous boot, 0 if the ring was not kept
+static uint32_t kept_heads[portNUM_PROCESSORS];
+#if FLIGHT_REC_COREDUMP
+//The core dump only takes loaded sections, the RTC rings are copied here on a panic
+static COREDUMP_DRAM_ATTR FLIGHT_REC_Ring_t dump_rings[portNUM_PROCESSORS];
+#endif
+
+static const char * TAG = "FLIGHT_REC";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static const char * FLIGHT_REC_TypeName(uint8_t type){
+
+    switch(type){
+        case FLIGHT_REC_TYPE_RAIL:          return "rail";
+        case FLIGHT_REC_TYPE_BUTTON:        return "button";
+        case FLIGHT_REC_TYPE_ADC_ALARM:     return "ADC alarm";
+        case FLIGHT_REC_TYPE_TIMER:         return "timer";
+        case FLIGHT_REC_TYPE_BOOT:          return "boot";
+        default:                            return "unknown";
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Flight recorder initialization
+*
+*   This function is used to check the rings left in RTC memory by the
+*   previous boot. Rings kept by a reset are continued after a boot event,
+*   the others are cleared. Events recorded before this call are lost when
+*   the rings are cleared.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t FLIGHT_REC_InitModule(void){
+
+    uint8_t reason = (uint8_t)esp_reset_reason();
+
+    for(uint8_t core=0; core<portNUM_PROCESSORS; core++){
+        FLIGHT_REC_Ring_t *pRing = &flight_rings[core];
+
+        //Random content after a power on
+        if(pRing->magic[0] == FLIGHT_REC_MAGIC_0 && pRing->magic[1] == FLIGHT_REC_MAGIC_1 &&
+           pRing->version == FLIGHT_REC_VERSION && pRing->core == core &&
+           pRing->events == FLIGHT_REC_EVENTS && pRing->event_size == sizeof(FLIGHT_REC_Event_t) &&
+           pRing->cpu_mhz == FLIGHT_REC_CPU_MHZ){
+            kept_heads[core] = pRing->head;
+        }
+        else{
+            memset(pRing, 0, sizeof(FLIGHT_REC_Ring_t));
+            pRing->magic[0] = FLIGHT_REC_MAGIC_0;
+            pRing->magic[1] = FLIGHT_REC_MAGIC_1;
+            pRing->version = FLIGHT_REC_VERSION;
+            pRing->core = core;
+            pRing->events = FLIGHT_REC_EVENTS;
+            pRing->event_size = sizeof(FLIGHT_REC_Event_t);
+            pRing->cpu_mhz = FLIGHT_REC_CPU_MHZ;
+            kept_heads[core] = 0;
+        }
+    }
+
+    //The cycle counters restart, times before this event belong to the previous boot
+    FLIGHT_REC_Record(FLIGHT_REC_TYPE_BOOT, 0, reason);
+
+    return FLIGHT_REC_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Flight recorder print report
+*
+*   This function is used to print the events recorded before the last
+*   reset, and to report a core dump left in flash by the last crash.
+*
+*   Preconditions: FLIGHT_REC_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t FLIGHT_REC_PrintReport(void){
+
+    FLIGHT_REC_Event_t event;
+
+    for(uint8_t core=0; core<portNUM_PROCESSORS; core++){
+        uint32_t head = kept_heads[core];
+        uint32_t first = (head > FLIGHT_REC_EVENTS) ? head - FLIGHT_REC_EVENTS + 1 : 1;
+
+        if(head == 0){
+            continue;
+        }
+        ESP_LOGW(TAG, "Core %u, last events before the reset:", core);
+
+        //Oldest first, the ones overwritten since the boot are left out
+        for(uint32_t sequence=first; sequence<=head; sequence++){
+            FLIGHT_REC_Event_t *pEvent = &flight_rings[core].event[(sequence - 1) & FLIGHT_REC_MASK];
+
+            if(__atomic_load_n(&pEvent->sequence, __ATOMIC_ACQUIRE) != sequence){
+                continue;
+            }
+            event = *pEvent;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if(__atomic_load_n(&pEvent->sequence, __ATOMIC_RELAXED) != sequence){
+                continue;
+            }
+            ESP_LOGW(TAG, "#%lu %lu us %s %u %u", (unsigned long)sequence, (unsigned long)(event.cycles / FLIGHT_REC_CPU_MHZ),
+                     FLIGHT_REC_TypeName(event.type), event.id, event.value);
+        }
+    }
+
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+    size_t address = 0;
+    size_t size = 0;
+
+    if(esp_core_dump_image_get(&address, &size) == ESP_OK){
+        char reason[64] = "unknown";
+
+#if CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+        esp_core_dump_get_panic_reason(reason, sizeof(reason));
+#endif
+        ESP_LOGW(TAG, "Core dump of %u bytes at 0x%x, %s", (unsigned)size, (unsigned)address, reason);
+    }
+#endif
+
+    return FLIGHT_REC_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Flight recorder record
+*
+*   This function is used to add an event to the ring of the calling core,
+*   overwriting the oldest one. It takes no lock and can be called from
+*   tasks and interrupts, with the cache disabled.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  type                Event type
+*   \param[in]  id                  Rail, button, channel or timer of the event
+*   \param[in]  value               Event value
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t IRAM_ATTR FLIGHT_REC_Record(FLIGHT_REC_Type_t type, uint8_t id, uint16_t value){
+
+    if(type >= FLIGHT_REC_TYPE_MAX){
+        return FLIGHT_REC_STATUS_FAIL;
+    }
+
+    //A task preempted here by another recorder on this core keeps its slot
+    FLIGHT_REC_Ring_t *pRing = &flight_rings[esp_cpu_get_core_id()];
+    uint32_t sequence = __atomic_add_fetch(&pRing->head, 1, __ATOMIC_RELAXED);
+    FLIGHT_REC_Event_t *pEvent = &pRing->event[(sequence - 1) & FLIGHT_REC_MASK];
+
+    //The sequence is written last, a dump taken in between shows the slot as empty
+    __atomic_store_n(&pEvent->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    pEvent->cycles = (uint32_t)esp_cpu_get_cycle_count();
+    pEvent->type = type;
+    pEvent->id = id;
+    pEvent->value = value;
+    __atomic_store_n(&pEvent->sequence, sequence, __ATOMIC_RELEASE);
+
+    return FLIGHT_REC_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Flight recorder get events
+*
+*   This function is used to copy the latest events of a core, oldest
+*   first. Events overwritten while they are copied are left out.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  core                Core of the ring
+*   \param[out] pEvents             Buffer of *pCount events
+*   \param[in,out] pCount           Buffer size, then number of events copied
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t FLIGHT_REC_GetEvents(uint8_t core, FLIGHT_REC_Event_t *pEvents, uint16_t *pCount){
+
+    if(core >= portNUM_PROCESSORS || pEvents == NULL || pCount == NULL){
+        return FLIGHT_REC_STATUS_FAIL;
+    }
+
+    FLIGHT_REC_Ring_t *pRing = &flight_rings[core];
+    uint32_t head = __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE);
+    uint32_t count = *pCount;
+
+    if(count > FLIGHT_REC_EVENTS)   count = FLIGHT_REC_EVENTS;
+    if(count > head)                count = head;
+
+    uint16_t copied = 0;
+    for(uint32_t sequence = head - count + 1; sequence <= head; sequence++){
+        FLIGHT_REC_Event_t *pEvent = &pRing->event[(sequence - 1) & FLIGHT_REC_MASK];
+
+        if(__atomic_load_n(&pEvent->sequence, __ATOMIC_ACQUIRE) != sequence){
+            continue;
+        }
+        pEvents[copied].cycles = pEvent->cycles;
+        pEvents[copied].type = pEvent->type;
+        pEvents[copied].id = pEvent->id;
+        pEvents[copied].value = pEvent->value;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        //Overwritten by the other core while copied
+        if(__atomic_load_n(&pEvent->sequence, __ATOMIC_RELAXED) != sequence){
+            continue;
+        }
+        pEvents[copied].sequence = sequence;
+        copied++;
+    }
+    *pCount = copied;
+
+    return FLIGHT_REC_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+#if FLIGHT_REC_COREDUMP
+/***************************************************************************//*!
+*  \brief Flight recorder panic handler
+*
+*   This function is called instead of esp_panic_handler, it copies the
+*   rings to the core dump section before the core dump is written. The
+*   other core is already stopped, an event it was writing shows as empty.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pInfo               Panic information
+*
+*******************************************************************************/
+void IRAM_ATTR __wrap_esp_panic_handler(panic_info_t *pInfo){
+
+    memcpy(dump_rings, flight_rings, sizeof(dump_rings));
+
+    __real_esp_panic_handler(pInfo);
+}
+#endif
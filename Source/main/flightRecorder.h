@@ -0,0 +1,143 @@
+#ifndef _FLIGHT_RECORDER_H
+#define _FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#if CONFIG_FLIGHT_RECORDER
+#define FLIGHT_REC_EVENTS                   (CONFIG_FLIGHT_RECORDER_EVENTS)
+#else
+#define FLIGHT_REC_EVENTS                   (16)
+#endif
+
+//Ring header magic, found by tools/flight_recorder.py in a memory dump
+#define FLIGHT_REC_MAGIC_0                  (0x52544C46)    //"FLTR"
+#define FLIGHT_REC_MAGIC_1                  (0x31434552)    //"REC1"
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+//Compiled out with the flight recorder, hooks cost nothing then
+#if CONFIG_FLIGHT_RECORDER
+#define FLIGHT_REC_RECORD(type, id, value)  FLIGHT_REC_Record((type), (id), (value))
+#else
+#define FLIGHT_REC_RECORD(type, id, value)
+#endif
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum FLIGHT_REC_Type_e{
+    FLIGHT_REC_TYPE_RAIL = 1,               //id: SOFT_IO_Id_t, value: 1 on, 0 off
+    FLIGHT_REC_TYPE_BUTTON,                 //id: GPIO, value: 1 pressed, 0 released
+    FLIGHT_REC_TYPE_ADC_ALARM,              //id: ADC channel, value: reading in mV
+    FLIGHT_REC_TYPE_TIMER,                  //id: timer, value: user defined
+    FLIGHT_REC_TYPE_BOOT,                   //id: 0, value: esp_reset_reason_t of the new boot
+
+    FLIGHT_REC_TYPE_MAX,
+}FLIGHT_REC_Type_t;
+
+typedef struct FLIGHT_REC_Event_s{
+    uint32_t sequence;                      //Events recorded on the core, 0 while written
+    uint32_t cycles;                        //CPU cycle count of the core
+    uint8_t type;                           //FLIGHT_REC_Type_t
+    uint8_t id;
+    uint16_t value;
+}FLIGHT_REC_Event_t;
+
+typedef enum FLIGHT_REC_Ret_e{
+    FLIGHT_REC_STATUS_FAIL,
+    FLIGHT_REC_STATUS_SUCCESS,
+}FLIGHT_REC_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if (FLIGHT_REC_EVENTS & (FLIGHT_REC_EVENTS - 1)) != 0
+#error "CONFIG_FLIGHT_RECORDER_EVENTS must be a power of two"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Flight recorder initialization
+*
+*   This function is used to check the rings left in RTC memory by the
+*   previous boot. Rings kept by a reset are continued after a boot event,
+*   the others are cleared. Events recorded before this call are lost when
+*   the rings are cleared.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t FLIGHT_REC_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Flight recorder print report
+*
+*   This function is used to print the events recorded before the last
+*   reset, and to report a core dump left in flash by the last crash.
+*
+*   Preconditions: FLIGHT_REC_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t FLIGHT_REC_PrintReport(void);
+
+/***************************************************************************//*!
+*  \brief Flight recorder record
+*
+*   This function is used to add an event to the ring of the calling core,
+*   overwriting the oldest one. It takes no lock and can be called from
+*   tasks and interrupts, with the cache disabled.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  type                Event type
+*   \param[in]  id                  Rail, button, channel or timer of the event
+*   \param[in]  value               Event value
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t FLIGHT_REC_Record(FLIGHT_REC_Type_t type, uint8_t id, uint16_t value);
+
+/***************************************************************************//*!
+*  \brief Flight recorder get events
+*
+*   This function is used to copy the latest events of a core, oldest
+*   first. Events overwritten while they are copied are left out.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  core                Core of the ring
+*   \param[out] pEvents             Buffer of *pCount events
+*   \param[in,out] pCount           Buffer size, then number of events copied
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FLIGHT_REC_Ret_t FLIGHT_REC_GetEvents(uint8_t core, FLIGHT_REC_Event_t *pEvents, uint16_t *pCount);
+
+#endif//_FLIGHT_RECORDER_H
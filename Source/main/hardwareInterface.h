@@ -1,21 +1,39 @@
 #ifndef _HARDWARE_INTERFACE_H
 #define _HARDWARE_INTERFACE_H
 
+#include "sdkconfig.h"
+
 /******************************************************************************
 *   Public Definitions
 *******************************************************************************/
 #define HWI_BATT_LEVEL_1_OUT                (4)
 #define HWI_BATT_LEVEL_2_OUT                (5)
+#if CONFIG_IDF_TARGET_ESP32
+//GPIO6 to GPIO11 drive the SPI flash
+#define HWI_BATT_LEVEL_3_OUT                (25)
+#define HWI_BATT_LEVEL_4_OUT                (26)
+#else
 #define HWI_BATT_LEVEL_3_OUT                (6)
 #define HWI_BATT_LEVEL_4_OUT                (7)
+#endif
+//WS2812 strip SKUs, the strip replaces the battery level LEDs
+#define HWI_LED_STRIP_OUT                   (4)
 #define HWI_PWR_OUT                         (18)
 #define HWI_CHARGE_OUT                      (19)
 #define HWI_BTN_IN                          (9)
+//Fuel gauge and charger bus
+#define HWI_I2C_SDA_IO                      (21)
+#define HWI_I2C_SCL_IO                      (22)
+
+//Active level of the rail outputs, the bootloader drives the opposite level
+#define HWI_PWR_ACTIVE_LEVEL                (1)
+#define HWI_CHARGE_ACTIVE_LEVEL             (1)
 
 /******************************************************************************
 *   Public Macros
 *******************************************************************************/
-
+//SPI flash pins of the esp32
+#define HWI_IS_FLASH_IO(io)                 (((io) >= 6) && ((io) <= 11))
 
 /******************************************************************************
 *   Public Data Types
@@ -30,6 +48,15 @@
 /******************************************************************************
 *   Error Check
 *******************************************************************************/
+#if (HWI_PWR_ACTIVE_LEVEL > 1) || (HWI_CHARGE_ACTIVE_LEVEL > 1)
+#error "Rail output active levels must be 0 or 1"
+#endif
+
+#if CONFIG_IDF_TARGET_ESP32 && CONFIG_LED_BACKEND_DISCRETE &&                          \
+    (HWI_IS_FLASH_IO(HWI_BATT_LEVEL_1_OUT) || HWI_IS_FLASH_IO(HWI_BATT_LEVEL_2_OUT) ||  \
+     HWI_IS_FLASH_IO(HWI_BATT_LEVEL_3_OUT) || HWI_IS_FLASH_IO(HWI_BATT_LEVEL_4_OUT))
+#error "Battery level LEDs can not use the SPI flash pins of the esp32"
+#endif
 
 
 /******************************************************************************
@@ -0,0 +1,250 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Linux host init graph test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "initGraph.h"
+
+#define TEST_WORKERS        (2)
+#define TEST_INIT_MS        (50)
+#define TEST_WAIT           (pdMS_TO_TICKS(2000))
+
+enum {
+    TEST_RAILS_ID,
+    TEST_A_ID,
+    TEST_B_ID,
+    TEST_C_ID,
+    TEST_LAZY_ID,
+    TEST_MAX_ID,
+};
+
+static uint8_t init_order[TEST_MAX_ID];
+static uint8_t init_count;
+static bool rails_ready_on_start;
+static bool fail_a;
+static SemaphoreHandle_t record_mutex;
+
+/* The app timer is headers only on linux, read the host clock instead */
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void test_record(uint8_t id)
+{
+    xSemaphoreTake(record_mutex, portMAX_DELAY);
+    init_order[init_count++] = id;
+    xSemaphoreGive(record_mutex);
+}
+
+/* Position of a module in the init order, TEST_MAX_ID if never initialized */
+static uint8_t test_position(uint8_t id)
+{
+    for (uint8_t i = 0; i < init_count; i++) {
+        if (init_order[i] == id) {
+            return i;
+        }
+    }
+    return TEST_MAX_ID;
+}
+
+static bool test_init_rails(void)
+{
+    test_record(TEST_RAILS_ID);
+    return true;
+}
+
+static bool test_init_a(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(TEST_INIT_MS));
+    test_record(TEST_A_ID);
+    return !fail_a;
+}
+
+static bool test_init_b(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(TEST_INIT_MS));
+    test_record(TEST_B_ID);
+    return true;
+}
+
+static bool test_init_c(void)
+{
+    test_record(TEST_C_ID);
+    return true;
+}
+
+static bool test_init_lazy(void)
+{
+    test_record(TEST_LAZY_ID);
+    return true;
+}
+
+/* A and B are independent and overlap, C waits for A */
+static const INIT_GRAPH_Module_t test_table[TEST_MAX_ID] = {
+    [TEST_RAILS_ID] = {"rails", test_init_rails, INIT_GRAPH_MODE_CRITICAL, 0},
+    [TEST_A_ID] = {"a", test_init_a, INIT_GRAPH_MODE_PARALLEL, 0},
+    [TEST_B_ID] = {"b", test_init_b, INIT_GRAPH_MODE_PARALLEL, 0},
+    [TEST_C_ID] = {"c", test_init_c, INIT_GRAPH_MODE_PARALLEL, INIT_GRAPH_DEP(TEST_A_ID)},
+    [TEST_LAZY_ID] = {"lazy", test_init_lazy, INIT_GRAPH_MODE_LAZY, INIT_GRAPH_DEP(TEST_B_ID)},
+};
+
+static void test_start(const INIT_GRAPH_Module_t *pModules, uint8_t count, INIT_GRAPH_Ret_t expected)
+{
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_InitModule());
+    TEST_ASSERT_EQUAL(expected, INIT_GRAPH_Start(pModules, count, TEST_WORKERS));
+    /* The workers may already be running, only the critical module was initialized before */
+    xSemaphoreTake(record_mutex, portMAX_DELAY);
+    rails_ready_on_start = (init_count >= 1 && init_order[0] == TEST_RAILS_ID);
+    xSemaphoreGive(record_mutex);
+}
+
+TEST_GROUP(init_graph);
+
+TEST_SETUP(init_graph)
+{
+    memset(init_order, 0, sizeof(init_order));
+    init_count = 0;
+    fail_a = false;
+    if (record_mutex == NULL) {
+        record_mutex = xSemaphoreCreateMutex();
+    }
+}
+
+TEST_TEAR_DOWN(init_graph)
+{
+    /* Let the workers of the test delete themselves before the next graph */
+    INIT_GRAPH_Wait(TEST_WAIT);
+    vTaskDelay(pdMS_TO_TICKS(10));
+}
+
+TEST(init_graph, test_critical_first)
+{
+    test_start(test_table, TEST_MAX_ID, INIT_GRAPH_STATUS_SUCCESS);
+    TEST_ASSERT_TRUE(rails_ready_on_start);
+
+    INIT_GRAPH_Stats_t stats;
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_RAILS_ID, &stats));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATE_READY, stats.state);
+    TEST_ASSERT_EQUAL_STRING("rails", stats.pName);
+}
+
+TEST(init_graph, test_dependency_order)
+{
+    test_start(test_table, TEST_MAX_ID, INIT_GRAPH_STATUS_SUCCESS);
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_Wait(TEST_WAIT));
+
+    TEST_ASSERT_LESS_THAN(test_position(TEST_C_ID), test_position(TEST_A_ID));
+    TEST_ASSERT_LESS_THAN(TEST_MAX_ID, test_position(TEST_B_ID));
+}
+
+TEST(init_graph, test_parallel_overlap)
+{
+    test_start(test_table, TEST_MAX_ID, INIT_GRAPH_STATUS_SUCCESS);
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_Wait(TEST_WAIT));
+
+    INIT_GRAPH_Stats_t a, b;
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_A_ID, &a));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_B_ID, &b));
+
+    /* Each init takes TEST_INIT_MS, B starts while A is still running */
+    TEST_ASSERT_GREATER_OR_EQUAL(TEST_INIT_MS * 1000, a.duration_us);
+    TEST_ASSERT_GREATER_OR_EQUAL(TEST_INIT_MS * 1000, b.duration_us);
+    int64_t later = (a.start_us > b.start_us) ? a.start_us : b.start_us;
+    int64_t earlier = (a.start_us > b.start_us) ? b.start_us : a.start_us;
+    TEST_ASSERT_LESS_THAN(TEST_INIT_MS * 1000, later - earlier);
+}
+
+TEST(init_graph, test_lazy_on_require)
+{
+    test_start(test_table, TEST_MAX_ID, INIT_GRAPH_STATUS_SUCCESS);
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_Wait(TEST_WAIT));
+
+    INIT_GRAPH_Stats_t stats;
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_LAZY_ID, &stats));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATE_PENDING, stats.state);
+    TEST_ASSERT_EQUAL(TEST_MAX_ID, test_position(TEST_LAZY_ID));
+
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_Require(TEST_LAZY_ID));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_LAZY_ID, &stats));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATE_READY, stats.state);
+
+    /* Required again, initialized once */
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_Require(TEST_LAZY_ID));
+    TEST_ASSERT_EQUAL(TEST_MAX_ID, init_count);
+}
+
+TEST(init_graph, test_failed_dependency)
+{
+    fail_a = true;
+    test_start(test_table, TEST_MAX_ID, INIT_GRAPH_STATUS_SUCCESS);
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_FAIL, INIT_GRAPH_Wait(TEST_WAIT));
+
+    INIT_GRAPH_Stats_t stats;
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_A_ID, &stats));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATE_FAILED, stats.state);
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_C_ID, &stats));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATE_FAILED, stats.state);
+    TEST_ASSERT_EQUAL(TEST_MAX_ID, test_position(TEST_C_ID));
+
+    /* B does not depend on A */
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATUS_SUCCESS, INIT_GRAPH_GetStats(TEST_B_ID, &stats));
+    TEST_ASSERT_EQUAL(INIT_GRAPH_STATE_READY, stats.state);
+}
+
+TEST(init_graph, test_invalid_table)
+{
+    const INIT_GRAPH_Module_t cycle[] = {
+        {"x", test_init_a, INIT_GRAPH_MODE_PARALLEL, INIT_GRAPH_DEP(1)},
+        {"y", test_init_b, INIT_GRAPH_MODE_PARALLEL, INIT_GRAPH_DEP(0)},
+    };
+    test_start(cycle, 2, INIT_GRAPH_STATUS_FAIL);
+
+    const INIT_GRAPH_Module_t critical[] = {
+        {"x", test_init_a, INIT_GRAPH_MODE_PARALLEL, 0},
+        {"y", test_init_rails, INIT_GRAPH_MODE_CRITICAL, INIT_GRAPH_DEP(0)},
+    };
+    test_start(critical, 2, INIT_GRAPH_STATUS_FAIL);
+
+    const INIT_GRAPH_Module_t missing[] = {
+        {"x", test_init_a, INIT_GRAPH_MODE_PARALLEL, INIT_GRAPH_DEP(5)},
+    };
+    test_start(missing, 1, INIT_GRAPH_STATUS_FAIL);
+
+    TEST_ASSERT_EQUAL(0, init_count);
+}
+
+TEST_GROUP_RUNNER(init_graph)
+{
+    RUN_TEST_CASE(init_graph, test_critical_first);
+    RUN_TEST_CASE(init_graph, test_dependency_order);
+    RUN_TEST_CASE(init_graph, test_parallel_overlap);
+    RUN_TEST_CASE(init_graph, test_lazy_on_require);
+    RUN_TEST_CASE(init_graph, test_failed_dependency);
+    RUN_TEST_CASE(init_graph, test_invalid_table);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(init_graph);
+}
+
+void app_main(void)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+}
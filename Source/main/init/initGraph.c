@@ -0,0 +1,542 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "initGraph.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#ifdef CONFIG_INIT_GRAPH_WORKER_STACK_SIZE
+#define INIT_GRAPH_WORKER_STACK         (CONFIG_INIT_GRAPH_WORKER_STACK_SIZE)
+#else
+#define INIT_GRAPH_WORKER_STACK         (3072)
+#endif
+//Below the main task, above app_main
+#define INIT_GRAPH_WORKER_PRIORITY      (3)
+
+//Set once every worker task is gone
+#define INIT_GRAPH_DONE_BIT             (1UL << INIT_GRAPH_MAX_MODULES)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define INIT_GRAPH_IS_FINISHED(state)   ((state) == INIT_GRAPH_STATE_READY || (state) == INIT_GRAPH_STATE_FAILED)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static bool INIT_GRAPH_IsValid(const INIT_GRAPH_Module_t *pModules, uint8_t count);
+static void INIT_GRAPH_Finish(uint8_t id, INIT_GRAPH_State_t state);
+static INIT_GRAPH_State_t INIT_GRAPH_Process(uint8_t id);
+static bool INIT_GRAPH_NextParallel(uint8_t *pId);
+static void tInitWorkerTask(void *pvParameters);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const INIT_GRAPH_Module_t *module_table = NULL;
+static uint8_t module_count = 0;
+static INIT_GRAPH_Stats_t module_stats[INIT_GRAPH_MAX_MODULES];
+
+static uint8_t active_workers = 0;
+
+static SemaphoreHandle_t init_graph_mutex_handle = NULL;
+static EventGroupHandle_t init_graph_event_handle = NULL;
+
+static const char * TAG = "INIT_GRAPH";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Init graph table check
+*
+*   This function is used to check the dependencies of a module table:
+*   existing modules only, no cycle, and critical modules only depending on
+*   critical modules. Modules are peeled off in dependency order, a table
+*   with a cycle leaves some behind.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pModules            Module table
+*   \param[in]  count               Number of modules
+*
+*   \return     true if the table is valid
+*
+*******************************************************************************/
+static bool INIT_GRAPH_IsValid(const INIT_GRAPH_Module_t *pModules, uint8_t count){
+
+    uint32_t all = INIT_GRAPH_DEP(count) - 1;
+    uint32_t critical = 0;
+
+    for(uint8_t i=0; i<count; i++){
+        if(pModules[i].init == NULL || (pModules[i].dependencies & ~all) || (pModules[i].dependencies & INIT_GRAPH_DEP(i))){
+            ESP_LOGE(TAG, "Invalid module %u", i);
+            return false;
+        }
+        if(pModules[i].mode == INIT_GRAPH_MODE_CRITICAL){
+            critical |= INIT_GRAPH_DEP(i);
+        }
+    }
+
+    for(uint8_t i=0; i<count; i++){
+        if(pModules[i].mode == INIT_GRAPH_MODE_CRITICAL && (pModules[i].dependencies & ~critical)){
+            ESP_LOGE(TAG, "Critical module %s depends on a non critical module", pModules[i].pName);
+            return false;
+        }
+    }
+
+    uint32_t done = 0;
+    bool progress = true;
+    while(done != all && progress){
+        progress = false;
+        for(uint8_t i=0; i<count; i++){
+            if(!(done & INIT_GRAPH_DEP(i)) && (pModules[i].dependencies & ~done) == 0){
+                done |= INIT_GRAPH_DEP(i);
+                progress = true;
+            }
+        }
+    }
+    if(done != all){
+        ESP_LOGE(TAG, "Dependency cycle in the module table");
+        return false;
+    }
+
+    return true;
+}
+
+/***************************************************************************//*!
+*  \brief Init graph finish
+*
+*   This function is used to store the final state of a module and wake up
+*   the tasks waiting for it.
+*
+*   Preconditions: Mutex taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  id                  Module id
+*   \param[in]  state               Ready or failed
+*
+*******************************************************************************/
+static void INIT_GRAPH_Finish(uint8_t id, INIT_GRAPH_State_t state){
+
+    module_stats[id].state = state;
+    xEventGroupSetBits(init_graph_event_handle, INIT_GRAPH_DEP(id));
+}
+
+/***************************************************************************//*!
+*  \brief Init graph process
+*
+*   This function is used to bring a module to a final state. Dependencies
+*   are processed first, then a pending module is initialized in the calling
+*   task, or a module initialized by another task is waited for. There is
+*   no cycle, this never waits on itself.
+*
+*   Preconditions: Module table set.
+*
+*   Side Effects: None.
+*
+*   \param[in]  id                  Module id
+*
+*   \return     final state of the module
+*
+*******************************************************************************/
+static INIT_GRAPH_State_t INIT_GRAPH_Process(uint8_t id){
+
+    bool deps_ready = true;
+    for(uint8_t i=0; i<module_count; i++){
+        if((module_table[id].dependencies & INIT_GRAPH_DEP(i)) && INIT_GRAPH_Process(i) != INIT_GRAPH_STATE_READY){
+            deps_ready = false;
+        }
+    }
+
+    xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+    INIT_GRAPH_State_t state = module_stats[id].state;
+
+    if(state == INIT_GRAPH_STATE_PENDING && !deps_ready){
+        ESP_LOGW(TAG, "%s skipped, a dependency failed", module_table[id].pName);
+        INIT_GRAPH_Finish(id, INIT_GRAPH_STATE_FAILED);
+        state = INIT_GRAPH_STATE_FAILED;
+    }
+    else if(state == INIT_GRAPH_STATE_PENDING){
+        module_stats[id].state = INIT_GRAPH_STATE_RUNNING;
+        module_stats[id].start_us = esp_timer_get_time();
+        xSemaphoreGive(init_graph_mutex_handle);
+
+        bool ok = module_table[id].init();
+        int64_t end_us = esp_timer_get_time();
+
+        xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+        module_stats[id].duration_us = (uint32_t)(end_us - module_stats[id].start_us);
+        state = ok ? INIT_GRAPH_STATE_READY : INIT_GRAPH_STATE_FAILED;
+        INIT_GRAPH_Finish(id, state);
+        if(!ok){
+            ESP_LOGE(TAG, "%s failed", module_table[id].pName);
+        }
+    }
+    else if(state == INIT_GRAPH_STATE_RUNNING){
+        xSemaphoreGive(init_graph_mutex_handle);
+        xEventGroupWaitBits(init_graph_event_handle, INIT_GRAPH_DEP(id), pdFALSE, pdTRUE, portMAX_DELAY);
+        xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+        state = module_stats[id].state;
+    }
+    xSemaphoreGive(init_graph_mutex_handle);
+
+    return state;
+}
+
+/***************************************************************************//*!
+*  \brief Init graph next parallel module
+*
+*   This function is used by the workers to pick the next pending parallel
+*   module, preferably one whose dependencies are all finished so that it
+*   does not wait on another worker.
+*
+*   Preconditions: Mutex taken.
+*
+*   Side Effects: None.
+*
+*   \param[out] pId                 Pointer to store the module id
+*
+*   \return     false when no parallel module is pending
+*
+*******************************************************************************/
+static bool INIT_GRAPH_NextParallel(uint8_t *pId){
+
+    bool found = false;
+
+    for(uint8_t i=0; i<module_count; i++){
+        if(module_table[i].mode != INIT_GRAPH_MODE_PARALLEL || module_stats[i].state != INIT_GRAPH_STATE_PENDING){
+            continue;
+        }
+
+        bool deps_finished = true;
+        for(uint8_t d=0; d<module_count; d++){
+            if((module_table[i].dependencies & INIT_GRAPH_DEP(d)) && !INIT_GRAPH_IS_FINISHED(module_stats[d].state)){
+                deps_finished = false;
+            }
+        }
+
+        if(deps_finished){
+            *pId = i;
+            return true;
+        }
+        if(!found){
+            *pId = i;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+static void tInitWorkerTask(void *pvParameters){
+
+    uint8_t id;
+
+    for(;;){
+        xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+        bool found = INIT_GRAPH_NextParallel(&id);
+        if(!found){
+            if(--active_workers == 0){
+                xEventGroupSetBits(init_graph_event_handle, INIT_GRAPH_DONE_BIT);
+            }
+            xSemaphoreGive(init_graph_mutex_handle);
+            break;
+        }
+        xSemaphoreGive(init_graph_mutex_handle);
+
+        INIT_GRAPH_Process(id);
+    }
+    vTaskDelete(NULL);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Init graph initialization
+*
+*   This function is used to initialize the init graph module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_InitModule(void){
+
+    //Worker tasks of a previous graph still use the mutex and event group
+    if(active_workers != 0){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+
+    //Create mutex and event group
+    if(init_graph_mutex_handle == NULL){
+        init_graph_mutex_handle = xSemaphoreCreateMutex();
+        if(init_graph_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Init Graph mutex");
+            return INIT_GRAPH_STATUS_FAIL;
+        }
+    }
+    if(init_graph_event_handle == NULL){
+        init_graph_event_handle = xEventGroupCreate();
+        if(init_graph_event_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Init Graph event group");
+            return INIT_GRAPH_STATUS_FAIL;
+        }
+    }
+
+    xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+    module_table = NULL;
+    module_count = 0;
+    memset(module_stats, 0, sizeof(module_stats));
+    xEventGroupClearBits(init_graph_event_handle, INIT_GRAPH_DONE_BIT | (INIT_GRAPH_DONE_BIT - 1));
+    xSemaphoreGive(init_graph_mutex_handle);
+
+    return INIT_GRAPH_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Init graph start
+*
+*   This function is used to initialize the application modules. The
+*   critical modules are initialized first, in the calling task, so they are
+*   ready when this function returns. The parallel modules are then
+*   initialized by worker tasks, each module as soon as its dependencies are
+*   ready. Lazy modules wait for INIT_GRAPH_Require or a dependent module.
+*
+*   A module whose dependency failed is not initialized and is marked as
+*   failed too.
+*
+*   Preconditions: INIT_GRAPH_InitModule called. The table stays valid, has
+*                  no dependency cycle and critical modules only depend on
+*                  critical modules.
+*
+*   Side Effects: Creates the worker tasks, they delete themselves once no
+*                 parallel module is left.
+*
+*   \param[in]  pModules            Module table, indexed by module id
+*   \param[in]  count               Number of modules
+*   \param[in]  workers             Number of worker tasks
+*
+*   \return     operation status, fail if a critical module failed
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_Start(const INIT_GRAPH_Module_t *pModules, uint8_t count, uint8_t workers){
+
+    if(init_graph_mutex_handle == NULL || module_table != NULL || pModules == NULL ||
+       count == 0 || count > INIT_GRAPH_MAX_MODULES || workers > INIT_GRAPH_MAX_WORKERS){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+    if(!INIT_GRAPH_IsValid(pModules, count)){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+    module_table = pModules;
+    module_count = count;
+    for(uint8_t i=0; i<count; i++){
+        module_stats[i].pName = pModules[i].pName;
+        module_stats[i].state = INIT_GRAPH_STATE_PENDING;
+    }
+    xSemaphoreGive(init_graph_mutex_handle);
+
+    //Critical modules only depend on critical modules, nothing else runs yet
+    INIT_GRAPH_Ret_t ret = INIT_GRAPH_STATUS_SUCCESS;
+    for(uint8_t i=0; i<count; i++){
+        if(pModules[i].mode == INIT_GRAPH_MODE_CRITICAL && INIT_GRAPH_Process(i) != INIT_GRAPH_STATE_READY){
+            ret = INIT_GRAPH_STATUS_FAIL;
+        }
+    }
+
+    xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+    for(uint8_t i=0; i<workers; i++){
+        if(pdTRUE != xTaskCreate(tInitWorkerTask,
+                                 "Init worker",
+                                 INIT_GRAPH_WORKER_STACK,
+                                 NULL,
+                                 INIT_GRAPH_WORKER_PRIORITY,
+                                 NULL)){
+            ESP_LOGE(TAG, "Failed to create init worker");
+            break;
+        }
+        active_workers++;
+    }
+    if(active_workers == 0){
+        //Parallel modules are left to INIT_GRAPH_Require
+        xEventGroupSetBits(init_graph_event_handle, INIT_GRAPH_DONE_BIT);
+    }
+    xSemaphoreGive(init_graph_mutex_handle);
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Init graph require
+*
+*   This function is used before the first use of a module. A pending
+*   module is initialized in the calling task, after its dependencies, a
+*   module being initialized by another task is waited for.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  id                  Module id
+*
+*   \return     operation status, success once the module is ready
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_Require(uint8_t id){
+
+    if(module_table == NULL || id >= module_count){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+
+    return (INIT_GRAPH_Process(id) == INIT_GRAPH_STATE_READY) ? INIT_GRAPH_STATUS_SUCCESS : INIT_GRAPH_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Init graph wait
+*
+*   This function is used to wait for every parallel module to be
+*   initialized.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  timeout             Ticks to wait
+*
+*   \return     operation status, fail on timeout or if a module failed
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_Wait(TickType_t timeout){
+
+    if(module_table == NULL){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+
+    EventBits_t wait_bits = INIT_GRAPH_DONE_BIT;
+    for(uint8_t i=0; i<module_count; i++){
+        if(module_table[i].mode == INIT_GRAPH_MODE_PARALLEL){
+            wait_bits |= INIT_GRAPH_DEP(i);
+        }
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(init_graph_event_handle, wait_bits, pdFALSE, pdTRUE, timeout);
+    if((bits & wait_bits) != wait_bits){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+
+    INIT_GRAPH_Ret_t ret = INIT_GRAPH_STATUS_SUCCESS;
+    xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+    for(uint8_t i=0; i<module_count; i++){
+        if(module_table[i].mode == INIT_GRAPH_MODE_PARALLEL && module_stats[i].state != INIT_GRAPH_STATE_READY){
+            ret = INIT_GRAPH_STATUS_FAIL;
+        }
+    }
+    xSemaphoreGive(init_graph_mutex_handle);
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Init graph stats
+*
+*   This function is used to read the state and init duration of a module.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  id                  Module id
+*   \param[out] pStats              Pointer to store the stats
+*
+*   \return     operation status
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_GetStats(uint8_t id, INIT_GRAPH_Stats_t *pStats){
+
+    if(module_table == NULL || id >= module_count || pStats == NULL){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(init_graph_mutex_handle, portMAX_DELAY);
+    *pStats = module_stats[id];
+    xSemaphoreGive(init_graph_mutex_handle);
+
+    return INIT_GRAPH_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Init graph print
+*
+*   This function is used to log the state and init duration of every
+*   module.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_PrintReport(void){
+
+    static const char * const state_names[] = {"pending", "running", "ready", "failed"};
+    INIT_GRAPH_Stats_t stats;
+
+    if(module_table == NULL){
+        return INIT_GRAPH_STATUS_FAIL;
+    }
+
+    for(uint8_t i=0; i<module_count; i++){
+        INIT_GRAPH_GetStats(i, &stats);
+        ESP_LOGI(TAG, "  %-16s %-8s start %8lld us  took %8lu us",
+                 stats.pName,
+                 state_names[stats.state],
+                 (long long)stats.start_us,
+                 (unsigned long)stats.duration_us);
+    }
+
+    return INIT_GRAPH_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
@@ -0,0 +1,184 @@
+#ifndef _INIT_GRAPH_H
+#define _INIT_GRAPH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+//One event group bit per module, plus the completion bit
+#define INIT_GRAPH_MAX_MODULES              (16)
+#define INIT_GRAPH_MAX_WORKERS              (4)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+//Dependency mask entry, modules are identified by their index in the table
+#define INIT_GRAPH_DEP(id)                  (1UL << (id))
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum INIT_GRAPH_Mode_e{
+    INIT_GRAPH_MODE_CRITICAL,               //Initialized by INIT_GRAPH_Start, before any other module
+    INIT_GRAPH_MODE_PARALLEL,               //Initialized on a worker task once its dependencies are ready
+    INIT_GRAPH_MODE_LAZY,                   //Initialized on first INIT_GRAPH_Require, or by a dependent module
+}INIT_GRAPH_Mode_t;
+
+typedef enum INIT_GRAPH_State_e{
+    INIT_GRAPH_STATE_PENDING,
+    INIT_GRAPH_STATE_RUNNING,
+    INIT_GRAPH_STATE_READY,
+    INIT_GRAPH_STATE_FAILED,                //Init failed, or one of its dependencies did
+}INIT_GRAPH_State_t;
+
+//Module init, returns true once the module is ready
+typedef bool (*INIT_GRAPH_InitFn_t)(void);
+
+typedef struct INIT_GRAPH_Module_s{
+    const char *pName;
+    INIT_GRAPH_InitFn_t init;
+    INIT_GRAPH_Mode_t mode;
+    uint32_t dependencies;                  //INIT_GRAPH_DEP of the modules initialized first
+}INIT_GRAPH_Module_t;
+
+typedef struct INIT_GRAPH_Stats_s{
+    const char *pName;
+    INIT_GRAPH_State_t state;
+    int64_t start_us;                       //App timer when the init started
+    uint32_t duration_us;                   //Time spent in the init function
+}INIT_GRAPH_Stats_t;
+
+typedef enum INIT_GRAPH_Ret_e{
+    INIT_GRAPH_STATUS_FAIL,
+    INIT_GRAPH_STATUS_SUCCESS,
+}INIT_GRAPH_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if (INIT_GRAPH_MAX_MODULES > 23)
+#error "Init graph modules do not fit in an event group"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Init graph initialization
+*
+*   This function is used to initialize the init graph module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Init graph start
+*
+*   This function is used to initialize the application modules. The
+*   critical modules are initialized first, in the calling task, so they are
+*   ready when this function returns. The parallel modules are then
+*   initialized by worker tasks, each module as soon as its dependencies are
+*   ready. Lazy modules wait for INIT_GRAPH_Require or a dependent module.
+*
+*   A module whose dependency failed is not initialized and is marked as
+*   failed too.
+*
+*   Preconditions: INIT_GRAPH_InitModule called. The table stays valid, has
+*                  no dependency cycle and critical modules only depend on
+*                  critical modules.
+*
+*   Side Effects: Creates the worker tasks, they delete themselves once no
+*                 parallel module is left.
+*
+*   \param[in]  pModules            Module table, indexed by module id
+*   \param[in]  count               Number of modules
+*   \param[in]  workers             Number of worker tasks
+*
+*   \return     operation status, fail if a critical module failed
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_Start(const INIT_GRAPH_Module_t *pModules, uint8_t count, uint8_t workers);
+
+/***************************************************************************//*!
+*  \brief Init graph require
+*
+*   This function is used before the first use of a module. A pending
+*   module is initialized in the calling task, after its dependencies, a
+*   module being initialized by another task is waited for.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  id                  Module id
+*
+*   \return     operation status, success once the module is ready
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_Require(uint8_t id);
+
+/***************************************************************************//*!
+*  \brief Init graph wait
+*
+*   This function is used to wait for every parallel module to be
+*   initialized.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  timeout             Ticks to wait
+*
+*   \return     operation status, fail on timeout or if a module failed
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_Wait(TickType_t timeout);
+
+/***************************************************************************//*!
+*  \brief Init graph stats
+*
+*   This function is used to read the state and init duration of a module.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  id                  Module id
+*   \param[out] pStats              Pointer to store the stats
+*
+*   \return     operation status
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_GetStats(uint8_t id, INIT_GRAPH_Stats_t *pStats);
+
+/***************************************************************************//*!
+*  \brief Init graph print
+*
+*   This function is used to log the state and init duration of every
+*   module.
+*
+*   Preconditions: INIT_GRAPH_Start called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+INIT_GRAPH_Ret_t INIT_GRAPH_PrintReport(void);
+
+#endif//_INIT_GRAPH_H
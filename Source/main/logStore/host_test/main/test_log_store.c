@@ -0,0 +1,381 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Linux host log store test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "wear_levelling.h"
+#include "ff.h"
+#include "diskio_impl.h"
+#include "diskio_wl.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "logStore.h"
+
+#define TEST_FILE_SIZE      (8192)      //CONFIG_LOG_STORE_FILE_SIZE
+#define TEST_MAX_FILES      (3)         //CONFIG_LOG_STORE_MAX_FILES
+#define TEST_RECORD_SIZE    (256)
+#define TEST_PAYLOAD_SIZE   (TEST_RECORD_SIZE - sizeof(LOG_STORE_Record_Header_t))
+#define TEST_WAIT           (pdMS_TO_TICKS(2000))
+#define TEST_PREVIOUS_TEXT  "previous boot"
+//Boot and text records left in a partial batch by the previous boot
+#define TEST_PREVIOUS_SIZE  (2 * sizeof(LOG_STORE_Record_Header_t) + 1 + strlen(TEST_PREVIOUS_TEXT))
+
+static bool initialized;
+static uint8_t file_data[TEST_FILE_SIZE];
+static uint8_t pack_data[TEST_FILE_SIZE + sizeof(LOG_STORE_Pack_Header_t)];
+
+/* The app timer is headers only on linux, read the host clock instead */
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Leaves the first file partly written, as a reset after a flush does. Formatted as the log store does */
+static void test_previous_boot(void)
+{
+    const esp_partition_t *pPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, LOG_STORE_PARTITION_LABEL);
+    TEST_ASSERT_NOT_NULL(pPartition);
+
+    wl_handle_t wl_handle;
+    BYTE drive_num;
+    TEST_ASSERT_EQUAL(ESP_OK, wl_mount(pPartition, &wl_handle));
+    TEST_ASSERT_EQUAL(ESP_OK, ff_diskio_get_drive(&drive_num));
+    TEST_ASSERT_EQUAL(ESP_OK, ff_diskio_register_wl_partition(drive_num, wl_handle));
+
+    FATFS fs;
+    char drive[3] = {'0' + drive_num, ':', '\0'};
+    const MKFS_PARM opt = {(BYTE)(FM_ANY | FM_SFD), 1, LOG_STORE_BATCH_SIZE / CONFIG_WL_SECTOR_SIZE, 0, LOG_STORE_BATCH_SIZE};
+    TEST_ASSERT_EQUAL(FR_OK, f_mkfs(drive, &opt, file_data, sizeof(file_data)));
+    TEST_ASSERT_EQUAL(FR_OK, f_mount(&fs, drive, 1));
+
+    uint8_t reason = 1;
+    LOG_STORE_Record_Header_t boot = {.type = LOG_STORE_TYPE_BOOT, .length = 1, .sequence = 0};
+    LOG_STORE_Record_Header_t text = {.type = LOG_STORE_TYPE_TEXT, .length = strlen(TEST_PREVIOUS_TEXT), .sequence = 1};
+    size_t length = 0;
+    memcpy(&file_data[length], &boot, sizeof(boot));
+    length += sizeof(boot);
+    file_data[length++] = reason;
+    memcpy(&file_data[length], &text, sizeof(text));
+    length += sizeof(text);
+    memcpy(&file_data[length], TEST_PREVIOUS_TEXT, strlen(TEST_PREVIOUS_TEXT));
+    length += strlen(TEST_PREVIOUS_TEXT);
+    TEST_ASSERT_EQUAL(TEST_PREVIOUS_SIZE, length);
+
+    char path[LOG_STORE_PATH_SIZE];
+    FIL file;
+    UINT count = 0;
+    snprintf(path, sizeof(path), "%c:/L0000001.LOG", '0' + drive_num);
+    TEST_ASSERT_EQUAL(FR_OK, f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE));
+    TEST_ASSERT_EQUAL(FR_OK, f_write(&file, file_data, length, &count));
+    TEST_ASSERT_EQUAL(length, count);
+    TEST_ASSERT_EQUAL(FR_OK, f_close(&file));
+
+    TEST_ASSERT_EQUAL(FR_OK, f_mount(NULL, drive, 0));
+    ff_diskio_unregister(drive_num);
+    TEST_ASSERT_EQUAL(ESP_OK, wl_unmount(wl_handle));
+}
+
+/* Appends records of TEST_RECORD_SIZE bytes, the last one takes the rest */
+static void test_fill(size_t size)
+{
+    uint8_t payload[TEST_PAYLOAD_SIZE];
+    memset(payload, 0xA5, sizeof(payload));
+
+    while (size > 0) {
+        size_t record = (size > TEST_RECORD_SIZE) ? TEST_RECORD_SIZE : size;
+        TEST_ASSERT_GREATER_OR_EQUAL(sizeof(LOG_STORE_Record_Header_t), record);
+        TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_Append(LOG_STORE_TYPE_APP, payload, record - sizeof(LOG_STORE_Record_Header_t)));
+        size -= record;
+    }
+}
+
+/* Waits for the writer task to reach the counters */
+static LOG_STORE_Stats_t test_wait(uint32_t batches_written, uint32_t files_packed)
+{
+    LOG_STORE_Stats_t stats;
+    TickType_t start = xTaskGetTickCount();
+
+    do {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&stats));
+    } while ((stats.batches_written < batches_written || stats.files_packed < files_packed) &&
+             (xTaskGetTickCount() - start) < TEST_WAIT);
+
+    TEST_ASSERT_EQUAL(batches_written, stats.batches_written);
+    TEST_ASSERT_EQUAL(files_packed, stats.files_packed);
+    return stats;
+}
+
+static size_t test_read(uint32_t index, uint8_t *pData, size_t size, bool *pPacked)
+{
+    char path[LOG_STORE_PATH_SIZE];
+    FIL file;
+    UINT count = 0;
+
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetFilePath(index, path, pPacked));
+    TEST_ASSERT_EQUAL(FR_OK, f_open(&file, path, FA_READ));
+    TEST_ASSERT_EQUAL(FR_OK, f_read(&file, pData, size, &count));
+    f_close(&file);
+    return count;
+}
+
+/* Heatshrink LZSS decoder, as tools/log_store.py */
+static size_t test_unpack(const uint8_t *pData, size_t size, uint8_t *pOut, size_t out_size)
+{
+    LOG_STORE_Pack_Header_t header;
+    memcpy(&header, pData, sizeof(header));
+    TEST_ASSERT_EQUAL_HEX32(LOG_STORE_PACK_MAGIC, header.magic);
+    TEST_ASSERT_LESS_OR_EQUAL(out_size, header.size);
+
+    size_t bit = sizeof(header) * 8;
+    size_t length = 0;
+
+    while (length < header.size) {
+        uint16_t fields[3] = {0};
+        uint8_t widths[3] = {1, 8, 0};
+
+        for (uint8_t f = 0; f < 3; f++) {
+            if (f == 1 && fields[0] == 0) {
+                widths[1] = header.window_bits;
+                widths[2] = header.lookahead_bits;
+            }
+            for (uint8_t i = 0; i < widths[f]; i++, bit++) {
+                TEST_ASSERT_LESS_THAN(size * 8, bit);
+                fields[f] = (fields[f] << 1) | ((pData[bit / 8] >> (7 - bit % 8)) & 1);
+            }
+        }
+
+        if (fields[0] == 1) {
+            pOut[length++] = fields[1];
+            continue;
+        }
+        TEST_ASSERT_LESS_OR_EQUAL(length, fields[1] + 1);
+        for (uint16_t i = 0; i <= fields[2] && length < header.size; i++, length++) {
+            pOut[length] = pOut[length - fields[1] - 1];
+        }
+    }
+
+    return length;
+}
+
+TEST_GROUP(log_store);
+
+TEST_SETUP(log_store)
+{
+    if (!initialized) {
+        test_previous_boot();
+        TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_InitModule());
+        initialized = true;
+    }
+}
+
+TEST_TEAR_DOWN(log_store)
+{
+}
+
+TEST(log_store, test_batch_write)
+{
+    /* The file of the previous boot is resumed, not rotated */
+    LOG_STORE_Stats_t stats;
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(1, stats.first_file);
+    TEST_ASSERT_EQUAL(1, stats.current_file);
+
+    /* Nothing reaches the flash before the batch is full */
+    test_fill(LOG_STORE_BATCH_SIZE - TEST_RECORD_SIZE - TEST_PREVIOUS_SIZE);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(0, stats.syncs);
+
+    /* One write and one sync per batch */
+    test_fill(TEST_RECORD_SIZE);
+    stats = test_wait(1, 0);
+    TEST_ASSERT_EQUAL(1, stats.syncs);
+    TEST_ASSERT_EQUAL(LOG_STORE_BATCH_SIZE / TEST_RECORD_SIZE, stats.records_appended);
+    TEST_ASSERT_EQUAL(0, stats.write_errors);
+    TEST_ASSERT_EQUAL(LOG_STORE_BATCH_SIZE, test_read(1, file_data, sizeof(file_data), NULL));
+
+    /* The records of the previous boot are kept in front of the new ones */
+    LOG_STORE_Record_Header_t header;
+    memcpy(&header, &file_data[TEST_PREVIOUS_SIZE - sizeof(header) - strlen(TEST_PREVIOUS_TEXT)], sizeof(header));
+    TEST_ASSERT_EQUAL(LOG_STORE_TYPE_TEXT, header.type);
+    TEST_ASSERT_EQUAL_MEMORY(TEST_PREVIOUS_TEXT, &file_data[TEST_PREVIOUS_SIZE - strlen(TEST_PREVIOUS_TEXT)], strlen(TEST_PREVIOUS_TEXT));
+    memcpy(&header, &file_data[TEST_PREVIOUS_SIZE], sizeof(header));
+    TEST_ASSERT_EQUAL(LOG_STORE_TYPE_APP, header.type);
+    TEST_ASSERT_EQUAL(0, header.sequence);
+}
+
+TEST(log_store, test_flush_partial)
+{
+    const char *pText[] = {"first", "second", "third"};
+    size_t length = 0;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_Append(LOG_STORE_TYPE_TEXT, pText[i], strlen(pText[i])));
+        length += sizeof(LOG_STORE_Record_Header_t) + strlen(pText[i]);
+    }
+
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_Flush(TEST_WAIT));
+    LOG_STORE_Stats_t stats = test_wait(1, 0);
+    TEST_ASSERT_EQUAL(2, stats.syncs);
+
+    /* The partial batch follows the first one */
+    bool packed = true;
+    TEST_ASSERT_EQUAL(LOG_STORE_BATCH_SIZE + length, test_read(1, file_data, sizeof(file_data), &packed));
+    TEST_ASSERT_FALSE(packed);
+
+    LOG_STORE_Record_Header_t header;
+    memcpy(&header, &file_data[LOG_STORE_BATCH_SIZE], sizeof(header));
+    TEST_ASSERT_EQUAL(LOG_STORE_TYPE_TEXT, header.type);
+    TEST_ASSERT_EQUAL(strlen(pText[0]), header.length);
+    TEST_ASSERT_EQUAL(LOG_STORE_BATCH_SIZE / TEST_RECORD_SIZE, header.sequence);
+    TEST_ASSERT_EQUAL_MEMORY(pText[0], &file_data[LOG_STORE_BATCH_SIZE + sizeof(header)], header.length);
+
+    /* Nothing new, no sync */
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_Flush(TEST_WAIT));
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&stats));
+    TEST_ASSERT_EQUAL(2, stats.syncs);
+
+    /* The full batch is written again at the same offset, the file is closed */
+    test_fill(LOG_STORE_BATCH_SIZE - length);
+    stats = test_wait(2, 1);
+    TEST_ASSERT_EQUAL(3, stats.syncs);
+    TEST_ASSERT_EQUAL(2, stats.current_file);
+}
+
+TEST(log_store, test_rotate_pack)
+{
+    bool packed = false;
+    size_t size = test_read(1, pack_data, sizeof(pack_data), &packed);
+    TEST_ASSERT_TRUE(packed);
+    TEST_ASSERT_LESS_THAN(TEST_FILE_SIZE / 2, size);
+
+    memset(file_data, 0, sizeof(file_data));
+    TEST_ASSERT_EQUAL(TEST_FILE_SIZE, test_unpack(pack_data, size, file_data, sizeof(file_data)));
+
+    /* Every record is back, in sequence after the previous boot ones */
+    LOG_STORE_Record_Header_t previous;
+    memcpy(&previous, file_data, sizeof(previous));
+    TEST_ASSERT_EQUAL(LOG_STORE_TYPE_BOOT, previous.type);
+    size_t pos = TEST_PREVIOUS_SIZE;
+    uint16_t sequence = 0;
+    uint8_t texts = 0;
+    while (pos < TEST_FILE_SIZE) {
+        LOG_STORE_Record_Header_t header;
+        memcpy(&header, &file_data[pos], sizeof(header));
+        TEST_ASSERT_EQUAL(sequence, header.sequence);
+        if (header.type == LOG_STORE_TYPE_TEXT) {
+            texts++;
+        } else {
+            TEST_ASSERT_EQUAL(LOG_STORE_TYPE_APP, header.type);
+            TEST_ASSERT_EACH_EQUAL_HEX8(0xA5, &file_data[pos + sizeof(header)], header.length);
+        }
+        pos += sizeof(header) + header.length;
+        sequence++;
+    }
+    TEST_ASSERT_EQUAL(TEST_FILE_SIZE, pos);
+    TEST_ASSERT_EQUAL(3, texts);
+}
+
+TEST(log_store, test_delete_oldest)
+{
+    char path[LOG_STORE_PATH_SIZE];
+
+    LOG_STORE_Stats_t stats;
+
+    /* Files 2 and 3 filled, 4 created, only the last TEST_MAX_FILES kept. One batch at a time, the
+     * compression of a file holds the writer task longer than filling two batches takes */
+    for (uint32_t batch = 3; batch <= 6; batch++) {
+        test_fill(LOG_STORE_BATCH_SIZE);
+        stats = test_wait(batch, batch / 2);
+    }
+    TEST_ASSERT_EQUAL(4, stats.current_file);
+    TEST_ASSERT_EQUAL(4 - TEST_MAX_FILES + 1, stats.first_file);
+    TEST_ASSERT_EQUAL(0, stats.records_dropped);
+    TEST_ASSERT_EQUAL(0, stats.write_errors);
+
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_FAIL, LOG_STORE_GetFilePath(1, path, NULL));
+    bool packed = false;
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetFilePath(2, path, &packed));
+    TEST_ASSERT_TRUE(packed);
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetFilePath(4, path, &packed));
+    TEST_ASSERT_FALSE(packed);
+}
+
+TEST(log_store, test_invalid_record)
+{
+    uint8_t payload[LOG_STORE_MAX_PAYLOAD + 1] = {0};
+    LOG_STORE_Stats_t before, after;
+
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&before));
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_FAIL, LOG_STORE_Append(LOG_STORE_TYPE_APP, payload, sizeof(payload)));
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_FAIL, LOG_STORE_Append(LOG_STORE_TYPE_APP, NULL, 1));
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_FAIL, LOG_STORE_InitModule());
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&after));
+    /* Only the warning of the second initialization is captured */
+    TEST_ASSERT_EQUAL(before.records_appended + 1, after.records_appended);
+}
+
+TEST(log_store, test_capture_log)
+{
+    LOG_STORE_Stats_t before, after;
+
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&before));
+    ESP_LOGI("TEST", "not captured");
+    ESP_LOGW("TEST", "captured %d", 42);
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_GetStats(&after));
+    TEST_ASSERT_EQUAL(before.records_appended + 1, after.records_appended);
+
+    /* The file holds the two captured warnings, the line is kept without its color and line end */
+    TEST_ASSERT_EQUAL(LOG_STORE_STATUS_SUCCESS, LOG_STORE_Flush(TEST_WAIT));
+    size_t size = test_read(after.current_file, file_data, sizeof(file_data), NULL);
+
+    const char *pText[2] = {"LOG_STORE: Already initialized", "TEST: captured 42"};
+    size_t pos = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+        LOG_STORE_Record_Header_t header;
+        TEST_ASSERT_LESS_OR_EQUAL(size, pos + sizeof(header));
+        memcpy(&header, &file_data[pos], sizeof(header));
+        pos += sizeof(header);
+        TEST_ASSERT_EQUAL(LOG_STORE_TYPE_TEXT, header.type);
+        TEST_ASSERT_GREATER_THAN(strlen(pText[i]), header.length);
+        TEST_ASSERT_EQUAL('W', file_data[pos]);
+        TEST_ASSERT_EQUAL_MEMORY(pText[i], &file_data[pos + header.length - strlen(pText[i])], strlen(pText[i]));
+        pos += header.length;
+    }
+    TEST_ASSERT_EQUAL(size, pos);
+}
+
+TEST_GROUP_RUNNER(log_store)
+{
+    RUN_TEST_CASE(log_store, test_batch_write);
+    RUN_TEST_CASE(log_store, test_flush_partial);
+    RUN_TEST_CASE(log_store, test_rotate_pack);
+    RUN_TEST_CASE(log_store, test_delete_oldest);
+    RUN_TEST_CASE(log_store, test_invalid_record);
+    RUN_TEST_CASE(log_store, test_capture_log);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(log_store);
+}
+
+void app_main(void)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+}
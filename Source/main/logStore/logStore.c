@@ -0,0 +1,1004 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "wear_levelling.h"
+#include "ff.h"
+#include "diskio_impl.h"
+#include "diskio_wl.h"
+
+#include "logStore.h"
+#include "stackMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define LOG_STORE_TASK_STACK            (CONFIG_LOG_STORE_TASK_STACK_SIZE)
+//Below the application tasks, the compression runs on this task
+#define LOG_STORE_TASK_PRIORITY         (2)
+
+#define LOG_STORE_FILE_SIZE             (CONFIG_LOG_STORE_FILE_SIZE)
+#define LOG_STORE_MAX_FILES             (CONFIG_LOG_STORE_MAX_FILES)
+#define LOG_STORE_FLUSH_PERIOD_MS       (CONFIG_LOG_STORE_FLUSH_PERIOD_MS)
+#if CONFIG_LOG_STORE_COMPRESS
+#define LOG_STORE_COMPRESS              (1)
+#else
+#define LOG_STORE_COMPRESS              (0)
+#endif
+#if CONFIG_LOG_STORE_CAPTURE_LOGS
+#define LOG_STORE_CAPTURE_LOGS          (1)
+#else
+#define LOG_STORE_CAPTURE_LOGS          (0)
+#endif
+
+#define LOG_STORE_PACK_WINDOW           (1 << LOG_STORE_PACK_WINDOW_BITS)
+#define LOG_STORE_PACK_LOOKAHEAD        (1 << LOG_STORE_PACK_LOOKAHEAD_BITS)
+//A back reference costs its tag bit, offset and count
+#define LOG_STORE_PACK_BACKREF_BITS     (1 + LOG_STORE_PACK_WINDOW_BITS + LOG_STORE_PACK_LOOKAHEAD_BITS)
+#define LOG_STORE_PACK_OUT_SIZE         (64)
+
+#if (LOG_STORE_FILE_SIZE % LOG_STORE_BATCH_SIZE) != 0
+#error "Log store file size must be a multiple of the batch size"
+#endif
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define LOG_STORE_BUFFER(index)         ((uint8_t *)log_buffers[index])
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+//LZSS encoder state, the window keeps the history in front of the bytes to encode
+typedef struct LOG_STORE_Packer_s{
+    uint8_t window[2 * LOG_STORE_PACK_WINDOW];
+    uint16_t length;                        //Bytes in the window
+    uint16_t pos;                           //Next byte to encode
+    uint8_t out[LOG_STORE_PACK_OUT_SIZE];
+    uint16_t out_length;                    //Complete bytes in out
+    uint8_t out_bits;                       //Bits used in the byte after them
+    bool error;
+}LOG_STORE_Packer_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static void tLogStoreTask(void *pvParameters);
+static void LOG_STORE_GetPath(uint32_t index, bool packed, char *pPath);
+static bool LOG_STORE_ParseName(const char *pName, uint32_t *pIndex, bool *pPacked);
+static bool LOG_STORE_Mount(void);
+static bool LOG_STORE_Scan(uint32_t *pResumeSize);
+static bool LOG_STORE_Resume(uint32_t size);
+static bool LOG_STORE_OpenCurrent(bool resume);
+static void LOG_STORE_DeleteOldest(void);
+static bool LOG_STORE_WriteBatch(const uint8_t *pData, uint16_t length);
+static void LOG_STORE_Rotate(void);
+static void LOG_STORE_PutBits(uint16_t value, uint8_t count);
+static void LOG_STORE_FlushBits(bool last);
+static void LOG_STORE_EncodeNext(void);
+static bool LOG_STORE_Pack(uint32_t index);
+static void LOG_STORE_PackClosedFiles(void);
+static void LOG_STORE_Process(bool flush);
+static void LOG_STORE_SwapBuffers(void);
+static void LOG_STORE_CaptureText(const char *pFormat, va_list args);
+static int LOG_STORE_CaptureLog(const char *pFormat, va_list args);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static wl_handle_t wl_handle = WL_INVALID_HANDLE;
+static BYTE log_drive = 0;
+static FATFS log_fs;
+static FIL log_file;                        //File being written, source of the compression
+static FIL pack_file;                       //Compressed file being written
+static bool log_file_open = false;
+
+static uint32_t first_file = 0;
+static uint32_t current_file = 0;
+static bool closed_files = false;           //Files left uncompressed by a previous boot
+static bool resume_file = false;            //The current file was left not full by a previous boot
+
+//Two batches, one is filled by LOG_STORE_Append while the other one is written
+static uint64_t log_buffers[2][LOG_STORE_BATCH_SIZE / sizeof(uint64_t)];
+static uint8_t fill_buffer = 0;
+static uint16_t fill_length = 0;
+static int8_t pending_buffer = -1;
+static uint16_t sequence = 0;
+static bool flush_requested = false;
+
+//Writer task only
+static uint32_t batch_offset = 0;           //File offset of the batch being filled
+static uint16_t flushed_length = 0;         //Bytes of that batch already in the file
+static LOG_STORE_Packer_t packer;
+
+static LOG_STORE_Stats_t log_stats;
+
+static SemaphoreHandle_t log_store_mutex_handle = NULL;
+static SemaphoreHandle_t flush_done_handle = NULL;
+static TaskHandle_t log_store_task_handle = NULL;
+
+static vprintf_like_t log_vprintf = NULL;  //Console output of the captured logs
+
+static const char * TAG = "LOG_STORE";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static void tLogStoreTask(void *pvParameters){
+
+    TickType_t period = (LOG_STORE_FLUSH_PERIOD_MS > 0) ? pdMS_TO_TICKS(LOG_STORE_FLUSH_PERIOD_MS) : portMAX_DELAY;
+    TickType_t last_flush = xTaskGetTickCount();
+
+    //Records appended meanwhile wait in the batches
+    LOG_STORE_PackClosedFiles();
+    LOG_STORE_OpenCurrent(resume_file);
+
+    for(;;){
+        ulTaskNotifyTake(pdTRUE, period);
+
+        xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+        bool requested = flush_requested;
+        flush_requested = false;
+        xSemaphoreGive(log_store_mutex_handle);
+
+        TickType_t now = xTaskGetTickCount();
+        bool flush = requested || (LOG_STORE_FLUSH_PERIOD_MS > 0 && (now - last_flush) >= period);
+        if(flush){
+            last_flush = now;
+        }
+
+        LOG_STORE_Process(flush);
+
+        if(requested){
+            xSemaphoreGive(flush_done_handle);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+static void LOG_STORE_GetPath(uint32_t index, bool packed, char *pPath){
+
+    snprintf(pPath, LOG_STORE_PATH_SIZE, "%c:/L%07lu.%s", '0' + log_drive, (unsigned long)(index % 10000000), packed ? "LZS" : "LOG");
+}
+
+//"L0000001.LOG" or "L0000001.LZS", anything else is not a log file
+static bool LOG_STORE_ParseName(const char *pName, uint32_t *pIndex, bool *pPacked){
+
+    if(strlen(pName) != 12 || pName[0] != 'L' || pName[8] != '.'){
+        return false;
+    }
+
+    uint32_t index = 0;
+    for(uint8_t i=1; i<8; i++){
+        if(pName[i] < '0' || pName[i] > '9'){
+            return false;
+        }
+        index = index * 10 + (pName[i] - '0');
+    }
+
+    if(strcmp(&pName[9], "LOG") == 0){
+        *pPacked = false;
+    }
+    else if(strcmp(&pName[9], "LZS") == 0){
+        *pPacked = true;
+    }
+    else{
+        return false;
+    }
+
+    *pIndex = index;
+    return true;
+}
+
+static bool LOG_STORE_Mount(void){
+
+    const esp_partition_t *pPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, LOG_STORE_PARTITION_LABEL);
+    if(pPartition == NULL){
+        ESP_LOGW(TAG, "Failed to find partition %s", LOG_STORE_PARTITION_LABEL);
+        return false;
+    }
+
+    esp_err_t err = wl_mount(pPartition, &wl_handle);
+    if(err != ESP_OK){
+        ESP_LOGW(TAG, "Failed to mount wear levelling -> %s", esp_err_to_name(err));
+        wl_handle = WL_INVALID_HANDLE;
+        return false;
+    }
+
+    err = ff_diskio_get_drive(&log_drive);
+    if(err == ESP_OK){
+        err = ff_diskio_register_wl_partition(log_drive, wl_handle);
+    }
+    if(err != ESP_OK){
+        ESP_LOGW(TAG, "Failed to register FAT drive -> %s", esp_err_to_name(err));
+        wl_unmount(wl_handle);
+        wl_handle = WL_INVALID_HANDLE;
+        return false;
+    }
+
+    char drive[3] = {'0' + log_drive, ':', '\0'};
+    FRESULT res = f_mount(&log_fs, drive, 1);
+    if(res == FR_NO_FILESYSTEM){
+        ESP_LOGW(TAG, "Formatting partition %s", LOG_STORE_PARTITION_LABEL);
+        //The batches are not used yet, one of them is the work area. One batch per cluster, aligned on flash sectors
+        const MKFS_PARM opt = {(BYTE)(FM_ANY | FM_SFD), 1, LOG_STORE_BATCH_SIZE / CONFIG_WL_SECTOR_SIZE, 0, LOG_STORE_BATCH_SIZE};
+        res = f_mkfs(drive, &opt, LOG_STORE_BUFFER(0), LOG_STORE_BATCH_SIZE);
+        if(res == FR_OK){
+            res = f_mount(&log_fs, drive, 1);
+        }
+    }
+    if(res != FR_OK){
+        ESP_LOGW(TAG, "Failed to mount FAT -> %d", res);
+        ff_diskio_unregister(log_drive);
+        wl_unmount(wl_handle);
+        wl_handle = WL_INVALID_HANDLE;
+        return false;
+    }
+
+    return true;
+}
+
+//Finds the oldest and newest files. The newest file is resumed if it is not compressed nor full,
+//otherwise the new file follows it
+static bool LOG_STORE_Scan(uint32_t *pResumeSize){
+
+    char drive[4] = {'0' + log_drive, ':', '/', '\0'};
+    FF_DIR dir;
+    FILINFO info;
+    uint32_t index;
+    bool packed;
+    bool found = false;
+    uint32_t last = 0;
+    uint32_t last_size = 0;
+    bool last_open = false;                 //The newest file has a .LOG
+    uint32_t open_files = 0;                //.LOG files
+
+    if(f_opendir(&dir, drive) == FR_OK){
+        while(f_readdir(&dir, &info) == FR_OK && info.fname[0] != '\0'){
+            if(!LOG_STORE_ParseName(info.fname, &index, &packed)){
+                continue;
+            }
+            if(!found || index < first_file){
+                first_file = index;
+            }
+            if(!found || index > last){
+                last = index;
+                last_open = false;
+            }
+            if(index == last && !packed){
+                last_open = true;
+                last_size = info.fsize;
+            }
+            found = true;
+            open_files += !packed;
+        }
+        f_closedir(&dir);
+    }
+
+    bool resume = last_open && last_size < LOG_STORE_FILE_SIZE;
+    closed_files = open_files > (resume ? 1 : 0);
+    *pResumeSize = last_size;
+
+    current_file = found ? (resume ? last : last + 1) : 1;
+    if(!found){
+        first_file = current_file;
+    }
+
+    return resume;
+}
+
+//Reads the records after the last full batch of the current file back into the batch being filled,
+//the file is written again from its last full batch
+static bool LOG_STORE_Resume(uint32_t size){
+
+    char path[LOG_STORE_PATH_SIZE];
+    uint32_t offset = size - (size % LOG_STORE_BATCH_SIZE);
+    UINT length = size - offset;
+    UINT count = 0;
+
+    LOG_STORE_GetPath(current_file, false, path);
+    FRESULT res = f_open(&log_file, path, FA_READ);
+    if(res == FR_OK){
+        res = f_lseek(&log_file, offset);
+        if(res == FR_OK){
+            res = f_read(&log_file, LOG_STORE_BUFFER(fill_buffer), length, &count);
+        }
+        f_close(&log_file);
+    }
+    if(res == FR_OK && count != length){
+        res = FR_INT_ERR;
+    }
+    if(res != FR_OK){
+        ESP_LOGW(TAG, "Failed to resume %s -> %d", path, res);
+        return false;
+    }
+
+    batch_offset = offset;
+    fill_length = length;
+    flushed_length = length;
+
+    return true;
+}
+
+static bool LOG_STORE_OpenCurrent(bool resume){
+
+    char path[LOG_STORE_PATH_SIZE];
+
+    LOG_STORE_GetPath(current_file, false, path);
+    FRESULT res = f_open(&log_file, path, (resume ? FA_OPEN_ALWAYS : FA_CREATE_ALWAYS) | FA_WRITE);
+    if(res != FR_OK){
+        ESP_LOGW(TAG, "Failed to create %s -> %d", path, res);
+        return false;
+    }
+
+    log_file_open = true;
+    if(!resume){
+        batch_offset = 0;
+        flushed_length = 0;
+    }
+
+    return true;
+}
+
+static void LOG_STORE_DeleteOldest(void){
+
+    char path[LOG_STORE_PATH_SIZE];
+
+    LOG_STORE_GetPath(first_file, true, path);
+    if(f_unlink(path) != FR_OK){
+        LOG_STORE_GetPath(first_file, false, path);
+        f_unlink(path);
+    }
+
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+    first_file++;
+    xSemaphoreGive(log_store_mutex_handle);
+}
+
+//Writes a batch at its file offset and syncs the file once, the oldest file is deleted if the disk is full
+static bool LOG_STORE_WriteBatch(const uint8_t *pData, uint16_t length){
+
+    FRESULT res = FR_INVALID_OBJECT;
+    UINT written = 0;
+
+    if(log_file_open){
+        for(;;){
+            res = f_lseek(&log_file, batch_offset);
+            if(res == FR_OK){
+                res = f_write(&log_file, pData, length, &written);
+            }
+            if(res == FR_OK && written != length && first_file < current_file){
+                LOG_STORE_DeleteOldest();
+                continue;
+            }
+            break;
+        }
+        if(res == FR_OK && written != length){
+            res = FR_DENIED;
+        }
+        if(res == FR_OK){
+            res = f_sync(&log_file);
+        }
+    }
+
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+    if(res == FR_OK){
+        log_stats.syncs++;
+    }
+    else{
+        log_stats.write_errors++;
+    }
+    xSemaphoreGive(log_store_mutex_handle);
+
+    if(res != FR_OK){
+        ESP_LOGW(TAG, "Failed to write file %lu -> %d", (unsigned long)current_file, res);
+        return false;
+    }
+
+    return true;
+}
+
+//Closes the full file, compresses it and starts the next one
+static void LOG_STORE_Rotate(void){
+
+    f_close(&log_file);
+    log_file_open = false;
+
+    uint32_t closed = current_file;
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+    current_file++;
+    xSemaphoreGive(log_store_mutex_handle);
+
+    if(LOG_STORE_COMPRESS){
+        LOG_STORE_Pack(closed);
+    }
+
+    while(current_file - first_file >= LOG_STORE_MAX_FILES){
+        LOG_STORE_DeleteOldest();
+    }
+
+    LOG_STORE_OpenCurrent(false);
+}
+
+//Most significant bit first, as heatshrink
+static void LOG_STORE_PutBits(uint16_t value, uint8_t count){
+
+    while(count > 0){
+        count--;
+        if(packer.out_bits == 0){
+            packer.out[packer.out_length] = 0;
+        }
+        if(value & (1U << count)){
+            packer.out[packer.out_length] |= 0x80 >> packer.out_bits;
+        }
+        packer.out_bits++;
+        if(packer.out_bits == 8){
+            packer.out_bits = 0;
+            packer.out_length++;
+            if(packer.out_length == LOG_STORE_PACK_OUT_SIZE){
+                LOG_STORE_FlushBits(false);
+            }
+        }
+    }
+}
+
+//Called on complete bytes only, but the last one which is padded with zero bits
+static void LOG_STORE_FlushBits(bool last){
+
+    UINT written = 0;
+    UINT length = packer.out_length + ((last && packer.out_bits != 0) ? 1 : 0);
+
+    if(length > 0 && !packer.error){
+        if(f_write(&pack_file, packer.out, length, &written) != FR_OK || written != length){
+            packer.error = true;
+        }
+    }
+
+    packer.out_length = 0;
+    packer.out_bits = 0;
+}
+
+//Longest match in the window, a literal if a back reference costs more
+static void LOG_STORE_EncodeNext(void){
+
+    uint16_t available = packer.length - packer.pos;
+    uint16_t max_length = (available < LOG_STORE_PACK_LOOKAHEAD) ? available : LOG_STORE_PACK_LOOKAHEAD;
+    uint16_t max_offset = (packer.pos < LOG_STORE_PACK_WINDOW) ? packer.pos : LOG_STORE_PACK_WINDOW;
+    uint16_t best_length = 0;
+    uint16_t best_offset = 0;
+
+    for(uint16_t offset=1; offset<=max_offset && best_length<max_length; offset++){
+        const uint8_t *pStart = &packer.window[packer.pos - offset];
+        const uint8_t *pNext = &packer.window[packer.pos];
+        uint16_t length = 0;
+
+        while(length < max_length && pStart[length] == pNext[length]){
+            length++;
+        }
+        if(length > best_length){
+            best_length = length;
+            best_offset = offset;
+        }
+    }
+
+    if(best_length * 9 > LOG_STORE_PACK_BACKREF_BITS){
+        LOG_STORE_PutBits(0, 1);
+        LOG_STORE_PutBits(best_offset - 1, LOG_STORE_PACK_WINDOW_BITS);
+        LOG_STORE_PutBits(best_length - 1, LOG_STORE_PACK_LOOKAHEAD_BITS);
+        packer.pos += best_length;
+    }
+    else{
+        LOG_STORE_PutBits(1, 1);
+        LOG_STORE_PutBits(packer.window[packer.pos], 8);
+        packer.pos++;
+    }
+}
+
+//Compresses a closed file, the original is deleted once the compressed one is complete
+static bool LOG_STORE_Pack(uint32_t index){
+
+    char src_path[LOG_STORE_PATH_SIZE];
+    char dst_path[LOG_STORE_PATH_SIZE];
+    UINT count = 0;
+
+    LOG_STORE_GetPath(index, false, src_path);
+    LOG_STORE_GetPath(index, true, dst_path);
+
+    if(f_open(&log_file, src_path, FA_READ) != FR_OK){
+        return false;
+    }
+
+    LOG_STORE_Pack_Header_t header = {
+        .magic = LOG_STORE_PACK_MAGIC,
+        .window_bits = LOG_STORE_PACK_WINDOW_BITS,
+        .lookahead_bits = LOG_STORE_PACK_LOOKAHEAD_BITS,
+        .reserved = 0xFFFF,
+        .size = f_size(&log_file),
+    };
+
+    memset(&packer, 0, sizeof(packer));
+
+    FRESULT res = f_open(&pack_file, dst_path, FA_CREATE_ALWAYS | FA_WRITE);
+    if(res != FR_OK){
+        f_close(&log_file);
+        ESP_LOGW(TAG, "Failed to create %s -> %d", dst_path, res);
+        return false;
+    }
+
+    res = f_write(&pack_file, &header, sizeof(header), &count);
+    if(res == FR_OK && count != sizeof(header)){
+        res = FR_DENIED;
+    }
+
+    bool eof = false;
+    while(res == FR_OK && !packer.error && !(eof && packer.pos == packer.length)){
+
+        //Keep one window of history in front of the next byte
+        if(packer.pos > LOG_STORE_PACK_WINDOW){
+            uint16_t shift = packer.pos - LOG_STORE_PACK_WINDOW;
+            memmove(packer.window, &packer.window[shift], packer.length - shift);
+            packer.length -= shift;
+            packer.pos -= shift;
+        }
+
+        if(!eof){
+            UINT space = sizeof(packer.window) - packer.length;
+            res = f_read(&log_file, &packer.window[packer.length], space, &count);
+            eof = (count < space);
+            packer.length += count;
+        }
+
+        //Encode while a full lookahead is in the window, up to the end once the file is read
+        while(res == FR_OK && packer.pos < packer.length && (eof || (packer.length - packer.pos) >= LOG_STORE_PACK_LOOKAHEAD)){
+            LOG_STORE_EncodeNext();
+        }
+    }
+    LOG_STORE_FlushBits(true);
+
+    if(res == FR_OK && packer.error){
+        res = FR_DENIED;
+    }
+    if(res == FR_OK){
+        res = f_close(&pack_file);
+    }
+    else{
+        f_close(&pack_file);
+    }
+    f_close(&log_file);
+
+    if(res != FR_OK){
+        ESP_LOGW(TAG, "Failed to compress %s -> %d", src_path, res);
+        f_unlink(dst_path);
+        return false;
+    }
+
+    f_unlink(src_path);
+
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+    log_stats.files_packed++;
+    xSemaphoreGive(log_store_mutex_handle);
+
+    return true;
+}
+
+//Files of a previous boot, closed by the reset
+static void LOG_STORE_PackClosedFiles(void){
+
+    char path[LOG_STORE_PATH_SIZE];
+    FILINFO info;
+
+    if(!LOG_STORE_COMPRESS || !closed_files){
+        return;
+    }
+
+    for(uint32_t index=first_file; index<current_file; index++){
+        LOG_STORE_GetPath(index, false, path);
+        if(f_stat(path, &info) == FR_OK){
+            LOG_STORE_Pack(index);
+        }
+    }
+    closed_files = false;
+}
+
+static void LOG_STORE_Process(bool flush){
+
+    for(;;){
+        xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+        int8_t pending = pending_buffer;
+        xSemaphoreGive(log_store_mutex_handle);
+
+        if(pending < 0){
+            break;
+        }
+
+        //A failed batch is lost, the next one is written at the same offset
+        bool written = LOG_STORE_WriteBatch(LOG_STORE_BUFFER(pending), LOG_STORE_BATCH_SIZE);
+
+        xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+        pending_buffer = -1;
+        if(written){
+            log_stats.batches_written++;
+        }
+        //Filled while this one was written
+        if(fill_length == LOG_STORE_BATCH_SIZE){
+            LOG_STORE_SwapBuffers();
+        }
+        xSemaphoreGive(log_store_mutex_handle);
+
+        flushed_length = 0;
+        if(written){
+            batch_offset += LOG_STORE_BATCH_SIZE;
+            if(batch_offset >= LOG_STORE_FILE_SIZE){
+                LOG_STORE_Rotate();
+            }
+        }
+    }
+
+    if(!flush){
+        return;
+    }
+
+    //Appends only add bytes after fill_length, the start of the batch can be written without the mutex
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+    int8_t pending = pending_buffer;
+    uint8_t index = fill_buffer;
+    uint16_t length = fill_length;
+    xSemaphoreGive(log_store_mutex_handle);
+
+    //A batch handed over meanwhile goes first, at this offset
+    if(pending >= 0 || length <= flushed_length){
+        return;
+    }
+
+    if(LOG_STORE_WriteBatch(LOG_STORE_BUFFER(index), length)){
+        flushed_length = length;
+    }
+}
+
+//Hands the full batch to the writer and starts filling the other one
+static void LOG_STORE_SwapBuffers(void){
+
+    pending_buffer = fill_buffer;
+    fill_buffer ^= 1;
+    fill_length = 0;
+}
+
+//Formats a warning or error line and appends it as a text record, only these lines pay for the buffer
+static NOINLINE_ATTR void LOG_STORE_CaptureText(const char *pFormat, va_list args){
+
+    char text[LOG_STORE_MAX_PAYLOAD + 1];
+
+    int length = vsnprintf(text, sizeof(text), pFormat, args);
+    if(length <= 0){
+        return;
+    }
+
+    //Without the color sequences and the line end, "W (1234) TAG: message"
+    char *pStart = text;
+    if(pStart[0] == '\033'){
+        pStart = strchr(pStart, 'm');
+        pStart = (pStart != NULL) ? (pStart + 1) : text;
+    }
+    size_t size = strcspn(pStart, "\033\r\n");
+
+    if(size > 0){
+        LOG_STORE_Append(LOG_STORE_TYPE_TEXT, pStart, size);
+    }
+}
+
+//esp_log output hook, warnings and errors are appended as text records then printed as before
+static int LOG_STORE_CaptureLog(const char *pFormat, va_list args){
+
+    //The level letter follows the color sequence of the format, "\033[0;33mW (%lu) %s: ..."
+    const char *pLevel = pFormat;
+    if(pLevel[0] == '\033'){
+        pLevel = strchr(pLevel, 'm');
+        pLevel = (pLevel != NULL) ? (pLevel + 1) : pFormat;
+    }
+
+    if((pLevel[0] == 'E' || pLevel[0] == 'W') && !xPortInIsrContext()){
+        va_list copy;
+
+        va_copy(copy, args);
+        LOG_STORE_CaptureText(pFormat, copy);
+        va_end(copy);
+    }
+
+    return log_vprintf(pFormat, args);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Log store initialization
+*
+*   This function is used to mount the wear-levelled FAT partition, format
+*   it on first use and start the writer task. The newest file is resumed
+*   from its last full batch if it is not full, so resets do not rotate the
+*   history away. The writer task compresses the other files left open by
+*   the previous boot, then creates the next file if none is resumed.
+*   With CONFIG_LOG_STORE_CAPTURE_LOGS, application log warnings and errors
+*   are also appended as text records.
+*
+*   Preconditions: None.
+*
+*   Side Effects: Formats the partition if it holds no file system.
+*   Installs an esp_log_set_vprintf hook with CONFIG_LOG_STORE_CAPTURE_LOGS.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_InitModule(void){
+
+    if(log_store_task_handle != NULL){
+        ESP_LOGW(TAG, "Already initialized");
+        return LOG_STORE_STATUS_FAIL;
+    }
+
+    //Create mutex and flush semaphore
+    if(log_store_mutex_handle == NULL){
+        log_store_mutex_handle = xSemaphoreCreateMutex();
+        if(log_store_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Log Store mutex");
+            return LOG_STORE_STATUS_FAIL;
+        }
+    }
+    if(flush_done_handle == NULL){
+        flush_done_handle = xSemaphoreCreateBinary();
+        if(flush_done_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Log Store flush semaphore");
+            return LOG_STORE_STATUS_FAIL;
+        }
+    }
+
+    if(wl_handle == WL_INVALID_HANDLE && !LOG_STORE_Mount()){
+        return LOG_STORE_STATUS_FAIL;
+    }
+
+    fill_buffer = 0;
+    fill_length = 0;
+    pending_buffer = -1;
+    sequence = 0;
+    flush_requested = false;
+    memset(&log_stats, 0, sizeof(log_stats));
+
+    uint32_t resume_size = 0;
+    resume_file = LOG_STORE_Scan(&resume_size);
+    if(resume_file && !LOG_STORE_Resume(resume_size)){
+        //Left as a closed file
+        resume_file = false;
+        closed_files = true;
+        current_file++;
+    }
+    while(current_file - first_file >= LOG_STORE_MAX_FILES){
+        LOG_STORE_DeleteOldest();
+    }
+    ESP_LOGI(TAG, "Files %lu to %lu%s", (unsigned long)first_file, (unsigned long)current_file, resume_file ? ", resumed" : "");
+
+    if(pdTRUE != xTaskCreate(tLogStoreTask,
+                             "Log store task",
+                             LOG_STORE_TASK_STACK,
+                             NULL,
+                             LOG_STORE_TASK_PRIORITY,
+                             &log_store_task_handle)){
+
+        ESP_LOGW(TAG, "Failed to create Log Store task");
+        return LOG_STORE_STATUS_FAIL;
+    }
+    STACK_MON_RegisterTask(log_store_task_handle, LOG_STORE_TASK_STACK);
+
+    if(LOG_STORE_CAPTURE_LOGS){
+        log_vprintf = esp_log_set_vprintf(LOG_STORE_CaptureLog);
+    }
+
+    return LOG_STORE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Log store append
+*
+*   This function is used to append a record. The record is copied into the
+*   RAM batch being filled, a full batch is handed to the writer task. It
+*   never waits for flash, records are dropped while both batches are full.
+*
+*   Preconditions: LOG_STORE_InitModule called. Not callable from an ISR.
+*
+*   Side Effects: None.
+*
+*   \param[in]  type                Record type
+*   \param[in]  pPayload            Payload, may be NULL if length is 0
+*   \param[in]  length              Payload bytes, up to LOG_STORE_MAX_PAYLOAD
+*
+*   \return     operation status, fail if the record was dropped
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_Append(uint8_t type, const void *pPayload, size_t length){
+
+    if(log_store_task_handle == NULL || length > LOG_STORE_MAX_PAYLOAD || (pPayload == NULL && length != 0)){
+        return LOG_STORE_STATUS_FAIL;
+    }
+
+    LOG_STORE_Record_Header_t header = {
+        .type = type,
+        .length = (uint8_t)length,
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+    };
+    const uint8_t *pParts[2] = {(const uint8_t *)&header, pPayload};
+    size_t sizes[2] = {sizeof(header), length};
+    bool notify = false;
+
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+
+    size_t space = (LOG_STORE_BATCH_SIZE - fill_length) + ((pending_buffer < 0) ? LOG_STORE_BATCH_SIZE : 0);
+    if(sizeof(header) + length > space){
+        log_stats.records_dropped++;
+        xSemaphoreGive(log_store_mutex_handle);
+        return LOG_STORE_STATUS_FAIL;
+    }
+
+    header.sequence = sequence++;
+
+    //A record may cross into the next batch
+    for(uint8_t i=0; i<2; i++){
+        const uint8_t *pData = pParts[i];
+        size_t size = sizes[i];
+
+        while(size > 0){
+            if(fill_length == LOG_STORE_BATCH_SIZE){
+                LOG_STORE_SwapBuffers();
+                notify = true;
+            }
+            size_t copy = LOG_STORE_BATCH_SIZE - fill_length;
+            if(copy > size){
+                copy = size;
+            }
+            memcpy(&LOG_STORE_BUFFER(fill_buffer)[fill_length], pData, copy);
+            fill_length += copy;
+            pData += copy;
+            size -= copy;
+        }
+    }
+
+    if(fill_length == LOG_STORE_BATCH_SIZE && pending_buffer < 0){
+        LOG_STORE_SwapBuffers();
+        notify = true;
+    }
+    log_stats.records_appended++;
+
+    xSemaphoreGive(log_store_mutex_handle);
+
+    if(notify){
+        xTaskNotifyGive(log_store_task_handle);
+    }
+
+    return LOG_STORE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Log store flush
+*
+*   This function is used to write the records of the batch being filled
+*   without waiting for it to be full, e.g. before a restart. The batch is
+*   written again once full, at the same file offset.
+*
+*   Preconditions: LOG_STORE_InitModule called. One caller at a time.
+*
+*   Side Effects: None.
+*
+*   \param[in]  timeout             Ticks to wait for the writer task
+*
+*   \return     operation status, fail on timeout
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_Flush(TickType_t timeout){
+
+    if(log_store_task_handle == NULL){
+        return LOG_STORE_STATUS_FAIL;
+    }
+
+    //Drop a completion left by a flush that timed out
+    xSemaphoreTake(flush_done_handle, 0);
+
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+    flush_requested = true;
+    xSemaphoreGive(log_store_mutex_handle);
+    xTaskNotifyGive(log_store_task_handle);
+
+    return (xSemaphoreTake(flush_done_handle, timeout) == pdTRUE) ? LOG_STORE_STATUS_SUCCESS : LOG_STORE_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Log store statistics
+*
+*   This function is used to read the log store counters.
+*
+*   Preconditions: LOG_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_GetStats(LOG_STORE_Stats_t *pStats){
+
+    if(log_store_task_handle == NULL || pStats == NULL){
+        return LOG_STORE_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(log_store_mutex_handle, portMAX_DELAY);
+    *pStats = log_stats;
+    pStats->first_file = first_file;
+    pStats->current_file = current_file;
+    xSemaphoreGive(log_store_mutex_handle);
+
+    return LOG_STORE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Log store file path
+*
+*   This function is used to get the FatFs path of a log file, to read it
+*   with f_open. Compressed files start with a LOG_STORE_Pack_Header_t.
+*
+*   Preconditions: LOG_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index               File index
+*   \param[out] pPath               Buffer of LOG_STORE_PATH_SIZE bytes
+*   \param[out] pPacked             Set if the file is compressed, may be NULL
+*
+*   \return     operation status, fail if the file does not exist
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_GetFilePath(uint32_t index, char *pPath, bool *pPacked){
+
+    FILINFO info;
+
+    if(log_store_task_handle == NULL || pPath == NULL){
+        return LOG_STORE_STATUS_FAIL;
+    }
+
+    for(uint8_t packed=0; packed<2; packed++){
+        LOG_STORE_GetPath(index, packed, pPath);
+        if(f_stat(pPath, &info) == FR_OK){
+            if(pPacked != NULL){
+                *pPacked = packed;
+            }
+            return LOG_STORE_STATUS_SUCCESS;
+        }
+    }
+
+    return LOG_STORE_STATUS_FAIL;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
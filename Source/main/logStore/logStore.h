@@ -0,0 +1,185 @@
+#ifndef _LOG_STORE_H
+#define _LOG_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define LOG_STORE_PARTITION_LABEL           "logs"
+
+//Records are written in batches of one flash sector, one f_sync per batch
+#define LOG_STORE_BATCH_SIZE                (4096)
+#define LOG_STORE_MAX_PAYLOAD               (255)
+
+//Closed files are compressed with heatshrink's LZSS format
+#define LOG_STORE_PACK_MAGIC                (0x314B504C)    //"LPK1"
+#define LOG_STORE_PACK_WINDOW_BITS          (10)
+#define LOG_STORE_PACK_LOOKAHEAD_BITS       (5)
+
+//8.3 names, "0:/L0000001.LOG" while written, "0:/L0000001.LZS" once compressed
+#define LOG_STORE_PATH_SIZE                 (16)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum LOG_STORE_Type_e{
+    LOG_STORE_TYPE_BOOT,                    //Payload: esp_reset_reason_t, one byte
+    LOG_STORE_TYPE_TEXT,                    //Payload: characters, not terminated
+    LOG_STORE_TYPE_APP = 0x80,              //First type left to the application
+}LOG_STORE_Type_t;
+
+/*
+ * Log files are a stream of records, little endian: a header followed by
+ * length payload bytes. Records may cross batch boundaries.
+ */
+typedef struct __attribute__((packed)) LOG_STORE_Record_Header_s{
+    uint8_t type;                           //LOG_STORE_Type_t
+    uint8_t length;                         //Payload bytes
+    uint16_t sequence;                      //Incremented for every record appended since boot
+    uint32_t timestamp_ms;                  //esp_timer time of the append
+}LOG_STORE_Record_Header_t;
+
+typedef struct __attribute__((packed)) LOG_STORE_Pack_Header_s{
+    uint32_t magic;                         //LOG_STORE_PACK_MAGIC
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    uint16_t reserved;
+    uint32_t size;                          //Bytes of the file before compression
+}LOG_STORE_Pack_Header_t;
+
+typedef struct LOG_STORE_Stats_s{
+    uint32_t records_appended;
+    uint32_t records_dropped;               //Records lost while both buffers were full
+    uint32_t batches_written;               //Full batches
+    uint32_t syncs;                         //Full batches and partial flushes
+    uint32_t files_packed;
+    uint32_t write_errors;
+    uint32_t first_file;                    //Oldest file index kept
+    uint32_t current_file;                  //File index being written
+}LOG_STORE_Stats_t;
+
+typedef enum LOG_STORE_Ret_e{
+    LOG_STORE_STATUS_FAIL,
+    LOG_STORE_STATUS_SUCCESS,
+}LOG_STORE_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if (LOG_STORE_PACK_LOOKAHEAD_BITS >= LOG_STORE_PACK_WINDOW_BITS)
+#error "Log store lookahead must be shorter than the window"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Log store initialization
+*
+*   This function is used to mount the wear-levelled FAT partition, format
+*   it on first use and start the writer task. The newest file is resumed
+*   from its last full batch if it is not full, so resets do not rotate the
+*   history away. The writer task compresses the other files left open by
+*   the previous boot, then creates the next file if none is resumed.
+*   With CONFIG_LOG_STORE_CAPTURE_LOGS, application log warnings and errors
+*   are also appended as text records.
+*
+*   Preconditions: None.
+*
+*   Side Effects: Formats the partition if it holds no file system.
+*   Installs an esp_log_set_vprintf hook with CONFIG_LOG_STORE_CAPTURE_LOGS.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Log store append
+*
+*   This function is used to append a record. The record is copied into the
+*   RAM batch being filled, a full batch is handed to the writer task. It
+*   never waits for flash, records are dropped while both batches are full.
+*
+*   Preconditions: LOG_STORE_InitModule called. Not callable from an ISR.
+*
+*   Side Effects: None.
+*
+*   \param[in]  type                Record type
+*   \param[in]  pPayload            Payload, may be NULL if length is 0
+*   \param[in]  length              Payload bytes, up to LOG_STORE_MAX_PAYLOAD
+*
+*   \return     operation status, fail if the record was dropped
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_Append(uint8_t type, const void *pPayload, size_t length);
+
+/***************************************************************************//*!
+*  \brief Log store flush
+*
+*   This function is used to write the records of the batch being filled
+*   without waiting for it to be full, e.g. before a restart. The batch is
+*   written again once full, at the same file offset.
+*
+*   Preconditions: LOG_STORE_InitModule called. One caller at a time.
+*
+*   Side Effects: None.
+*
+*   \param[in]  timeout             Ticks to wait for the writer task
+*
+*   \return     operation status, fail on timeout
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_Flush(TickType_t timeout);
+
+/***************************************************************************//*!
+*  \brief Log store statistics
+*
+*   This function is used to read the log store counters.
+*
+*   Preconditions: LOG_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_GetStats(LOG_STORE_Stats_t *pStats);
+
+/***************************************************************************//*!
+*  \brief Log store file path
+*
+*   This function is used to get the FatFs path of a log file, to read it
+*   with f_open. Compressed files start with a LOG_STORE_Pack_Header_t.
+*
+*   Preconditions: LOG_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index               File index
+*   \param[out] pPath               Buffer of LOG_STORE_PATH_SIZE bytes
+*   \param[out] pPacked             Set if the file is compressed, may be NULL
+*
+*   \return     operation status, fail if the file does not exist
+*
+*******************************************************************************/
+LOG_STORE_Ret_t LOG_STORE_GetFilePath(uint32_t index, char *pPath, bool *pPacked);
+
+#endif//_LOG_STORE_H
@@ -17,14 +17,38 @@
 #include "esp_flash.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#if CONFIG_LOG_DEFERRED
+#include "esp_log_deferred.h"
+#endif
 
 #include "hardwareInterface.h"
+#include "bootTrace.h"
+#include "initGraph.h"
+#include "softSwitcher.h"
+#include "stackMonitor.h"
+#include "buttonController.h"
+#include "ledController.h"
+#include "userInterface.h"
+#include "adcController.h"
+#include "logStore.h"
+#include "assetStore.h"
+#include "flightRecorder.h"
+#if CONFIG_FUEL_GAUGE
+#include "driver/i2c_master.h"
+#include "fuelGauge.h"
+#endif
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
 #define LOG_LOCAL_LEVEL             (ESP_LOG_INFO)
 
+#define MAIN_INIT_WORKERS           (2)
+
+//Rail steps run once the asset store is ready, optional
+#define MAIN_POWER_SEQUENCE_ASSET   "boot.seq"
+#define MAIN_POWER_SEQUENCE_VERSION (1)
+
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
@@ -33,11 +57,63 @@
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
+//Entry of the power sequence table, packed with the tools/asset_pack.py format '<BBH'
+typedef struct __attribute__((packed)) MAIN_Power_Step_s{
+    uint8_t rail;                           //SOFT_IO_Id_t
+    uint8_t on;                             //1 to set the rail, 0 to clear it
+    uint16_t delay_ms;                      //Wait before the step
+}MAIN_Power_Step_t;
+
+typedef enum MAIN_Init_Id_e{
+    MAIN_INIT_RAILS_ID,
+    MAIN_INIT_STACK_MON_ID,
+    MAIN_INIT_BUTTONS_ID,
+    MAIN_INIT_LEDS_ID,
+    MAIN_INIT_ADC_ID,
+    MAIN_INIT_UI_ID,
+    MAIN_INIT_CHIP_INFO_ID,
+#if CONFIG_LOG_STORE
+    MAIN_INIT_LOG_STORE_ID,
+#endif
+#if CONFIG_ASSET_STORE
+    MAIN_INIT_ASSET_STORE_ID,
+    MAIN_INIT_ASSET_TABLES_ID,
+#endif
+#if CONFIG_FLIGHT_RECORDER
+    MAIN_INIT_FLIGHT_REC_ID,
+#endif
+#if CONFIG_FUEL_GAUGE
+    MAIN_INIT_FUEL_GAUGE_ID,
+#endif
 
+    MAIN_INIT_MAX_ID,
+}MAIN_Init_Id_t;
 
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
+static bool MAIN_InitRails(void);
+static bool MAIN_InitStackMonitor(void);
+static bool MAIN_InitButtons(void);
+static bool MAIN_InitLeds(void);
+static bool MAIN_InitAdc(void);
+static bool MAIN_InitUserInterface(void);
+static bool MAIN_PrintChipInfo(void);
+#if CONFIG_LOG_STORE
+static bool MAIN_InitLogStore(void);
+#endif
+#if CONFIG_ASSET_STORE
+static bool MAIN_InitAssetStore(void);
+static bool MAIN_RunPowerSequence(void);
+static bool MAIN_LoadAssetTables(void);
+#endif
+#if CONFIG_FLIGHT_RECORDER
+static bool MAIN_ReportFlightRecorder(void);
+#endif
+#if CONFIG_FUEL_GAUGE
+static bool MAIN_InitFuelGauge(void);
+static void MAIN_UpdateCharging(void);
+#endif
 static void tMainTask(void *pvParameters);
 
 /******************************************************************************
@@ -48,6 +124,90 @@ static void tMainTask(void *pvParameters);
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
+//Only the rails are switch critical, everything else initializes in parallel
+static const INIT_GRAPH_Module_t init_table[MAIN_INIT_MAX_ID] = {
+    [MAIN_INIT_RAILS_ID] = {
+        .pName = "rails",
+        .init = MAIN_InitRails,
+        .mode = INIT_GRAPH_MODE_CRITICAL,
+        .dependencies = 0,
+    },
+    [MAIN_INIT_STACK_MON_ID] = {
+        .pName = "stack monitor",
+        .init = MAIN_InitStackMonitor,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = 0,
+    },
+    [MAIN_INIT_BUTTONS_ID] = {
+        .pName = "buttons",
+        .init = MAIN_InitButtons,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = INIT_GRAPH_DEP(MAIN_INIT_STACK_MON_ID),
+    },
+    [MAIN_INIT_LEDS_ID] = {
+        .pName = "leds",
+        .init = MAIN_InitLeds,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = INIT_GRAPH_DEP(MAIN_INIT_STACK_MON_ID),
+    },
+    [MAIN_INIT_ADC_ID] = {
+        .pName = "adc",
+        .init = MAIN_InitAdc,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = 0,
+    },
+    [MAIN_INIT_UI_ID] = {
+        .pName = "ui",
+        .init = MAIN_InitUserInterface,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = INIT_GRAPH_DEP(MAIN_INIT_BUTTONS_ID) | INIT_GRAPH_DEP(MAIN_INIT_LEDS_ID),
+    },
+    [MAIN_INIT_CHIP_INFO_ID] = {
+        .pName = "chip info",
+        .init = MAIN_PrintChipInfo,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = 0,
+    },
+#if CONFIG_LOG_STORE
+    [MAIN_INIT_LOG_STORE_ID] = {
+        .pName = "log store",
+        .init = MAIN_InitLogStore,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = INIT_GRAPH_DEP(MAIN_INIT_STACK_MON_ID),
+    },
+#endif
+#if CONFIG_ASSET_STORE
+    [MAIN_INIT_ASSET_STORE_ID] = {
+        .pName = "asset store",
+        .init = MAIN_InitAssetStore,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = INIT_GRAPH_DEP(MAIN_INIT_STACK_MON_ID),
+    },
+    [MAIN_INIT_ASSET_TABLES_ID] = {
+        .pName = "asset tables",
+        .init = MAIN_LoadAssetTables,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = INIT_GRAPH_DEP(MAIN_INIT_ASSET_STORE_ID) | INIT_GRAPH_DEP(MAIN_INIT_RAILS_ID) | INIT_GRAPH_DEP(MAIN_INIT_UI_ID),
+    },
+#endif
+#if CONFIG_FLIGHT_RECORDER
+    [MAIN_INIT_FLIGHT_REC_ID] = {
+        .pName = "flight recorder",
+        .init = MAIN_ReportFlightRecorder,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = 0,
+    },
+#endif
+#if CONFIG_FUEL_GAUGE
+    [MAIN_INIT_FUEL_GAUGE_ID] = {
+        .pName = "fuel gauge",
+        .init = MAIN_InitFuelGauge,
+        .mode = INIT_GRAPH_MODE_PARALLEL,
+        .dependencies = INIT_GRAPH_DEP(MAIN_INIT_STACK_MON_ID),
+    },
+#endif
+};
+
 static TaskHandle_t main_task_handle = NULL;
 
 static const char * TAG = "MAIN";
@@ -55,18 +215,46 @@ static const char * TAG = "MAIN";
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
-static void tMainTask(void *pvParameters){
+static bool MAIN_InitRails(void){
 
-    ESP_LOGI(TAG, "Starting Main Task");
+    SOFT_IO_Config_t pwr_io = {
+        .io_num = HWI_PWR_OUT,
+        .active_level = HWI_PWR_ACTIVE_LEVEL ? SOFT_IO_LEVEL_HIGH : SOFT_IO_LEVEL_LOW,
+    };
+    SOFT_IO_Config_t charging_io = {
+        .io_num = HWI_CHARGE_OUT,
+        .active_level = HWI_CHARGE_ACTIVE_LEVEL ? SOFT_IO_LEVEL_HIGH : SOFT_IO_LEVEL_LOW,
+    };
 
-    for(;;){
+    return SOFT_InitModule(pwr_io, charging_io) == SOFT_SWITCHER_STATUS_SUCCESS;
+}
 
-        vTaskDelay(1000/portTICK_PERIOD_MS);
-    }
-    vTaskDelete(NULL);
+static bool MAIN_InitStackMonitor(void){
+
+    return STACK_MON_InitModule() == STACK_MON_STATUS_SUCCESS;
 }
 
-void app_main(void){
+static bool MAIN_InitButtons(void){
+
+    return BTN_InitController() == BTN_CTRL_STATUS_SUCCESS;
+}
+
+static bool MAIN_InitLeds(void){
+
+    return LED_InitController() == LED_CTRL_STATUS_SUCCESS;
+}
+
+static bool MAIN_InitAdc(void){
+
+    return ADC_InitController() == ADC_CTRL_STATUS_SUCCESS;
+}
+
+static bool MAIN_InitUserInterface(void){
+
+    return UI_InitInterface() == UI_STATUS_SUCCESS;
+}
+
+static bool MAIN_PrintChipInfo(void){
 
     /* Print chip information */
     esp_chip_info_t chip_info;
@@ -85,7 +273,7 @@ void app_main(void){
     printf("silicon revision v%d.%d, ", major_rev, minor_rev);
     if(esp_flash_get_size(NULL, &flash_size) != ESP_OK) {
         printf("Get flash size failed");
-        return;
+        return false;
     }
 
     printf("%" PRIu32 "MB %s flash\n", flash_size / (uint32_t)(1024 * 1024),
@@ -93,9 +281,184 @@ void app_main(void){
 
     printf("Minimum free heap size: %" PRIu32 " bytes\n", esp_get_minimum_free_heap_size());
 
+    return true;
+}
+
+#if CONFIG_LOG_STORE
+static bool MAIN_InitLogStore(void){
+
+    if(LOG_STORE_InitModule() != LOG_STORE_STATUS_SUCCESS){
+        return false;
+    }
+
+    //First record of every boot
+    uint8_t reason = (uint8_t)esp_reset_reason();
+    LOG_STORE_Append(LOG_STORE_TYPE_BOOT, &reason, sizeof(reason));
+
+    return true;
+}
+#endif
+
+#if CONFIG_ASSET_STORE
+static bool MAIN_InitAssetStore(void){
+
+    return ASSET_STORE_InitModule() == ASSET_STORE_STATUS_SUCCESS;
+}
+
+//Runs the power sequence table once, true if there is none
+static bool MAIN_RunPowerSequence(void){
+
+    const ASSET_STORE_Table_t *pTable = NULL;
+    MAIN_Power_Step_t step;
+    bool done = true;
+
+    if(ASSET_STORE_Acquire(MAIN_POWER_SEQUENCE_ASSET, &pTable) != ASSET_STORE_STATUS_SUCCESS){
+        return true;
+    }
+
+    if(pTable->header.type != ASSET_STORE_TYPE_POWER_SEQUENCE ||
+       pTable->header.version != MAIN_POWER_SEQUENCE_VERSION ||
+       pTable->header.entry_size != sizeof(MAIN_Power_Step_t)){
+        ESP_LOGW(TAG, "Failed to run %s -> Unsupported table", MAIN_POWER_SEQUENCE_ASSET);
+        done = false;
+    }
+    for(uint16_t i=0; done && i<pTable->header.entry_count; i++){
+        done = (ASSET_STORE_ReadEntries(pTable, i, 1, &step) == ASSET_STORE_STATUS_SUCCESS &&
+                step.rail < SOFT_SWITCHER_INVALID_ID);
+        if(!done){
+            ESP_LOGW(TAG, "Failed to run %s -> Step %u", MAIN_POWER_SEQUENCE_ASSET, i);
+        }
+        else{
+            vTaskDelay(pdMS_TO_TICKS(step.delay_ms));
+            if(step.on){
+                SOFT_SetOutput((SOFT_IO_Id_t)step.rail);
+            }
+            else{
+                SOFT_ClearOutput((SOFT_IO_Id_t)step.rail);
+            }
+        }
+    }
+
+    ASSET_STORE_Release(pTable);
+
+    return done;
+}
+
+static bool MAIN_LoadAssetTables(void){
+
+    bool sequence = MAIN_RunPowerSequence();
+
+    return (UI_LoadAssets() == UI_STATUS_SUCCESS) && sequence;
+}
+#endif
+
+#if CONFIG_FLIGHT_RECORDER
+static bool MAIN_ReportFlightRecorder(void){
+
+    return FLIGHT_REC_PrintReport() == FLIGHT_REC_STATUS_SUCCESS;
+}
+#endif
+
+#if CONFIG_FUEL_GAUGE
+static bool MAIN_InitFuelGauge(void){
+
+    i2c_master_bus_config_t bus_config = {
+        .i2c_port = -1,
+        .sda_io_num = HWI_I2C_SDA_IO,
+        .scl_io_num = HWI_I2C_SCL_IO,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .trans_queue_depth = FUEL_GAUGE_BUS_QUEUE_DEPTH,
+        .flags.enable_internal_pullup = true,
+    };
+    i2c_master_bus_handle_t bus = NULL;
+
+    if(i2c_new_master_bus(&bus_config, &bus) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to create I2C bus");
+        return false;
+    }
+
+    return FUEL_GAUGE_InitModule(bus) == FUEL_GAUGE_STATUS_SUCCESS;
+}
+
+static void MAIN_UpdateCharging(void){
+
+    FUEL_GAUGE_Status_t status;
+
+    if(FUEL_GAUGE_GetStatus(&status) == FUEL_GAUGE_STATUS_SUCCESS){
+        SOFT_Charge_Status_t charge = {
+            .valid = status.valid,
+            .soc = status.soc,
+            .power_good = status.power_good,
+            .done = (status.charge == FUEL_GAUGE_CHARGE_DONE),
+            .fault = ((status.faults & FUEL_GAUGE_CHARGE_FAULTS) != 0),
+        };
+        SOFT_UpdateCharging(&charge);
+        if(status.valid){
+            UI_ShowBattery(status.soc);
+        }
+    }
+
+    //Returns before the reads are sent, their status is used on the next loop
+    FUEL_GAUGE_Poll();
+}
+#endif
+
+static void tMainTask(void *pvParameters){
+
+    ESP_LOGI(TAG, "Starting Main Task");
+
+    if(INIT_GRAPH_Require(MAIN_INIT_STACK_MON_ID) == INIT_GRAPH_STATUS_SUCCESS){
+        STACK_MON_RegisterTask(xTaskGetCurrentTaskHandle(), CONFIG_APP_MAIN_TASK_STACK_SIZE);
+    }
+
+    if(INIT_GRAPH_Wait(portMAX_DELAY) != INIT_GRAPH_STATUS_SUCCESS){
+        ESP_LOGW(TAG, "Some modules failed to initialize");
+    }
+    BOOT_TRACE_Mark("modules");
+    BOOT_TRACE_PrintReport();
+    INIT_GRAPH_PrintReport();
+
+    for(;;){
+
+#if CONFIG_STACK_MONITOR
+        STACK_MON_Process();
+#endif
+#if CONFIG_FUEL_GAUGE
+        MAIN_UpdateCharging();
+#endif
+        vTaskDelay(1000/portTICK_PERIOD_MS);
+    }
+    vTaskDelete(NULL);
+}
+
+void app_main(void){
+
+    if(BOOT_TRACE_InitModule() != BOOT_TRACE_STATUS_SUCCESS){
+        ESP_LOGW(TAG, "Failed to initialize boot trace");
+    }
+#if CONFIG_FLIGHT_RECORDER
+    //Before the rails record their first events
+    FLIGHT_REC_InitModule();
+#endif
+
+    //The rails are ready when this returns, the bootloader already holds them at their inactive level
+    if(INIT_GRAPH_InitModule() != INIT_GRAPH_STATUS_SUCCESS ||
+       INIT_GRAPH_Start(init_table, MAIN_INIT_MAX_ID, MAIN_INIT_WORKERS) != INIT_GRAPH_STATUS_SUCCESS){
+        ESP_LOGE(TAG, "Failed to initialize critical modules");
+    }
+    BOOT_TRACE_Mark("rails");
+
+#if CONFIG_LOG_DEFERRED
+    //Start deferred log drain task (logs are only stored in RAM until then)
+    if(esp_log_deferred_init() != ESP_OK){
+        printf("Failed to start deferred log task\n");
+    }
+#endif
+
     if(pdTRUE != xTaskCreate(tMainTask,
                              "Main task",
-                             2048,
+                             CONFIG_APP_MAIN_TASK_STACK_SIZE,
                              NULL,
                              4,
                              &main_task_handle)){
@@ -103,6 +466,11 @@ void app_main(void){
         ESP_LOGE(TAG, "Failed to create Main taks");
         while(1);//Stall here until the end of time...
     }
+
+#if !CONFIG_FAST_BOOT
+    //Sequential boot, app_main returns once every module is initialized
+    INIT_GRAPH_Wait(portMAX_DELAY);
+#endif
 }
 
 /******************************************************************************
@@ -0,0 +1,622 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "mbedtls/sha256.h"
+
+#include "deltaOta.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define DELTA_OTA_SHA256_SIZE           (32)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define DELTA_OTA_WINDOW_MASK           ((1U << delta_header.window_bits) - 1)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef enum DELTA_OTA_State_e{
+    DELTA_OTA_STATE_HEADER,
+    DELTA_OTA_STATE_RECORD,
+    DELTA_OTA_STATE_DIFF,
+    DELTA_OTA_STATE_EXTRA,
+    DELTA_OTA_STATE_DONE,
+}DELTA_OTA_State_t;
+
+//Next field of the LZSS bit stream
+typedef enum DELTA_OTA_Lzss_State_e{
+    DELTA_OTA_LZSS_TAG,
+    DELTA_OTA_LZSS_LITERAL,
+    DELTA_OTA_LZSS_INDEX,
+    DELTA_OTA_LZSS_COUNT,
+}DELTA_OTA_Lzss_State_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static void DELTA_OTA_Cleanup(void);
+static bool DELTA_OTA_Flush(void);
+static bool DELTA_OTA_Output(uint8_t byte);
+static bool DELTA_OTA_EndRecord(void);
+static bool DELTA_OTA_Apply(uint8_t byte);
+static bool DELTA_OTA_Inflate(uint8_t byte);
+static bool DELTA_OTA_StartImage(void);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const esp_partition_t *pSource = NULL;
+static const esp_partition_t *pTarget = NULL;
+static esp_ota_handle_t ota_handle = 0;
+static bool ota_begun = false;
+
+static const uint8_t *pSourceImage = NULL;
+static esp_partition_mmap_handle_t source_map_handle;
+static bool source_mapped = false;
+
+static bool update_running = false;
+static DELTA_OTA_State_t delta_state = DELTA_OTA_STATE_HEADER;
+static DELTA_OTA_Header_t delta_header;
+static DELTA_OTA_Record_t delta_record;
+static size_t field_len = 0;                //Bytes of the header or record received
+static uint32_t field_remaining = 0;        //Diff or extra bytes left in the record
+static uint32_t source_pos = 0;
+static uint32_t patch_bytes = 0;
+static uint32_t image_bytes = 0;
+
+//The image is hashed and written one chunk at a time
+static uint8_t chunk[DELTA_OTA_CHUNK_SIZE];
+static size_t chunk_len = 0;
+static mbedtls_sha256_context image_sha;
+
+static DELTA_OTA_Lzss_State_t lzss_state = DELTA_OTA_LZSS_TAG;
+static uint8_t lzss_window[1 << DELTA_OTA_MAX_WINDOW_BITS];
+static uint16_t lzss_window_pos = 0;
+static uint16_t lzss_value = 0;
+static uint8_t lzss_bits = 0;               //Bits of the current field received
+static uint16_t lzss_offset = 0;
+
+static SemaphoreHandle_t delta_mutex_handle = NULL;
+
+static const char * TAG = "DELTA_OTA";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static void DELTA_OTA_Cleanup(void){
+
+    if(ota_begun){
+        esp_ota_abort(ota_handle);
+        ota_begun = false;
+    }
+    if(source_mapped){
+        esp_partition_munmap(source_map_handle);
+        source_mapped = false;
+        pSourceImage = NULL;
+    }
+    mbedtls_sha256_free(&image_sha);
+    update_running = false;
+}
+
+static bool DELTA_OTA_Flush(void){
+
+    if(chunk_len == 0){
+        return true;
+    }
+
+    mbedtls_sha256_update(&image_sha, chunk, chunk_len);
+    if(esp_ota_write_with_offset(ota_handle, chunk, chunk_len, image_bytes - chunk_len) != ESP_OK){
+        ESP_LOGE(TAG, "Failed to write image at %lu", (unsigned long)(image_bytes - chunk_len));
+        return false;
+    }
+    chunk_len = 0;
+
+    return true;
+}
+
+static bool DELTA_OTA_Output(uint8_t byte){
+
+    chunk[chunk_len++] = byte;
+    image_bytes++;
+
+    if(chunk_len == DELTA_OTA_CHUNK_SIZE){
+        return DELTA_OTA_Flush();
+    }
+
+    return true;
+}
+
+static bool DELTA_OTA_EndRecord(void){
+
+    int64_t next_pos = (int64_t)source_pos + delta_record.seek;
+    if(next_pos < 0 || next_pos > delta_header.source_size){
+        ESP_LOGE(TAG, "Seek out of the source image");
+        return false;
+    }
+    source_pos = (uint32_t)next_pos;
+
+    if(image_bytes == delta_header.target_size){
+        delta_state = DELTA_OTA_STATE_DONE;
+        return DELTA_OTA_Flush();
+    }
+
+    delta_state = DELTA_OTA_STATE_RECORD;
+    return true;
+}
+
+//Runs the decoded patch body
+static bool DELTA_OTA_Apply(uint8_t byte){
+
+    switch(delta_state){
+
+        case DELTA_OTA_STATE_RECORD:
+            ((uint8_t *)&delta_record)[field_len++] = byte;
+            if(field_len < sizeof(delta_record)){
+                return true;
+            }
+            field_len = 0;
+
+            if((uint64_t)delta_record.diff_len + delta_record.extra_len > delta_header.target_size - image_bytes ||
+               delta_record.diff_len > delta_header.source_size - source_pos){
+                ESP_LOGE(TAG, "Record out of the images");
+                return false;
+            }
+
+            if(delta_record.diff_len != 0){
+                delta_state = DELTA_OTA_STATE_DIFF;
+                field_remaining = delta_record.diff_len;
+            }
+            else if(delta_record.extra_len != 0){
+                delta_state = DELTA_OTA_STATE_EXTRA;
+                field_remaining = delta_record.extra_len;
+            }
+            else{
+                return DELTA_OTA_EndRecord();
+            }
+            return true;
+
+        case DELTA_OTA_STATE_DIFF:
+            if(!DELTA_OTA_Output(pSourceImage[source_pos++] + byte)){
+                return false;
+            }
+            if(--field_remaining != 0){
+                return true;
+            }
+            if(delta_record.extra_len != 0){
+                delta_state = DELTA_OTA_STATE_EXTRA;
+                field_remaining = delta_record.extra_len;
+                return true;
+            }
+            return DELTA_OTA_EndRecord();
+
+        case DELTA_OTA_STATE_EXTRA:
+            if(!DELTA_OTA_Output(byte)){
+                return false;
+            }
+            if(--field_remaining != 0){
+                return true;
+            }
+            return DELTA_OTA_EndRecord();
+
+        default:
+            ESP_LOGE(TAG, "Patch longer than the image");
+            return false;
+    }
+}
+
+//Decodes heatshrink's LZSS bit stream, most significant bit first
+static bool DELTA_OTA_Inflate(uint8_t byte){
+
+    for(uint8_t mask = 0x80; mask != 0; mask >>= 1){
+        uint8_t bit = (byte & mask) ? 1 : 0;
+
+        //The last byte is padded with zero bits
+        if(delta_state == DELTA_OTA_STATE_DONE){
+            return true;
+        }
+
+        if(lzss_state == DELTA_OTA_LZSS_TAG){
+            lzss_state = bit ? DELTA_OTA_LZSS_LITERAL : DELTA_OTA_LZSS_INDEX;
+            lzss_value = 0;
+            lzss_bits = 0;
+            continue;
+        }
+
+        lzss_value = (lzss_value << 1) | bit;
+        lzss_bits++;
+
+        switch(lzss_state){
+
+            case DELTA_OTA_LZSS_LITERAL:
+                if(lzss_bits < 8){
+                    continue;
+                }
+                lzss_window[lzss_window_pos++ & DELTA_OTA_WINDOW_MASK] = (uint8_t)lzss_value;
+                if(!DELTA_OTA_Apply((uint8_t)lzss_value)){
+                    return false;
+                }
+                lzss_state = DELTA_OTA_LZSS_TAG;
+                break;
+
+            case DELTA_OTA_LZSS_INDEX:
+                if(lzss_bits < delta_header.window_bits){
+                    continue;
+                }
+                lzss_offset = lzss_value + 1;
+                lzss_value = 0;
+                lzss_bits = 0;
+                lzss_state = DELTA_OTA_LZSS_COUNT;
+                break;
+
+            default:
+                if(lzss_bits < delta_header.lookahead_bits){
+                    continue;
+                }
+                //Byte by byte, a copy may overlap the bytes it produces
+                for(uint16_t i=0; i<=lzss_value; i++){
+                    uint8_t out = lzss_window[(uint16_t)(lzss_window_pos - lzss_offset) & DELTA_OTA_WINDOW_MASK];
+                    lzss_window[lzss_window_pos++ & DELTA_OTA_WINDOW_MASK] = out;
+                    if(!DELTA_OTA_Apply(out)){
+                        return false;
+                    }
+                }
+                lzss_state = DELTA_OTA_LZSS_TAG;
+                break;
+        }
+    }
+
+    return true;
+}
+
+//Checks the header and the running image, then prepares the OTA partition
+static bool DELTA_OTA_StartImage(void){
+
+    if(delta_header.magic != DELTA_OTA_MAGIC || delta_header.version != DELTA_OTA_VERSION){
+        ESP_LOGE(TAG, "Not a version %d patch", DELTA_OTA_VERSION);
+        return false;
+    }
+    if(delta_header.window_bits != 0 &&
+       (delta_header.window_bits < DELTA_OTA_MIN_WINDOW_BITS || delta_header.window_bits > DELTA_OTA_MAX_WINDOW_BITS ||
+        delta_header.lookahead_bits == 0 || delta_header.lookahead_bits >= delta_header.window_bits)){
+        ESP_LOGE(TAG, "Unsupported window %d, lookahead %d", delta_header.window_bits, delta_header.lookahead_bits);
+        return false;
+    }
+    if(delta_header.source_size > pSource->size || delta_header.target_size == 0 || delta_header.target_size > pTarget->size){
+        ESP_LOGE(TAG, "Image sizes do not fit the partitions");
+        return false;
+    }
+
+    //The patch only applies to the exact image it was made from
+    uint8_t source_sha256[DELTA_OTA_SHA256_SIZE];
+    if(delta_header.source_size != 0){
+        const void *pMapped = NULL;
+        if(esp_partition_mmap(pSource, 0, delta_header.source_size, ESP_PARTITION_MMAP_DATA, &pMapped, &source_map_handle) != ESP_OK){
+            ESP_LOGE(TAG, "Failed to map partition %s", pSource->label);
+            return false;
+        }
+        source_mapped = true;
+        pSourceImage = pMapped;
+    }
+    mbedtls_sha256(pSourceImage, delta_header.source_size, source_sha256, 0);
+    if(memcmp(source_sha256, delta_header.source_sha256, DELTA_OTA_SHA256_SIZE) != 0){
+        ESP_LOGE(TAG, "Patch made for another image than the one in %s", pSource->label);
+        return false;
+    }
+
+    if(esp_ota_begin(pTarget, delta_header.target_size, &ota_handle) != ESP_OK){
+        ESP_LOGE(TAG, "Failed to begin OTA on %s", pTarget->label);
+        return false;
+    }
+    ota_begun = true;
+
+    ESP_LOGI(TAG, "Patching %lu bytes from %s into %lu bytes in %s", (unsigned long)delta_header.source_size, pSource->label,
+             (unsigned long)delta_header.target_size, pTarget->label);
+
+    delta_state = DELTA_OTA_STATE_RECORD;
+    return true;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Delta OTA initialization
+*
+*   This function is used to initialize the delta OTA module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_InitModule(void){
+
+    //Create mutex, once
+    if(delta_mutex_handle == NULL){
+        delta_mutex_handle = xSemaphoreCreateMutex();
+        if(delta_mutex_handle == NULL){
+            ESP_LOGE(TAG, "Failed to create mutex");
+            return DELTA_OTA_STATUS_FAIL;
+        }
+    }
+
+    update_running = false;
+    ota_begun = false;
+    source_mapped = false;
+
+    return DELTA_OTA_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Delta OTA begin
+*
+*   This function is used to start an update from a patch against the
+*   running image. The new image is written to the next OTA partition.
+*
+*   Preconditions: DELTA_OTA_InitModule called, no update running.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_Begin(void){
+
+    if(delta_mutex_handle == NULL){
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(delta_mutex_handle, portMAX_DELAY);
+
+    if(update_running){
+        xSemaphoreGive(delta_mutex_handle);
+        ESP_LOGW(TAG, "Update already running");
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    pSource = esp_ota_get_running_partition();
+    pTarget = esp_ota_get_next_update_partition(NULL);
+    if(pSource == NULL || pTarget == NULL){
+        xSemaphoreGive(delta_mutex_handle);
+        ESP_LOGE(TAG, "No OTA partition to update");
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    delta_state = DELTA_OTA_STATE_HEADER;
+    field_len = 0;
+    field_remaining = 0;
+    source_pos = 0;
+    patch_bytes = 0;
+    image_bytes = 0;
+    chunk_len = 0;
+    memset(&delta_header, 0, sizeof(delta_header));
+
+    lzss_state = DELTA_OTA_LZSS_TAG;
+    lzss_window_pos = 0;
+    memset(lzss_window, 0, sizeof(lzss_window));
+
+    mbedtls_sha256_init(&image_sha);
+    mbedtls_sha256_starts(&image_sha, 0);
+    update_running = true;
+
+    xSemaphoreGive(delta_mutex_handle);
+
+    return DELTA_OTA_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Delta OTA write
+*
+*   This function is used by the transport to feed the next patch bytes, in
+*   pieces of any size. Once the header is in, the source hash is checked
+*   on the mapped running partition and the OTA partition is erased. The
+*   body is then decoded on the fly, every full chunk of the new image is
+*   written with esp_ota_write_with_offset. RAM use does not depend on the
+*   image or patch size.
+*
+*   Preconditions: DELTA_OTA_Begin called.
+*
+*   Side Effects: A failure aborts the update.
+*
+*   \param[in]  pData               Patch bytes
+*   \param[in]  len                 Number of bytes
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_Write(const uint8_t *pData, size_t len){
+
+    if(delta_mutex_handle == NULL || (pData == NULL && len != 0)){
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(delta_mutex_handle, portMAX_DELAY);
+
+    if(!update_running){
+        xSemaphoreGive(delta_mutex_handle);
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    for(size_t i=0; i<len; i++){
+        bool ok;
+
+        if(delta_state == DELTA_OTA_STATE_HEADER){
+            ((uint8_t *)&delta_header)[field_len++] = pData[i];
+            ok = true;
+            if(field_len == sizeof(delta_header)){
+                field_len = 0;
+                ok = DELTA_OTA_StartImage();
+            }
+        }
+        else if(delta_header.window_bits != 0){
+            ok = DELTA_OTA_Inflate(pData[i]);
+        }
+        else{
+            ok = DELTA_OTA_Apply(pData[i]);
+        }
+
+        if(!ok){
+            DELTA_OTA_Cleanup();
+            xSemaphoreGive(delta_mutex_handle);
+            ESP_LOGE(TAG, "Update aborted at patch byte %lu", (unsigned long)(patch_bytes + i));
+            return DELTA_OTA_STATUS_FAIL;
+        }
+    }
+    patch_bytes += len;
+
+    xSemaphoreGive(delta_mutex_handle);
+
+    return DELTA_OTA_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Delta OTA end
+*
+*   This function is used once the whole patch was written. The new image
+*   hash is checked against the patch header, then the image is validated
+*   and set as the boot partition.
+*
+*   Preconditions: DELTA_OTA_Begin called.
+*
+*   Side Effects: The new image runs after the next restart.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_End(void){
+
+    if(delta_mutex_handle == NULL){
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(delta_mutex_handle, portMAX_DELAY);
+
+    if(!update_running){
+        xSemaphoreGive(delta_mutex_handle);
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    if(delta_state != DELTA_OTA_STATE_DONE){
+        ESP_LOGE(TAG, "Patch incomplete, %lu of %lu image bytes", (unsigned long)image_bytes, (unsigned long)delta_header.target_size);
+        DELTA_OTA_Cleanup();
+        xSemaphoreGive(delta_mutex_handle);
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    uint8_t image_sha256[DELTA_OTA_SHA256_SIZE];
+    mbedtls_sha256_finish(&image_sha, image_sha256);
+    if(memcmp(image_sha256, delta_header.target_sha256, DELTA_OTA_SHA256_SIZE) != 0){
+        ESP_LOGE(TAG, "New image hash mismatch");
+        DELTA_OTA_Cleanup();
+        xSemaphoreGive(delta_mutex_handle);
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    //esp_ota_end releases the handle even when the image is invalid
+    ota_begun = false;
+    esp_err_t err = esp_ota_end(ota_handle);
+    if(err == ESP_OK){
+        err = esp_ota_set_boot_partition(pTarget);
+    }
+    DELTA_OTA_Cleanup();
+
+    xSemaphoreGive(delta_mutex_handle);
+
+    if(err != ESP_OK){
+        ESP_LOGE(TAG, "Failed to validate and select the new image (%s)", esp_err_to_name(err));
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Update written to %s from a %lu byte patch", pTarget->label, (unsigned long)patch_bytes);
+
+    return DELTA_OTA_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Delta OTA abort
+*
+*   This function is used to give up a running update.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_Abort(void){
+
+    if(delta_mutex_handle == NULL){
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(delta_mutex_handle, portMAX_DELAY);
+    if(update_running){
+        DELTA_OTA_Cleanup();
+    }
+    xSemaphoreGive(delta_mutex_handle);
+
+    return DELTA_OTA_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Delta OTA progress
+*
+*   This function is used to read the progress of the update.
+*
+*   Preconditions: DELTA_OTA_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pProgress           Pointer to store the progress
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_GetProgress(DELTA_OTA_Progress_t *pProgress){
+
+    if(delta_mutex_handle == NULL || pProgress == NULL){
+        return DELTA_OTA_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(delta_mutex_handle, portMAX_DELAY);
+    pProgress->running = update_running;
+    pProgress->patch_bytes = patch_bytes;
+    pProgress->image_bytes = image_bytes;
+    pProgress->image_size = (delta_state == DELTA_OTA_STATE_HEADER) ? 0 : delta_header.target_size;
+    xSemaphoreGive(delta_mutex_handle);
+
+    return DELTA_OTA_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
@@ -0,0 +1,182 @@
+#ifndef _DELTA_OTA_H
+#define _DELTA_OTA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define DELTA_OTA_MAGIC                     (0x41544F44)    //"DOTA"
+#define DELTA_OTA_VERSION                   (1)
+
+//The image is rebuilt in chunks of this size, one flash sector per write
+#define DELTA_OTA_CHUNK_SIZE                (4096)
+//Largest LZSS window a patch may use, the window is a static buffer
+#define DELTA_OTA_MAX_WINDOW_BITS           (11)
+#define DELTA_OTA_MIN_WINDOW_BITS           (4)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+/*
+ * Patch layout, little endian: a header followed by the patch body. The body
+ * is a sequence of records, each one followed by diff_len diff bytes and
+ * extra_len extra bytes:
+ *
+ *  - diff bytes are added to the source bytes at the source position,
+ *  - extra bytes are copied as they are,
+ *  - the source position then moves by seek.
+ *
+ * With window_bits set, the body is compressed with heatshrink's LZSS
+ * format using this window and lookahead.
+ */
+typedef struct __attribute__((packed)) DELTA_OTA_Header_s{
+    uint32_t magic;                         //DELTA_OTA_MAGIC
+    uint8_t version;                        //DELTA_OTA_VERSION
+    uint8_t window_bits;                    //0 for an uncompressed body
+    uint8_t lookahead_bits;
+    uint8_t reserved;
+    uint32_t source_size;                   //Bytes of the running image the patch applies to
+    uint32_t target_size;                   //Bytes of the new image
+    uint8_t source_sha256[32];
+    uint8_t target_sha256[32];
+}DELTA_OTA_Header_t;
+
+typedef struct __attribute__((packed)) DELTA_OTA_Record_s{
+    uint32_t diff_len;
+    uint32_t extra_len;
+    int32_t seek;
+}DELTA_OTA_Record_t;
+
+typedef struct DELTA_OTA_Progress_s{
+    bool running;                           //Between DELTA_OTA_Begin and DELTA_OTA_End
+    uint32_t patch_bytes;                   //Patch bytes received
+    uint32_t image_bytes;                   //Image bytes rebuilt
+    uint32_t image_size;                    //Size of the new image, 0 until the header is in
+}DELTA_OTA_Progress_t;
+
+typedef enum DELTA_OTA_Ret_e{
+    DELTA_OTA_STATUS_FAIL,
+    DELTA_OTA_STATUS_SUCCESS,
+}DELTA_OTA_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if (DELTA_OTA_MAX_WINDOW_BITS > 15) || (DELTA_OTA_MIN_WINDOW_BITS > DELTA_OTA_MAX_WINDOW_BITS)
+#error "Invalid delta OTA window size"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Delta OTA initialization
+*
+*   This function is used to initialize the delta OTA module.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Delta OTA begin
+*
+*   This function is used to start an update from a patch against the
+*   running image. The new image is written to the next OTA partition.
+*
+*   Preconditions: DELTA_OTA_InitModule called, no update running.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_Begin(void);
+
+/***************************************************************************//*!
+*  \brief Delta OTA write
+*
+*   This function is used by the transport to feed the next patch bytes, in
+*   pieces of any size. Once the header is in, the source hash is checked
+*   on the mapped running partition and the OTA partition is erased. The
+*   body is then decoded on the fly, every full chunk of the new image is
+*   written with esp_ota_write_with_offset. RAM use does not depend on the
+*   image or patch size.
+*
+*   Preconditions: DELTA_OTA_Begin called.
+*
+*   Side Effects: A failure aborts the update.
+*
+*   \param[in]  pData               Patch bytes
+*   \param[in]  len                 Number of bytes
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_Write(const uint8_t *pData, size_t len);
+
+/***************************************************************************//*!
+*  \brief Delta OTA end
+*
+*   This function is used once the whole patch was written. The new image
+*   hash is checked against the patch header, then the image is validated
+*   and set as the boot partition.
+*
+*   Preconditions: DELTA_OTA_Begin called.
+*
+*   Side Effects: The new image runs after the next restart.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_End(void);
+
+/***************************************************************************//*!
+*  \brief Delta OTA abort
+*
+*   This function is used to give up a running update.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_Abort(void);
+
+/***************************************************************************//*!
+*  \brief Delta OTA progress
+*
+*   This function is used to read the progress of the update.
+*
+*   Preconditions: DELTA_OTA_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pProgress           Pointer to store the progress
+*
+*   \return     operation status
+*
+*******************************************************************************/
+DELTA_OTA_Ret_t DELTA_OTA_GetProgress(DELTA_OTA_Progress_t *pProgress);
+
+#endif//_DELTA_OTA_H
@@ -0,0 +1,383 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Linux host delta OTA test
+ */
+
+#include <string.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_private/partition_linux.h"
+#include "esp_ota_ops.h"
+#include "mbedtls/sha256.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "deltaOta.h"
+
+#define TEST_SOURCE_SIZE    (40000)
+#define TEST_INSERT_AT      (10000)
+#define TEST_INSERT_LEN     (300)
+#define TEST_SKIP_LEN       (500)
+#define TEST_REPEAT_LEN     (2000)
+#define TEST_TARGET_SIZE    (TEST_SOURCE_SIZE - TEST_SKIP_LEN + TEST_INSERT_LEN + TEST_REPEAT_LEN)
+#define TEST_PATCH_SIZE     (64 * 1024)
+
+#define TEST_WINDOW_BITS    (8)
+#define TEST_LOOKAHEAD_BITS (4)
+
+typedef struct {
+    uint8_t data[TEST_PATCH_SIZE];
+    size_t len;
+    uint8_t bits;                           /* bits used in the last byte */
+} test_buf_t;
+
+static uint8_t source[TEST_SOURCE_SIZE];
+static uint8_t target[TEST_TARGET_SIZE];
+static test_buf_t body;
+static test_buf_t patch;
+
+static const esp_partition_t *ota_partition;
+static const esp_partition_t *boot_partition;
+static bool ota_open;
+static bool ota_aborted;
+static size_t largest_write;
+
+/* The OTA operations used by the module, on top of the emulated partitions */
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, NULL);
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    return esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, NULL);
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    TEST_ASSERT_FALSE(ota_open);
+    size_t erase_size = (image_size + partition->erase_size - 1) / partition->erase_size * partition->erase_size;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_erase_range(partition, 0, erase_size));
+    ota_partition = partition;
+    ota_open = true;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write_with_offset(esp_ota_handle_t handle, const void *data, size_t size, uint32_t offset)
+{
+    TEST_ASSERT_TRUE(ota_open);
+    largest_write = (size > largest_write) ? size : largest_write;
+    return esp_partition_write(ota_partition, offset, data, size);
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    TEST_ASSERT_TRUE(ota_open);
+    ota_open = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    TEST_ASSERT_TRUE(ota_open);
+    ota_open = false;
+    ota_aborted = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    boot_partition = partition;
+    return ESP_OK;
+}
+
+static void buf_put(test_buf_t *buf, const void *data, size_t len)
+{
+    TEST_ASSERT_LESS_OR_EQUAL(sizeof(buf->data), buf->len + len);
+    memcpy(&buf->data[buf->len], data, len);
+    buf->len += len;
+}
+
+/* Most significant bit first, like heatshrink */
+static void buf_put_bits(test_buf_t *buf, uint16_t value, uint8_t count)
+{
+    for (int i = count - 1; i >= 0; i--) {
+        if (buf->bits == 0) {
+            TEST_ASSERT_LESS_THAN(sizeof(buf->data), buf->len);
+            buf->data[buf->len++] = 0;
+        }
+        if (value & (1 << i)) {
+            buf->data[buf->len - 1] |= 0x80 >> buf->bits;
+        }
+        buf->bits = (buf->bits + 1) % 8;
+    }
+}
+
+/* Greedy LZSS in heatshrink's format */
+static void compress(const test_buf_t *in, test_buf_t *out)
+{
+    const size_t window = 1 << TEST_WINDOW_BITS;
+    const size_t lookahead = 1 << TEST_LOOKAHEAD_BITS;
+
+    for (size_t pos = 0; pos < in->len; ) {
+        size_t best_len = 0;
+        size_t best_offset = 0;
+        for (size_t offset = 1; offset <= window && offset <= pos; offset++) {
+            size_t len = 0;
+            while (len < lookahead && pos + len < in->len && in->data[pos + len - offset] == in->data[pos + len]) {
+                len++;
+            }
+            if (len > best_len) {
+                best_len = len;
+                best_offset = offset;
+            }
+        }
+
+        if (best_len * 9 > 1 + TEST_WINDOW_BITS + TEST_LOOKAHEAD_BITS) {
+            buf_put_bits(out, 0, 1);
+            buf_put_bits(out, best_offset - 1, TEST_WINDOW_BITS);
+            buf_put_bits(out, best_len - 1, TEST_LOOKAHEAD_BITS);
+            pos += best_len;
+        } else {
+            buf_put_bits(out, 1, 1);
+            buf_put_bits(out, in->data[pos], 8);
+            pos++;
+        }
+    }
+}
+
+static void add_record(uint32_t *src_pos, uint32_t *dst_pos, uint32_t diff_len, uint32_t extra_len, int32_t seek)
+{
+    DELTA_OTA_Record_t record = {
+        .diff_len = diff_len,
+        .extra_len = extra_len,
+        .seek = seek,
+    };
+    buf_put(&body, &record, sizeof(record));
+
+    for (uint32_t i = 0; i < diff_len; i++) {
+        uint8_t diff = target[*dst_pos + i] - source[*src_pos + i];
+        buf_put(&body, &diff, 1);
+    }
+    buf_put(&body, &target[*dst_pos + diff_len], extra_len);
+
+    *src_pos += diff_len + seek;
+    *dst_pos += diff_len + extra_len;
+}
+
+/* The patch the server would make between source and target */
+static void make_patch(bool compressed)
+{
+    uint32_t src_pos = 0;
+    uint32_t dst_pos = 0;
+
+    memset(&body, 0, sizeof(body));
+    add_record(&src_pos, &dst_pos, TEST_INSERT_AT, TEST_INSERT_LEN, TEST_SKIP_LEN);
+    add_record(&src_pos, &dst_pos, TEST_SOURCE_SIZE - TEST_INSERT_AT - TEST_SKIP_LEN, 0, -TEST_SOURCE_SIZE);
+    add_record(&src_pos, &dst_pos, TEST_REPEAT_LEN, 0, 0);
+    TEST_ASSERT_EQUAL_UINT32(TEST_TARGET_SIZE, dst_pos);
+
+    DELTA_OTA_Header_t header = {
+        .magic = DELTA_OTA_MAGIC,
+        .version = DELTA_OTA_VERSION,
+        .window_bits = compressed ? TEST_WINDOW_BITS : 0,
+        .lookahead_bits = compressed ? TEST_LOOKAHEAD_BITS : 0,
+        .source_size = TEST_SOURCE_SIZE,
+        .target_size = TEST_TARGET_SIZE,
+    };
+    mbedtls_sha256(source, sizeof(source), header.source_sha256, 0);
+    mbedtls_sha256(target, sizeof(target), header.target_sha256, 0);
+
+    memset(&patch, 0, sizeof(patch));
+    buf_put(&patch, &header, sizeof(header));
+    if (compressed) {
+        compress(&body, &patch);
+    } else {
+        buf_put(&patch, body.data, body.len);
+    }
+}
+
+/* Feed the patch in pieces of the given size, as the transport would */
+static DELTA_OTA_Ret_t write_patch(size_t len, size_t piece)
+{
+    for (size_t pos = 0; pos < len; pos += piece) {
+        size_t n = (len - pos < piece) ? (len - pos) : piece;
+        if (DELTA_OTA_Write(&patch.data[pos], n) != DELTA_OTA_STATUS_SUCCESS) {
+            return DELTA_OTA_STATUS_FAIL;
+        }
+    }
+    return DELTA_OTA_STATUS_SUCCESS;
+}
+
+static void check_new_image(void)
+{
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    const void *image;
+    esp_partition_mmap_handle_t handle;
+    uint8_t expected_sha256[32];
+    uint8_t image_sha256[32];
+
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_mmap(partition, 0, TEST_TARGET_SIZE, ESP_PARTITION_MMAP_DATA, &image, &handle));
+    mbedtls_sha256(image, TEST_TARGET_SIZE, image_sha256, 0);
+    esp_partition_munmap(handle);
+
+    mbedtls_sha256(target, sizeof(target), expected_sha256, 0);
+    TEST_ASSERT_EQUAL_MEMORY(expected_sha256, image_sha256, sizeof(image_sha256));
+    TEST_ASSERT_EQUAL_PTR(partition, boot_partition);
+    TEST_ASSERT_LESS_OR_EQUAL(DELTA_OTA_CHUNK_SIZE, largest_write);
+}
+
+TEST_GROUP(delta_ota);
+
+TEST_SETUP(delta_ota)
+{
+    // fresh erased flash file for every test
+    esp_partition_file_munmap();
+    esp_partition_file_mmap_ctrl_t *p_file_mmap_ctrl_input = esp_partition_get_file_mmap_ctrl_input();
+    memset(p_file_mmap_ctrl_input, 0, sizeof(*p_file_mmap_ctrl_input));
+    p_file_mmap_ctrl_input->remove_dump = true;
+
+    // running image and a new version: patched words, an insertion, a removal and a repeated block
+    for (uint32_t i = 0; i < TEST_SOURCE_SIZE; i++) {
+        source[i] = (uint8_t)((i * 7) ^ (i >> 8));
+    }
+    memcpy(target, source, TEST_INSERT_AT);
+    for (uint32_t i = 0; i < TEST_INSERT_AT; i += 1000) {
+        target[i] += 3;
+    }
+    for (uint32_t i = 0; i < TEST_INSERT_LEN; i++) {
+        target[TEST_INSERT_AT + i] = (uint8_t)(i * 13);
+    }
+    memcpy(&target[TEST_INSERT_AT + TEST_INSERT_LEN], &source[TEST_INSERT_AT + TEST_SKIP_LEN], TEST_SOURCE_SIZE - TEST_INSERT_AT - TEST_SKIP_LEN);
+    memcpy(&target[TEST_TARGET_SIZE - TEST_REPEAT_LEN], source, TEST_REPEAT_LEN);
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    TEST_ASSERT_NOT_NULL(running);
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_erase_range(running, 0, running->size));
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(running, 0, source, sizeof(source)));
+
+    boot_partition = NULL;
+    ota_open = false;
+    ota_aborted = false;
+    largest_write = 0;
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_InitModule());
+}
+
+TEST_TEAR_DOWN(delta_ota)
+{
+    DELTA_OTA_Abort();
+    esp_partition_file_munmap();
+}
+
+TEST(delta_ota, test_uncompressed_patch)
+{
+    make_patch(false);
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_Begin());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, write_patch(patch.len, 1000));
+
+    DELTA_OTA_Progress_t progress;
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_GetProgress(&progress));
+    TEST_ASSERT_TRUE(progress.running);
+    TEST_ASSERT_EQUAL_UINT32(patch.len, progress.patch_bytes);
+    TEST_ASSERT_EQUAL_UINT32(TEST_TARGET_SIZE, progress.image_bytes);
+    TEST_ASSERT_EQUAL_UINT32(TEST_TARGET_SIZE, progress.image_size);
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_End());
+    check_new_image();
+    TEST_ASSERT_FALSE(ota_open);
+}
+
+TEST(delta_ota, test_compressed_patch)
+{
+    make_patch(true);
+    // diff bytes are mostly zeros, only the inserted bytes are left
+    TEST_ASSERT_LESS_THAN(TEST_TARGET_SIZE / 8, patch.len);
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_Begin());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, write_patch(patch.len, 1));
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_End());
+    check_new_image();
+}
+
+TEST(delta_ota, test_other_source_image)
+{
+    make_patch(true);
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    uint8_t byte = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, esp_partition_write(running, TEST_SOURCE_SIZE - 1, &byte, 1));
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_Begin());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_FAIL, write_patch(patch.len, 512));
+    TEST_ASSERT_FALSE(ota_open);
+    TEST_ASSERT_NULL(boot_partition);
+
+    // the update is over, a new one can start
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_FAIL, DELTA_OTA_End());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_Begin());
+}
+
+TEST(delta_ota, test_corrupted_patch)
+{
+    make_patch(false);
+    patch.data[sizeof(DELTA_OTA_Header_t) + sizeof(DELTA_OTA_Record_t) + 1]++;
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_Begin());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, write_patch(patch.len, 4096));
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_FAIL, DELTA_OTA_End());
+    TEST_ASSERT_TRUE(ota_aborted);
+    TEST_ASSERT_NULL(boot_partition);
+}
+
+TEST(delta_ota, test_truncated_patch)
+{
+    make_patch(true);
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_Begin());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_FAIL, DELTA_OTA_Begin());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, write_patch(patch.len - 10, 100));
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_FAIL, DELTA_OTA_End());
+    TEST_ASSERT_TRUE(ota_aborted);
+    TEST_ASSERT_NULL(boot_partition);
+}
+
+TEST(delta_ota, test_record_out_of_source)
+{
+    make_patch(false);
+    DELTA_OTA_Record_t *record = (DELTA_OTA_Record_t *)&patch.data[sizeof(DELTA_OTA_Header_t)];
+    record->seek = TEST_SOURCE_SIZE;
+
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_Begin());
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_FAIL, write_patch(patch.len, 4096));
+    TEST_ASSERT_TRUE(ota_aborted);
+
+    DELTA_OTA_Progress_t progress;
+    TEST_ASSERT_EQUAL(DELTA_OTA_STATUS_SUCCESS, DELTA_OTA_GetProgress(&progress));
+    TEST_ASSERT_FALSE(progress.running);
+}
+
+TEST_GROUP_RUNNER(delta_ota)
+{
+    RUN_TEST_CASE(delta_ota, test_uncompressed_patch);
+    RUN_TEST_CASE(delta_ota, test_compressed_patch);
+    RUN_TEST_CASE(delta_ota, test_other_source_image);
+    RUN_TEST_CASE(delta_ota, test_corrupted_patch);
+    RUN_TEST_CASE(delta_ota, test_truncated_patch);
+    RUN_TEST_CASE(delta_ota, test_record_out_of_source);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(delta_ota);
+}
+
+void app_main(void)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+}
@@ -0,0 +1,567 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+
+#include "fuelGauge.h"
+#include "stackMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define FUEL_GAUGE_TASK_STACK           (CONFIG_FUEL_GAUGE_TASK_STACK_SIZE)
+#define FUEL_GAUGE_TASK_PRIORITY        (3)
+#define FUEL_GAUGE_I2C_SPEED_HZ         (CONFIG_FUEL_GAUGE_I2C_SPEED_HZ)
+//A burst takes well under 1ms at 100kHz, longer means no callback is coming
+#define FUEL_GAUGE_TIMEOUT_MS           (50)
+
+//Task notification bits
+#define FUEL_GAUGE_NOTIFY_POLL          (1 << 0)        //Reads queued
+#define FUEL_GAUGE_NOTIFY_DONE          (1 << 1)        //Burst answered, result in fuel_gauge_done
+
+//Burst tags, sequence number and device of a burst, never FUEL_GAUGE_TAG_NONE
+#define FUEL_GAUGE_TAG_NONE             (0)
+#define FUEL_GAUGE_TAG_ERROR            (0x80)          //Burst not acknowledged
+#define FUEL_GAUGE_TAG_LATE             (0x40)          //Burst given up on, its answer only ends the drain
+#define FUEL_GAUGE_TAG_DEVICE_MASK      (0x3F)
+
+//Highest register read plus one, of both devices
+#define FUEL_GAUGE_REG_MAP_SIZE         (32)
+
+//MAX17048 registers, 16 bits, MSB first
+#define MAX17048_VCELL_REG              (0x02)      //78.125uV per LSB
+#define MAX17048_SOC_REG                (0x04)      //1/256 % per LSB
+#define MAX17048_CRATE_REG              (0x16)      //0.208 %/h per LSB, signed
+
+//BQ24295 registers, 8 bits
+#define BQ24295_STATUS_REG              (0x08)
+#define BQ24295_FAULT_REG               (0x09)
+#define BQ24295_STATUS_CHRG_SHIFT       (4)
+#define BQ24295_STATUS_CHRG_MASK        (0x03)
+#define BQ24295_STATUS_PG_BIT           (1 << 2)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define FUEL_GAUGE_REG16(regs, reg)     ((uint16_t)(((regs)[reg] << 8) | (regs)[(reg) + 1]))
+#define FUEL_GAUGE_TAG(seq, device)     (((uint32_t)(seq) << 8) | ((device) + 1))
+#define FUEL_GAUGE_TAG_DEVICE(tag)      (((tag) & FUEL_GAUGE_TAG_DEVICE_MASK) - 1)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef enum FUEL_GAUGE_Device_e{
+    FUEL_GAUGE_DEVICE_GAUGE,
+    FUEL_GAUGE_DEVICE_CHARGER,
+
+    FUEL_GAUGE_DEVICE_MAX,
+}FUEL_GAUGE_Device_t;
+
+//Read of size registers from reg, one burst on the bus
+typedef struct FUEL_GAUGE_Transfer_s{
+    uint8_t device;                         //FUEL_GAUGE_Device_t
+    uint8_t reg;
+    uint8_t size;
+    uint8_t data[FUEL_GAUGE_BURST_MAX];
+}FUEL_GAUGE_Transfer_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static FUEL_GAUGE_Ret_t FUEL_GAUGE_QueueRead(FUEL_GAUGE_Device_t device, uint8_t reg, uint8_t size);
+static bool FUEL_GAUGE_Pop(FUEL_GAUGE_Transfer_t *pTransfer);
+static void FUEL_GAUGE_Decode(void);
+static void FUEL_GAUGE_Complete(const FUEL_GAUGE_Transfer_t *pTransfer, bool success);
+static bool FUEL_GAUGE_TransferDone(i2c_master_dev_handle_t dev, const i2c_master_event_data_t *pEvent, void *pArg);
+static void tFuelGaugeTask(void *pvParameters);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const uint16_t fuel_gauge_addr[FUEL_GAUGE_DEVICE_MAX] = {
+    [FUEL_GAUGE_DEVICE_GAUGE] = FUEL_GAUGE_GAUGE_ADDR,
+    [FUEL_GAUGE_DEVICE_CHARGER] = FUEL_GAUGE_CHARGER_ADDR,
+};
+
+//Reads waiting for the bus, oldest first
+static FUEL_GAUGE_Transfer_t fuel_gauge_queue[FUEL_GAUGE_QUEUE_SIZE];
+static uint8_t fuel_gauge_queue_head = 0;
+static uint8_t fuel_gauge_queue_count = 0;
+
+//Last value read of every register
+static uint8_t fuel_gauge_regs[FUEL_GAUGE_DEVICE_MAX][FUEL_GAUGE_REG_MAP_SIZE];
+static bool fuel_gauge_answered[FUEL_GAUGE_DEVICE_MAX];
+static FUEL_GAUGE_Status_t fuel_gauge_status;
+static FUEL_GAUGE_Stats_t fuel_gauge_stats;
+
+static i2c_master_bus_handle_t fuel_gauge_bus = NULL;
+static i2c_master_dev_handle_t fuel_gauge_devices[FUEL_GAUGE_DEVICE_MAX];
+static TaskHandle_t fuel_gauge_task_handle = NULL;
+//Tag of the burst in flight and of the last burst answered, shared with the I2C ISR
+static uint32_t fuel_gauge_inflight = FUEL_GAUGE_TAG_NONE;
+static uint32_t fuel_gauge_done = FUEL_GAUGE_TAG_NONE;
+static SemaphoreHandle_t fuel_gauge_mutex_handle = NULL;
+
+static const char * TAG = "FUEL_GAUGE";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Fuel gauge queue read
+*
+*   This function is used to queue a register read. The read is merged into
+*   a queued burst of the same device when the burst stays within
+*   FUEL_GAUGE_BURST_MAX registers, the registers in between are read too.
+*
+*   Preconditions: Fuel gauge mutex taken.
+*
+*   Side Effects: None.
+*
+*   \param[in]  device              Device to read
+*   \param[in]  reg                 First register
+*   \param[in]  size                Number of registers
+*
+*   \return     operation status, fail if the queue is full
+*
+*******************************************************************************/
+static FUEL_GAUGE_Ret_t FUEL_GAUGE_QueueRead(FUEL_GAUGE_Device_t device, uint8_t reg, uint8_t size){
+
+    for(uint8_t i=0; i<fuel_gauge_queue_count; i++){
+        FUEL_GAUGE_Transfer_t *pTransfer = &fuel_gauge_queue[(fuel_gauge_queue_head + i) % FUEL_GAUGE_QUEUE_SIZE];
+        if(pTransfer->device != device){
+            continue;
+        }
+
+        uint8_t start = (pTransfer->reg < reg) ? pTransfer->reg : reg;
+        uint8_t end = ((pTransfer->reg + pTransfer->size) > (reg + size)) ? (pTransfer->reg + pTransfer->size) : (reg + size);
+        if((end - start) <= FUEL_GAUGE_BURST_MAX){
+            pTransfer->reg = start;
+            pTransfer->size = end - start;
+            fuel_gauge_stats.merged++;
+            return FUEL_GAUGE_STATUS_SUCCESS;
+        }
+    }
+
+    if(fuel_gauge_queue_count >= FUEL_GAUGE_QUEUE_SIZE){
+        fuel_gauge_stats.dropped++;
+        return FUEL_GAUGE_STATUS_FAIL;
+    }
+
+    FUEL_GAUGE_Transfer_t *pTransfer = &fuel_gauge_queue[(fuel_gauge_queue_head + fuel_gauge_queue_count) % FUEL_GAUGE_QUEUE_SIZE];
+    pTransfer->device = device;
+    pTransfer->reg = reg;
+    pTransfer->size = size;
+    fuel_gauge_queue_count++;
+
+    return FUEL_GAUGE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Fuel gauge pop
+*
+*   This function is used to take the oldest queued burst.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[out] pTransfer           Pointer to store the burst
+*
+*   \return     true if a burst was queued
+*
+*******************************************************************************/
+static bool FUEL_GAUGE_Pop(FUEL_GAUGE_Transfer_t *pTransfer){
+
+    bool queued = false;
+
+    xSemaphoreTake(fuel_gauge_mutex_handle, portMAX_DELAY);
+    if(fuel_gauge_queue_count > 0){
+        *pTransfer = fuel_gauge_queue[fuel_gauge_queue_head];
+        fuel_gauge_queue_head = (fuel_gauge_queue_head + 1) % FUEL_GAUGE_QUEUE_SIZE;
+        fuel_gauge_queue_count--;
+        queued = true;
+    }
+    xSemaphoreGive(fuel_gauge_mutex_handle);
+
+    return queued;
+}
+
+/***************************************************************************//*!
+*  \brief Fuel gauge decode
+*
+*   This function is used to update the status from the registers read.
+*
+*   Preconditions: Fuel gauge mutex taken.
+*
+*   Side Effects: None.
+*
+*******************************************************************************/
+static void FUEL_GAUGE_Decode(void){
+
+    const uint8_t *pGauge = fuel_gauge_regs[FUEL_GAUGE_DEVICE_GAUGE];
+    const uint8_t *pCharger = fuel_gauge_regs[FUEL_GAUGE_DEVICE_CHARGER];
+
+    uint32_t soc = ((uint32_t)FUEL_GAUGE_REG16(pGauge, MAX17048_SOC_REG) + 128) / 256;
+    int32_t rate = ((int32_t)(int16_t)FUEL_GAUGE_REG16(pGauge, MAX17048_CRATE_REG) * 208) / 100;
+
+    fuel_gauge_status.soc = (soc > 100) ? 100 : (uint8_t)soc;
+    fuel_gauge_status.voltage_mv = (uint16_t)(((uint32_t)FUEL_GAUGE_REG16(pGauge, MAX17048_VCELL_REG) * 5) / 64);
+    fuel_gauge_status.rate = (rate > INT16_MAX) ? INT16_MAX : (rate < INT16_MIN) ? INT16_MIN : (int16_t)rate;
+
+    uint8_t status = pCharger[BQ24295_STATUS_REG];
+    fuel_gauge_status.charge = (FUEL_GAUGE_Charge_t)((status >> BQ24295_STATUS_CHRG_SHIFT) & BQ24295_STATUS_CHRG_MASK);
+    fuel_gauge_status.power_good = ((status & BQ24295_STATUS_PG_BIT) != 0);
+    fuel_gauge_status.faults = pCharger[BQ24295_FAULT_REG];
+}
+
+/***************************************************************************//*!
+*  \brief Fuel gauge complete
+*
+*   This function is used to store the registers of a completed burst and
+*   update the status. The status is only valid while both devices answer.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pTransfer           Burst sent
+*   \param[in]  success             Burst acknowledged
+*
+*******************************************************************************/
+static void FUEL_GAUGE_Complete(const FUEL_GAUGE_Transfer_t *pTransfer, bool success){
+
+    xSemaphoreTake(fuel_gauge_mutex_handle, portMAX_DELAY);
+
+    if(success){
+        memcpy(&fuel_gauge_regs[pTransfer->device][pTransfer->reg], pTransfer->data, pTransfer->size);
+        FUEL_GAUGE_Decode();
+    }
+    else{
+        fuel_gauge_stats.errors++;
+    }
+
+    //Only changes are logged, an absent device fails every poll
+    if(success && !fuel_gauge_answered[pTransfer->device]){
+        ESP_LOGI(TAG, "Device 0x%02X answering", fuel_gauge_addr[pTransfer->device]);
+    }
+    else if(!success && fuel_gauge_answered[pTransfer->device]){
+        ESP_LOGW(TAG, "Device 0x%02X not answering", fuel_gauge_addr[pTransfer->device]);
+    }
+    fuel_gauge_answered[pTransfer->device] = success;
+    fuel_gauge_status.valid = fuel_gauge_answered[FUEL_GAUGE_DEVICE_GAUGE] && fuel_gauge_answered[FUEL_GAUGE_DEVICE_CHARGER];
+
+    xSemaphoreGive(fuel_gauge_mutex_handle);
+}
+
+static void tFuelGaugeTask(void *pvParameters){
+
+    //The driver reads into the burst in flight, it stays on this stack until done
+    FUEL_GAUGE_Transfer_t transfer;
+    uint32_t seq = 0;
+    uint32_t tag = FUEL_GAUGE_TAG_NONE;
+    bool busy = false;
+    TickType_t sent = 0;
+    const TickType_t timeout = pdMS_TO_TICKS(FUEL_GAUGE_TIMEOUT_MS);
+
+    ESP_LOGI(TAG, "Starting fuel gauge task");
+
+    for(;;){
+
+        TickType_t wait = portMAX_DELAY;
+        if(busy){
+            TickType_t elapsed = xTaskGetTickCount() - sent;
+            wait = (elapsed < timeout) ? (timeout - elapsed) : 0;
+        }
+        uint32_t notified = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notified, wait);
+
+        if(busy){
+            uint32_t done = __atomic_load_n(&fuel_gauge_done, __ATOMIC_ACQUIRE);
+            if((notified & FUEL_GAUGE_NOTIFY_DONE) && (done & ~FUEL_GAUGE_TAG_ERROR) == tag){
+                __atomic_store_n(&fuel_gauge_inflight, FUEL_GAUGE_TAG_NONE, __ATOMIC_RELEASE);
+                FUEL_GAUGE_Complete(&transfer, (done & FUEL_GAUGE_TAG_ERROR) == 0);
+                busy = false;
+            }
+            else if((xTaskGetTickCount() - sent) >= timeout){
+                //A late answer can not complete the burst from here
+                tag |= FUEL_GAUGE_TAG_LATE;
+                __atomic_store_n(&fuel_gauge_inflight, tag, __ATOMIC_RELEASE);
+
+                //Asynchronous transfers do not report every bus error, free the bus for the next burst
+                i2c_master_bus_reset(fuel_gauge_bus);
+                FUEL_GAUGE_Complete(&transfer, false);
+                busy = false;
+
+                xSemaphoreTake(fuel_gauge_mutex_handle, portMAX_DELAY);
+                fuel_gauge_stats.bus_resets++;
+                xSemaphoreGive(fuel_gauge_mutex_handle);
+
+                //A late answer still writes its data, drain it before the burst is reused
+                TickType_t start = xTaskGetTickCount();
+                while((__atomic_load_n(&fuel_gauge_done, __ATOMIC_ACQUIRE) & ~FUEL_GAUGE_TAG_ERROR) != tag &&
+                      (xTaskGetTickCount() - start) < timeout){
+                    xTaskNotifyWait(0, FUEL_GAUGE_NOTIFY_DONE, NULL, timeout - (xTaskGetTickCount() - start));
+                }
+                __atomic_store_n(&fuel_gauge_inflight, FUEL_GAUGE_TAG_NONE, __ATOMIC_RELEASE);
+            }
+            else{
+                //Woken by FUEL_GAUGE_Poll, the burst in flight goes first
+                continue;
+            }
+        }
+
+        while(!busy && FUEL_GAUGE_Pop(&transfer)){
+
+            //Tagged before sending, the ISR can run before the driver returns
+            seq++;
+            tag = FUEL_GAUGE_TAG(seq, transfer.device);
+            __atomic_store_n(&fuel_gauge_inflight, tag, __ATOMIC_RELEASE);
+
+            esp_err_t err = i2c_master_transmit_receive(fuel_gauge_devices[transfer.device],
+                                                        &transfer.reg, 1,
+                                                        transfer.data, transfer.size,
+                                                        FUEL_GAUGE_TIMEOUT_MS);
+
+            xSemaphoreTake(fuel_gauge_mutex_handle, portMAX_DELAY);
+            fuel_gauge_stats.transfers++;
+            xSemaphoreGive(fuel_gauge_mutex_handle);
+
+            if(err == ESP_OK){
+                //Returns before the burst is sent, FUEL_GAUGE_TransferDone wakes the task
+                busy = true;
+                sent = xTaskGetTickCount();
+            }
+            else{
+                __atomic_store_n(&fuel_gauge_inflight, FUEL_GAUGE_TAG_NONE, __ATOMIC_RELEASE);
+                FUEL_GAUGE_Complete(&transfer, false);
+            }
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Fuel gauge initialization
+*
+*   This function is used to add the fuel gauge and the charger to an I2C
+*   bus and start the task sending the queued register reads. The bus is
+*   created by the caller, with FUEL_GAUGE_BUS_QUEUE_DEPTH as its transfer
+*   queue depth so transfers are asynchronous.
+*
+*   Preconditions: None.
+*
+*   Side Effects: Every device of the bus has asynchronous transfers.
+*
+*   \param[in]  bus                 I2C master bus
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_InitModule(i2c_master_bus_handle_t bus){
+
+    if(fuel_gauge_task_handle != NULL || bus == NULL){
+        return FUEL_GAUGE_STATUS_FAIL;
+    }
+
+    memset(fuel_gauge_regs, 0, sizeof(fuel_gauge_regs));
+    memset(fuel_gauge_answered, 0, sizeof(fuel_gauge_answered));
+    memset(&fuel_gauge_status, 0, sizeof(fuel_gauge_status));
+    memset(&fuel_gauge_stats, 0, sizeof(fuel_gauge_stats));
+    fuel_gauge_queue_head = 0;
+    fuel_gauge_queue_count = 0;
+    fuel_gauge_inflight = FUEL_GAUGE_TAG_NONE;
+    fuel_gauge_done = FUEL_GAUGE_TAG_NONE;
+    fuel_gauge_bus = bus;
+
+    //Create fuel gauge mutex
+    fuel_gauge_mutex_handle = xSemaphoreCreateMutex();
+    if(fuel_gauge_mutex_handle == NULL){
+        ESP_LOGW(TAG, "Failed to create fuel gauge mutex");
+        return FUEL_GAUGE_STATUS_FAIL;
+    }
+
+    //Create fuel gauge task, before the callbacks can notify it
+    if(pdTRUE != xTaskCreate(tFuelGaugeTask,
+                             "Fuel gauge task",
+                             FUEL_GAUGE_TASK_STACK,
+                             NULL,
+                             FUEL_GAUGE_TASK_PRIORITY,
+                             &fuel_gauge_task_handle)){
+        ESP_LOGE(TAG, "Failed to create fuel gauge task");
+        return FUEL_GAUGE_STATUS_FAIL;
+    }
+    STACK_MON_RegisterTask(fuel_gauge_task_handle, FUEL_GAUGE_TASK_STACK);
+
+    const i2c_master_event_callbacks_t callbacks = {
+        .on_trans_done = FUEL_GAUGE_TransferDone,
+    };
+
+    //The device is the callback argument, checked against the burst in flight
+    for(uint8_t i=0; i<FUEL_GAUGE_DEVICE_MAX; i++){
+        i2c_device_config_t dev_config = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = fuel_gauge_addr[i],
+            .scl_speed_hz = FUEL_GAUGE_I2C_SPEED_HZ,
+        };
+        if(i2c_master_bus_add_device(bus, &dev_config, &fuel_gauge_devices[i]) != ESP_OK ||
+           i2c_master_register_event_callbacks(fuel_gauge_devices[i], &callbacks, (void *)(uintptr_t)i) != ESP_OK){
+            ESP_LOGW(TAG, "Failed to add device 0x%02X", fuel_gauge_addr[i]);
+            return FUEL_GAUGE_STATUS_FAIL;
+        }
+    }
+
+    return FUEL_GAUGE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Fuel gauge poll
+*
+*   This function is used to queue the reads of the battery and charger
+*   registers. It returns without waiting for the bus, the status is
+*   updated by the fuel gauge task once the reads complete.
+*
+*   Preconditions: FUEL_GAUGE_InitModule called. Not callable from an ISR.
+*
+*   Side Effects: None.
+*
+*   \return     operation status, fail if a read was dropped
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_Poll(void){
+
+    if(fuel_gauge_task_handle == NULL){
+        return FUEL_GAUGE_STATUS_FAIL;
+    }
+
+    FUEL_GAUGE_Ret_t ret = FUEL_GAUGE_STATUS_SUCCESS;
+
+    //Cell voltage and state of charge are next to each other, one burst
+    const struct{
+        FUEL_GAUGE_Device_t device;
+        uint8_t reg;
+        uint8_t size;
+    }reads[] = {
+        {FUEL_GAUGE_DEVICE_GAUGE,   MAX17048_VCELL_REG,     2},
+        {FUEL_GAUGE_DEVICE_GAUGE,   MAX17048_SOC_REG,       2},
+        {FUEL_GAUGE_DEVICE_GAUGE,   MAX17048_CRATE_REG,     2},
+        {FUEL_GAUGE_DEVICE_CHARGER, BQ24295_STATUS_REG,     1},
+        {FUEL_GAUGE_DEVICE_CHARGER, BQ24295_FAULT_REG,      1},
+    };
+
+    xSemaphoreTake(fuel_gauge_mutex_handle, portMAX_DELAY);
+    for(uint8_t i=0; i<(sizeof(reads) / sizeof(reads[0])); i++){
+        if(FUEL_GAUGE_QueueRead(reads[i].device, reads[i].reg, reads[i].size) != FUEL_GAUGE_STATUS_SUCCESS){
+            ret = FUEL_GAUGE_STATUS_FAIL;
+        }
+    }
+    xSemaphoreGive(fuel_gauge_mutex_handle);
+
+    xTaskNotify(fuel_gauge_task_handle, FUEL_GAUGE_NOTIFY_POLL, eSetBits);
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Fuel gauge status
+*
+*   This function is used to read the battery and charger state decoded
+*   from the last completed reads.
+*
+*   Preconditions: FUEL_GAUGE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStatus             Pointer to store the status
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_GetStatus(FUEL_GAUGE_Status_t *pStatus){
+
+    if(fuel_gauge_mutex_handle == NULL || pStatus == NULL){
+        return FUEL_GAUGE_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(fuel_gauge_mutex_handle, portMAX_DELAY);
+    *pStatus = fuel_gauge_status;
+    xSemaphoreGive(fuel_gauge_mutex_handle);
+
+    return FUEL_GAUGE_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Fuel gauge statistics
+*
+*   This function is used to read the fuel gauge bus counters.
+*
+*   Preconditions: FUEL_GAUGE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_GetStats(FUEL_GAUGE_Stats_t *pStats){
+
+    if(fuel_gauge_mutex_handle == NULL || pStats == NULL){
+        return FUEL_GAUGE_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(fuel_gauge_mutex_handle, portMAX_DELAY);
+    *pStats = fuel_gauge_stats;
+    xSemaphoreGive(fuel_gauge_mutex_handle);
+
+    return FUEL_GAUGE_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+/*
+ * I2C transfer done, called from the I2C ISR. The next burst is sent by the
+ * fuel gauge task, the driver API can not be called from here. A burst given
+ * up on after a bus reset can still answer, it only ends the drain of the task.
+ */
+static bool IRAM_ATTR FUEL_GAUGE_TransferDone(i2c_master_dev_handle_t dev, const i2c_master_event_data_t *pEvent, void *pArg){
+
+    BaseType_t woken = pdFALSE;
+    uint32_t tag = __atomic_load_n(&fuel_gauge_inflight, __ATOMIC_ACQUIRE);
+
+    if(tag == FUEL_GAUGE_TAG_NONE || FUEL_GAUGE_TAG_DEVICE(tag) != (uint32_t)(uintptr_t)pArg){
+        return false;
+    }
+
+    if(pEvent->event != I2C_EVENT_DONE){
+        tag |= FUEL_GAUGE_TAG_ERROR;
+    }
+    __atomic_store_n(&fuel_gauge_done, tag, __ATOMIC_RELEASE);
+    xTaskNotifyFromISR(fuel_gauge_task_handle, FUEL_GAUGE_NOTIFY_DONE, eSetBits, &woken);
+
+    return (woken == pdTRUE);
+}
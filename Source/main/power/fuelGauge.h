@@ -0,0 +1,147 @@
+#ifndef _FUEL_GAUGE_H
+#define _FUEL_GAUGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "driver/i2c_master.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+//MAX17048 fuel gauge and BQ24295 charger, 7 bit addresses
+#define FUEL_GAUGE_GAUGE_ADDR               (0x36)
+#define FUEL_GAUGE_CHARGER_ADDR             (0x6B)
+
+//Charger faults stopping the charge: charge, battery and NTC. The watchdog fault only
+//means the charger registers went back to their defaults, boost faults do not matter
+#define FUEL_GAUGE_CHARGE_FAULTS            (0x3F)
+
+//Reads of the same device this close are sent as one burst
+#define FUEL_GAUGE_BURST_MAX                (8)
+#define FUEL_GAUGE_QUEUE_SIZE               (8)
+//Driver queue depth the bus must be created with, one transfer at a time plus a margin
+#define FUEL_GAUGE_BUS_QUEUE_DEPTH          (2)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum FUEL_GAUGE_Charge_e{
+    FUEL_GAUGE_CHARGE_OFF,
+    FUEL_GAUGE_CHARGE_PRE,                  //Precharge of a deeply discharged cell
+    FUEL_GAUGE_CHARGE_FAST,
+    FUEL_GAUGE_CHARGE_DONE,
+}FUEL_GAUGE_Charge_t;
+
+typedef struct FUEL_GAUGE_Status_s{
+    bool valid;                             //Both devices answered their last read
+    uint8_t soc;                            //State of charge, in %
+    uint16_t voltage_mv;                    //Cell voltage
+    int16_t rate;                           //Charge rate, in 0.1 %/h, negative when discharging
+    FUEL_GAUGE_Charge_t charge;
+    bool power_good;                        //Charger input present
+    uint8_t faults;                         //Charger faults latched since the previous read, 0 without fault
+}FUEL_GAUGE_Status_t;
+
+typedef struct FUEL_GAUGE_Stats_s{
+    uint32_t transfers;                     //Bursts sent on the bus
+    uint32_t merged;                        //Register reads merged into a queued burst
+    uint32_t dropped;                       //Register reads lost while the queue was full
+    uint32_t errors;                        //Bursts not acknowledged or timed out
+    uint32_t bus_resets;
+}FUEL_GAUGE_Stats_t;
+
+typedef enum FUEL_GAUGE_Ret_e{
+    FUEL_GAUGE_STATUS_FAIL,
+    FUEL_GAUGE_STATUS_SUCCESS,
+}FUEL_GAUGE_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if (FUEL_GAUGE_BURST_MAX < 4)
+#error "Fuel gauge bursts must hold the cell voltage and state of charge"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Fuel gauge initialization
+*
+*   This function is used to add the fuel gauge and the charger to an I2C
+*   bus and start the task sending the queued register reads. The bus is
+*   created by the caller, with FUEL_GAUGE_BUS_QUEUE_DEPTH as its transfer
+*   queue depth so transfers are asynchronous.
+*
+*   Preconditions: None.
+*
+*   Side Effects: Every device of the bus has asynchronous transfers.
+*
+*   \param[in]  bus                 I2C master bus
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_InitModule(i2c_master_bus_handle_t bus);
+
+/***************************************************************************//*!
+*  \brief Fuel gauge poll
+*
+*   This function is used to queue the reads of the battery and charger
+*   registers. It returns without waiting for the bus, the status is
+*   updated by the fuel gauge task once the reads complete.
+*
+*   Preconditions: FUEL_GAUGE_InitModule called. Not callable from an ISR.
+*
+*   Side Effects: None.
+*
+*   \return     operation status, fail if a read was dropped
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_Poll(void);
+
+/***************************************************************************//*!
+*  \brief Fuel gauge status
+*
+*   This function is used to read the battery and charger state decoded
+*   from the last completed reads.
+*
+*   Preconditions: FUEL_GAUGE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStatus             Pointer to store the status
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_GetStatus(FUEL_GAUGE_Status_t *pStatus);
+
+/***************************************************************************//*!
+*  \brief Fuel gauge statistics
+*
+*   This function is used to read the fuel gauge bus counters.
+*
+*   Preconditions: FUEL_GAUGE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+FUEL_GAUGE_Ret_t FUEL_GAUGE_GetStats(FUEL_GAUGE_Stats_t *pStats);
+
+#endif//_FUEL_GAUGE_H
@@ -0,0 +1,369 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Linux host fuel gauge test
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "driver/i2c_master.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#include "fuelGauge.h"
+
+#define TEST_XFER_MS        (20)        //Simulated burst duration
+#define TEST_LATE_MS        (60)        //Extra duration of a stalled burst, past the fuel gauge timeout
+#define TEST_MAX_LOG        (32)
+#define TEST_REG_SIZE       (32)
+#define TEST_WAIT           (pdMS_TO_TICKS(2000))
+
+/* Simulated devices, the handles of i2c_master_bus_add_device */
+struct i2c_master_dev_t {
+    uint16_t address;
+    uint8_t regs[TEST_REG_SIZE];
+    bool nack;                          //Completes with I2C_EVENT_NACK
+    bool stuck;                         //Never completes, until the bus is reset
+    bool late;                          //Completes after the fuel gauge gave up on the burst
+    i2c_master_callback_t on_trans_done;
+    void *user_ctx;
+};
+
+typedef struct {
+    i2c_master_dev_handle_t dev;
+    uint8_t reg;
+    uint8_t *pData;
+    size_t size;
+} test_burst_t;
+
+typedef struct {
+    uint16_t address;
+    uint8_t reg;
+    uint8_t size;
+} test_log_t;
+
+static struct i2c_master_dev_t gauge = {.address = FUEL_GAUGE_GAUGE_ADDR};
+static struct i2c_master_dev_t charger = {.address = FUEL_GAUGE_CHARGER_ADDR};
+
+static test_log_t burst_log[TEST_MAX_LOG];
+static uint8_t burst_count;
+static uint32_t bus_resets;
+static bool initialized;
+static QueueHandle_t bus_queue;
+static SemaphoreHandle_t log_mutex;
+
+/* The app timer is headers only on linux, read the host clock instead */
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Simulated bus: bursts complete in order, the callback runs like the I2C ISR */
+static void test_bus_task(void *pvParameters)
+{
+    test_burst_t burst;
+
+    for (;;) {
+        xQueueReceive(bus_queue, &burst, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(TEST_XFER_MS + (burst.dev->late ? TEST_LATE_MS : 0)));
+
+        if (burst.dev->stuck) {
+            continue;
+        }
+
+        i2c_master_event_data_t evt = {
+            .event = burst.dev->nack ? I2C_EVENT_NACK : I2C_EVENT_DONE,
+        };
+        if (!burst.dev->nack) {
+            memcpy(burst.pData, &burst.dev->regs[burst.reg], burst.size);
+        }
+        burst.dev->on_trans_done(burst.dev, &evt, burst.dev->user_ctx);
+    }
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config, i2c_master_dev_handle_t *ret_handle)
+{
+    if (dev_config->device_address == FUEL_GAUGE_GAUGE_ADDR) {
+        *ret_handle = &gauge;
+    } else if (dev_config->device_address == FUEL_GAUGE_CHARGER_ADDR) {
+        *ret_handle = &charger;
+    } else {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_register_event_callbacks(i2c_master_dev_handle_t i2c_dev, const i2c_master_event_callbacks_t *cbs, void *user_data)
+{
+    i2c_dev->on_trans_done = cbs->on_trans_done;
+    i2c_dev->user_ctx = user_data;
+    return ESP_OK;
+}
+
+/* Asynchronous like the driver once a callback is registered */
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size, uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    TEST_ASSERT_NOT_NULL(i2c_dev->on_trans_done);
+    TEST_ASSERT_EQUAL(1, write_size);
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_REG_SIZE, write_buffer[0] + read_size);
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    if (burst_count < TEST_MAX_LOG) {
+        burst_log[burst_count++] = (test_log_t) {i2c_dev->address, write_buffer[0], (uint8_t)read_size};
+    }
+    xSemaphoreGive(log_mutex);
+
+    test_burst_t burst = {i2c_dev, write_buffer[0], read_buffer, read_size};
+    return (xQueueSend(bus_queue, &burst, 0) == pdTRUE) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus_handle)
+{
+    bus_resets++;
+    return ESP_OK;
+}
+
+static void test_set_reg16(uint8_t *regs, uint8_t reg, uint16_t value)
+{
+    regs[reg] = value >> 8;
+    regs[reg + 1] = value & 0xFF;
+}
+
+/* Waits for the fuel gauge task to reach the transfer count */
+static FUEL_GAUGE_Stats_t test_wait(uint32_t transfers)
+{
+    FUEL_GAUGE_Stats_t stats;
+    TickType_t start = xTaskGetTickCount();
+
+    do {
+        vTaskDelay(pdMS_TO_TICKS(TEST_XFER_MS));
+        TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&stats));
+    } while ((stats.transfers < transfers || uxQueueMessagesWaiting(bus_queue) > 0) &&
+             (xTaskGetTickCount() - start) < TEST_WAIT);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(transfers, stats.transfers);
+    /* Completion of the last burst */
+    vTaskDelay(pdMS_TO_TICKS(2 * TEST_XFER_MS));
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&stats));
+    return stats;
+}
+
+TEST_GROUP(fuel_gauge);
+
+TEST_SETUP(fuel_gauge)
+{
+    if (!initialized) {
+        bus_queue = xQueueCreate(FUEL_GAUGE_BUS_QUEUE_DEPTH, sizeof(test_burst_t));
+        log_mutex = xSemaphoreCreateMutex();
+        TEST_ASSERT_NOT_NULL(bus_queue);
+        TEST_ASSERT_NOT_NULL(log_mutex);
+        TEST_ASSERT_EQUAL(pdTRUE, xTaskCreate(test_bus_task, "bus", 4096, NULL, 5, NULL));
+        TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_FAIL, FUEL_GAUGE_InitModule(NULL));
+        TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_InitModule((i2c_master_bus_handle_t)&bus_queue));
+        initialized = true;
+    }
+
+    /* 4160mV, 90.5%, -2.0%/h, fast charging with input power, no fault */
+    memset(gauge.regs, 0, sizeof(gauge.regs));
+    memset(charger.regs, 0, sizeof(charger.regs));
+    test_set_reg16(gauge.regs, 0x02, 0xD000);
+    test_set_reg16(gauge.regs, 0x04, 0x5A80);
+    test_set_reg16(gauge.regs, 0x16, 0xFFF6);
+    charger.regs[0x08] = 0x24;
+    charger.regs[0x09] = 0x00;
+    gauge.nack = charger.nack = false;
+    gauge.stuck = charger.stuck = false;
+    gauge.late = charger.late = false;
+    burst_count = 0;
+}
+
+TEST_TEAR_DOWN(fuel_gauge)
+{
+}
+
+TEST(fuel_gauge, test_poll_bursts)
+{
+    FUEL_GAUGE_Stats_t before;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&before));
+
+    /* Queued only, the caller never waits for the bus */
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    TEST_ASSERT_LESS_THAN(TEST_XFER_MS * 1000 / 2, esp_timer_get_time() - start);
+
+    FUEL_GAUGE_Stats_t stats = test_wait(before.transfers + 3);
+    TEST_ASSERT_EQUAL(before.transfers + 3, stats.transfers);
+    TEST_ASSERT_EQUAL(before.merged + 2, stats.merged);
+    TEST_ASSERT_EQUAL(before.errors, stats.errors);
+
+    /* Voltage and state of charge in one burst, status and fault in another */
+    const test_log_t expected[] = {
+        {FUEL_GAUGE_GAUGE_ADDR, 0x02, 4},
+        {FUEL_GAUGE_GAUGE_ADDR, 0x16, 2},
+        {FUEL_GAUGE_CHARGER_ADDR, 0x08, 2},
+    };
+    TEST_ASSERT_EQUAL(3, burst_count);
+    for (uint8_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_HEX16(expected[i].address, burst_log[i].address);
+        TEST_ASSERT_EQUAL_HEX8(expected[i].reg, burst_log[i].reg);
+        TEST_ASSERT_EQUAL(expected[i].size, burst_log[i].size);
+    }
+
+    FUEL_GAUGE_Status_t status;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_TRUE(status.valid);
+    TEST_ASSERT_EQUAL(91, status.soc);
+    TEST_ASSERT_EQUAL(4160, status.voltage_mv);
+    TEST_ASSERT_EQUAL(-20, status.rate);
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_CHARGE_FAST, status.charge);
+    TEST_ASSERT_TRUE(status.power_good);
+    TEST_ASSERT_EQUAL(0, status.faults);
+}
+
+TEST(fuel_gauge, test_poll_while_busy)
+{
+    FUEL_GAUGE_Stats_t before;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&before));
+
+    /* The first burst is in flight, the second poll merges into the queued ones */
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    vTaskDelay(pdMS_TO_TICKS(TEST_XFER_MS / 4));
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+
+    FUEL_GAUGE_Stats_t stats = test_wait(before.transfers + 4);
+    TEST_ASSERT_EQUAL(before.transfers + 4, stats.transfers);
+    TEST_ASSERT_EQUAL(before.merged + 6, stats.merged);
+    TEST_ASSERT_EQUAL(before.dropped, stats.dropped);
+}
+
+TEST(fuel_gauge, test_charge_done)
+{
+    charger.regs[0x08] = 0x34;
+    charger.regs[0x09] = 0x08;
+    test_set_reg16(gauge.regs, 0x04, 0x6400);
+
+    FUEL_GAUGE_Stats_t before;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&before));
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    test_wait(before.transfers + 3);
+
+    FUEL_GAUGE_Status_t status;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_TRUE(status.valid);
+    TEST_ASSERT_EQUAL(100, status.soc);
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_CHARGE_DONE, status.charge);
+    TEST_ASSERT_EQUAL_HEX8(0x08, status.faults & FUEL_GAUGE_CHARGE_FAULTS);
+}
+
+TEST(fuel_gauge, test_nack)
+{
+    charger.nack = true;
+    test_set_reg16(gauge.regs, 0x04, 0x3200);
+
+    FUEL_GAUGE_Stats_t before;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&before));
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    FUEL_GAUGE_Stats_t stats = test_wait(before.transfers + 3);
+    TEST_ASSERT_EQUAL(before.errors + 1, stats.errors);
+
+    /* The gauge still answers, the status is not valid without the charger */
+    FUEL_GAUGE_Status_t status;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_FALSE(status.valid);
+    TEST_ASSERT_EQUAL(50, status.soc);
+
+    charger.nack = false;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    test_wait(stats.transfers + 3);
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_TRUE(status.valid);
+}
+
+TEST(fuel_gauge, test_timeout_resets_bus)
+{
+    gauge.stuck = true;
+    uint32_t resets = bus_resets;
+
+    FUEL_GAUGE_Stats_t before;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&before));
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    FUEL_GAUGE_Stats_t stats = test_wait(before.transfers + 3);
+
+    /* Both gauge bursts time out, the charger burst goes through after them */
+    TEST_ASSERT_EQUAL(before.errors + 2, stats.errors);
+    TEST_ASSERT_EQUAL(before.bus_resets + 2, stats.bus_resets);
+    TEST_ASSERT_EQUAL(resets + 2, bus_resets);
+
+    FUEL_GAUGE_Status_t status;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_FALSE(status.valid);
+
+    gauge.stuck = false;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    test_wait(stats.transfers + 3);
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_TRUE(status.valid);
+}
+
+TEST(fuel_gauge, test_late_answer)
+{
+    gauge.late = true;
+
+    FUEL_GAUGE_Stats_t before;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStats(&before));
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    FUEL_GAUGE_Stats_t stats = test_wait(before.transfers + 3);
+
+    /* The late answers complete neither their own burst nor the next one */
+    TEST_ASSERT_EQUAL(before.errors + 2, stats.errors);
+    TEST_ASSERT_EQUAL(before.bus_resets + 2, stats.bus_resets);
+
+    FUEL_GAUGE_Status_t status;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_FALSE(status.valid);
+
+    /* Nothing written into another burst, the rate and charger are those of the last reads */
+    TEST_ASSERT_EQUAL(-20, status.rate);
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_CHARGE_FAST, status.charge);
+    TEST_ASSERT_TRUE(status.power_good);
+
+    gauge.late = false;
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_Poll());
+    stats = test_wait(stats.transfers + 3);
+    TEST_ASSERT_EQUAL(before.errors + 2, stats.errors);
+    TEST_ASSERT_EQUAL(FUEL_GAUGE_STATUS_SUCCESS, FUEL_GAUGE_GetStatus(&status));
+    TEST_ASSERT_TRUE(status.valid);
+    TEST_ASSERT_EQUAL(91, status.soc);
+    TEST_ASSERT_EQUAL(4160, status.voltage_mv);
+    TEST_ASSERT_EQUAL(-20, status.rate);
+}
+
+TEST_GROUP_RUNNER(fuel_gauge)
+{
+    RUN_TEST_CASE(fuel_gauge, test_poll_bursts);
+    RUN_TEST_CASE(fuel_gauge, test_poll_while_busy);
+    RUN_TEST_CASE(fuel_gauge, test_charge_done);
+    RUN_TEST_CASE(fuel_gauge, test_nack);
+    RUN_TEST_CASE(fuel_gauge, test_timeout_resets_bus);
+    RUN_TEST_CASE(fuel_gauge, test_late_answer);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(fuel_gauge);
+}
+
+void app_main(void)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+}
@@ -0,0 +1,566 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+
+#include "flashRecorder.h"
+#include "stackMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define RECORDER_TASK_STACK             (CONFIG_RECORDER_TASK_STACK_SIZE)
+#define RECORDER_TASK_PRIORITY          (3)
+
+#define RECORDER_NO_BLOCK               (UINT32_MAX)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define RECORDER_BUFFER(index)          ((RECORDER_Block_t *)record_buffers[index])
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static void tRecorderTask(void *pvParameters);
+static bool RECORDER_ReadHeader(uint32_t block, RECORDER_Block_Header_t *pHeader);
+static bool RECORDER_FollowsFirst(uint32_t block, uint32_t first_sequence);
+static void RECORDER_FindHead(void);
+static void RECORDER_SwapBuffers(void);
+static void RECORDER_ResumeWriter(void);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const esp_partition_t *pPartition = NULL;
+static uint32_t block_count = 0;
+static uint32_t sample_period_us = 0;
+
+static bool log_empty = true;
+static uint32_t head_sequence = 0;          //Sequence of the last complete block
+static uint32_t next_block = 0;
+
+//Two blocks, one is filled by RECORDER_AddSamples while the other one is written
+static uint64_t record_buffers[2][RECORDER_BLOCK_SIZE / sizeof(uint64_t)];
+static uint8_t active_buffer = 0;
+static volatile int8_t pending_buffer = -1;
+
+//Block held by the open reader and block being erased and written, each one is never used by the other side
+static bool reader_open = false;
+static uint32_t reader_block = RECORDER_NO_BLOCK;
+static uint32_t writer_block = RECORDER_NO_BLOCK;
+
+static uint32_t blocks_written = 0;
+static uint32_t samples_dropped = 0;
+static uint32_t write_errors = 0;
+
+static TaskHandle_t recorder_task_handle = NULL;
+static SemaphoreHandle_t recorder_mutex_handle = NULL;
+
+static const char * TAG = "RECORDER";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static void tRecorderTask(void *pvParameters){
+
+    for(;;){
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        RECORDER_WritePending();
+    }
+    vTaskDelete(NULL);
+}
+
+static bool RECORDER_ReadHeader(uint32_t block, RECORDER_Block_Header_t *pHeader){
+
+    if(esp_partition_read(pPartition, block * RECORDER_BLOCK_SIZE, pHeader, sizeof(RECORDER_Block_Header_t)) != ESP_OK){
+        return false;
+    }
+
+    return pHeader->magic == RECORDER_BLOCK_MAGIC;
+}
+
+//True for every block written after block 0 in the current lap
+static bool RECORDER_FollowsFirst(uint32_t block, uint32_t first_sequence){
+
+    RECORDER_Block_Header_t header;
+
+    if(!RECORDER_ReadHeader(block, &header)){
+        return false;
+    }
+
+    return (header.sequence - first_sequence) == block;
+}
+
+static void RECORDER_FindHead(void){
+
+    RECORDER_Block_Header_t header;
+    uint32_t head;
+
+    log_empty = false;
+
+    if(!RECORDER_ReadHeader(0, &header)){
+        //Only the block after the head can be incomplete, block 0 is either that one or the log is empty
+        if(!RECORDER_ReadHeader(block_count - 1, &header)){
+            log_empty = true;
+            head_sequence = 0;
+            next_block = 0;
+            return;
+        }
+        head = block_count - 1;
+    }
+    else{
+        uint32_t first_sequence = header.sequence;
+        uint32_t low = 0;
+        uint32_t high = block_count - 1;
+
+        //Last block following block 0, the blocks after it are erased, incomplete or from the previous lap
+        while(low < high){
+            uint32_t mid = low + (high - low + 1) / 2;
+            if(RECORDER_FollowsFirst(mid, first_sequence)){
+                low = mid;
+            }
+            else{
+                high = mid - 1;
+            }
+        }
+        head = low;
+        RECORDER_ReadHeader(head, &header);
+    }
+
+    head_sequence = header.sequence;
+    next_block = (head + 1) % block_count;
+}
+
+//Hands the full active buffer to the writer and starts filling the other one
+static void RECORDER_SwapBuffers(void){
+
+    pending_buffer = active_buffer;
+    active_buffer ^= 1;
+    RECORDER_BUFFER(active_buffer)->header.count = 0;
+}
+
+//Wakes the writer up in case it was waiting for the reader to release the oldest block
+static void RECORDER_ResumeWriter(void){
+
+    if(pending_buffer >= 0 && recorder_task_handle != NULL){
+        xTaskNotifyGive(recorder_task_handle);
+    }
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Flash recorder initialization
+*
+*   This function is used to find the recorder partition and its write head
+*   and to start the writer task. Blocks carry consecutive sequence numbers
+*   around the partition, the head is the last block whose sequence follows
+*   the one of block 0, found with a binary search over the block headers.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  period_us           Sampling period stored with every block
+*
+*   \return     operation status
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_InitModule(uint32_t period_us){
+
+    pPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, RECORDER_PARTITION_SUBTYPE, RECORDER_PARTITION_LABEL);
+    if(pPartition == NULL){
+        ESP_LOGW(TAG, "Failed to find partition %s", RECORDER_PARTITION_LABEL);
+        return RECORDER_STATUS_FAIL;
+    }
+
+    if((RECORDER_BLOCK_SIZE % pPartition->erase_size) != 0 || pPartition->size < 2 * RECORDER_BLOCK_SIZE){
+        ESP_LOGW(TAG, "Failed to use partition -> Invalid size");
+        pPartition = NULL;
+        return RECORDER_STATUS_FAIL;
+    }
+
+    //Create mutex, once, the module can be initialized again on the same partition
+    if(recorder_mutex_handle == NULL){
+        recorder_mutex_handle = xSemaphoreCreateMutex();
+        if(recorder_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Recorder mutex");
+            pPartition = NULL;
+            return RECORDER_STATUS_FAIL;
+        }
+    }
+
+    block_count = pPartition->size / RECORDER_BLOCK_SIZE;
+    sample_period_us = period_us;
+    active_buffer = 0;
+    pending_buffer = -1;
+    RECORDER_BUFFER(0)->header.count = 0;
+    blocks_written = 0;
+    samples_dropped = 0;
+    write_errors = 0;
+    reader_open = false;
+    reader_block = RECORDER_NO_BLOCK;
+    writer_block = RECORDER_NO_BLOCK;
+
+    RECORDER_FindHead();
+    ESP_LOGI(TAG, "%u blocks, next block %u", (unsigned)block_count, (unsigned)next_block);
+
+    if(recorder_task_handle == NULL){
+        if(pdTRUE != xTaskCreate(tRecorderTask,
+                                 "Recorder task",
+                                 RECORDER_TASK_STACK,
+                                 NULL,
+                                 RECORDER_TASK_PRIORITY,
+                                 &recorder_task_handle)){
+
+            ESP_LOGW(TAG, "Failed to create Recorder task");
+            pPartition = NULL;
+            return RECORDER_STATUS_FAIL;
+        }
+        STACK_MON_RegisterTask(recorder_task_handle, RECORDER_TASK_STACK);
+    }
+
+    return RECORDER_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Flash recorder add samples
+*
+*   This function is used by the ADC path to record samples. They are
+*   copied into the RAM buffer being filled, a full buffer is swapped with
+*   the other one and the writer task is notified. Samples are dropped
+*   while both buffers are full.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pSamples            Samples to record
+*   \param[in]  count               Number of samples
+*   \param[in]  timestamp_us        esp_timer time of the first sample
+*
+*   \return     operation status, fail if samples were dropped
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_AddSamples(const RECORDER_Sample_t *pSamples, size_t count, int64_t timestamp_us){
+
+    if(pPartition == NULL || (pSamples == NULL && count != 0)){
+        return RECORDER_STATUS_FAIL;
+    }
+
+    bool notify = false;
+
+    while(count > 0){
+        RECORDER_Block_t *pBlock = RECORDER_BUFFER(active_buffer);
+
+        //Full buffer kept because the writer is still busy with the other one
+        if(pBlock->header.count == RECORDER_BLOCK_SAMPLES){
+            if(pending_buffer >= 0){
+                samples_dropped += count;
+                break;
+            }
+            RECORDER_SwapBuffers();
+            notify = true;
+            continue;
+        }
+
+        if(pBlock->header.count == 0){
+            pBlock->header.timestamp_us = timestamp_us;
+        }
+
+        size_t copy = RECORDER_BLOCK_SAMPLES - pBlock->header.count;
+        if(copy > count){
+            copy = count;
+        }
+
+        memcpy(&pBlock->samples[pBlock->header.count], pSamples, copy * sizeof(RECORDER_Sample_t));
+        pBlock->header.count += copy;
+        pSamples += copy;
+        count -= copy;
+        timestamp_us += (int64_t)copy * sample_period_us;
+
+        if(pBlock->header.count == RECORDER_BLOCK_SAMPLES && pending_buffer < 0){
+            RECORDER_SwapBuffers();
+            notify = true;
+        }
+    }
+
+    if(notify && recorder_task_handle != NULL){
+        xTaskNotifyGive(recorder_task_handle);
+    }
+
+    return (count == 0) ? RECORDER_STATUS_SUCCESS : RECORDER_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Flash recorder write pending buffer
+*
+*   This function is called by the writer task to erase the next block and
+*   write the full buffer to it. Samples go first and the header last, an
+*   interrupted write leaves a block without magic that is skipped. The
+*   buffer stays pending while the oldest block is held by the reader.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: Erases the oldest block.
+*
+*   \return     operation status, success if nothing was pending or the write waits for the reader
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_WritePending(void){
+
+    if(pPartition == NULL){
+        return RECORDER_STATUS_FAIL;
+    }
+
+    if(pending_buffer < 0){
+        return RECORDER_STATUS_SUCCESS;
+    }
+
+    xSemaphoreTake(recorder_mutex_handle, portMAX_DELAY);
+    //The oldest block is still used by the reader, the buffer is written once it moves on
+    if(reader_block == next_block){
+        xSemaphoreGive(recorder_mutex_handle);
+        return RECORDER_STATUS_SUCCESS;
+    }
+    writer_block = next_block;
+    xSemaphoreGive(recorder_mutex_handle);
+
+    RECORDER_Block_t *pBlock = RECORDER_BUFFER(pending_buffer);
+    size_t offset = next_block * RECORDER_BLOCK_SIZE;
+    uint32_t sequence = log_empty ? 0 : (head_sequence + 1);
+
+    pBlock->header.sequence = sequence;
+    pBlock->header.reserved = 0xFFFF;
+    pBlock->header.period_us = sample_period_us;
+    pBlock->header.magic = RECORDER_BLOCK_MAGIC;
+
+    esp_err_t err = esp_partition_erase_range(pPartition, offset, RECORDER_BLOCK_SIZE);
+    if(err == ESP_OK){
+        err = esp_partition_write(pPartition, offset + sizeof(RECORDER_Block_Header_t), pBlock->samples,
+                                  pBlock->header.count * sizeof(RECORDER_Sample_t));
+    }
+    if(err == ESP_OK){
+        err = esp_partition_write(pPartition, offset, &pBlock->header, sizeof(RECORDER_Block_Header_t));
+    }
+
+    xSemaphoreTake(recorder_mutex_handle, portMAX_DELAY);
+
+    writer_block = RECORDER_NO_BLOCK;
+    if(err == ESP_OK){
+        log_empty = false;
+        head_sequence = sequence;
+        next_block = (next_block + 1) % block_count;
+        blocks_written++;
+    }
+    else{
+        write_errors++;
+    }
+
+    xSemaphoreGive(recorder_mutex_handle);
+
+    //The buffer is released either way, a failed block is retried with the next buffer
+    pending_buffer = -1;
+
+    if(err != ESP_OK){
+        ESP_LOGW(TAG, "Failed to write block %u -> %s", (unsigned)next_block, esp_err_to_name(err));
+        return RECORDER_STATUS_FAIL;
+    }
+
+    return RECORDER_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Flash recorder statistics
+*
+*   This function is used to read the recorder counters.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_GetStats(RECORDER_Stats_t *pStats){
+
+    if(pPartition == NULL || pStats == NULL){
+        return RECORDER_STATUS_FAIL;
+    }
+
+    pStats->blocks_written = blocks_written;
+    pStats->samples_dropped = samples_dropped;
+    pStats->write_errors = write_errors;
+
+    return RECORDER_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Flash recorder open reader
+*
+*   This function is used to map the recorder partition for reading. Blocks
+*   written before this call are returned oldest first. Only one reader can
+*   be open at a time.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pReader             Reader to open
+*
+*   \return     operation status
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_OpenReader(RECORDER_Reader_t *pReader){
+
+    if(pPartition == NULL || pReader == NULL){
+        return RECORDER_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(recorder_mutex_handle, portMAX_DELAY);
+    bool busy = reader_open;
+    reader_open = true;
+    xSemaphoreGive(recorder_mutex_handle);
+
+    if(busy){
+        ESP_LOGW(TAG, "Failed to open reader -> Already open");
+        return RECORDER_STATUS_FAIL;
+    }
+
+    const void *pMapped = NULL;
+    if(esp_partition_mmap(pPartition, 0, block_count * RECORDER_BLOCK_SIZE, ESP_PARTITION_MMAP_DATA, &pMapped, &pReader->handle) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to map partition %s", RECORDER_PARTITION_LABEL);
+        xSemaphoreTake(recorder_mutex_handle, portMAX_DELAY);
+        reader_open = false;
+        xSemaphoreGive(recorder_mutex_handle);
+        return RECORDER_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(recorder_mutex_handle, portMAX_DELAY);
+
+    //The oldest block follows the head
+    pReader->pBase = pMapped;
+    pReader->block = next_block;
+    pReader->remaining = log_empty ? 0 : block_count;
+    pReader->last_sequence = head_sequence;
+
+    xSemaphoreGive(recorder_mutex_handle);
+
+    return RECORDER_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Flash recorder read next block
+*
+*   This function is used to get the next complete block. The block points
+*   into the mapped partition and is valid until the next call or until the
+*   reader is closed, the writer does not erase it meanwhile. Blocks the
+*   writer overwrote before the reader got to them are skipped.
+*
+*   Preconditions: RECORDER_OpenReader called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pReader             Reader
+*
+*   \return     next block, NULL once all blocks were returned
+*
+*******************************************************************************/
+const RECORDER_Block_t *RECORDER_ReadNextBlock(RECORDER_Reader_t *pReader){
+
+    if(pReader == NULL || pReader->pBase == NULL){
+        return NULL;
+    }
+
+    const RECORDER_Block_t *pFound = NULL;
+
+    xSemaphoreTake(recorder_mutex_handle, portMAX_DELAY);
+
+    //The previous block is released
+    reader_block = RECORDER_NO_BLOCK;
+
+    while(pReader->remaining > 0 && pFound == NULL){
+        uint32_t block = pReader->block;
+        const RECORDER_Block_t *pBlock = (const RECORDER_Block_t *)&pReader->pBase[block * RECORDER_BLOCK_SIZE];
+
+        pReader->block = (pReader->block + 1) % block_count;
+        pReader->remaining--;
+
+        //Skip the block being rewritten, incomplete blocks and blocks written after the reader was opened
+        if(block != writer_block && pBlock->header.magic == RECORDER_BLOCK_MAGIC &&
+           pBlock->header.count <= RECORDER_BLOCK_SAMPLES && (pReader->last_sequence - pBlock->header.sequence) < block_count){
+            reader_block = block;
+            pFound = pBlock;
+        }
+    }
+
+    xSemaphoreGive(recorder_mutex_handle);
+
+    RECORDER_ResumeWriter();
+
+    return pFound;
+}
+
+/***************************************************************************//*!
+*  \brief Flash recorder close reader
+*
+*   This function is used to unmap the recorder partition and release the
+*   last block returned.
+*
+*   Preconditions: RECORDER_OpenReader called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pReader             Reader to close
+*
+*******************************************************************************/
+void RECORDER_CloseReader(RECORDER_Reader_t *pReader){
+
+    if(pReader == NULL || pReader->pBase == NULL){
+        return;
+    }
+
+    xSemaphoreTake(recorder_mutex_handle, portMAX_DELAY);
+    reader_block = RECORDER_NO_BLOCK;
+    reader_open = false;
+    xSemaphoreGive(recorder_mutex_handle);
+
+    esp_partition_munmap(pReader->handle);
+    pReader->pBase = NULL;
+    pReader->remaining = 0;
+
+    RECORDER_ResumeWriter();
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
@@ -0,0 +1,206 @@
+#ifndef _FLASH_RECORDER_H
+#define _FLASH_RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_partition.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define RECORDER_PARTITION_LABEL            "recorder"
+#define RECORDER_PARTITION_SUBTYPE          (0x40)
+
+//One block per flash sector, a block is erased and written as a whole
+#define RECORDER_BLOCK_SIZE                 (4096)
+#define RECORDER_BLOCK_MAGIC                (0x52454331)
+#define RECORDER_BLOCK_SAMPLES              ((RECORDER_BLOCK_SIZE - sizeof(RECORDER_Block_Header_t)) / sizeof(RECORDER_Sample_t))
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef struct RECORDER_Sample_s{
+    uint16_t voltage_raw;
+    uint16_t current_raw;
+}RECORDER_Sample_t;
+
+typedef struct RECORDER_Block_Header_s{
+    uint32_t sequence;                      //Incremented for every block written
+    uint16_t count;                         //Samples in the block
+    uint16_t reserved;
+    int64_t timestamp_us;                   //esp_timer time of the first sample
+    uint32_t period_us;                     //Sampling period
+    uint32_t magic;                         //Written last, marks the block as complete
+}RECORDER_Block_Header_t;
+
+//Layout of a block in flash, read in place through the memory map
+typedef struct RECORDER_Block_s{
+    RECORDER_Block_Header_t header;
+    RECORDER_Sample_t samples[];
+}RECORDER_Block_t;
+
+typedef struct RECORDER_Stats_s{
+    uint32_t blocks_written;
+    uint32_t samples_dropped;               //Samples lost while both buffers were full
+    uint32_t write_errors;
+}RECORDER_Stats_t;
+
+typedef struct RECORDER_Reader_s{
+    const uint8_t *pBase;
+    esp_partition_mmap_handle_t handle;
+    uint32_t block;                         //Next block to return
+    uint32_t remaining;                     //Blocks left to visit
+    uint32_t last_sequence;                 //Sequence of the head when opened
+}RECORDER_Reader_t;
+
+typedef enum RECORDER_Ret_e{
+    RECORDER_STATUS_FAIL,
+    RECORDER_STATUS_SUCCESS,
+}RECORDER_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Flash recorder initialization
+*
+*   This function is used to find the recorder partition and its write head
+*   and to start the writer task. Blocks carry consecutive sequence numbers
+*   around the partition, the head is the last block whose sequence follows
+*   the one of block 0, found with a binary search over the block headers.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  period_us           Sampling period stored with every block
+*
+*   \return     operation status
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_InitModule(uint32_t period_us);
+
+/***************************************************************************//*!
+*  \brief Flash recorder add samples
+*
+*   This function is used by the ADC path to record samples. They are
+*   copied into the RAM buffer being filled, a full buffer is swapped with
+*   the other one and the writer task is notified. Samples are dropped
+*   while both buffers are full.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pSamples            Samples to record
+*   \param[in]  count               Number of samples
+*   \param[in]  timestamp_us        esp_timer time of the first sample
+*
+*   \return     operation status, fail if samples were dropped
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_AddSamples(const RECORDER_Sample_t *pSamples, size_t count, int64_t timestamp_us);
+
+/***************************************************************************//*!
+*  \brief Flash recorder write pending buffer
+*
+*   This function is called by the writer task to erase the next block and
+*   write the full buffer to it. Samples go first and the header last, an
+*   interrupted write leaves a block without magic that is skipped. The
+*   buffer stays pending while the oldest block is held by the reader.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: Erases the oldest block.
+*
+*   \return     operation status, success if nothing was pending or the write waits for the reader
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_WritePending(void);
+
+/***************************************************************************//*!
+*  \brief Flash recorder statistics
+*
+*   This function is used to read the recorder counters.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_GetStats(RECORDER_Stats_t *pStats);
+
+/***************************************************************************//*!
+*  \brief Flash recorder open reader
+*
+*   This function is used to map the recorder partition for reading. Blocks
+*   written before this call are returned oldest first. Only one reader can
+*   be open at a time.
+*
+*   Preconditions: RECORDER_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pReader             Reader to open
+*
+*   \return     operation status
+*
+*******************************************************************************/
+RECORDER_Ret_t RECORDER_OpenReader(RECORDER_Reader_t *pReader);
+
+/***************************************************************************//*!
+*  \brief Flash recorder read next block
+*
+*   This function is used to get the next complete block. The block points
+*   into the mapped partition and is valid until the next call or until the
+*   reader is closed, the writer does not erase it meanwhile. Blocks the
+*   writer overwrote before the reader got to them are skipped.
+*
+*   Preconditions: RECORDER_OpenReader called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pReader             Reader
+*
+*   \return     next block, NULL once all blocks were returned
+*
+*******************************************************************************/
+const RECORDER_Block_t *RECORDER_ReadNextBlock(RECORDER_Reader_t *pReader);
+
+/***************************************************************************//*!
+*  \brief Flash recorder close reader
+*
+*   This function is used to unmap the recorder partition and release the
+*   last block returned.
+*
+*   Preconditions: RECORDER_OpenReader called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pReader             Reader to close
+*
+*******************************************************************************/
+void RECORDER_CloseReader(RECORDER_Reader_t *pReader);
+
+#endif//_FLASH_RECORDER_H
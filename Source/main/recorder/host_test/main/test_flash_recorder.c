@@ -0,0 +1,326 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Linux host flash recorder test
+ */
+
+#include <string.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_private/partition_linux.h"
+#include "unity.h"
+#include "unity_fixture.h"
+#include "Mocktask.h"
+#include "Mockqueue.h"
+
+#include "flashRecorder.h"
+
+#define TEST_PERIOD_US      (100)
+#define TEST_CHUNK          (64)
+
+static uint32_t block_count;
+static uint32_t sample_counter;
+static int recorder_mutex;
+
+static RECORDER_Sample_t test_sample(uint32_t n)
+{
+    RECORDER_Sample_t sample = {
+        .voltage_raw = (uint16_t)n,
+        .current_raw = (uint16_t)~n,
+    };
+    return sample;
+}
+
+/* record whole blocks, the writer task runs after every chunk */
+static void record_blocks(uint32_t blocks)
+{
+    RECORDER_Sample_t chunk[TEST_CHUNK];
+    uint32_t total = blocks * RECORDER_BLOCK_SAMPLES;
+
+    for (uint32_t done = 0; done < total; ) {
+        uint32_t count = (total - done < TEST_CHUNK) ? (total - done) : TEST_CHUNK;
+        for (uint32_t i = 0; i < count; i++) {
+            chunk[i] = test_sample(sample_counter + i);
+        }
+        TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_AddSamples(chunk, count, (int64_t)sample_counter * TEST_PERIOD_US));
+        TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_WritePending());
+        sample_counter += count;
+        done += count;
+    }
+}
+
+/* read the log back, checking blocks are in order and samples are contiguous */
+static uint32_t read_blocks(uint32_t first_sequence)
+{
+    RECORDER_Reader_t reader;
+    const RECORDER_Block_t *block;
+    uint32_t blocks = 0;
+
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_OpenReader(&reader));
+    while ((block = RECORDER_ReadNextBlock(&reader)) != NULL) {
+        TEST_ASSERT_EQUAL_UINT32(first_sequence + blocks, block->header.sequence);
+        TEST_ASSERT_EQUAL(RECORDER_BLOCK_SAMPLES, block->header.count);
+        TEST_ASSERT_EQUAL_UINT32(TEST_PERIOD_US, block->header.period_us);
+
+        uint32_t n = (uint32_t)(block->header.timestamp_us / TEST_PERIOD_US);
+        for (uint32_t i = 0; i < block->header.count; i++) {
+            RECORDER_Sample_t expected = test_sample(n + i);
+            TEST_ASSERT_EQUAL_MEMORY(&expected, &block->samples[i], sizeof(RECORDER_Sample_t));
+        }
+        blocks++;
+    }
+    RECORDER_CloseReader(&reader);
+
+    return blocks;
+}
+
+/* check a block returned by the reader against the samples recorded */
+static void check_block(const RECORDER_Block_t *block, uint32_t sequence)
+{
+    TEST_ASSERT_NOT_NULL(block);
+    TEST_ASSERT_EQUAL_UINT32(sequence, block->header.sequence);
+    TEST_ASSERT_EQUAL(RECORDER_BLOCK_SAMPLES, block->header.count);
+
+    uint32_t n = (uint32_t)(block->header.timestamp_us / TEST_PERIOD_US);
+    TEST_ASSERT_EQUAL_UINT32(sequence * RECORDER_BLOCK_SAMPLES, n);
+    for (uint32_t i = 0; i < block->header.count; i++) {
+        RECORDER_Sample_t expected = test_sample(n + i);
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &block->samples[i], sizeof(RECORDER_Sample_t));
+    }
+}
+
+/* add one block of samples, the writer task runs once */
+static void record_block_pending(void)
+{
+    RECORDER_Sample_t chunk[TEST_CHUNK];
+
+    for (uint32_t done = 0; done < RECORDER_BLOCK_SAMPLES; ) {
+        uint32_t count = (RECORDER_BLOCK_SAMPLES - done < TEST_CHUNK) ? (RECORDER_BLOCK_SAMPLES - done) : TEST_CHUNK;
+        for (uint32_t i = 0; i < count; i++) {
+            chunk[i] = test_sample(sample_counter + i);
+        }
+        TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_AddSamples(chunk, count, (int64_t)sample_counter * TEST_PERIOD_US));
+        sample_counter += count;
+        done += count;
+    }
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_WritePending());
+}
+
+static uint32_t blocks_written(void)
+{
+    RECORDER_Stats_t stats;
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_GetStats(&stats));
+    return stats.blocks_written;
+}
+
+/* restart the module on the same flash contents */
+static void reboot(void)
+{
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_InitModule(TEST_PERIOD_US));
+}
+
+/* start writing a block and lose power while its samples are written */
+static void power_loss_during_block(void)
+{
+    RECORDER_Sample_t chunk[TEST_CHUNK];
+    for (uint32_t i = 0; i < RECORDER_BLOCK_SAMPLES + 1; i += TEST_CHUNK) {
+        for (uint32_t j = 0; j < TEST_CHUNK; j++) {
+            chunk[j] = test_sample(sample_counter + i + j);
+        }
+        RECORDER_AddSamples(chunk, TEST_CHUNK, (int64_t)(sample_counter + i) * TEST_PERIOD_US);
+    }
+
+    // one erase, then 100 words of samples
+    esp_partition_fail_after(1 + 100, ESP_PARTITION_FAIL_AFTER_MODE_BOTH);
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_FAIL, RECORDER_WritePending());
+    esp_partition_fail_after(SIZE_MAX, 0);
+}
+
+TEST_GROUP(flash_recorder);
+
+TEST_SETUP(flash_recorder)
+{
+    // fresh erased flash file for every test
+    esp_partition_file_munmap();
+    esp_partition_file_mmap_ctrl_t *p_file_mmap_ctrl_input = esp_partition_get_file_mmap_ctrl_input();
+    memset(p_file_mmap_ctrl_input, 0, sizeof(*p_file_mmap_ctrl_input));
+    p_file_mmap_ctrl_input->remove_dump = true;
+
+    xTaskCreatePinnedToCore_IgnoreAndReturn(pdTRUE);
+    xQueueCreateMutex_IgnoreAndReturn((QueueHandle_t)&recorder_mutex);
+    xQueueSemaphoreTake_IgnoreAndReturn(pdTRUE);
+    xQueueGenericSend_IgnoreAndReturn(pdTRUE);
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, RECORDER_PARTITION_SUBTYPE, RECORDER_PARTITION_LABEL);
+    TEST_ASSERT_NOT_NULL(partition);
+    block_count = partition->size / RECORDER_BLOCK_SIZE;
+    sample_counter = 0;
+
+    reboot();
+}
+
+TEST_TEAR_DOWN(flash_recorder)
+{
+    esp_partition_fail_after(SIZE_MAX, 0);
+    esp_partition_file_munmap();
+}
+
+TEST(flash_recorder, test_empty_log)
+{
+    TEST_ASSERT_EQUAL_UINT32(0, read_blocks(0));
+}
+
+TEST(flash_recorder, test_record_and_read)
+{
+    record_blocks(3);
+    TEST_ASSERT_EQUAL_UINT32(3, read_blocks(0));
+
+    RECORDER_Stats_t stats;
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_GetStats(&stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.blocks_written);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.samples_dropped);
+
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(3, read_blocks(0));
+}
+
+TEST(flash_recorder, test_wraparound)
+{
+    record_blocks(block_count + 5);
+    TEST_ASSERT_EQUAL_UINT32(block_count, read_blocks(5));
+
+    // head search reads a header per halving step
+    esp_partition_clear_stats();
+    reboot();
+    uint32_t steps = 0;
+    for (uint32_t n = block_count; n > 1; n >>= 1) {
+        steps++;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(steps + 2, esp_partition_get_read_ops());
+
+    record_blocks(1);
+    TEST_ASSERT_EQUAL_UINT32(block_count, read_blocks(6));
+}
+
+TEST(flash_recorder, test_power_loss)
+{
+    record_blocks(3);
+    power_loss_during_block();
+
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(3, read_blocks(0));
+
+    sample_counter += RECORDER_BLOCK_SAMPLES;
+    record_blocks(1);
+    TEST_ASSERT_EQUAL_UINT32(4, read_blocks(0));
+}
+
+TEST(flash_recorder, test_power_loss_on_first_block_after_wrap)
+{
+    record_blocks(block_count);
+    power_loss_during_block();
+
+    reboot();
+    TEST_ASSERT_EQUAL_UINT32(block_count - 1, read_blocks(1));
+
+    sample_counter += RECORDER_BLOCK_SAMPLES;
+    record_blocks(1);
+    TEST_ASSERT_EQUAL_UINT32(block_count, read_blocks(1));
+}
+
+TEST(flash_recorder, test_overrun)
+{
+    RECORDER_Sample_t sample = test_sample(0);
+    RECORDER_Ret_t ret = RECORDER_STATUS_SUCCESS;
+
+    // the writer task never runs, two buffers fill up
+    for (uint32_t i = 0; i < 3 * RECORDER_BLOCK_SAMPLES; i++) {
+        if (RECORDER_AddSamples(&sample, 1, 0) != RECORDER_STATUS_SUCCESS) {
+            ret = RECORDER_STATUS_FAIL;
+        }
+    }
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_FAIL, ret);
+
+    RECORDER_Stats_t stats;
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_GetStats(&stats));
+    TEST_ASSERT_EQUAL_UINT32(RECORDER_BLOCK_SAMPLES, stats.samples_dropped);
+}
+
+TEST(flash_recorder, test_writer_waits_for_reader)
+{
+    RECORDER_Reader_t reader;
+    RECORDER_Reader_t second;
+
+    record_blocks(block_count);
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_OpenReader(&reader));
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_FAIL, RECORDER_OpenReader(&second));
+
+    // the oldest block is held, the writer keeps the buffer
+    const RECORDER_Block_t *block = RECORDER_ReadNextBlock(&reader);
+    check_block(block, 0);
+    record_block_pending();
+    TEST_ASSERT_EQUAL_UINT32(block_count, blocks_written());
+    check_block(block, 0);
+
+    // released by the next read, the pending buffer goes to the oldest block
+    check_block(RECORDER_ReadNextBlock(&reader), 1);
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_WritePending());
+    TEST_ASSERT_EQUAL_UINT32(block_count + 1, blocks_written());
+
+    // the block overwritten behind the reader is not returned again
+    uint32_t blocks = 2;
+    while ((block = RECORDER_ReadNextBlock(&reader)) != NULL) {
+        check_block(block, blocks);
+        blocks++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(block_count, blocks);
+    RECORDER_CloseReader(&reader);
+
+    TEST_ASSERT_EQUAL_UINT32(block_count, read_blocks(1));
+}
+
+TEST(flash_recorder, test_reader_skips_overwritten_blocks)
+{
+    RECORDER_Reader_t reader;
+
+    record_blocks(block_count);
+    TEST_ASSERT_EQUAL(RECORDER_STATUS_SUCCESS, RECORDER_OpenReader(&reader));
+
+    // nothing held yet, the oldest block is overwritten before the reader gets to it
+    record_blocks(1);
+    TEST_ASSERT_EQUAL_UINT32(block_count + 1, blocks_written());
+
+    uint32_t blocks = 0;
+    const RECORDER_Block_t *block;
+    while ((block = RECORDER_ReadNextBlock(&reader)) != NULL) {
+        check_block(block, blocks + 1);
+        blocks++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(block_count - 1, blocks);
+    RECORDER_CloseReader(&reader);
+}
+
+TEST_GROUP_RUNNER(flash_recorder)
+{
+    RUN_TEST_CASE(flash_recorder, test_empty_log);
+    RUN_TEST_CASE(flash_recorder, test_record_and_read);
+    RUN_TEST_CASE(flash_recorder, test_wraparound);
+    RUN_TEST_CASE(flash_recorder, test_power_loss);
+    RUN_TEST_CASE(flash_recorder, test_power_loss_on_first_block_after_wrap);
+    RUN_TEST_CASE(flash_recorder, test_overrun);
+    RUN_TEST_CASE(flash_recorder, test_writer_waits_for_reader);
+    RUN_TEST_CASE(flash_recorder, test_reader_skips_overwritten_blocks);
+}
+
+static void run_all_tests(void)
+{
+    RUN_TEST_GROUP(flash_recorder);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_MAIN_FUNC(run_all_tests);
+    return 0;
+}
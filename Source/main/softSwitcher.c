@@ -6,19 +6,24 @@
 /******************************************************************************
 *   Includes
 *******************************************************************************/
-#include "freertos/freeRTOS.h"
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
 #include "driver/gpio.h"
 #include "esp_log.h"
 
 #include "softSwitcher.h"
+#include "flightRecorder.h"
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
+#define SOFT_CHARGE_RESUME_SOC          (CONFIG_CHARGE_RESUME_SOC)
+
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
@@ -48,6 +53,11 @@ static SOFT_IO_Level_t pwr_active_level = SOFT_IO_LEVEL_HIGH;
 static uint8_t charging_io_num = 0xFF;
 static SOFT_IO_Level_t charging_active_level = SOFT_IO_LEVEL_HIGH;
 
+//Set once the charge is done, until the cell drops below SOFT_CHARGE_RESUME_SOC
+static bool charge_full = false;
+//Last charging output written by SOFT_UpdateCharging, the output is off after init
+static bool charge_on = false;
+
 static SemaphoreHandle_t soft_mutex_handle = NULL;
 
 static const char * TAG = "SOFT_SWITCHER";
@@ -77,11 +87,13 @@ static const char * TAG = "SOFT_SWITCHER";
 *******************************************************************************/
 SOFT_Switcher_Ret_t SOFT_InitModule(SOFT_IO_Config_t pwr_io, SOFT_IO_Config_t charging_io){
 
-    //Create mutex
-    soft_mutex_handle = xSemaphoreCreateMutex();
+    //Create mutex, once
     if(soft_mutex_handle == NULL){
-        ESP_LOGW(TAG, "Failed to create Soft Switcher mutex");
-        return SOFT_SWITCHER_STATUS_FAIL;
+        soft_mutex_handle = xSemaphoreCreateMutex();
+        if(soft_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Soft Switcher mutex");
+            return SOFT_SWITCHER_STATUS_FAIL;
+        }
     }
 
     xSemaphoreTake(soft_mutex_handle, portMAX_DELAY);
@@ -147,7 +159,7 @@ SOFT_Switcher_Ret_t SOFT_SetOutput(SOFT_IO_Id_t io_id){
     switch(io_id){
         case SOFT_SWITCHER_PWR_ID:
         {
-            gpio_set_level(pwr_io_num, (pwr_io_num == SOFT_IO_LEVEL_HIGH));
+            gpio_set_level(pwr_io_num, (pwr_active_level == SOFT_IO_LEVEL_HIGH));
         }
         break;
         
@@ -164,6 +176,7 @@ SOFT_Switcher_Ret_t SOFT_SetOutput(SOFT_IO_Id_t io_id){
         break;
     }
 
+    FLIGHT_REC_RECORD(FLIGHT_REC_TYPE_RAIL, io_id, 1);
     xSemaphoreGive(soft_mutex_handle);
 
     return SOFT_SWITCHER_STATUS_SUCCESS;
@@ -212,6 +225,7 @@ SOFT_Switcher_Ret_t SOFT_ClearOutput(SOFT_IO_Id_t io_id){
         break;
     }
 
+    FLIGHT_REC_RECORD(FLIGHT_REC_TYPE_RAIL, io_id, 0);
     xSemaphoreGive(soft_mutex_handle);
 
     return SOFT_SWITCHER_STATUS_SUCCESS;
@@ -281,6 +295,58 @@ SOFT_Switcher_Ret_t SOFT_GetIOState(SOFT_IO_Id_t io_id, uint8_t *pLevel){
     return SOFT_SWITCHER_STATUS_SUCCESS;
 }
 
+/***************************************************************************//*!
+*  \brief Soft Switcher update charging
+*
+*   This function is used to switch the charging output from the battery
+*   state. Charging runs while the charger input is present without fault,
+*   stops once the charger reports the charge done and resumes when the
+*   state of charge drops below CONFIG_CHARGE_RESUME_SOC. The output is
+*   only written when the decision changes, it can be switched by hand in
+*   between.
+*   
+*   Preconditions: SOFT_InitModule called. One caller at a time.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pStatus             Battery state
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SOFT_Switcher_Ret_t SOFT_UpdateCharging(const SOFT_Charge_Status_t *pStatus){
+
+    if(pStatus == NULL){
+        ESP_LOGW(TAG, "Failed to update charging -> Invalid status");
+        return SOFT_SWITCHER_STATUS_FAIL;
+    }
+
+    //Unknown battery state, switched by hand only
+    if(!pStatus->valid){
+        return SOFT_SWITCHER_STATUS_SUCCESS;
+    }
+
+    //The charger reports not charging once the output is off, the full state is kept here
+    if(pStatus->done){
+        charge_full = true;
+    }
+    else if(pStatus->soc < SOFT_CHARGE_RESUME_SOC){
+        charge_full = false;
+    }
+
+    bool charge = pStatus->power_good && !pStatus->fault && !charge_full;
+    if(charge == charge_on){
+        return SOFT_SWITCHER_STATUS_SUCCESS;
+    }
+
+    SOFT_Switcher_Ret_t ret = charge ? SOFT_SetOutput(SOFT_SWITCHER_CHARGING_ID) : SOFT_ClearOutput(SOFT_SWITCHER_CHARGING_ID);
+    if(ret == SOFT_SWITCHER_STATUS_SUCCESS){
+        ESP_LOGI(TAG, "Charging %s at %u%%%s", charge ? "started" : "stopped", pStatus->soc, pStatus->fault ? ", fault" : "");
+        charge_on = charge;
+    }
+
+    return ret;
+}
 
 /******************************************************************************
 *   Interrupts
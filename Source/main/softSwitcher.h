@@ -34,6 +34,15 @@ typedef struct SOFT_IO_Config_e{
     SOFT_IO_Level_t active_level; 
 }SOFT_IO_Config_t;
 
+//Battery state driving the charging output, e.g. read from the fuel gauge
+typedef struct SOFT_Charge_Status_s{
+    bool valid;                             //The charging output is left as is while false
+    uint8_t soc;                            //State of charge, in %
+    bool power_good;                        //Charger input present
+    bool done;                              //Charger reports the charge done
+    bool fault;                             //Charger or battery fault
+}SOFT_Charge_Status_t;
+
 typedef enum SOFT_Switcher_Ret_e{
     SOFT_SWITCHER_STATUS_FAIL,
     SOFT_SWITCHER_STATUS_SUCCESS,
@@ -119,4 +128,25 @@ SOFT_Switcher_Ret_t SOFT_ClearOutput(SOFT_IO_Id_t io_id);
 *******************************************************************************/
 SOFT_Switcher_Ret_t SOFT_GetIOState(SOFT_IO_Id_t io_id, uint8_t *pLevel);
 
+/***************************************************************************//*!
+*  \brief Soft Switcher update charging
+*
+*   This function is used to switch the charging output from the battery
+*   state. Charging runs while the charger input is present without fault,
+*   stops once the charger reports the charge done and resumes when the
+*   state of charge drops below CONFIG_CHARGE_RESUME_SOC. The output is
+*   only written when the decision changes, it can be switched by hand in
+*   between.
+*   
+*   Preconditions: SOFT_InitModule called. One caller at a time.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pStatus             Battery state
+*
+*   \return     operation status
+*
+*******************************************************************************/
+SOFT_Switcher_Ret_t SOFT_UpdateCharging(const SOFT_Charge_Status_t *pStatus);
+
 #endif//_SOFT_SWITCHER_H
\ No newline at end of file
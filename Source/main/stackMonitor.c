@@ -0,0 +1,249 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+
+#include "stackMonitor.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#ifdef CONFIG_STACK_MONITOR_MARGIN_PERCENT
+#define STACK_MON_MARGIN_PERCENT        (CONFIG_STACK_MONITOR_MARGIN_PERCENT)
+#else
+#define STACK_MON_MARGIN_PERCENT        (25)
+#endif
+
+//Recommended sizes are rounded up to this granularity
+#define STACK_MON_SIZE_ALIGN            (64)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define STACK_MON_ROUND_UP(x)           ((((x) + STACK_MON_SIZE_ALIGN - 1) / STACK_MON_SIZE_ALIGN) * STACK_MON_SIZE_ALIGN)
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+typedef struct STACK_MON_Task_s{
+    TaskHandle_t handle;
+    uint32_t stack_size;
+    uint32_t peak_usage;
+    bool warned;                            //Low stack warning already logged
+}STACK_MON_Task_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static uint32_t STACK_MON_Recommended(uint32_t peak_usage);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static STACK_MON_Task_t task_table[STACK_MON_MAX_TASKS];
+static uint8_t task_count = 0;
+
+static SemaphoreHandle_t stack_mon_mutex_handle = NULL;
+
+static const char * TAG = "STACK_MON";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static uint32_t STACK_MON_Recommended(uint32_t peak_usage){
+
+    uint32_t recommended = STACK_MON_ROUND_UP(peak_usage + (peak_usage * STACK_MON_MARGIN_PERCENT) / 100);
+
+    return (recommended < configMINIMAL_STACK_SIZE) ? configMINIMAL_STACK_SIZE : recommended;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Stack monitor initialization
+*
+*   This function is used to initialize the stack monitor.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_InitModule(void){
+
+    //Create mutex, once
+    if(stack_mon_mutex_handle == NULL){
+        stack_mon_mutex_handle = xSemaphoreCreateMutex();
+        if(stack_mon_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Stack Monitor mutex");
+            return STACK_MON_STATUS_FAIL;
+        }
+    }
+
+    task_count = 0;
+
+    return STACK_MON_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Stack monitor register task
+*
+*   This function is used by the modules creating a task to add it to the
+*   monitored tasks.
+*
+*   Preconditions: STACK_MON_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_handle         Task to monitor
+*   \param[in]  stack_size          Stack size the task was created with, in bytes
+*
+*   \return     operation status
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_RegisterTask(TaskHandle_t task_handle, uint32_t stack_size){
+
+    if(stack_mon_mutex_handle == NULL || task_handle == NULL){
+        return STACK_MON_STATUS_FAIL;
+    }
+
+    STACK_MON_Ret_t ret = STACK_MON_STATUS_FAIL;
+
+    xSemaphoreTake(stack_mon_mutex_handle, portMAX_DELAY);
+
+    if(task_count < STACK_MON_MAX_TASKS){
+        task_table[task_count].handle = task_handle;
+        task_table[task_count].stack_size = stack_size;
+        task_table[task_count].peak_usage = 0;
+        task_table[task_count].warned = false;
+        task_count++;
+        ret = STACK_MON_STATUS_SUCCESS;
+    }
+
+    xSemaphoreGive(stack_mon_mutex_handle);
+
+    if(ret != STACK_MON_STATUS_SUCCESS){
+        ESP_LOGW(TAG, "Failed to register task '%s' -> Table full", pcTaskGetName(task_handle));
+    }
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief Stack monitor process
+*
+*   This function is used to read the stack high water mark of every
+*   monitored task. When the peak usage of a task grows, the peak and the
+*   recommended size are logged as
+*
+*       '<task name>' size <size> peak <peak> recommended <size>
+*
+*   which tools/stack_report.py merges with the build time estimates. A
+*   warning is logged when the free stack of a task goes below the margin.
+*
+*   Preconditions: STACK_MON_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_Process(void){
+
+    if(stack_mon_mutex_handle == NULL){
+        return STACK_MON_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(stack_mon_mutex_handle, portMAX_DELAY);
+
+    for(uint8_t i=0; i<task_count; i++){
+        STACK_MON_Task_t *pTask = &task_table[i];
+
+        //ESP-IDF FreeRTOS counts stacks in bytes
+        uint32_t free_bytes = uxTaskGetStackHighWaterMark(pTask->handle) * sizeof(StackType_t);
+        uint32_t usage = (free_bytes < pTask->stack_size) ? (pTask->stack_size - free_bytes) : 0;
+
+        if(usage <= pTask->peak_usage){
+            continue;
+        }
+        pTask->peak_usage = usage;
+
+        ESP_LOGI(TAG, "'%s' size %u peak %u recommended %u",
+                 pcTaskGetName(pTask->handle),
+                 (unsigned)pTask->stack_size,
+                 (unsigned)usage,
+                 (unsigned)STACK_MON_Recommended(usage));
+
+        if(!pTask->warned && (free_bytes * 100) < (pTask->stack_size * STACK_MON_MARGIN_PERCENT)){
+            ESP_LOGW(TAG, "'%s' only has %u bytes of stack left", pcTaskGetName(pTask->handle), (unsigned)free_bytes);
+            pTask->warned = true;
+        }
+    }
+
+    xSemaphoreGive(stack_mon_mutex_handle);
+
+    return STACK_MON_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Stack monitor task statistics
+*
+*   This function is used to read the statistics of a monitored task.
+*
+*   Preconditions: STACK_MON_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index               Index of the task, in registration order
+*   \param[out] pStats              Pointer to store the statistics
+*
+*   \return     operation status, fail if no task is registered at index
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_GetTaskStats(uint8_t index, STACK_MON_Task_Stats_t *pStats){
+
+    if(stack_mon_mutex_handle == NULL || pStats == NULL){
+        return STACK_MON_STATUS_FAIL;
+    }
+
+    STACK_MON_Ret_t ret = STACK_MON_STATUS_FAIL;
+
+    xSemaphoreTake(stack_mon_mutex_handle, portMAX_DELAY);
+
+    if(index < task_count){
+        pStats->pName = pcTaskGetName(task_table[index].handle);
+        pStats->stack_size = task_table[index].stack_size;
+        pStats->peak_usage = task_table[index].peak_usage;
+        pStats->recommended_size = STACK_MON_Recommended(task_table[index].peak_usage);
+        ret = STACK_MON_STATUS_SUCCESS;
+    }
+
+    xSemaphoreGive(stack_mon_mutex_handle);
+
+    return ret;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
@@ -0,0 +1,118 @@
+#ifndef _STACK_MONITOR_H
+#define _STACK_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define STACK_MON_MAX_TASKS                 (8)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef struct STACK_MON_Task_Stats_s{
+    const char *pName;                      //FreeRTOS task name
+    uint32_t stack_size;                    //Configured stack size, in bytes
+    uint32_t peak_usage;                    //Highest stack usage seen, in bytes
+    uint32_t recommended_size;              //Peak usage plus margin, in bytes
+}STACK_MON_Task_Stats_t;
+
+typedef enum STACK_MON_Ret_e{
+    STACK_MON_STATUS_FAIL,
+    STACK_MON_STATUS_SUCCESS,
+}STACK_MON_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Stack monitor initialization
+*
+*   This function is used to initialize the stack monitor.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_InitModule(void);
+
+/***************************************************************************//*!
+*  \brief Stack monitor register task
+*
+*   This function is used by the modules creating a task to add it to the
+*   monitored tasks.
+*
+*   Preconditions: STACK_MON_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  task_handle         Task to monitor
+*   \param[in]  stack_size          Stack size the task was created with, in bytes
+*
+*   \return     operation status
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_RegisterTask(TaskHandle_t task_handle, uint32_t stack_size);
+
+/***************************************************************************//*!
+*  \brief Stack monitor process
+*
+*   This function is used to read the stack high water mark of every
+*   monitored task. When the peak usage of a task grows, the peak and the
+*   recommended size are logged as
+*
+*       '<task name>' size <size> peak <peak> recommended <size>
+*
+*   which tools/stack_report.py merges with the build time estimates. A
+*   warning is logged when the free stack of a task goes below the margin.
+*
+*   Preconditions: STACK_MON_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_Process(void);
+
+/***************************************************************************//*!
+*  \brief Stack monitor task statistics
+*
+*   This function is used to read the statistics of a monitored task.
+*
+*   Preconditions: STACK_MON_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index               Index of the task, in registration order
+*   \param[out] pStats              Pointer to store the statistics
+*
+*   \return     operation status, fail if no task is registered at index
+*
+*******************************************************************************/
+STACK_MON_Ret_t STACK_MON_GetTaskStats(uint8_t index, STACK_MON_Task_Stats_t *pStats);
+
+#endif//_STACK_MONITOR_H
@@ -0,0 +1,244 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "cJSON.h"
+#include "cJSON_Writer.h"
+#include "telemetry.pb-c.h"
+
+#include "telemetryEncoder.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define ROUNDS                          (200000)
+#define JSON_BUFFER_SIZE                (512)
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const TELEMETRY_Snapshot_t typical_snapshot = {
+    .sequence = 1234,
+    .uptime_s = 86400,
+    .rails = {
+        [TELEMETRY_RAIL_PWR_ID] = { .enabled = true, .voltage_mv = 5020 },
+        [TELEMETRY_RAIL_CHARGING_ID] = { .enabled = false, .voltage_mv = 0 },
+    },
+    .battery = { .voltage_mv = 3912, .level_percent = 76, .charging = false },
+    .current = { .last_ma = -412, .min_ma = -1250, .max_ma = 180, .average_ma = -398, .samples = 600 },
+    .temperature_dc = 287,
+    .buttons = { .short_presses = 42, .long_presses = 3 },
+};
+
+static const TELEMETRY_Snapshot_t largest_snapshot = {
+    .sequence = UINT32_MAX,
+    .uptime_s = UINT32_MAX,
+    .rails = {
+        [TELEMETRY_RAIL_PWR_ID] = { .enabled = true, .voltage_mv = UINT32_MAX },
+        [TELEMETRY_RAIL_CHARGING_ID] = { .enabled = true, .voltage_mv = UINT32_MAX },
+    },
+    .battery = { .voltage_mv = UINT32_MAX, .level_percent = UINT8_MAX, .charging = true },
+    .current = { .last_ma = INT32_MIN, .min_ma = INT32_MIN, .max_ma = INT32_MIN, .average_ma = INT32_MIN, .samples = UINT32_MAX },
+    .temperature_dc = INT32_MIN,
+    .buttons = { .short_presses = UINT32_MAX, .long_presses = UINT32_MAX },
+};
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static double elapsed_ns(clock_t start){
+
+    return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / ROUNDS;
+}
+
+static size_t encode_json_tree(const TELEMETRY_Snapshot_t *pSnapshot, char *pBuffer){
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON *rails = cJSON_AddArrayToObject(root, "rails");
+    cJSON *item = NULL;
+    size_t length = 0;
+
+    cJSON_AddNumberToObject(root, "sequence", pSnapshot->sequence);
+    cJSON_AddNumberToObject(root, "uptime_s", pSnapshot->uptime_s);
+    for(int i = 0; i < TELEMETRY_RAIL_COUNT; i++){
+        item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "id", i);
+        cJSON_AddBoolToObject(item, "enabled", pSnapshot->rails[i].enabled);
+        cJSON_AddNumberToObject(item, "voltage_mv", pSnapshot->rails[i].voltage_mv);
+        cJSON_AddItemToArray(rails, item);
+    }
+    item = cJSON_AddObjectToObject(root, "battery");
+    cJSON_AddNumberToObject(item, "voltage_mv", pSnapshot->battery.voltage_mv);
+    cJSON_AddNumberToObject(item, "level_percent", pSnapshot->battery.level_percent);
+    cJSON_AddBoolToObject(item, "charging", pSnapshot->battery.charging);
+    item = cJSON_AddObjectToObject(root, "current");
+    cJSON_AddNumberToObject(item, "last_ma", pSnapshot->current.last_ma);
+    cJSON_AddNumberToObject(item, "min_ma", pSnapshot->current.min_ma);
+    cJSON_AddNumberToObject(item, "max_ma", pSnapshot->current.max_ma);
+    cJSON_AddNumberToObject(item, "average_ma", pSnapshot->current.average_ma);
+    cJSON_AddNumberToObject(item, "samples", pSnapshot->current.samples);
+    cJSON_AddNumberToObject(root, "temperature_dc", pSnapshot->temperature_dc);
+    item = cJSON_AddObjectToObject(root, "buttons");
+    cJSON_AddNumberToObject(item, "short_presses", pSnapshot->buttons.short_presses);
+    cJSON_AddNumberToObject(item, "long_presses", pSnapshot->buttons.long_presses);
+
+    if(cJSON_PrintPreallocated(root, pBuffer, JSON_BUFFER_SIZE, 0)){
+        length = strlen(pBuffer);
+    }
+    cJSON_Delete(root);
+
+    return length;
+}
+
+static size_t encode_json_writer(const TELEMETRY_Snapshot_t *pSnapshot, char *pBuffer){
+
+    cJSON_Writer writer;
+
+    cJSON_WriterInit(&writer, pBuffer, JSON_BUFFER_SIZE, NULL, NULL);
+    cJSON_WriterStartObject(&writer);
+    cJSON_WriterKey(&writer, "sequence");
+    cJSON_WriterInt(&writer, (long)pSnapshot->sequence);
+    cJSON_WriterKey(&writer, "uptime_s");
+    cJSON_WriterInt(&writer, (long)pSnapshot->uptime_s);
+    cJSON_WriterKey(&writer, "rails");
+    cJSON_WriterStartArray(&writer);
+    for(int i = 0; i < TELEMETRY_RAIL_COUNT; i++){
+        cJSON_WriterStartObject(&writer);
+        cJSON_WriterKey(&writer, "id");
+        cJSON_WriterInt(&writer, i);
+        cJSON_WriterKey(&writer, "enabled");
+        cJSON_WriterBool(&writer, pSnapshot->rails[i].enabled);
+        cJSON_WriterKey(&writer, "voltage_mv");
+        cJSON_WriterInt(&writer, (long)pSnapshot->rails[i].voltage_mv);
+        cJSON_WriterEndObject(&writer);
+    }
+    cJSON_WriterEndArray(&writer);
+    cJSON_WriterKey(&writer, "battery");
+    cJSON_WriterStartObject(&writer);
+    cJSON_WriterKey(&writer, "voltage_mv");
+    cJSON_WriterInt(&writer, (long)pSnapshot->battery.voltage_mv);
+    cJSON_WriterKey(&writer, "level_percent");
+    cJSON_WriterInt(&writer, pSnapshot->battery.level_percent);
+    cJSON_WriterKey(&writer, "charging");
+    cJSON_WriterBool(&writer, pSnapshot->battery.charging);
+    cJSON_WriterEndObject(&writer);
+    cJSON_WriterKey(&writer, "current");
+    cJSON_WriterStartObject(&writer);
+    cJSON_WriterKey(&writer, "last_ma");
+    cJSON_WriterInt(&writer, pSnapshot->current.last_ma);
+    cJSON_WriterKey(&writer, "min_ma");
+    cJSON_WriterInt(&writer, pSnapshot->current.min_ma);
+    cJSON_WriterKey(&writer, "max_ma");
+    cJSON_WriterInt(&writer, pSnapshot->current.max_ma);
+    cJSON_WriterKey(&writer, "average_ma");
+    cJSON_WriterInt(&writer, pSnapshot->current.average_ma);
+    cJSON_WriterKey(&writer, "samples");
+    cJSON_WriterInt(&writer, (long)pSnapshot->current.samples);
+    cJSON_WriterEndObject(&writer);
+    cJSON_WriterKey(&writer, "temperature_dc");
+    cJSON_WriterInt(&writer, pSnapshot->temperature_dc);
+    cJSON_WriterKey(&writer, "buttons");
+    cJSON_WriterStartObject(&writer);
+    cJSON_WriterKey(&writer, "short_presses");
+    cJSON_WriterInt(&writer, (long)pSnapshot->buttons.short_presses);
+    cJSON_WriterKey(&writer, "long_presses");
+    cJSON_WriterInt(&writer, (long)pSnapshot->buttons.long_presses);
+    cJSON_WriterEndObject(&writer);
+    cJSON_WriterEndObject(&writer);
+
+    return cJSON_WriterFinish(&writer) ? writer.written : 0;
+}
+
+static int check_round_trip(const TELEMETRY_Snapshot_t *pSnapshot){
+
+    uint8_t buffer[TELEMETRY_MAX_ENCODED_SIZE];
+    size_t length = 0;
+    TelemetrySnapshot *pDecoded = NULL;
+    int ok = 0;
+
+    if(TELEMETRY_EncodeSnapshot(pSnapshot, buffer, sizeof(buffer), &length) != TELEMETRY_STATUS_SUCCESS){
+        printf("snapshot doesn't fit in TELEMETRY_MAX_ENCODED_SIZE\n");
+        return 0;
+    }
+
+    //One byte short has to fail instead of truncating
+    if(TELEMETRY_EncodeSnapshot(pSnapshot, buffer, length - 1, &length) != TELEMETRY_STATUS_FAIL){
+        printf("encoding into a too small buffer didn't fail\n");
+        return 0;
+    }
+    TELEMETRY_EncodeSnapshot(pSnapshot, buffer, sizeof(buffer), &length);
+
+    pDecoded = telemetry_snapshot__unpack(NULL, length, buffer);
+    if(pDecoded != NULL){
+        ok = (pDecoded->sequence == pSnapshot->sequence)
+            && (pDecoded->uptime_s == pSnapshot->uptime_s)
+            && (pDecoded->n_rails == TELEMETRY_RAIL_COUNT)
+            && (pDecoded->rails[TELEMETRY_RAIL_CHARGING_ID]->id == TELEMETRY_RAIL_ID__RailCharging)
+            && ((bool)pDecoded->rails[TELEMETRY_RAIL_PWR_ID]->enabled == pSnapshot->rails[TELEMETRY_RAIL_PWR_ID].enabled)
+            && (pDecoded->rails[TELEMETRY_RAIL_PWR_ID]->voltage_mv == pSnapshot->rails[TELEMETRY_RAIL_PWR_ID].voltage_mv)
+            && (pDecoded->battery->voltage_mv == pSnapshot->battery.voltage_mv)
+            && (pDecoded->battery->level_percent == pSnapshot->battery.level_percent)
+            && (pDecoded->current->min_ma == pSnapshot->current.min_ma)
+            && (pDecoded->current->samples == pSnapshot->current.samples)
+            && (pDecoded->temperature_dc == pSnapshot->temperature_dc)
+            && (pDecoded->buttons->long_presses == pSnapshot->buttons.long_presses);
+        telemetry_snapshot__free_unpacked(pDecoded, NULL);
+    }
+    if(!ok){
+        printf("decoded snapshot doesn't match\n");
+    }
+
+    return ok;
+}
+
+int main(void){
+
+    uint8_t protobuf[TELEMETRY_MAX_ENCODED_SIZE];
+    char json[JSON_BUFFER_SIZE];
+    size_t protobuf_length = 0;
+    size_t tree_length = 0;
+    size_t writer_length = 0;
+    clock_t start = 0;
+    double protobuf_ns = 0;
+    double tree_ns = 0;
+    double writer_ns = 0;
+
+    if(!check_round_trip(&typical_snapshot) || !check_round_trip(&largest_snapshot)){
+        return 1;
+    }
+    TELEMETRY_EncodeSnapshot(&largest_snapshot, protobuf, sizeof(protobuf), &protobuf_length);
+    printf("largest snapshot: %zu bytes, TELEMETRY_MAX_ENCODED_SIZE %d\n", protobuf_length, TELEMETRY_MAX_ENCODED_SIZE);
+
+    start = clock();
+    for(int i = 0; i < ROUNDS; i++){
+        TELEMETRY_EncodeSnapshot(&typical_snapshot, protobuf, sizeof(protobuf), &protobuf_length);
+    }
+    protobuf_ns = elapsed_ns(start);
+
+    start = clock();
+    for(int i = 0; i < ROUNDS; i++){
+        tree_length = encode_json_tree(&typical_snapshot, json);
+    }
+    tree_ns = elapsed_ns(start);
+
+    start = clock();
+    for(int i = 0; i < ROUNDS; i++){
+        writer_length = encode_json_writer(&typical_snapshot, json);
+    }
+    writer_ns = elapsed_ns(start);
+
+    printf("typical snapshot:\n");
+    printf("  protobuf-c          %4zu bytes %8.1f ns\n", protobuf_length, protobuf_ns);
+    printf("  cJSON tree + print  %4zu bytes %8.1f ns\n", tree_length, tree_ns);
+    printf("  cJSON_Writer        %4zu bytes %8.1f ns\n", writer_length, writer_ns);
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "esp_transport.h"
+#define CATCH_CONFIG_MAIN  // This tells the catch header to generate a main
+#include "catch.hpp"
+
+#include "mqtt_client.h"
+extern "C" {
+#include "Mockesp_event.h"
+#include "Mockesp_mac.h"
+#include "Mockesp_transport.h"
+#include "Mockesp_transport_ssl.h"
+#include "Mockesp_transport_tcp.h"
+#include "Mockesp_transport_ws.h"
+#include "Mockevent_groups.h"
+#include "Mockhttp_parser.h"
+#include "Mockqueue.h"
+#include "Mocktask.h"
+#if __has_include ("Mockidf_additions.h")
+/* Some functions were moved from "task.h" to "idf_additions.h" */
+#include "Mockidf_additions.h"
+#endif
+#include "Mockesp_timer.h"
+
+#include "telemetryBatch.h"
+#include "telemetryPublisher.h"
+
+    /*
+     * The following functions are not directly called but the generation of them
+     * from cmock is broken, so we need to define them here.
+     */
+    esp_err_t esp_tls_get_and_clear_last_error(esp_tls_error_handle_t h, int *esp_tls_code, int *esp_tls_flags)
+    {
+        return ESP_OK;
+    }
+}
+
+namespace {
+
+struct sample {
+    TELEMETRY_Channel_t channel;
+    uint32_t timestamp_ms;
+    int32_t value;
+};
+
+std::vector<sample> decode(const TELEMETRY_Batch_t &batch)
+{
+    std::vector<sample> samples;
+    auto collect = [](void *context, TELEMETRY_Channel_t channel, uint32_t timestamp_ms, int32_t value) {
+        static_cast<std::vector<sample> *>(context)->push_back({channel, timestamp_ms, value});
+    };
+    REQUIRE(TELEMETRY_BatchDecode(batch.pBuffer, batch.length, collect, &samples) == TELEMETRY_BATCH_STATUS_SUCCESS);
+    return samples;
+}
+
+using unique_mqtt_client = std::unique_ptr < std::remove_pointer_t<esp_mqtt_client_handle_t>, decltype([](esp_mqtt_client_handle_t client)
+{
+    esp_mqtt_client_destroy(client);
+}) >;
+
+} // namespace
+
+SCENARIO("Telemetry batch")
+{
+    std::vector<uint8_t> buffer(512);
+    TELEMETRY_Batch_t batch;
+    REQUIRE(TELEMETRY_BatchInit(&batch, buffer.data(), buffer.size(), 100) == TELEMETRY_BATCH_STATUS_SUCCESS);
+
+    GIVEN("Samples spread over a few buckets") {
+        REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_CURRENT, 100, 1010) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_CURRENT, 103, 1050) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_TEMPERATURE, -215, 1090) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_CURRENT, 90, 1120) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_CURRENT, 95, 1450) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        REQUIRE(TELEMETRY_BatchCloseBucket(&batch, 1499) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        REQUIRE(batch.records == 2);
+        REQUIRE(TELEMETRY_BatchCloseBucket(&batch, 1500) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        REQUIRE(batch.records == 3);
+
+        THEN("Buckets hold the rounded averages at their start time") {
+            auto samples = decode(batch);
+            REQUIRE(samples.size() == 4);
+            CHECK(samples[0].channel == TELEMETRY_CH_CURRENT);
+            CHECK(samples[0].timestamp_ms == 1000);
+            CHECK(samples[0].value == 102);
+            CHECK(samples[1].channel == TELEMETRY_CH_TEMPERATURE);
+            CHECK(samples[1].value == -215);
+            CHECK(samples[2].timestamp_ms == 1100);
+            CHECK(samples[2].value == 90);
+            CHECK(samples[3].timestamp_ms == 1400);
+            CHECK(samples[3].value == 95);
+        }
+        THEN("The open bucket moves to the restarted batch") {
+            REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_CURRENT, 80, 1510) == TELEMETRY_BATCH_STATUS_SUCCESS);
+            std::vector<uint8_t> next(128);
+            REQUIRE(TELEMETRY_BatchRestart(&batch, next.data(), next.size(), 200) == TELEMETRY_BATCH_STATUS_SUCCESS);
+            REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_CURRENT, 84, 1690) == TELEMETRY_BATCH_STATUS_SUCCESS);
+            REQUIRE(TELEMETRY_BatchCloseBucket(&batch, 1700) == TELEMETRY_BATCH_STATUS_SUCCESS);
+            auto samples = decode(batch);
+            REQUIRE(samples.size() == 1);
+            CHECK(samples[0].timestamp_ms == 1500);
+            CHECK(samples[0].value == 82);
+        }
+    }
+
+    GIVEN("A slowly changing channel") {
+        for (uint32_t i = 0; i < 100; i++) {
+            REQUIRE(TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_BATT_VOLTAGE, 3700 + (i % 5), i * 100) == TELEMETRY_BATCH_STATUS_SUCCESS);
+        }
+        REQUIRE(TELEMETRY_BatchCloseBucket(&batch, 100 * 100) == TELEMETRY_BATCH_STATUS_SUCCESS);
+
+        THEN("Each bucket takes three bytes") {
+            REQUIRE(batch.records == 100);
+            REQUIRE(batch.length <= TELEMETRY_BATCH_MAX_HEADER + 1 + 100 * 3);
+            auto samples = decode(batch);
+            REQUIRE(samples.size() == 100);
+            CHECK(samples[99].timestamp_ms == 9900);
+            CHECK(samples[99].value == 3704);
+        }
+    }
+
+    GIVEN("A batch without room for the next bucket") {
+        uint32_t now = 0;
+        TELEMETRY_Batch_Ret_t ret;
+        while ((ret = TELEMETRY_BatchAdd(&batch, TELEMETRY_CH_PWR_VOLTAGE, (now & 1) ? INT32_MAX : INT32_MIN, now)) == TELEMETRY_BATCH_STATUS_SUCCESS) {
+            now += 100;
+        }
+
+        THEN("The sample is refused and the batch stays readable") {
+            REQUIRE(ret == TELEMETRY_BATCH_STATUS_FULL);
+            REQUIRE(batch.bucket_open);
+            REQUIRE(batch.length > buffer.size() - TELEMETRY_BATCH_MAX_RECORD);
+            REQUIRE(decode(batch).size() == batch.records);
+        }
+    }
+
+    GIVEN("A malformed batch") {
+        uint8_t truncated[] = { TELEMETRY_BATCH_VERSION, 0x00, 0x64, 0x00, 0x01, 0x80 };
+        auto ignore = [](void *, TELEMETRY_Channel_t, uint32_t, int32_t) {};
+        THEN("Decoding fails") {
+            REQUIRE(TELEMETRY_BatchDecode(truncated, sizeof(truncated), ignore, nullptr) == TELEMETRY_BATCH_STATUS_FAIL);
+            truncated[0] = TELEMETRY_BATCH_VERSION + 1;
+            REQUIRE(TELEMETRY_BatchDecode(truncated, 3, ignore, nullptr) == TELEMETRY_BATCH_STATUS_FAIL);
+        }
+    }
+}
+
+SCENARIO("Telemetry publisher")
+{
+    // The client is never started, nothing leaves the outbox
+    int mtx = 0;
+    int transport_list = 0;
+    int transport = 0;
+    int event_group = 0;
+    uint8_t mac[] = {0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55};
+    int64_t now_us = 0;
+    esp_timer_get_time_IgnoreAndReturn(now_us);
+    xQueueTakeMutexRecursive_IgnoreAndReturn(true);
+    xQueueGiveMutexRecursive_IgnoreAndReturn(true);
+    xQueueSemaphoreTake_IgnoreAndReturn(true);
+    xQueueGenericSend_IgnoreAndReturn(true);
+    xQueueCreateMutex_IgnoreAndReturn(reinterpret_cast<QueueHandle_t>(&mtx));
+    xEventGroupCreate_IgnoreAndReturn(reinterpret_cast<EventGroupHandle_t>(&event_group));
+    esp_transport_list_init_IgnoreAndReturn(reinterpret_cast<esp_transport_list_handle_t>(&transport_list));
+    esp_transport_tcp_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
+    esp_transport_ssl_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
+    esp_transport_ws_init_IgnoreAndReturn(reinterpret_cast<esp_transport_handle_t>(&transport));
+    esp_transport_ws_set_subprotocol_IgnoreAndReturn(ESP_OK);
+    esp_transport_list_add_IgnoreAndReturn(ESP_OK);
+    esp_transport_set_default_port_IgnoreAndReturn(ESP_OK);
+    esp_event_loop_create_IgnoreAndReturn(ESP_OK);
+    esp_read_mac_IgnoreAndReturn(ESP_OK);
+    esp_read_mac_ReturnThruPtr_mac(mac);
+    esp_transport_list_destroy_IgnoreAndReturn(ESP_OK);
+    esp_transport_destroy_IgnoreAndReturn(ESP_OK);
+    vEventGroupDelete_Ignore();
+    vQueueDelete_Ignore();
+
+    esp_mqtt_client_config_t config{};
+    config.broker.address.hostname = "1.1.1.1";
+    config.broker.address.transport = MQTT_TRANSPORT_OVER_TCP;
+    config.outbox.limit = 600;
+    auto client = unique_mqtt_client{esp_mqtt_client_init(&config)};
+    REQUIRE(client != nullptr);
+
+    TELEMETRY_Pub_Config_t pub_config = {
+        .client = client.get(),
+        .topic = "device/telemetry",
+        .qos = 1,
+        .bucket_ms = 100,
+        .max_age_ms = 1000,
+        .flush_size = 256,
+    };
+    REQUIRE(TELEMETRY_InitPublisher(&pub_config) == TELEMETRY_PUB_STATUS_SUCCESS);
+
+    // Sensor controllers report every 10 ms, the publisher is processed every 50 ms
+    auto run_for = [&](uint32_t ms) {
+        for (uint32_t i = 0; i < ms / 10; i++) {
+            now_us += 10 * 1000;
+            esp_timer_get_time_IgnoreAndReturn(now_us);
+            int32_t t = static_cast<int32_t>(now_us / 1000);
+            REQUIRE(TELEMETRY_AddSample(TELEMETRY_CH_CURRENT, 250 + (t % 7)) == TELEMETRY_PUB_STATUS_SUCCESS);
+            REQUIRE(TELEMETRY_AddSample(TELEMETRY_CH_BATT_VOLTAGE, 3900 - t / 1000) == TELEMETRY_PUB_STATUS_SUCCESS);
+            if (i % 5 == 4) {
+                REQUIRE(TELEMETRY_ProcessPublisher() == TELEMETRY_PUB_STATUS_SUCCESS);
+            }
+        }
+    };
+    TELEMETRY_Pub_Stats_t stats;
+
+    GIVEN("An outbox with room") {
+        run_for(1050);
+
+        THEN("One batch per max age is enqueued") {
+            REQUIRE(TELEMETRY_GetPublisherStats(&stats) == TELEMETRY_PUB_STATUS_SUCCESS);
+            CHECK(stats.batches_sent == 1);
+            CHECK(stats.batches_dropped == 0);
+            CHECK(stats.bucket_ms == 100);
+            CHECK_FALSE(stats.pending);
+            // 10 buckets of two channels in a fraction of one sample per message
+            CHECK(esp_mqtt_client_get_outbox_size(client.get()) < 100);
+        }
+    }
+
+    GIVEN("An outbox that fills up") {
+        run_for(30000);
+        REQUIRE(TELEMETRY_GetPublisherStats(&stats) == TELEMETRY_PUB_STATUS_SUCCESS);
+
+        THEN("Buckets get coarser and the oldest waiting batches are dropped") {
+            CHECK(stats.bucket_ms == 100 << TELEMETRY_PUB_MAX_COARSENING);
+            CHECK(stats.pending);
+            CHECK(stats.batches_dropped > 0);
+        }
+        AND_WHEN("The outbox has room again") {
+            config.outbox.limit = 0;
+            REQUIRE(esp_mqtt_set_config(client.get(), &config) == ESP_OK);
+            uint32_t sent = stats.batches_sent;
+            run_for(60000);
+            REQUIRE(TELEMETRY_GetPublisherStats(&stats) == TELEMETRY_PUB_STATUS_SUCCESS);
+
+            THEN("Every accepted batch halves the buckets again") {
+                CHECK(stats.batches_sent > sent + TELEMETRY_PUB_MAX_COARSENING);
+                CHECK(stats.bucket_ms == 100);
+                CHECK_FALSE(stats.pending);
+            }
+        }
+    }
+}
@@ -0,0 +1,647 @@
+/* Generated by the protocol buffer compiler.  DO NOT EDIT! */
+/* Generated from: telemetry.proto */
+
+/* Do not generate deprecated warnings for self */
+#ifndef PROTOBUF_C__NO_DEPRECATED
+#define PROTOBUF_C__NO_DEPRECATED
+#endif
+
+#include "telemetry.pb-c.h"
+void   telemetry_rail__init
+                     (TelemetryRail         *message)
+{
+  static const TelemetryRail init_value = TELEMETRY_RAIL__INIT;
+  *message = init_value;
+}
+size_t telemetry_rail__get_packed_size
+                     (const TelemetryRail *message)
+{
+  assert(message->base.descriptor == &telemetry_rail__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t telemetry_rail__pack
+                     (const TelemetryRail *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &telemetry_rail__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t telemetry_rail__pack_to_buffer
+                     (const TelemetryRail *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &telemetry_rail__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+TelemetryRail *
+       telemetry_rail__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (TelemetryRail *)
+     protobuf_c_message_unpack (&telemetry_rail__descriptor,
+                                allocator, len, data);
+}
+void   telemetry_rail__free_unpacked
+                     (TelemetryRail *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &telemetry_rail__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+void   telemetry_battery__init
+                     (TelemetryBattery         *message)
+{
+  static const TelemetryBattery init_value = TELEMETRY_BATTERY__INIT;
+  *message = init_value;
+}
+size_t telemetry_battery__get_packed_size
+                     (const TelemetryBattery *message)
+{
+  assert(message->base.descriptor == &telemetry_battery__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t telemetry_battery__pack
+                     (const TelemetryBattery *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &telemetry_battery__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t telemetry_battery__pack_to_buffer
+                     (const TelemetryBattery *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &telemetry_battery__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+TelemetryBattery *
+       telemetry_battery__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (TelemetryBattery *)
+     protobuf_c_message_unpack (&telemetry_battery__descriptor,
+                                allocator, len, data);
+}
+void   telemetry_battery__free_unpacked
+                     (TelemetryBattery *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &telemetry_battery__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+void   telemetry_current__init
+                     (TelemetryCurrent         *message)
+{
+  static const TelemetryCurrent init_value = TELEMETRY_CURRENT__INIT;
+  *message = init_value;
+}
+size_t telemetry_current__get_packed_size
+                     (const TelemetryCurrent *message)
+{
+  assert(message->base.descriptor == &telemetry_current__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t telemetry_current__pack
+                     (const TelemetryCurrent *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &telemetry_current__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t telemetry_current__pack_to_buffer
+                     (const TelemetryCurrent *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &telemetry_current__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+TelemetryCurrent *
+       telemetry_current__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (TelemetryCurrent *)
+     protobuf_c_message_unpack (&telemetry_current__descriptor,
+                                allocator, len, data);
+}
+void   telemetry_current__free_unpacked
+                     (TelemetryCurrent *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &telemetry_current__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+void   telemetry_buttons__init
+                     (TelemetryButtons         *message)
+{
+  static const TelemetryButtons init_value = TELEMETRY_BUTTONS__INIT;
+  *message = init_value;
+}
+size_t telemetry_buttons__get_packed_size
+                     (const TelemetryButtons *message)
+{
+  assert(message->base.descriptor == &telemetry_buttons__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t telemetry_buttons__pack
+                     (const TelemetryButtons *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &telemetry_buttons__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t telemetry_buttons__pack_to_buffer
+                     (const TelemetryButtons *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &telemetry_buttons__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+TelemetryButtons *
+       telemetry_buttons__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (TelemetryButtons *)
+     protobuf_c_message_unpack (&telemetry_buttons__descriptor,
+                                allocator, len, data);
+}
+void   telemetry_buttons__free_unpacked
+                     (TelemetryButtons *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &telemetry_buttons__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+void   telemetry_snapshot__init
+                     (TelemetrySnapshot         *message)
+{
+  static const TelemetrySnapshot init_value = TELEMETRY_SNAPSHOT__INIT;
+  *message = init_value;
+}
+size_t telemetry_snapshot__get_packed_size
+                     (const TelemetrySnapshot *message)
+{
+  assert(message->base.descriptor == &telemetry_snapshot__descriptor);
+  return protobuf_c_message_get_packed_size ((const ProtobufCMessage*)(message));
+}
+size_t telemetry_snapshot__pack
+                     (const TelemetrySnapshot *message,
+                      uint8_t       *out)
+{
+  assert(message->base.descriptor == &telemetry_snapshot__descriptor);
+  return protobuf_c_message_pack ((const ProtobufCMessage*)message, out);
+}
+size_t telemetry_snapshot__pack_to_buffer
+                     (const TelemetrySnapshot *message,
+                      ProtobufCBuffer *buffer)
+{
+  assert(message->base.descriptor == &telemetry_snapshot__descriptor);
+  return protobuf_c_message_pack_to_buffer ((const ProtobufCMessage*)message, buffer);
+}
+TelemetrySnapshot *
+       telemetry_snapshot__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data)
+{
+  return (TelemetrySnapshot *)
+     protobuf_c_message_unpack (&telemetry_snapshot__descriptor,
+                                allocator, len, data);
+}
+void   telemetry_snapshot__free_unpacked
+                     (TelemetrySnapshot *message,
+                      ProtobufCAllocator *allocator)
+{
+  if(!message)
+    return;
+  assert(message->base.descriptor == &telemetry_snapshot__descriptor);
+  protobuf_c_message_free_unpacked ((ProtobufCMessage*)message, allocator);
+}
+static const ProtobufCFieldDescriptor telemetry_rail__field_descriptors[3] =
+{
+  {
+    "id",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_ENUM,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryRail, id),
+    &telemetry_rail_id__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "enabled",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_BOOL,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryRail, enabled),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "voltage_mv",
+    3,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryRail, voltage_mv),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned telemetry_rail__field_indices_by_name[] = {
+  1,   /* field[1] = enabled */
+  0,   /* field[0] = id */
+  2,   /* field[2] = voltage_mv */
+};
+static const ProtobufCIntRange telemetry_rail__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 3 }
+};
+const ProtobufCMessageDescriptor telemetry_rail__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "TelemetryRail",
+  "TelemetryRail",
+  "TelemetryRail",
+  "",
+  sizeof(TelemetryRail),
+  3,
+  telemetry_rail__field_descriptors,
+  telemetry_rail__field_indices_by_name,
+  1,  telemetry_rail__number_ranges,
+  (ProtobufCMessageInit) telemetry_rail__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor telemetry_battery__field_descriptors[3] =
+{
+  {
+    "voltage_mv",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryBattery, voltage_mv),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "level_percent",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryBattery, level_percent),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "charging",
+    3,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_BOOL,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryBattery, charging),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned telemetry_battery__field_indices_by_name[] = {
+  2,   /* field[2] = charging */
+  1,   /* field[1] = level_percent */
+  0,   /* field[0] = voltage_mv */
+};
+static const ProtobufCIntRange telemetry_battery__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 3 }
+};
+const ProtobufCMessageDescriptor telemetry_battery__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "TelemetryBattery",
+  "TelemetryBattery",
+  "TelemetryBattery",
+  "",
+  sizeof(TelemetryBattery),
+  3,
+  telemetry_battery__field_descriptors,
+  telemetry_battery__field_indices_by_name,
+  1,  telemetry_battery__number_ranges,
+  (ProtobufCMessageInit) telemetry_battery__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor telemetry_current__field_descriptors[5] =
+{
+  {
+    "last_ma",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_SINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryCurrent, last_ma),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "min_ma",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_SINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryCurrent, min_ma),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "max_ma",
+    3,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_SINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryCurrent, max_ma),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "average_ma",
+    4,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_SINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryCurrent, average_ma),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "samples",
+    5,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryCurrent, samples),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned telemetry_current__field_indices_by_name[] = {
+  3,   /* field[3] = average_ma */
+  0,   /* field[0] = last_ma */
+  2,   /* field[2] = max_ma */
+  1,   /* field[1] = min_ma */
+  4,   /* field[4] = samples */
+};
+static const ProtobufCIntRange telemetry_current__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 5 }
+};
+const ProtobufCMessageDescriptor telemetry_current__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "TelemetryCurrent",
+  "TelemetryCurrent",
+  "TelemetryCurrent",
+  "",
+  sizeof(TelemetryCurrent),
+  5,
+  telemetry_current__field_descriptors,
+  telemetry_current__field_indices_by_name,
+  1,  telemetry_current__number_ranges,
+  (ProtobufCMessageInit) telemetry_current__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor telemetry_buttons__field_descriptors[2] =
+{
+  {
+    "short_presses",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryButtons, short_presses),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "long_presses",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetryButtons, long_presses),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned telemetry_buttons__field_indices_by_name[] = {
+  1,   /* field[1] = long_presses */
+  0,   /* field[0] = short_presses */
+};
+static const ProtobufCIntRange telemetry_buttons__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 2 }
+};
+const ProtobufCMessageDescriptor telemetry_buttons__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "TelemetryButtons",
+  "TelemetryButtons",
+  "TelemetryButtons",
+  "",
+  sizeof(TelemetryButtons),
+  2,
+  telemetry_buttons__field_descriptors,
+  telemetry_buttons__field_indices_by_name,
+  1,  telemetry_buttons__number_ranges,
+  (ProtobufCMessageInit) telemetry_buttons__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCFieldDescriptor telemetry_snapshot__field_descriptors[7] =
+{
+  {
+    "sequence",
+    1,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetrySnapshot, sequence),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "uptime_s",
+    2,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_UINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetrySnapshot, uptime_s),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "rails",
+    3,
+    PROTOBUF_C_LABEL_REPEATED,
+    PROTOBUF_C_TYPE_MESSAGE,
+    offsetof(TelemetrySnapshot, n_rails),
+    offsetof(TelemetrySnapshot, rails),
+    &telemetry_rail__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "battery",
+    4,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    0,   /* quantifier_offset */
+    offsetof(TelemetrySnapshot, battery),
+    &telemetry_battery__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "current",
+    5,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    0,   /* quantifier_offset */
+    offsetof(TelemetrySnapshot, current),
+    &telemetry_current__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "temperature_dc",
+    6,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_SINT32,
+    0,   /* quantifier_offset */
+    offsetof(TelemetrySnapshot, temperature_dc),
+    NULL,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+  {
+    "buttons",
+    7,
+    PROTOBUF_C_LABEL_NONE,
+    PROTOBUF_C_TYPE_MESSAGE,
+    0,   /* quantifier_offset */
+    offsetof(TelemetrySnapshot, buttons),
+    &telemetry_buttons__descriptor,
+    NULL,
+    0,             /* flags */
+    0,NULL,NULL    /* reserved1,reserved2, etc */
+  },
+};
+static const unsigned telemetry_snapshot__field_indices_by_name[] = {
+  3,   /* field[3] = battery */
+  6,   /* field[6] = buttons */
+  4,   /* field[4] = current */
+  2,   /* field[2] = rails */
+  0,   /* field[0] = sequence */
+  5,   /* field[5] = temperature_dc */
+  1,   /* field[1] = uptime_s */
+};
+static const ProtobufCIntRange telemetry_snapshot__number_ranges[1 + 1] =
+{
+  { 1, 0 },
+  { 0, 7 }
+};
+const ProtobufCMessageDescriptor telemetry_snapshot__descriptor =
+{
+  PROTOBUF_C__MESSAGE_DESCRIPTOR_MAGIC,
+  "TelemetrySnapshot",
+  "TelemetrySnapshot",
+  "TelemetrySnapshot",
+  "",
+  sizeof(TelemetrySnapshot),
+  7,
+  telemetry_snapshot__field_descriptors,
+  telemetry_snapshot__field_indices_by_name,
+  1,  telemetry_snapshot__number_ranges,
+  (ProtobufCMessageInit) telemetry_snapshot__init,
+  NULL,NULL,NULL    /* reserved[123] */
+};
+static const ProtobufCEnumValue telemetry_rail_id__enum_values_by_number[2] =
+{
+  { "RailPower", "TELEMETRY_RAIL_ID__RailPower", 0 },
+  { "RailCharging", "TELEMETRY_RAIL_ID__RailCharging", 1 },
+};
+static const ProtobufCIntRange telemetry_rail_id__value_ranges[] = {
+{0, 0},{0, 2}
+};
+static const ProtobufCEnumValueIndex telemetry_rail_id__enum_values_by_name[2] =
+{
+  { "RailCharging", 1 },
+  { "RailPower", 0 },
+};
+const ProtobufCEnumDescriptor telemetry_rail_id__descriptor =
+{
+  PROTOBUF_C__ENUM_DESCRIPTOR_MAGIC,
+  "TelemetryRailId",
+  "TelemetryRailId",
+  "TelemetryRailId",
+  "",
+  2,
+  telemetry_rail_id__enum_values_by_number,
+  2,
+  telemetry_rail_id__enum_values_by_name,
+  1,
+  telemetry_rail_id__value_ranges,
+  NULL,NULL,NULL,NULL   /* reserved[1234] */
+};
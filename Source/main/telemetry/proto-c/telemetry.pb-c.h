@@ -0,0 +1,229 @@
+/* Generated by the protocol buffer compiler.  DO NOT EDIT! */
+/* Generated from: telemetry.proto */
+
+#ifndef PROTOBUF_C_telemetry_2eproto__INCLUDED
+#define PROTOBUF_C_telemetry_2eproto__INCLUDED
+
+#include <protobuf-c/protobuf-c.h>
+
+PROTOBUF_C__BEGIN_DECLS
+
+#if PROTOBUF_C_VERSION_NUMBER < 1003000
+# error This file was generated by a newer version of protoc-c which is incompatible with your libprotobuf-c headers. Please update your headers.
+#elif 1004000 < PROTOBUF_C_MIN_COMPILER_VERSION
+# error This file was generated by an older version of protoc-c which is incompatible with your libprotobuf-c headers. Please regenerate this file with a newer version of protoc-c.
+#endif
+
+
+typedef struct TelemetryRail TelemetryRail;
+typedef struct TelemetryBattery TelemetryBattery;
+typedef struct TelemetryCurrent TelemetryCurrent;
+typedef struct TelemetryButtons TelemetryButtons;
+typedef struct TelemetrySnapshot TelemetrySnapshot;
+
+
+/* --- enums --- */
+
+typedef enum _TelemetryRailId {
+  TELEMETRY_RAIL_ID__RailPower = 0,
+  TELEMETRY_RAIL_ID__RailCharging = 1
+    PROTOBUF_C__FORCE_ENUM_TO_BE_INT_SIZE(TELEMETRY_RAIL_ID)
+} TelemetryRailId;
+
+/* --- messages --- */
+
+struct  TelemetryRail
+{
+  ProtobufCMessage base;
+  TelemetryRailId id;
+  protobuf_c_boolean enabled;
+  uint32_t voltage_mv;
+};
+#define TELEMETRY_RAIL__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&telemetry_rail__descriptor) \
+    , TELEMETRY_RAIL_ID__RailPower, 0, 0 }
+
+
+struct  TelemetryBattery
+{
+  ProtobufCMessage base;
+  uint32_t voltage_mv;
+  uint32_t level_percent;
+  protobuf_c_boolean charging;
+};
+#define TELEMETRY_BATTERY__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&telemetry_battery__descriptor) \
+    , 0, 0, 0 }
+
+
+struct  TelemetryCurrent
+{
+  ProtobufCMessage base;
+  int32_t last_ma;
+  int32_t min_ma;
+  int32_t max_ma;
+  int32_t average_ma;
+  uint32_t samples;
+};
+#define TELEMETRY_CURRENT__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&telemetry_current__descriptor) \
+    , 0, 0, 0, 0, 0 }
+
+
+struct  TelemetryButtons
+{
+  ProtobufCMessage base;
+  uint32_t short_presses;
+  uint32_t long_presses;
+};
+#define TELEMETRY_BUTTONS__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&telemetry_buttons__descriptor) \
+    , 0, 0 }
+
+
+struct  TelemetrySnapshot
+{
+  ProtobufCMessage base;
+  uint32_t sequence;
+  uint32_t uptime_s;
+  size_t n_rails;
+  TelemetryRail **rails;
+  TelemetryBattery *battery;
+  TelemetryCurrent *current;
+  int32_t temperature_dc;
+  TelemetryButtons *buttons;
+};
+#define TELEMETRY_SNAPSHOT__INIT \
+ { PROTOBUF_C_MESSAGE_INIT (&telemetry_snapshot__descriptor) \
+    , 0, 0, 0,NULL, NULL, NULL, 0, NULL }
+
+
+/* TelemetryRail methods */
+void   telemetry_rail__init
+                     (TelemetryRail         *message);
+size_t telemetry_rail__get_packed_size
+                     (const TelemetryRail   *message);
+size_t telemetry_rail__pack
+                     (const TelemetryRail   *message,
+                      uint8_t             *out);
+size_t telemetry_rail__pack_to_buffer
+                     (const TelemetryRail   *message,
+                      ProtobufCBuffer     *buffer);
+TelemetryRail *
+       telemetry_rail__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   telemetry_rail__free_unpacked
+                     (TelemetryRail *message,
+                      ProtobufCAllocator *allocator);
+/* TelemetryBattery methods */
+void   telemetry_battery__init
+                     (TelemetryBattery         *message);
+size_t telemetry_battery__get_packed_size
+                     (const TelemetryBattery   *message);
+size_t telemetry_battery__pack
+                     (const TelemetryBattery   *message,
+                      uint8_t             *out);
+size_t telemetry_battery__pack_to_buffer
+                     (const TelemetryBattery   *message,
+                      ProtobufCBuffer     *buffer);
+TelemetryBattery *
+       telemetry_battery__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   telemetry_battery__free_unpacked
+                     (TelemetryBattery *message,
+                      ProtobufCAllocator *allocator);
+/* TelemetryCurrent methods */
+void   telemetry_current__init
+                     (TelemetryCurrent         *message);
+size_t telemetry_current__get_packed_size
+                     (const TelemetryCurrent   *message);
+size_t telemetry_current__pack
+                     (const TelemetryCurrent   *message,
+                      uint8_t             *out);
+size_t telemetry_current__pack_to_buffer
+                     (const TelemetryCurrent   *message,
+                      ProtobufCBuffer     *buffer);
+TelemetryCurrent *
+       telemetry_current__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   telemetry_current__free_unpacked
+                     (TelemetryCurrent *message,
+                      ProtobufCAllocator *allocator);
+/* TelemetryButtons methods */
+void   telemetry_buttons__init
+                     (TelemetryButtons         *message);
+size_t telemetry_buttons__get_packed_size
+                     (const TelemetryButtons   *message);
+size_t telemetry_buttons__pack
+                     (const TelemetryButtons   *message,
+                      uint8_t             *out);
+size_t telemetry_buttons__pack_to_buffer
+                     (const TelemetryButtons   *message,
+                      ProtobufCBuffer     *buffer);
+TelemetryButtons *
+       telemetry_buttons__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   telemetry_buttons__free_unpacked
+                     (TelemetryButtons *message,
+                      ProtobufCAllocator *allocator);
+/* TelemetrySnapshot methods */
+void   telemetry_snapshot__init
+                     (TelemetrySnapshot         *message);
+size_t telemetry_snapshot__get_packed_size
+                     (const TelemetrySnapshot   *message);
+size_t telemetry_snapshot__pack
+                     (const TelemetrySnapshot   *message,
+                      uint8_t             *out);
+size_t telemetry_snapshot__pack_to_buffer
+                     (const TelemetrySnapshot   *message,
+                      ProtobufCBuffer     *buffer);
+TelemetrySnapshot *
+       telemetry_snapshot__unpack
+                     (ProtobufCAllocator  *allocator,
+                      size_t               len,
+                      const uint8_t       *data);
+void   telemetry_snapshot__free_unpacked
+                     (TelemetrySnapshot *message,
+                      ProtobufCAllocator *allocator);
+/* --- per-message closures --- */
+
+typedef void (*TelemetryRail_Closure)
+                 (const TelemetryRail *message,
+                  void *closure_data);
+typedef void (*TelemetryBattery_Closure)
+                 (const TelemetryBattery *message,
+                  void *closure_data);
+typedef void (*TelemetryCurrent_Closure)
+                 (const TelemetryCurrent *message,
+                  void *closure_data);
+typedef void (*TelemetryButtons_Closure)
+                 (const TelemetryButtons *message,
+                  void *closure_data);
+typedef void (*TelemetrySnapshot_Closure)
+                 (const TelemetrySnapshot *message,
+                  void *closure_data);
+
+/* --- services --- */
+
+
+/* --- descriptors --- */
+
+extern const ProtobufCEnumDescriptor    telemetry_rail_id__descriptor;
+extern const ProtobufCMessageDescriptor telemetry_rail__descriptor;
+extern const ProtobufCMessageDescriptor telemetry_battery__descriptor;
+extern const ProtobufCMessageDescriptor telemetry_current__descriptor;
+extern const ProtobufCMessageDescriptor telemetry_buttons__descriptor;
+extern const ProtobufCMessageDescriptor telemetry_snapshot__descriptor;
+
+PROTOBUF_C__END_DECLS
+
+
+#endif  /* PROTOBUF_C_telemetry_2eproto__INCLUDED */
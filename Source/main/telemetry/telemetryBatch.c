@@ -0,0 +1,378 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+
+#include "telemetryBatch.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define ZIGZAG_ENCODE(x)                    ((((uint32_t)(x)) << 1) ^ (uint32_t)((x) >> 31))
+#define ZIGZAG_DECODE(x)                    ((int32_t)(((x) >> 1) ^ (~((x) & 1) + 1)))
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static size_t TELEMETRY_PutVarint(uint8_t *pData, uint32_t value);
+static bool TELEMETRY_GetVarint(const uint8_t *pData, size_t length, size_t *pOffset, uint32_t *pValue);
+static uint32_t TELEMETRY_BucketIndex(const TELEMETRY_Batch_t *pBatch, uint32_t timestamp_ms);
+static int32_t TELEMETRY_BucketAverage(const TELEMETRY_Batch_t *pBatch, uint8_t channel);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static size_t TELEMETRY_PutVarint(uint8_t *pData, uint32_t value){
+
+    size_t length = 0;
+
+    while(value >= 0x80){
+        pData[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    pData[length++] = (uint8_t)value;
+
+    return length;
+}
+
+static bool TELEMETRY_GetVarint(const uint8_t *pData, size_t length, size_t *pOffset, uint32_t *pValue){
+
+    uint32_t value = 0;
+
+    for(uint8_t shift = 0; shift < 35; shift += 7){
+        if(*pOffset >= length){
+            return false;
+        }
+
+        uint8_t byte = pData[(*pOffset)++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+
+        if((byte & 0x80) == 0){
+            *pValue = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static uint32_t TELEMETRY_BucketIndex(const TELEMETRY_Batch_t *pBatch, uint32_t timestamp_ms){
+
+    int32_t elapsed = (int32_t)(timestamp_ms - pBatch->start_ms);
+
+    if(elapsed < 0){
+        return 0;
+    }
+
+    return (uint32_t)elapsed / pBatch->bucket_ms;
+}
+
+static int32_t TELEMETRY_BucketAverage(const TELEMETRY_Batch_t *pBatch, uint8_t channel){
+
+    int64_t sum = pBatch->sum[channel];
+    int64_t count = pBatch->count[channel];
+
+    //Round half away from zero
+    if(sum < 0){
+        return (int32_t)((sum - count / 2) / count);
+    }
+    return (int32_t)((sum + count / 2) / count);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Telemetry batch initialization
+*
+*   This function is used to start an empty batch in a buffer.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch to initialize
+*   \param[in]  pBuffer             Buffer for the encoded batch
+*   \param[in]  size                Buffer size, at least TELEMETRY_BATCH_MIN_SIZE
+*   \param[in]  bucket_ms           Bucket width
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchInit(TELEMETRY_Batch_t *pBatch, uint8_t *pBuffer, size_t size, uint32_t bucket_ms){
+
+    if(pBatch == NULL){
+        return TELEMETRY_BATCH_STATUS_FAIL;
+    }
+
+    memset(pBatch, 0, sizeof(TELEMETRY_Batch_t));
+
+    return TELEMETRY_BatchRestart(pBatch, pBuffer, size, bucket_ms);
+}
+
+/***************************************************************************//*!
+*  \brief Telemetry batch restart
+*
+*   This function is used to start a new batch in another buffer once the
+*   current one was handed over. Samples of the open bucket are kept and
+*   become the first bucket of the new batch.
+*
+*   Preconditions: TELEMETRY_BatchInit called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch to restart
+*   \param[in]  pBuffer             Buffer for the encoded batch
+*   \param[in]  size                Buffer size, at least TELEMETRY_BATCH_MIN_SIZE
+*   \param[in]  bucket_ms           Bucket width of the new batch
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchRestart(TELEMETRY_Batch_t *pBatch, uint8_t *pBuffer, size_t size, uint32_t bucket_ms){
+
+    if(pBatch == NULL || pBuffer == NULL || size < TELEMETRY_BATCH_MIN_SIZE || bucket_ms == 0){
+        return TELEMETRY_BATCH_STATUS_FAIL;
+    }
+
+    if(pBatch->bucket_open){
+        pBatch->start_ms += pBatch->bucket_index * pBatch->bucket_ms;
+        pBatch->bucket_index = 0;
+    }
+
+    pBatch->pBuffer = pBuffer;
+    pBatch->size = size;
+    pBatch->length = 0;
+    pBatch->bucket_ms = bucket_ms;
+    pBatch->last_index = 0;
+    pBatch->records = 0;
+    memset(pBatch->last_value, 0, sizeof(pBatch->last_value));
+
+    return TELEMETRY_BATCH_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Telemetry batch add sample
+*
+*   This function is used to add a sample to its bucket. A sample of a later
+*   bucket closes the open one first.
+*
+*   Preconditions: TELEMETRY_BatchInit called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch
+*   \param[in]  channel             Channel of the sample
+*   \param[in]  value               Sample value
+*   \param[in]  timestamp_ms        Sample time, samples older than the open bucket count for it
+*
+*   \return     operation status, full if the open bucket can't be closed,
+*               the sample is not added then
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchAdd(TELEMETRY_Batch_t *pBatch, TELEMETRY_Channel_t channel, int32_t value, uint32_t timestamp_ms){
+
+    if(pBatch == NULL || channel >= TELEMETRY_CH_COUNT){
+        return TELEMETRY_BATCH_STATUS_FAIL;
+    }
+
+    if(pBatch->bucket_open){
+        if(TELEMETRY_BucketIndex(pBatch, timestamp_ms) > pBatch->bucket_index){
+            if(TELEMETRY_BatchCloseBucket(pBatch, timestamp_ms) != TELEMETRY_BATCH_STATUS_SUCCESS){
+                return TELEMETRY_BATCH_STATUS_FULL;
+            }
+        }
+    }
+
+    if(!pBatch->bucket_open){
+        if(pBatch->records == 0){
+            //Align the first bucket so timestamps of different batches line up
+            pBatch->start_ms = timestamp_ms - (timestamp_ms % pBatch->bucket_ms);
+        }
+
+        uint32_t index = TELEMETRY_BucketIndex(pBatch, timestamp_ms);
+
+        //Late samples of an already written bucket are reported with the last one
+        if(pBatch->records != 0 && index < pBatch->last_index){
+            index = pBatch->last_index;
+        }
+
+        pBatch->bucket_index = index;
+        pBatch->bucket_open = true;
+    }
+
+    pBatch->sum[channel] += value;
+    pBatch->count[channel]++;
+
+    return TELEMETRY_BATCH_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Telemetry batch close bucket
+*
+*   This function is used to write the open bucket as a record if it has
+*   ended at now_ms.
+*
+*   Preconditions: TELEMETRY_BatchInit called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch
+*   \param[in]  now_ms              Current time
+*
+*   \return     operation status, full if the record doesn't fit
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchCloseBucket(TELEMETRY_Batch_t *pBatch, uint32_t now_ms){
+
+    if(pBatch == NULL){
+        return TELEMETRY_BATCH_STATUS_FAIL;
+    }
+
+    if(!pBatch->bucket_open || TELEMETRY_BucketIndex(pBatch, now_ms) <= pBatch->bucket_index){
+        return TELEMETRY_BATCH_STATUS_SUCCESS;
+    }
+
+    uint8_t record[TELEMETRY_BATCH_MAX_HEADER + TELEMETRY_BATCH_MAX_RECORD];
+    int32_t values[TELEMETRY_CH_COUNT];
+    size_t length = 0;
+    uint8_t mask = 0;
+
+    if(pBatch->length == 0){
+        record[length++] = TELEMETRY_BATCH_VERSION;
+        length += TELEMETRY_PutVarint(&record[length], pBatch->start_ms);
+        length += TELEMETRY_PutVarint(&record[length], pBatch->bucket_ms);
+    }
+
+    length += TELEMETRY_PutVarint(&record[length], pBatch->bucket_index - pBatch->last_index);
+
+    size_t mask_offset = length++;
+    for(uint8_t i = 0; i < TELEMETRY_CH_COUNT; i++){
+        if(pBatch->count[i] == 0){
+            continue;
+        }
+
+        mask |= 1 << i;
+        values[i] = TELEMETRY_BucketAverage(pBatch, i);
+        int32_t delta = (int32_t)((uint32_t)values[i] - (uint32_t)pBatch->last_value[i]);
+        length += TELEMETRY_PutVarint(&record[length], ZIGZAG_ENCODE(delta));
+    }
+    record[mask_offset] = mask;
+
+    if(length > (pBatch->size - pBatch->length)){
+        return TELEMETRY_BATCH_STATUS_FULL;
+    }
+
+    memcpy(&pBatch->pBuffer[pBatch->length], record, length);
+    pBatch->length += length;
+    pBatch->records++;
+    pBatch->last_index = pBatch->bucket_index;
+
+    for(uint8_t i = 0; i < TELEMETRY_CH_COUNT; i++){
+        if(mask & (1 << i)){
+            pBatch->last_value[i] = values[i];
+        }
+        pBatch->sum[i] = 0;
+        pBatch->count[i] = 0;
+    }
+    pBatch->bucket_open = false;
+
+    return TELEMETRY_BATCH_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Telemetry batch decode
+*
+*   This function is used to read back an encoded batch, calling callback
+*   for every channel of every record.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Encoded batch
+*   \param[in]  length              Encoded length
+*   \param[in]  callback            Called with each decoded sample
+*   \param[in]  pContext            Passed to callback
+*
+*   \return     operation status, fail if the batch is malformed
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchDecode(const uint8_t *pData, size_t length, TELEMETRY_Batch_Sample_Cb_t callback, void *pContext){
+
+    if(pData == NULL || callback == NULL || length == 0 || pData[0] != TELEMETRY_BATCH_VERSION){
+        return TELEMETRY_BATCH_STATUS_FAIL;
+    }
+
+    size_t offset = 1;
+    uint32_t start_ms;
+    uint32_t bucket_ms;
+    uint32_t index = 0;
+    int32_t values[TELEMETRY_CH_COUNT] = { 0 };
+
+    if(!TELEMETRY_GetVarint(pData, length, &offset, &start_ms) || !TELEMETRY_GetVarint(pData, length, &offset, &bucket_ms)){
+        return TELEMETRY_BATCH_STATUS_FAIL;
+    }
+
+    while(offset < length){
+        uint32_t gap;
+
+        if(!TELEMETRY_GetVarint(pData, length, &offset, &gap) || offset >= length){
+            return TELEMETRY_BATCH_STATUS_FAIL;
+        }
+
+        uint8_t mask = pData[offset++];
+        if(mask >= (1 << TELEMETRY_CH_COUNT)){
+            return TELEMETRY_BATCH_STATUS_FAIL;
+        }
+
+        index += gap;
+        uint32_t timestamp_ms = start_ms + index * bucket_ms;
+
+        for(uint8_t i = 0; i < TELEMETRY_CH_COUNT; i++){
+            if((mask & (1 << i)) == 0){
+                continue;
+            }
+
+            uint32_t delta;
+            if(!TELEMETRY_GetVarint(pData, length, &offset, &delta)){
+                return TELEMETRY_BATCH_STATUS_FAIL;
+            }
+
+            values[i] = (int32_t)((uint32_t)values[i] + (uint32_t)ZIGZAG_DECODE(delta));
+            callback(pContext, (TELEMETRY_Channel_t)i, timestamp_ms, values[i]);
+        }
+    }
+
+    return TELEMETRY_BATCH_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
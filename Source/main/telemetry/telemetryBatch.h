@@ -0,0 +1,183 @@
+#ifndef _TELEMETRY_BATCH_H
+#define _TELEMETRY_BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+#define TELEMETRY_BATCH_VERSION             (1)
+
+//Largest header: version, start and bucket width as varints
+#define TELEMETRY_BATCH_MAX_HEADER          (1 + 5 + 5)
+//Largest record: bucket gap varint, channel mask, one delta varint per channel
+#define TELEMETRY_BATCH_MAX_RECORD          (5 + 1 + 5 * TELEMETRY_CH_COUNT)
+//Smallest buffer that can always hold one record
+#define TELEMETRY_BATCH_MIN_SIZE            (TELEMETRY_BATCH_MAX_HEADER + TELEMETRY_BATCH_MAX_RECORD)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum TELEMETRY_Channel_e{
+    TELEMETRY_CH_PWR_VOLTAGE,               //mV
+    TELEMETRY_CH_BATT_VOLTAGE,              //mV
+    TELEMETRY_CH_CURRENT,                   //mA
+    TELEMETRY_CH_TEMPERATURE,               //Tenths of a degree Celsius
+
+    TELEMETRY_CH_COUNT,
+}TELEMETRY_Channel_t;
+
+typedef enum TELEMETRY_Batch_Ret_e{
+    TELEMETRY_BATCH_STATUS_FAIL,
+    TELEMETRY_BATCH_STATUS_SUCCESS,
+    TELEMETRY_BATCH_STATUS_FULL,
+}TELEMETRY_Batch_Ret_t;
+
+/*
+ * Samples are averaged per channel over buckets of bucket_ms. Every closed bucket is appended as a record:
+ *
+ *   header: version byte, varint start_ms, varint bucket_ms
+ *   record: varint bucket gap, channel mask byte, zigzag varint delta per channel in the mask
+ *
+ * The gap is the number of buckets since the previous record (the bucket index for the first one), a delta is
+ * the change from the previous value of that channel in the batch (from 0 for the first one).
+ */
+typedef struct TELEMETRY_Batch_s{
+    uint8_t *pBuffer;
+    size_t size;
+    size_t length;                          //Encoded length, 0 until the first record is written
+    uint32_t start_ms;
+    uint32_t bucket_ms;
+    uint32_t last_index;                    //Bucket index of the last record
+    uint16_t records;
+    bool bucket_open;
+    uint32_t bucket_index;                  //Bucket index of the samples being averaged
+    int64_t sum[TELEMETRY_CH_COUNT];
+    uint32_t count[TELEMETRY_CH_COUNT];
+    int32_t last_value[TELEMETRY_CH_COUNT];
+}TELEMETRY_Batch_t;
+
+typedef void (*TELEMETRY_Batch_Sample_Cb_t)(void *pContext, TELEMETRY_Channel_t channel, uint32_t timestamp_ms, int32_t value);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+#if TELEMETRY_CH_COUNT > 8
+#error "The channel mask of a record is one byte"
+#endif
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Telemetry batch initialization
+*
+*   This function is used to start an empty batch in a buffer.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch to initialize
+*   \param[in]  pBuffer             Buffer for the encoded batch
+*   \param[in]  size                Buffer size, at least TELEMETRY_BATCH_MIN_SIZE
+*   \param[in]  bucket_ms           Bucket width
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchInit(TELEMETRY_Batch_t *pBatch, uint8_t *pBuffer, size_t size, uint32_t bucket_ms);
+
+/***************************************************************************//*!
+*  \brief Telemetry batch restart
+*
+*   This function is used to start a new batch in another buffer once the
+*   current one was handed over. Samples of the open bucket are kept and
+*   become the first bucket of the new batch.
+*
+*   Preconditions: TELEMETRY_BatchInit called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch to restart
+*   \param[in]  pBuffer             Buffer for the encoded batch
+*   \param[in]  size                Buffer size, at least TELEMETRY_BATCH_MIN_SIZE
+*   \param[in]  bucket_ms           Bucket width of the new batch
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchRestart(TELEMETRY_Batch_t *pBatch, uint8_t *pBuffer, size_t size, uint32_t bucket_ms);
+
+/***************************************************************************//*!
+*  \brief Telemetry batch add sample
+*
+*   This function is used to add a sample to its bucket. A sample of a later
+*   bucket closes the open one first.
+*
+*   Preconditions: TELEMETRY_BatchInit called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch
+*   \param[in]  channel             Channel of the sample
+*   \param[in]  value               Sample value
+*   \param[in]  timestamp_ms        Sample time, samples older than the open bucket count for it
+*
+*   \return     operation status, full if the open bucket can't be closed,
+*               the sample is not added then
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchAdd(TELEMETRY_Batch_t *pBatch, TELEMETRY_Channel_t channel, int32_t value, uint32_t timestamp_ms);
+
+/***************************************************************************//*!
+*  \brief Telemetry batch close bucket
+*
+*   This function is used to write the open bucket as a record if it has
+*   ended at now_ms.
+*
+*   Preconditions: TELEMETRY_BatchInit called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pBatch              Batch
+*   \param[in]  now_ms              Current time
+*
+*   \return     operation status, full if the record doesn't fit
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchCloseBucket(TELEMETRY_Batch_t *pBatch, uint32_t now_ms);
+
+/***************************************************************************//*!
+*  \brief Telemetry batch decode
+*
+*   This function is used to read back an encoded batch, calling callback
+*   for every channel of every record.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pData               Encoded batch
+*   \param[in]  length              Encoded length
+*   \param[in]  callback            Called with each decoded sample
+*   \param[in]  pContext            Passed to callback
+*
+*   \return     operation status, fail if the batch is malformed
+*
+*******************************************************************************/
+TELEMETRY_Batch_Ret_t TELEMETRY_BatchDecode(const uint8_t *pData, size_t length, TELEMETRY_Batch_Sample_Cb_t callback, void *pContext);
+
+#endif//_TELEMETRY_BATCH_H
@@ -0,0 +1,159 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include <string.h>
+
+#include "telemetry.pb-c.h"
+
+#include "telemetryEncoder.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+//ProtobufCBuffer writing into a fixed size buffer
+typedef struct TELEMETRY_Buffer_s{
+    ProtobufCBuffer base;
+    uint8_t *pData;
+    size_t size;
+    size_t length;
+    bool overflow;
+}TELEMETRY_Buffer_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static void TELEMETRY_BufferAppend(ProtobufCBuffer *pBase, size_t len, const uint8_t *pData);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const TelemetryRailId rail_ids[TELEMETRY_RAIL_COUNT] = {
+    [TELEMETRY_RAIL_PWR_ID] = TELEMETRY_RAIL_ID__RailPower,
+    [TELEMETRY_RAIL_CHARGING_ID] = TELEMETRY_RAIL_ID__RailCharging,
+};
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static void TELEMETRY_BufferAppend(ProtobufCBuffer *pBase, size_t len, const uint8_t *pData){
+
+    TELEMETRY_Buffer_t *pBuffer = (TELEMETRY_Buffer_t *)pBase;
+
+    //Drop everything after the first write that doesn't fit
+    if(pBuffer->overflow || len > (pBuffer->size - pBuffer->length)){
+        pBuffer->overflow = true;
+        return;
+    }
+
+    memcpy(&pBuffer->pData[pBuffer->length], pData, len);
+    pBuffer->length += len;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Telemetry snapshot encoding
+*
+*   This function is used to pack a snapshot as a TelemetrySnapshot protobuf
+*   message (see proto/telemetry.proto) into a caller provided buffer.
+*   The message is built on the stack and written through a ProtobufCBuffer,
+*   nothing is allocated.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pSnapshot           Snapshot to encode
+*   \param[out] pBuffer             Buffer to store the encoded message
+*   \param[in]  size                Buffer size, TELEMETRY_MAX_ENCODED_SIZE always fits
+*   \param[out] pLength             Pointer to store the encoded length
+*
+*   \return     operation status, fail if the message doesn't fit in the buffer
+*
+*******************************************************************************/
+TELEMETRY_Ret_t TELEMETRY_EncodeSnapshot(const TELEMETRY_Snapshot_t *pSnapshot, uint8_t *pBuffer, size_t size, size_t *pLength){
+
+    if(pSnapshot == NULL || pBuffer == NULL || pLength == NULL){
+        return TELEMETRY_STATUS_FAIL;
+    }
+
+    TelemetryRail rails[TELEMETRY_RAIL_COUNT];
+    TelemetryRail *pRails[TELEMETRY_RAIL_COUNT];
+    TelemetryBattery battery = TELEMETRY_BATTERY__INIT;
+    TelemetryCurrent current = TELEMETRY_CURRENT__INIT;
+    TelemetryButtons buttons = TELEMETRY_BUTTONS__INIT;
+    TelemetrySnapshot snapshot = TELEMETRY_SNAPSHOT__INIT;
+
+    for(uint8_t i = 0; i < TELEMETRY_RAIL_COUNT; i++){
+        telemetry_rail__init(&rails[i]);
+        rails[i].id = rail_ids[i];
+        rails[i].enabled = pSnapshot->rails[i].enabled;
+        rails[i].voltage_mv = pSnapshot->rails[i].voltage_mv;
+        pRails[i] = &rails[i];
+    }
+
+    battery.voltage_mv = pSnapshot->battery.voltage_mv;
+    battery.level_percent = pSnapshot->battery.level_percent;
+    battery.charging = pSnapshot->battery.charging;
+
+    current.last_ma = pSnapshot->current.last_ma;
+    current.min_ma = pSnapshot->current.min_ma;
+    current.max_ma = pSnapshot->current.max_ma;
+    current.average_ma = pSnapshot->current.average_ma;
+    current.samples = pSnapshot->current.samples;
+
+    buttons.short_presses = pSnapshot->buttons.short_presses;
+    buttons.long_presses = pSnapshot->buttons.long_presses;
+
+    snapshot.sequence = pSnapshot->sequence;
+    snapshot.uptime_s = pSnapshot->uptime_s;
+    snapshot.n_rails = TELEMETRY_RAIL_COUNT;
+    snapshot.rails = pRails;
+    snapshot.battery = &battery;
+    snapshot.current = &current;
+    snapshot.temperature_dc = pSnapshot->temperature_dc;
+    snapshot.buttons = &buttons;
+
+    TELEMETRY_Buffer_t buffer = {
+        .base = { .append = TELEMETRY_BufferAppend },
+        .pData = pBuffer,
+        .size = size,
+        .length = 0,
+        .overflow = false,
+    };
+    telemetry_snapshot__pack_to_buffer(&snapshot, &buffer.base);
+
+    if(buffer.overflow){
+        return TELEMETRY_STATUS_FAIL;
+    }
+
+    *pLength = buffer.length;
+
+    return TELEMETRY_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
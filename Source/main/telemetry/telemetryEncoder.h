@@ -0,0 +1,103 @@
+#ifndef _TELEMETRY_ENCODER_H
+#define _TELEMETRY_ENCODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+//Worst case size of an encoded snapshot (every field at its largest varint)
+#define TELEMETRY_MAX_ENCODED_SIZE          (99)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef enum TELEMETRY_Rail_Id_e{
+    TELEMETRY_RAIL_PWR_ID,
+    TELEMETRY_RAIL_CHARGING_ID,
+
+    TELEMETRY_RAIL_COUNT,
+}TELEMETRY_Rail_Id_t;
+
+typedef struct TELEMETRY_Rail_s{
+    bool enabled;
+    uint32_t voltage_mv;
+}TELEMETRY_Rail_t;
+
+typedef struct TELEMETRY_Battery_s{
+    uint32_t voltage_mv;
+    uint8_t level_percent;
+    bool charging;
+}TELEMETRY_Battery_t;
+
+typedef struct TELEMETRY_Current_s{
+    int32_t last_ma;
+    int32_t min_ma;
+    int32_t max_ma;
+    int32_t average_ma;
+    uint32_t samples;
+}TELEMETRY_Current_t;
+
+typedef struct TELEMETRY_Buttons_s{
+    uint32_t short_presses;
+    uint32_t long_presses;
+}TELEMETRY_Buttons_t;
+
+typedef struct TELEMETRY_Snapshot_s{
+    uint32_t sequence;
+    uint32_t uptime_s;
+    TELEMETRY_Rail_t rails[TELEMETRY_RAIL_COUNT];
+    TELEMETRY_Battery_t battery;
+    TELEMETRY_Current_t current;
+    int32_t temperature_dc;                 //Tenths of a degree Celsius
+    TELEMETRY_Buttons_t buttons;
+}TELEMETRY_Snapshot_t;
+
+typedef enum TELEMETRY_Ret_e{
+    TELEMETRY_STATUS_FAIL,
+    TELEMETRY_STATUS_SUCCESS,
+}TELEMETRY_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Telemetry snapshot encoding
+*
+*   This function is used to pack a snapshot as a TelemetrySnapshot protobuf
+*   message (see proto/telemetry.proto) into a caller provided buffer.
+*   The message is built on the stack and written through a ProtobufCBuffer,
+*   nothing is allocated.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pSnapshot           Snapshot to encode
+*   \param[out] pBuffer             Buffer to store the encoded message
+*   \param[in]  size                Buffer size, TELEMETRY_MAX_ENCODED_SIZE always fits
+*   \param[out] pLength             Pointer to store the encoded length
+*
+*   \return     operation status, fail if the message doesn't fit in the buffer
+*
+*******************************************************************************/
+TELEMETRY_Ret_t TELEMETRY_EncodeSnapshot(const TELEMETRY_Snapshot_t *pSnapshot, uint8_t *pBuffer, size_t size, size_t *pLength);
+
+#endif//_TELEMETRY_ENCODER_H
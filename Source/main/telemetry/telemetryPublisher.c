@@ -0,0 +1,290 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "telemetryPublisher.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+//esp_mqtt_client_enqueue result when the outbox limit is reached
+#define TELEMETRY_PUB_OUTBOX_FULL       (-2)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static uint32_t TELEMETRY_Now(void);
+static bool TELEMETRY_PublishPending(void);
+static void TELEMETRY_Flush(void);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static TELEMETRY_Pub_Config_t pub_config;
+
+static TELEMETRY_Batch_t batch;
+static uint8_t batch_buffers[2][TELEMETRY_PUB_BUFFER_SIZE];
+static uint8_t batch_buffer_index = 0;      //Buffer of the batch being filled, the other one is pending
+static size_t pending_length = 0;           //0 when no batch is waiting for the outbox
+
+static uint8_t coarsening = 0;
+static uint32_t batches_sent = 0;
+static uint32_t batches_dropped = 0;
+
+static SemaphoreHandle_t pub_mutex_handle = NULL;
+
+static const char * TAG = "TELEMETRY_PUB";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+static uint32_t TELEMETRY_Now(void){
+
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+//Hands the pending batch to the outbox, returns false if it has to wait for room
+static bool TELEMETRY_PublishPending(void){
+
+    const char *pData = (const char *)batch_buffers[batch_buffer_index ^ 1];
+
+    int msg_id = esp_mqtt_client_enqueue(pub_config.client, pub_config.topic, pData, pending_length, pub_config.qos, 0, true);
+
+    if(msg_id == TELEMETRY_PUB_OUTBOX_FULL){
+        return false;
+    }
+
+    if(msg_id < 0){
+        ESP_LOGW(TAG, "Failed to enqueue batch of %u bytes", (unsigned)pending_length);
+        batches_dropped++;
+    }
+    else{
+        batches_sent++;
+        if(coarsening > 0){
+            coarsening--;
+        }
+    }
+
+    pending_length = 0;
+
+    return true;
+}
+
+//Moves the batch to the pending buffer and publishes it, the batch restarts in the other buffer
+static void TELEMETRY_Flush(void){
+
+    //A newer batch replaces the one still waiting
+    if(pending_length != 0 && !TELEMETRY_PublishPending()){
+        batches_dropped++;
+    }
+
+    pending_length = batch.length;
+    batch_buffer_index ^= 1;
+
+    if(!TELEMETRY_PublishPending() && coarsening < TELEMETRY_PUB_MAX_COARSENING){
+        coarsening++;
+        ESP_LOGW(TAG, "Outbox full, bucket width %u ms", (unsigned)(pub_config.bucket_ms << coarsening));
+    }
+
+    TELEMETRY_BatchRestart(&batch, batch_buffers[batch_buffer_index], TELEMETRY_PUB_BUFFER_SIZE, pub_config.bucket_ms << coarsening);
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Telemetry publisher initialization
+*
+*   This function is used to initialize the telemetry publisher. Samples are
+*   batched (see telemetryBatch.h) and every batch is handed to the MQTT
+*   client outbox as one message. Calling it again restarts the publisher
+*   with the new config, the samples not published yet are lost.
+*
+*   Preconditions: MQTT client initialized, it can be started later.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pConfig             Publisher config, the topic must outlive the module
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_InitPublisher(const TELEMETRY_Pub_Config_t *pConfig){
+
+    if(pConfig == NULL || pConfig->client == NULL || pConfig->topic == NULL || pConfig->bucket_ms == 0 ||
+       pConfig->flush_size == 0 || pConfig->flush_size > TELEMETRY_PUB_BUFFER_SIZE){
+        ESP_LOGW(TAG, "Failed to initialize publisher -> Invalid config");
+        return TELEMETRY_PUB_STATUS_FAIL;
+    }
+
+    //Create mutex, once, samples may be added while the publisher restarts
+    if(pub_mutex_handle == NULL){
+        pub_mutex_handle = xSemaphoreCreateMutex();
+        if(pub_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create Telemetry Publisher mutex");
+            return TELEMETRY_PUB_STATUS_FAIL;
+        }
+    }
+
+    xSemaphoreTake(pub_mutex_handle, portMAX_DELAY);
+
+    pub_config = *pConfig;
+    batch_buffer_index = 0;
+    pending_length = 0;
+    coarsening = 0;
+    batches_sent = 0;
+    batches_dropped = 0;
+
+    TELEMETRY_BatchInit(&batch, batch_buffers[batch_buffer_index], TELEMETRY_PUB_BUFFER_SIZE, pub_config.bucket_ms);
+
+    xSemaphoreGive(pub_mutex_handle);
+
+    return TELEMETRY_PUB_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Telemetry publisher add sample
+*
+*   This function is used by the sensor controllers to report a sample. A
+*   batch that runs out of room is flushed.
+*
+*   Preconditions: TELEMETRY_InitPublisher called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  channel             Channel of the sample
+*   \param[in]  value               Sample value, in the unit of the channel
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_AddSample(TELEMETRY_Channel_t channel, int32_t value){
+
+    if(pub_mutex_handle == NULL || channel >= TELEMETRY_CH_COUNT){
+        return TELEMETRY_PUB_STATUS_FAIL;
+    }
+
+    uint32_t now_ms = TELEMETRY_Now();
+
+    xSemaphoreTake(pub_mutex_handle, portMAX_DELAY);
+
+    TELEMETRY_Batch_Ret_t ret = TELEMETRY_BatchAdd(&batch, channel, value, now_ms);
+    if(ret == TELEMETRY_BATCH_STATUS_FULL){
+        TELEMETRY_Flush();
+        ret = TELEMETRY_BatchAdd(&batch, channel, value, now_ms);
+    }
+
+    xSemaphoreGive(pub_mutex_handle);
+
+    return (ret == TELEMETRY_BATCH_STATUS_SUCCESS) ? TELEMETRY_PUB_STATUS_SUCCESS : TELEMETRY_PUB_STATUS_FAIL;
+}
+
+/***************************************************************************//*!
+*  \brief Telemetry publisher process
+*
+*   This function is used to close elapsed buckets, flush the batch once it
+*   reaches the size or age threshold and retry a batch the outbox had no
+*   room for. While the outbox is full every new batch uses buckets and an
+*   age twice as long as the previous one, each batch accepted by the
+*   outbox halves them again.
+*
+*   Preconditions: TELEMETRY_InitPublisher called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_ProcessPublisher(void){
+
+    if(pub_mutex_handle == NULL){
+        return TELEMETRY_PUB_STATUS_FAIL;
+    }
+
+    uint32_t now_ms = TELEMETRY_Now();
+
+    xSemaphoreTake(pub_mutex_handle, portMAX_DELAY);
+
+    bool flush = (TELEMETRY_BatchCloseBucket(&batch, now_ms) == TELEMETRY_BATCH_STATUS_FULL);
+
+    if(pending_length != 0){
+        TELEMETRY_PublishPending();
+    }
+
+    if(batch.records != 0){
+        flush |= (batch.length >= pub_config.flush_size);
+        flush |= ((now_ms - batch.start_ms) >= (pub_config.max_age_ms << coarsening));
+    }
+
+    if(flush){
+        TELEMETRY_Flush();
+    }
+
+    xSemaphoreGive(pub_mutex_handle);
+
+    return TELEMETRY_PUB_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief Telemetry publisher statistics
+*
+*   This function is used to read the publisher counters.
+*
+*   Preconditions: TELEMETRY_InitPublisher called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_GetPublisherStats(TELEMETRY_Pub_Stats_t *pStats){
+
+    if(pub_mutex_handle == NULL || pStats == NULL){
+        return TELEMETRY_PUB_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(pub_mutex_handle, portMAX_DELAY);
+
+    pStats->batches_sent = batches_sent;
+    pStats->batches_dropped = batches_dropped;
+    pStats->bucket_ms = batch.bucket_ms;
+    pStats->pending = (pending_length != 0);
+
+    xSemaphoreGive(pub_mutex_handle);
+
+    return TELEMETRY_PUB_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
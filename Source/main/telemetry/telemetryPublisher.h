@@ -0,0 +1,133 @@
+#ifndef _TELEMETRY_PUBLISHER_H
+#define _TELEMETRY_PUBLISHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mqtt_client.h"
+
+#include "telemetryBatch.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+//Size of each of the two batch buffers, the largest payload handed to the client
+#define TELEMETRY_PUB_BUFFER_SIZE           (512)
+//Bucket width and batch age are doubled at most this many times while the outbox is full
+#define TELEMETRY_PUB_MAX_COARSENING        (4)
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+typedef struct TELEMETRY_Pub_Config_s{
+    esp_mqtt_client_handle_t client;
+    const char *topic;
+    uint8_t qos;
+    uint32_t bucket_ms;                     //Finest bucket width
+    uint32_t max_age_ms;                    //A batch is flushed once its first bucket is this old
+    size_t flush_size;                      //A batch is flushed once it is this long
+}TELEMETRY_Pub_Config_t;
+
+typedef struct TELEMETRY_Pub_Stats_s{
+    uint32_t batches_sent;
+    uint32_t batches_dropped;
+    uint32_t bucket_ms;                     //Current bucket width
+    bool pending;                           //A batch is waiting for room in the outbox
+}TELEMETRY_Pub_Stats_t;
+
+typedef enum TELEMETRY_Pub_Ret_e{
+    TELEMETRY_PUB_STATUS_FAIL,
+    TELEMETRY_PUB_STATUS_SUCCESS,
+}TELEMETRY_Pub_Ret_t;
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief Telemetry publisher initialization
+*
+*   This function is used to initialize the telemetry publisher. Samples are
+*   batched (see telemetryBatch.h) and every batch is handed to the MQTT
+*   client outbox as one message. Calling it again restarts the publisher
+*   with the new config, the samples not published yet are lost.
+*
+*   Preconditions: MQTT client initialized, it can be started later.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pConfig             Publisher config, the topic must outlive the module
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_InitPublisher(const TELEMETRY_Pub_Config_t *pConfig);
+
+/***************************************************************************//*!
+*  \brief Telemetry publisher add sample
+*
+*   This function is used by the sensor controllers to report a sample. A
+*   batch that runs out of room is flushed.
+*
+*   Preconditions: TELEMETRY_InitPublisher called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  channel             Channel of the sample
+*   \param[in]  value               Sample value, in the unit of the channel
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_AddSample(TELEMETRY_Channel_t channel, int32_t value);
+
+/***************************************************************************//*!
+*  \brief Telemetry publisher process
+*
+*   This function is used to close elapsed buckets, flush the batch once it
+*   reaches the size or age threshold and retry a batch the outbox had no
+*   room for. While the outbox is full every new batch uses buckets and an
+*   age twice as long as the previous one, each batch accepted by the
+*   outbox halves them again.
+*
+*   Preconditions: TELEMETRY_InitPublisher called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_ProcessPublisher(void);
+
+/***************************************************************************//*!
+*  \brief Telemetry publisher statistics
+*
+*   This function is used to read the publisher counters.
+*
+*   Preconditions: TELEMETRY_InitPublisher called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+TELEMETRY_Pub_Ret_t TELEMETRY_GetPublisherStats(TELEMETRY_Pub_Stats_t *pStats);
+
+#endif//_TELEMETRY_PUBLISHER_H
@@ -7,6 +7,7 @@
 *   Includes
 *******************************************************************************/
 #include <stdbool.h>
+#include "sdkconfig.h"
 
 #include "freertos/freeRTOS.h"
 #include "freertos/task.h"
@@ -16,6 +17,8 @@
 #include "esp_log.h"
 
 #include "buttonController.h"
+#include "stackMonitor.h"
+#include "flightRecorder.h"
 
 /******************************************************************************
 *   Private Definitions
@@ -44,6 +47,7 @@ typedef struct Button_s{
     Button_State_t prev_state;
     BTN_Active_Level_t active_level;
     uint16_t debounce_cptr;
+    bool pressed;                           //Debounced state
     btnPressedCallback pressed_callback;
     btnReleasedCallback released_callback;
 }Button_t;
@@ -103,6 +107,8 @@ static void tButtonTask(void *pvPatameters){
                            (button_table[i].debounce_cptr != 0xFFFF)){
 
                             button_table[i].debounce_cptr = 0xFFFF;
+                            button_table[i].pressed = true;
+                            FLIGHT_REC_RECORD(FLIGHT_REC_TYPE_BUTTON, button_table[i].io, 1);
                             if(button_table[i].pressed_callback != NULL)    button_table[i].pressed_callback();
                         }
                     }
@@ -111,6 +117,8 @@ static void tButtonTask(void *pvPatameters){
                            (button_table[i].debounce_cptr != 0xFFFF)){
 
                             button_table[i].debounce_cptr = 0xFFFF;
+                            button_table[i].pressed = false;
+                            FLIGHT_REC_RECORD(FLIGHT_REC_TYPE_BUTTON, button_table[i].io, 0);
                             if(button_table[i].released_callback != NULL)   button_table[i].released_callback();
                         }
                     }
@@ -154,6 +162,7 @@ static void addButtonToTable(Button_t *pButton_config){
             button_table[index].pressed_callback = pButton_config->pressed_callback;
             button_table[index].released_callback = pButton_config->released_callback;
             button_table[index].debounce_cptr = 0;
+            button_table[index].pressed = false;
             break;
         }
     }
@@ -172,6 +181,7 @@ BTN_Ctrl_Ret_t BTN_InitController(void){
         button_table[i].debounce_cptr = 0;
         button_table[i].io = 0xFF;
         button_table[i].prev_state = BUTTON_STATE_RELEASED;
+        button_table[i].pressed = false;
         button_table[i].pressed_callback = NULL;
         button_table[i].released_callback = NULL;
     }
@@ -184,15 +194,16 @@ BTN_Ctrl_Ret_t BTN_InitController(void){
     }
 
     //Create button task
-    if(pdTRUE == xTaskCreate(tButtonTask,
+    if(pdTRUE != xTaskCreate(tButtonTask,
                              "Button Task",
-                             2048,
+                             CONFIG_BUTTON_TASK_STACK_SIZE,
                              NULL,
                              5,
                              &button_task_handle)){
         ESP_LOGE(TAG, "Failed to create button taks");
         return BTN_CTRL_STATUS_FAIL;
     }
+    STACK_MON_RegisterTask(button_task_handle, CONFIG_BUTTON_TASK_STACK_SIZE);
 
     return BTN_CTRL_STATUS_SUCCESS;
 }
@@ -226,6 +237,27 @@ BTN_Ctrl_Ret_t BTN_AddButton(uint8_t io_num,
     return BTN_CTRL_STATUS_SUCCESS;
 }
 
+BTN_Ctrl_Ret_t BTN_GetButtonState(uint8_t index, uint8_t *pIo, bool *pPressed){
+
+    if(index >= BTN_MAX_NUMBER_OF_BUTTON || button_mutex_handle == NULL){
+        return BTN_CTRL_STATUS_FAIL;
+    }
+
+    BTN_Ctrl_Ret_t ret = BTN_CTRL_STATUS_FAIL;
+
+    xSemaphoreTake(button_mutex_handle, portMAX_DELAY);
+
+    if(button_table[index].io != 0xFF){
+        if(pIo != NULL)         *pIo = button_table[index].io;
+        if(pPressed != NULL)    *pPressed = button_table[index].pressed;
+        ret = BTN_CTRL_STATUS_SUCCESS;
+    }
+
+    xSemaphoreGive(button_mutex_handle);
+
+    return ret;
+}
+
 /******************************************************************************
 *   Interrupts
 *******************************************************************************/
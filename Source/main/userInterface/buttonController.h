@@ -2,6 +2,7 @@
 #define _BUTTON_CONTROLLER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /******************************************************************************
 *   Public Definitions
@@ -51,4 +52,6 @@ BTN_Ctrl_Ret_t BTN_AddButton(uint8_t io_num,
                              btnPressedCallback pressed_callback,
                              btnReleasedCallback released_callback);
 
+BTN_Ctrl_Ret_t BTN_GetButtonState(uint8_t index, uint8_t *pIo, bool *pPressed);
+
 #endif//_BUTTON_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef _LED_BACKEND_H
+#define _LED_BACKEND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ledController.h"
+
+/******************************************************************************
+*   Public Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Error Check
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions
+*******************************************************************************/
+/*
+ * Implemented by the backend selected in menuconfig, ledDiscreteBackend.c or
+ * ledStripBackend.c, and only called from the LED controller task.
+ */
+
+/***************************************************************************//*!
+*  \brief LED backend initialization
+*
+*   This function is used to set up the LED hardware with every LED off.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  count               Number of LEDs
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_BACKEND_Init(uint8_t count);
+
+/***************************************************************************//*!
+*  \brief LED backend show
+*
+*   This function is used to send a frame to the LEDs. It may return before
+*   the LEDs are updated, the frame is copied first.
+*
+*   Preconditions: LED_BACKEND_Init called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pFrame              Color of every LED
+*   \param[in]  count               Number of LEDs
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_BACKEND_Show(const LED_Color_t *pFrame, uint8_t count);
+
+#endif//_LED_BACKEND_H
@@ -6,12 +6,28 @@
 /******************************************************************************
 *   Includes
 *******************************************************************************/
+#include <string.h>
+#include "sdkconfig.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "ledController.h"
+#include "ledBackend.h"
+#include "stackMonitor.h"
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
+#define LED_TASK_STACK                  (CONFIG_LED_TASK_STACK_SIZE)
+#define LED_TASK_PRIORITY               (3)
+#define LED_FRAME_PERIOD_US             (1000000 / CONFIG_LED_FRAME_RATE)
 
 /******************************************************************************
 *   Private Macros
@@ -21,12 +37,21 @@
 /******************************************************************************
 *   Private Data Types
 *******************************************************************************/
-
+typedef struct LED_State_s{
+    LED_Pattern_t pattern;
+    LED_Color_t color;
+    uint16_t period_ms;
+    uint32_t start_ms;                      //Time the pattern was set
+}LED_State_t;
 
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
-
+static uint32_t LED_Now(void);
+static LED_Color_t LED_Scale(LED_Color_t color, uint8_t level);
+static LED_Color_t LED_Render(const LED_State_t *pState, uint32_t now_ms);
+static void LED_FrameTimerCallback(void *pArg);
+static void tLedTask(void *pvParameters);
 
 /******************************************************************************
 *   Public Variables
@@ -36,20 +61,337 @@
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
+static LED_State_t led_states[LED_MAX_NUMBER_OF_LED];
+static LED_Stats_t led_stats;
 
+static esp_timer_handle_t led_timer_handle = NULL;
+static TaskHandle_t led_task_handle = NULL;
+static SemaphoreHandle_t led_mutex_handle = NULL;
+
+static const char * TAG = "LED";
 
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
+/***************************************************************************//*!
+*  \brief LED controller time
+*
+*   This function is used to read the time base of the patterns.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     time in milliseconds
+*
+*******************************************************************************/
+static uint32_t LED_Now(void){
+
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/***************************************************************************//*!
+*  \brief LED controller scale
+*
+*   This function is used to dim a color.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  color               Color
+*   \param[in]  level               Brightness, 255 for the color as is
+*
+*   \return     dimmed color
+*
+*******************************************************************************/
+static LED_Color_t LED_Scale(LED_Color_t color, uint8_t level){
+
+    LED_Color_t scaled = {
+        .red = (uint8_t)((color.red * level) / 255),
+        .green = (uint8_t)((color.green * level) / 255),
+        .blue = (uint8_t)((color.blue * level) / 255),
+    };
+
+    return scaled;
+}
+
+/***************************************************************************//*!
+*  \brief LED controller render
+*
+*   This function is used to compute the color of an LED at a given time.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pState              LED pattern
+*   \param[in]  now_ms              Current time
+*
+*   \return     LED color
+*
+*******************************************************************************/
+static LED_Color_t LED_Render(const LED_State_t *pState, uint32_t now_ms){
+
+    LED_Color_t color = {0};
+    uint32_t period = (pState->period_ms != 0) ? pState->period_ms : 1;
+    uint32_t phase = (now_ms - pState->start_ms) % period;
+
+    switch(pState->pattern){
+        case LED_PATTERN_ON:
+        {
+            color = pState->color;
+        }
+        break;
+
+        case LED_PATTERN_BLINK:
+        {
+            if(phase < period / 2){
+                color = pState->color;
+            }
+        }
+        break;
+
+        case LED_PATTERN_BREATHE:
+        {
+            //Triangle from 0 to 255 and back
+            uint32_t half = (phase < period / 2) ? phase : period - phase;
+            uint32_t level = (half * 510) / period;
+            color = LED_Scale(pState->color, (level > 255) ? 255 : (uint8_t)level);
+        }
+        break;
+
+        default:
+        {
+            //Off...
+        }
+        break;
+    }
+
+    return color;
+}
+
+static void LED_FrameTimerCallback(void *pArg){
+
+    xTaskNotifyGive(led_task_handle);
+}
+
+static void tLedTask(void *pvParameters){
+
+    //Frame sent last, the backend is only called when it changes
+    LED_Color_t shown[LED_MAX_NUMBER_OF_LED];
+    LED_Color_t frame[LED_MAX_NUMBER_OF_LED];
+    LED_State_t states[LED_MAX_NUMBER_OF_LED];
+
+    ESP_LOGI(TAG, "Starting LED task");
+
+    memset(shown, 0, sizeof(shown));
+    bool pending = false;
+
+    for(;;){
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
+        memcpy(states, led_states, sizeof(states));
+        xSemaphoreGive(led_mutex_handle);
+
+        //Computed while the backend still sends the previous frame
+        uint32_t now_ms = LED_Now();
+        for(uint8_t i=0; i<LED_MAX_NUMBER_OF_LED; i++){
+            frame[i] = LED_Render(&states[i], now_ms);
+        }
 
+        bool changed = (memcmp(frame, shown, sizeof(frame)) != 0);
+        bool sent = changed && (LED_BACKEND_Show(frame, LED_MAX_NUMBER_OF_LED) == LED_CTRL_STATUS_SUCCESS);
+        if(sent){
+            memcpy(shown, frame, sizeof(shown));
+        }
+        //Sent again on the next frame
+        pending = changed && !sent;
+
+        bool animated = false;
+
+        xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
+        led_stats.frames++;
+        if(sent)                led_stats.updates++;
+        else if(changed)        led_stats.errors++;
+
+        for(uint8_t i=0; i<LED_MAX_NUMBER_OF_LED; i++){
+            if(led_states[i].pattern == LED_PATTERN_BLINK || led_states[i].pattern == LED_PATTERN_BREATHE){
+                animated = true;
+            }
+        }
+        //No frame to compute until LED_SetPattern starts the timer again, under the mutex
+        if(!animated && !pending){
+            esp_timer_stop(led_timer_handle);
+        }
+        xSemaphoreGive(led_mutex_handle);
+    }
+    vTaskDelete(NULL);
+}
 
 /******************************************************************************
 *   Public Functions Definitions
 *******************************************************************************/
+/***************************************************************************//*!
+*  \brief LED controller initialization
+*
+*   This function is used to initialize the LED backend selected in
+*   menuconfig, discrete LEDs or a WS2812 strip, turn every LED off and
+*   start the task computing the frames at CONFIG_LED_FRAME_RATE.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_InitController(void){
 
+    if(led_task_handle != NULL){
+        return LED_CTRL_STATUS_FAIL;
+    }
 
-/******************************************************************************
-*   Interrupts
+    memset(led_states, 0, sizeof(led_states));
+    memset(&led_stats, 0, sizeof(led_stats));
+
+    if(LED_BACKEND_Init(LED_MAX_NUMBER_OF_LED) != LED_CTRL_STATUS_SUCCESS){
+        ESP_LOGW(TAG, "Failed to initialize LED backend");
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    //Create LED mutex
+    led_mutex_handle = xSemaphoreCreateMutex();
+    if(led_mutex_handle == NULL){
+        ESP_LOGW(TAG, "Failed to create LED mutex");
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = LED_FrameTimerCallback,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led frame",
+        .skip_unhandled_events = true,
+    };
+    if(esp_timer_create(&timer_args, &led_timer_handle) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to create LED frame timer");
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    //Create LED task
+    if(pdTRUE != xTaskCreate(tLedTask,
+                             "LED task",
+                             LED_TASK_STACK,
+                             NULL,
+                             LED_TASK_PRIORITY,
+                             &led_task_handle)){
+        ESP_LOGE(TAG, "Failed to create LED task");
+        return LED_CTRL_STATUS_FAIL;
+    }
+    STACK_MON_RegisterTask(led_task_handle, LED_TASK_STACK);
+
+    return LED_CTRL_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief LED controller set pattern
+*
+*   This function is used to set the pattern of an LED. Animated patterns
+*   restart from the beginning of their period. Discrete LEDs are lit when
+*   the brightest component of the color is at least half on.
+*
+*   Preconditions: LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index               LED index, from 0
+*   \param[in]  pattern             Pattern
+*   \param[in]  color               Color when lit
+*   \param[in]  period_ms           Period of animated patterns
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_SetPattern(uint8_t index, LED_Pattern_t pattern, LED_Color_t color, uint16_t period_ms){
+
+    if(led_task_handle == NULL || index >= LED_MAX_NUMBER_OF_LED || pattern >= LED_PATTERN_INVALID){
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
+    led_states[index].pattern = pattern;
+    led_states[index].color = color;
+    led_states[index].period_ms = period_ms;
+    led_states[index].start_ms = LED_Now();
+    if(!esp_timer_is_active(led_timer_handle)){
+        esp_timer_start_periodic(led_timer_handle, LED_FRAME_PERIOD_US);
+    }
+    xSemaphoreGive(led_mutex_handle);
+
+    //Shown now rather than on the next frame
+    xTaskNotifyGive(led_task_handle);
+
+    return LED_CTRL_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief LED controller set level
+*
+*   This function is used to show a level as a bar, the first LEDs on and
+*   the others off, e.g. the battery level.
+*
+*   Preconditions: LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  level               Number of LEDs on
+*   \param[in]  color               Color of the LEDs on
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_SetLevel(uint8_t level, LED_Color_t color){
+
+    LED_Ctrl_Ret_t ret = LED_CTRL_STATUS_SUCCESS;
+
+    for(uint8_t i=0; i<LED_MAX_NUMBER_OF_LED; i++){
+        if(LED_SetPattern(i, (i < level) ? LED_PATTERN_ON : LED_PATTERN_OFF, color, 0) != LED_CTRL_STATUS_SUCCESS){
+            ret = LED_CTRL_STATUS_FAIL;
+        }
+    }
+
+    return ret;
+}
+
+/***************************************************************************//*!
+*  \brief LED controller statistics
+*
+*   This function is used to read the LED controller counters.
+*
+*   Preconditions: LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
 *******************************************************************************/
+LED_Ctrl_Ret_t LED_GetStats(LED_Stats_t *pStats){
+
+    if(led_mutex_handle == NULL || pStats == NULL){
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    xSemaphoreTake(led_mutex_handle, portMAX_DELAY);
+    *pStats = led_stats;
+    xSemaphoreGive(led_mutex_handle);
 
+    return LED_CTRL_STATUS_SUCCESS;
+}
 
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
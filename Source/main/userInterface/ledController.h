@@ -1,10 +1,18 @@
 #ifndef _LED_CONTROLLER_H
 #define _LED_CONTROLLER_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
 /******************************************************************************
 *   Public Definitions
 *******************************************************************************/
-
+#if CONFIG_LED_BACKEND_WS2812
+#define LED_MAX_NUMBER_OF_LED               (CONFIG_LED_STRIP_LENGTH)
+#else
+#define LED_MAX_NUMBER_OF_LED               (4)     //HWI_BATT_LEVEL_1_OUT to HWI_BATT_LEVEL_4_OUT
+#endif
 
 /******************************************************************************
 *   Public Macros
@@ -14,7 +22,31 @@
 /******************************************************************************
 *   Public Data Types
 *******************************************************************************/
+typedef struct LED_Color_s{
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+}LED_Color_t;
+
+typedef enum LED_Pattern_e{
+    LED_PATTERN_OFF,
+    LED_PATTERN_ON,
+    LED_PATTERN_BLINK,                      //On for the first half of the period
+    LED_PATTERN_BREATHE,                    //Fades in and out over the period
 
+    LED_PATTERN_INVALID,
+}LED_Pattern_t;
+
+typedef struct LED_Stats_s{
+    uint32_t frames;                        //Frames computed
+    uint32_t updates;                       //Frames sent to the LEDs, unchanged frames are not
+    uint32_t errors;                        //Frames the backend failed to send
+}LED_Stats_t;
+
+typedef enum LED_Ctrl_Ret_e{
+    LED_CTRL_STATUS_FAIL,
+    LED_CTRL_STATUS_SUCCESS,
+}LED_Ctrl_Ret_t;
 
 /******************************************************************************
 *   Public Variables
@@ -29,6 +61,75 @@
 /******************************************************************************
 *   Public Functions
 *******************************************************************************/
+/***************************************************************************//*!
+*  \brief LED controller initialization
+*
+*   This function is used to initialize the LED backend selected in
+*   menuconfig, discrete LEDs or a WS2812 strip, turn every LED off and
+*   start the task computing the frames at CONFIG_LED_FRAME_RATE.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_InitController(void);
 
+/***************************************************************************//*!
+*  \brief LED controller set pattern
+*
+*   This function is used to set the pattern of an LED. Animated patterns
+*   restart from the beginning of their period. Discrete LEDs are lit when
+*   the brightest component of the color is at least half on.
+*
+*   Preconditions: LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  index               LED index, from 0
+*   \param[in]  pattern             Pattern
+*   \param[in]  color               Color when lit
+*   \param[in]  period_ms           Period of animated patterns
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_SetPattern(uint8_t index, LED_Pattern_t pattern, LED_Color_t color, uint16_t period_ms);
+
+/***************************************************************************//*!
+*  \brief LED controller set level
+*
+*   This function is used to show a level as a bar, the first LEDs on and
+*   the others off, e.g. the battery level.
+*
+*   Preconditions: LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  level               Number of LEDs on
+*   \param[in]  color               Color of the LEDs on
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_SetLevel(uint8_t level, LED_Color_t color);
+
+/***************************************************************************//*!
+*  \brief LED controller statistics
+*
+*   This function is used to read the LED controller counters.
+*
+*   Preconditions: LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[out] pStats              Pointer to store the counters
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_GetStats(LED_Stats_t *pStats);
 
-#endif//_LED_CONTROLLER_H
\ No newline at end of file
+#endif//_LED_CONTROLLER_H
@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include "sdkconfig.h"
+
+#if CONFIG_LED_BACKEND_DISCRETE
+
+#include "driver/gpio.h"
+#include "esp_log.h"
+
+#include "hardwareInterface.h"
+#include "ledBackend.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+//Lit when the brightest component reaches this level
+#define LED_DISCRETE_THRESHOLD          (128)
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+static const uint8_t led_discrete_io[LED_MAX_NUMBER_OF_LED] = {
+    HWI_BATT_LEVEL_1_OUT,
+    HWI_BATT_LEVEL_2_OUT,
+    HWI_BATT_LEVEL_3_OUT,
+    HWI_BATT_LEVEL_4_OUT,
+};
+
+static const char * TAG = "LED_DISCRETE";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief LED backend initialization
+*
+*   This function is used to set up the LED hardware with every LED off.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  count               Number of LEDs
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_BACKEND_Init(uint8_t count){
+
+    uint64_t mask = 0;
+
+    if(count > LED_MAX_NUMBER_OF_LED){
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    for(uint8_t i=0; i<count; i++){
+        mask |= (1ULL << led_discrete_io[i]);
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = mask,
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    if(gpio_config(&io_conf) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to configure LED outputs");
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    for(uint8_t i=0; i<count; i++){
+        gpio_set_level(led_discrete_io[i], 0);
+    }
+
+    return LED_CTRL_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief LED backend show
+*
+*   This function is used to send a frame to the LEDs. It may return before
+*   the LEDs are updated, the frame is copied first.
+*
+*   Preconditions: LED_BACKEND_Init called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pFrame              Color of every LED
+*   \param[in]  count               Number of LEDs
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_BACKEND_Show(const LED_Color_t *pFrame, uint8_t count){
+
+    if(pFrame == NULL || count > LED_MAX_NUMBER_OF_LED){
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    for(uint8_t i=0; i<count; i++){
+        bool lit = (pFrame[i].red >= LED_DISCRETE_THRESHOLD) ||
+                   (pFrame[i].green >= LED_DISCRETE_THRESHOLD) ||
+                   (pFrame[i].blue >= LED_DISCRETE_THRESHOLD);
+        gpio_set_level(led_discrete_io[i], lit);
+    }
+
+    return LED_CTRL_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
+#endif//CONFIG_LED_BACKEND_DISCRETE
@@ -0,0 +1,340 @@
+/*
+ * SPDX-FileCopyrightText: 2010-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+/******************************************************************************
+*   Includes
+*******************************************************************************/
+#include "sdkconfig.h"
+
+#if CONFIG_LED_BACKEND_WS2812
+
+#include <stdlib.h>
+#include "soc/soc_caps.h"
+
+#include "driver/rmt_tx.h"
+#include "esp_log.h"
+
+#include "hardwareInterface.h"
+#include "ledBackend.h"
+
+/******************************************************************************
+*   Private Definitions
+*******************************************************************************/
+#define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
+
+#define LED_STRIP_RESOLUTION_HZ         (10000000)      //0.1us ticks
+#define LED_STRIP_RESET_US              (50)
+#define LED_STRIP_BYTES_PER_LED         (3)
+#define LED_STRIP_FRAME_SIZE            (LED_MAX_NUMBER_OF_LED * LED_STRIP_BYTES_PER_LED)
+//A frame takes 30us per LED, waiting longer means the channel is stuck
+#define LED_STRIP_TX_TIMEOUT_MS         (20)
+
+#if SOC_RMT_SUPPORT_DMA
+//The DMA fetches the symbols, the CPU only encodes
+#define LED_STRIP_WITH_DMA              (1)
+#define LED_STRIP_MEM_SYMBOLS           (1024)
+#else
+//The RMT interrupt refills half of the channel memory at a time
+#define LED_STRIP_WITH_DMA              (0)
+#define LED_STRIP_MEM_SYMBOLS           (SOC_RMT_MEM_WORDS_PER_CHANNEL)
+#endif
+
+/******************************************************************************
+*   Private Macros
+*******************************************************************************/
+#define LED_STRIP_TICKS(ns)             ((uint16_t)(((uint64_t)(ns) * LED_STRIP_RESOLUTION_HZ) / 1000000000ULL))
+
+/******************************************************************************
+*   Private Data Types
+*******************************************************************************/
+//WS2812 pixel bytes, then the reset code
+typedef struct LED_Strip_Encoder_s{
+    rmt_encoder_t base;
+    rmt_encoder_handle_t bytes_encoder;
+    rmt_encoder_handle_t copy_encoder;
+    uint8_t state;                          //0 pixels, 1 reset code
+    rmt_symbol_word_t reset_code;
+}LED_Strip_Encoder_t;
+
+/******************************************************************************
+*   Private Functions Declaration
+*******************************************************************************/
+static size_t LED_STRIP_Encode(rmt_encoder_t *pEncoder, rmt_channel_handle_t channel,
+                               const void *pData, size_t size, rmt_encode_state_t *pState);
+static esp_err_t LED_STRIP_EncoderReset(rmt_encoder_t *pEncoder);
+static esp_err_t LED_STRIP_EncoderDelete(rmt_encoder_t *pEncoder);
+static LED_Strip_Encoder_t *LED_STRIP_NewEncoder(void);
+
+/******************************************************************************
+*   Public Variables
+*******************************************************************************/
+
+
+/******************************************************************************
+*   Private Variables
+*******************************************************************************/
+/*
+ * Double buffered frames: the RMT reads the front buffer while the next
+ * frame is written to the back one, which is only sent once the front one
+ * is done.
+ */
+static uint8_t strip_buffers[2][LED_STRIP_FRAME_SIZE];
+static uint8_t strip_back = 0;
+static uint8_t strip_count = 0;
+
+static rmt_channel_handle_t strip_channel = NULL;
+static LED_Strip_Encoder_t *pStrip_encoder = NULL;
+
+static const char * TAG = "LED_STRIP";
+
+/******************************************************************************
+*   Private Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief LED strip encode
+*
+*   This function is used by the RMT driver to turn a frame into symbols,
+*   it is called again from the RMT interrupt when the channel memory was
+*   full.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pEncoder            LED strip encoder
+*   \param[in]  channel             RMT channel
+*   \param[in]  pData               GRB bytes
+*   \param[in]  size                Number of bytes
+*   \param[out] pState              Encoding state
+*
+*   \return     number of symbols encoded
+*
+*******************************************************************************/
+static size_t LED_STRIP_Encode(rmt_encoder_t *pEncoder, rmt_channel_handle_t channel,
+                               const void *pData, size_t size, rmt_encode_state_t *pState){
+
+    LED_Strip_Encoder_t *pStrip = __containerof(pEncoder, LED_Strip_Encoder_t, base);
+    rmt_encode_state_t session = RMT_ENCODING_RESET;
+    rmt_encode_state_t state = RMT_ENCODING_RESET;
+    size_t symbols = 0;
+
+    if(pStrip->state == 0){
+        symbols += pStrip->bytes_encoder->encode(pStrip->bytes_encoder, channel, pData, size, &session);
+        if(session & RMT_ENCODING_COMPLETE){
+            pStrip->state = 1;
+        }
+        if(session & RMT_ENCODING_MEM_FULL){
+            *pState = RMT_ENCODING_MEM_FULL;
+            return symbols;
+        }
+    }
+
+    if(pStrip->state == 1){
+        symbols += pStrip->copy_encoder->encode(pStrip->copy_encoder, channel, &pStrip->reset_code,
+                                                sizeof(pStrip->reset_code), &session);
+        if(session & RMT_ENCODING_COMPLETE){
+            pStrip->state = 0;
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if(session & RMT_ENCODING_MEM_FULL){
+            state |= RMT_ENCODING_MEM_FULL;
+        }
+    }
+
+    *pState = state;
+    return symbols;
+}
+
+static esp_err_t LED_STRIP_EncoderReset(rmt_encoder_t *pEncoder){
+
+    LED_Strip_Encoder_t *pStrip = __containerof(pEncoder, LED_Strip_Encoder_t, base);
+
+    rmt_encoder_reset(pStrip->bytes_encoder);
+    rmt_encoder_reset(pStrip->copy_encoder);
+    pStrip->state = 0;
+
+    return ESP_OK;
+}
+
+static esp_err_t LED_STRIP_EncoderDelete(rmt_encoder_t *pEncoder){
+
+    LED_Strip_Encoder_t *pStrip = __containerof(pEncoder, LED_Strip_Encoder_t, base);
+
+    if(pStrip->bytes_encoder != NULL)   rmt_del_encoder(pStrip->bytes_encoder);
+    if(pStrip->copy_encoder != NULL)    rmt_del_encoder(pStrip->copy_encoder);
+    free(pStrip);
+
+    return ESP_OK;
+}
+
+/***************************************************************************//*!
+*  \brief LED strip new encoder
+*
+*   This function is used to create the WS2812 encoder: a bytes encoder
+*   with the WS2812 bit timings, MSB first, followed by a 50us low reset
+*   code.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \return     encoder, NULL on failure
+*
+*******************************************************************************/
+static LED_Strip_Encoder_t *LED_STRIP_NewEncoder(void){
+
+    LED_Strip_Encoder_t *pStrip = rmt_alloc_encoder_mem(sizeof(LED_Strip_Encoder_t));
+    if(pStrip == NULL){
+        return NULL;
+    }
+
+    pStrip->base.encode = LED_STRIP_Encode;
+    pStrip->base.reset = LED_STRIP_EncoderReset;
+    pStrip->base.del = LED_STRIP_EncoderDelete;
+    pStrip->bytes_encoder = NULL;
+    pStrip->copy_encoder = NULL;
+    pStrip->state = 0;
+
+    rmt_bytes_encoder_config_t bytes_config = {
+        .bit0 = {
+            .level0 = 1,
+            .duration0 = LED_STRIP_TICKS(300),      //T0H
+            .level1 = 0,
+            .duration1 = LED_STRIP_TICKS(900),      //T0L
+        },
+        .bit1 = {
+            .level0 = 1,
+            .duration0 = LED_STRIP_TICKS(900),      //T1H
+            .level1 = 0,
+            .duration1 = LED_STRIP_TICKS(300),      //T1L
+        },
+        .flags.msb_first = 1,
+    };
+    rmt_copy_encoder_config_t copy_config = {};
+
+    if(rmt_new_bytes_encoder(&bytes_config, &pStrip->bytes_encoder) != ESP_OK ||
+       rmt_new_copy_encoder(&copy_config, &pStrip->copy_encoder) != ESP_OK){
+        LED_STRIP_EncoderDelete(&pStrip->base);
+        return NULL;
+    }
+
+    pStrip->reset_code = (rmt_symbol_word_t){
+        .level0 = 0,
+        .duration0 = LED_STRIP_TICKS(LED_STRIP_RESET_US * 1000 / 2),
+        .level1 = 0,
+        .duration1 = LED_STRIP_TICKS(LED_STRIP_RESET_US * 1000 / 2),
+    };
+
+    return pStrip;
+}
+
+/******************************************************************************
+*   Public Functions Definitions
+*******************************************************************************/
+/***************************************************************************//*!
+*  \brief LED backend initialization
+*
+*   This function is used to set up the LED hardware with every LED off.
+*
+*   Preconditions: None.
+*
+*   Side Effects: None.
+*
+*   \param[in]  count               Number of LEDs
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_BACKEND_Init(uint8_t count){
+
+    if(strip_channel != NULL || count == 0 || count > LED_MAX_NUMBER_OF_LED){
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    rmt_tx_channel_config_t channel_config = {
+        .gpio_num = HWI_LED_STRIP_OUT,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = LED_STRIP_RESOLUTION_HZ,
+        .mem_block_symbols = LED_STRIP_MEM_SYMBOLS,
+        .trans_queue_depth = 2,
+        .flags.with_dma = LED_STRIP_WITH_DMA,
+    };
+    if(rmt_new_tx_channel(&channel_config, &strip_channel) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to create RMT channel");
+        strip_channel = NULL;
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    pStrip_encoder = LED_STRIP_NewEncoder();
+    if(pStrip_encoder == NULL || rmt_enable(strip_channel) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to set up RMT encoder");
+        if(pStrip_encoder != NULL)  LED_STRIP_EncoderDelete(&pStrip_encoder->base);
+        rmt_del_channel(strip_channel);
+        pStrip_encoder = NULL;
+        strip_channel = NULL;
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    strip_count = count;
+    strip_back = 0;
+
+    //The LEDs keep their color over a reset of the chip
+    LED_Color_t off[LED_MAX_NUMBER_OF_LED] = {0};
+    return LED_BACKEND_Show(off, count);
+}
+
+/***************************************************************************//*!
+*  \brief LED backend show
+*
+*   This function is used to send a frame to the LEDs. It may return before
+*   the LEDs are updated, the frame is copied first.
+*
+*   Preconditions: LED_BACKEND_Init called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  pFrame              Color of every LED
+*   \param[in]  count               Number of LEDs
+*
+*   \return     operation status
+*
+*******************************************************************************/
+LED_Ctrl_Ret_t LED_BACKEND_Show(const LED_Color_t *pFrame, uint8_t count){
+
+    if(strip_channel == NULL || pFrame == NULL || count != strip_count){
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    //WS2812 order is green, red, blue
+    uint8_t *pBuffer = strip_buffers[strip_back];
+    for(uint8_t i=0; i<count; i++){
+        pBuffer[i * LED_STRIP_BYTES_PER_LED + 0] = (uint8_t)((pFrame[i].green * CONFIG_LED_STRIP_BRIGHTNESS) / 255);
+        pBuffer[i * LED_STRIP_BYTES_PER_LED + 1] = (uint8_t)((pFrame[i].red * CONFIG_LED_STRIP_BRIGHTNESS) / 255);
+        pBuffer[i * LED_STRIP_BYTES_PER_LED + 2] = (uint8_t)((pFrame[i].blue * CONFIG_LED_STRIP_BRIGHTNESS) / 255);
+    }
+
+    //The front buffer is free once its frame is out, usually long before
+    if(rmt_tx_wait_all_done(strip_channel, LED_STRIP_TX_TIMEOUT_MS) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to send frame -> Timeout");
+        return LED_CTRL_STATUS_FAIL;
+    }
+
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+    };
+    if(rmt_transmit(strip_channel, &pStrip_encoder->base, pBuffer, count * LED_STRIP_BYTES_PER_LED, &tx_config) != ESP_OK){
+        ESP_LOGW(TAG, "Failed to send frame");
+        return LED_CTRL_STATUS_FAIL;
+    }
+    strip_back ^= 1;
+
+    return LED_CTRL_STATUS_SUCCESS;
+}
+
+/******************************************************************************
+*   Interrupts
+*******************************************************************************/
+
+#endif//CONFIG_LED_BACKEND_WS2812
@@ -8,6 +8,9 @@
 *******************************************************************************/
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "sdkconfig.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -18,12 +21,19 @@
 
 #include "hardwareInterface.h"
 #include "userInterface.h"
+#include "ledController.h"
+#if CONFIG_ASSET_STORE
+#include "assetStore.h"
+#endif
 
 /******************************************************************************
 *   Private Definitions
 *******************************************************************************/
 #define LOG_LOCAL_LEVEL                 (ESP_LOG_INFO)
 
+//Battery level shown in red at or below this state of charge
+#define UI_BATTERY_LOW_SOC              (20)
+
 /******************************************************************************
 *   Private Macros
 *******************************************************************************/
@@ -37,7 +47,11 @@
 /******************************************************************************
 *   Private Functions Declaration
 *******************************************************************************/
-
+#if CONFIG_ASSET_STORE
+static void UI_SetLedPatterns(void);
+static void UI_AssetCallback(const char *pName);
+#endif
+static void UI_ShowLevel(void);
 
 /******************************************************************************
 *   Public Variables
@@ -47,12 +61,92 @@
 /******************************************************************************
 *   Private Variables
 *******************************************************************************/
+#if CONFIG_ASSET_STORE
+static bool assets_loaded = false;
+#endif
+
+//The LED patterns of the asset table replace the battery level
+static bool patterns_set = false;
+static int16_t battery_soc = -1;           //-1 until the fuel gauge is read
+
+static SemaphoreHandle_t ui_mutex_handle = NULL;
+
 static const char * TAG = "UI";
 
 /******************************************************************************
 *   Private Functions Definitions
 *******************************************************************************/
+#if CONFIG_ASSET_STORE
+static void UI_SetLedPatterns(void){
+
+    const ASSET_STORE_Table_t *pTable = NULL;
+    UI_Led_Pattern_Entry_t entry;
+
+    xSemaphoreTake(ui_mutex_handle, portMAX_DELAY);
+
+    //Removed or invalid, no LED keeps the pattern of the old table
+    if(ASSET_STORE_Acquire(UI_LED_PATTERN_ASSET, &pTable) != ASSET_STORE_STATUS_SUCCESS){
+        patterns_set = false;
+        UI_ShowLevel();
+        xSemaphoreGive(ui_mutex_handle);
+        return;
+    }
+    patterns_set = true;
+
+    if(pTable->header.type != ASSET_STORE_TYPE_LED_PATTERN ||
+       pTable->header.version != UI_LED_PATTERN_VERSION ||
+       pTable->header.entry_size != sizeof(UI_Led_Pattern_Entry_t)){
+        ESP_LOGW(TAG, "Failed to set %s -> Unsupported table", UI_LED_PATTERN_ASSET);
+    }
+    else{
+        for(uint16_t i=0; i<pTable->header.entry_count; i++){
+            if(ASSET_STORE_ReadEntries(pTable, i, 1, &entry) != ASSET_STORE_STATUS_SUCCESS){
+                ESP_LOGW(TAG, "Failed to set %s -> Entry %u not read", UI_LED_PATTERN_ASSET, i);
+                break;
+            }
+
+            LED_Color_t color = {
+                .red = entry.red,
+                .green = entry.green,
+                .blue = entry.blue,
+            };
+            if(LED_SetPattern(entry.index, (LED_Pattern_t)entry.pattern, color, entry.period_ms) != LED_CTRL_STATUS_SUCCESS){
+                ESP_LOGW(TAG, "Failed to set %s -> Entry %u invalid", UI_LED_PATTERN_ASSET, i);
+            }
+        }
+    }
+
+    ASSET_STORE_Release(pTable);
+    xSemaphoreGive(ui_mutex_handle);
+}
+
+//Called on the asset store task
+static void UI_AssetCallback(const char *pName){
 
+    if(strcmp(pName, UI_LED_PATTERN_ASSET) == 0){
+        UI_SetLedPatterns();
+    }
+}
+#endif
+
+//Shows the battery level on the LEDs, called with the mutex taken
+static void UI_ShowLevel(void){
+
+    const LED_Color_t off = {0};
+    const LED_Color_t green = {.green = 255};
+    const LED_Color_t red = {.red = 255};
+
+    if(battery_soc < 0){
+        for(uint8_t i=0; i<LED_MAX_NUMBER_OF_LED; i++){
+            LED_SetPattern(i, LED_PATTERN_OFF, off, 0);
+        }
+        return;
+    }
+
+    //One LED per started share, off at 0 %
+    uint8_t level = (uint8_t)((battery_soc * LED_MAX_NUMBER_OF_LED + 99) / 100);
+    LED_SetLevel(level, (battery_soc <= UI_BATTERY_LOW_SOC) ? red : green);
+}
 
 /******************************************************************************
 *   Public Functions Definitions
@@ -61,7 +155,91 @@ UI_Ret_t UI_InitInterface(void){
 
     ESP_LOGI(TAG, "Interface initialization");
 
+    //Create mutex, once
+    if(ui_mutex_handle == NULL){
+        ui_mutex_handle = xSemaphoreCreateMutex();
+        if(ui_mutex_handle == NULL){
+            ESP_LOGW(TAG, "Failed to create UI mutex");
+            return UI_STATUS_FAIL;
+        }
+    }
+
+    return UI_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief User interface show battery
+*
+*   This function is used to show the battery state of charge as a bar on
+*   the LEDs, unless the LED pattern table is set.
+*
+*   Preconditions: UI_InitInterface and LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  soc                 State of charge, in %
+*
+*   \return     operation status
+*
+*******************************************************************************/
+UI_Ret_t UI_ShowBattery(uint8_t soc){
+
+    if(ui_mutex_handle == NULL){
+        return UI_STATUS_FAIL;
+    }
+    if(soc > 100){
+        soc = 100;
+    }
+
+    xSemaphoreTake(ui_mutex_handle, portMAX_DELAY);
+    bool changed = (battery_soc != soc);
+    battery_soc = soc;
+    //Only sent when it changes, every call wakes the LED task
+    if(changed && !patterns_set){
+        UI_ShowLevel();
+    }
+    xSemaphoreGive(ui_mutex_handle);
+
+    return UI_STATUS_SUCCESS;
+}
+
+/***************************************************************************//*!
+*  \brief User interface load assets
+*
+*   This function is used to set the LED patterns of the UI_LED_PATTERN_ASSET
+*   table and to set them again every time the table changes. The battery
+*   level is shown again when the table is removed.
+*
+*   Preconditions: UI_InitInterface, LED_InitController and
+*                  ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+UI_Ret_t UI_LoadAssets(void){
+
+#if CONFIG_ASSET_STORE
+    if(ui_mutex_handle == NULL){
+        return UI_STATUS_FAIL;
+    }
+
+    //Register callback, once
+    if(!assets_loaded){
+        if(ASSET_STORE_RegisterCallback(UI_AssetCallback) != ASSET_STORE_STATUS_SUCCESS){
+            ESP_LOGW(TAG, "Failed to register asset callback");
+            return UI_STATUS_FAIL;
+        }
+        assets_loaded = true;
+    }
+
+    UI_SetLedPatterns();
+
     return UI_STATUS_SUCCESS;
+#else
+    return UI_STATUS_FAIL;
+#endif
 }
 
 /******************************************************************************
@@ -1,10 +1,14 @@
 #ifndef _USER_INTERFACE_H
 #define _USER_INTERFACE_H
 
+#include <stdint.h>
+
 /******************************************************************************
 *   Public Definitions
 *******************************************************************************/
-
+//LED pattern table of the asset store
+#define UI_LED_PATTERN_ASSET                "leds.pat"
+#define UI_LED_PATTERN_VERSION              (1)
 
 /******************************************************************************
 *   Public Macros
@@ -14,7 +18,15 @@
 /******************************************************************************
 *   Public Data Types
 *******************************************************************************/
-
+//Entry of the LED pattern table, packed with the tools/asset_pack.py format '<BBHBBB'
+typedef struct __attribute__((packed)) UI_Led_Pattern_Entry_s{
+    uint8_t index;                          //LED index, from 0
+    uint8_t pattern;                        //LED_Pattern_t
+    uint16_t period_ms;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+}UI_Led_Pattern_Entry_t;
 
 /******************************************************************************
 *   Public Variables
@@ -34,4 +46,38 @@ typedef enum UI_Ret_e{
 *******************************************************************************/
 UI_Ret_t UI_InitInterface(void);
 
+/***************************************************************************//*!
+*  \brief User interface show battery
+*
+*   This function is used to show the battery state of charge as a bar on
+*   the LEDs, unless the LED pattern table is set.
+*
+*   Preconditions: UI_InitInterface and LED_InitController called.
+*
+*   Side Effects: None.
+*
+*   \param[in]  soc                 State of charge, in %
+*
+*   \return     operation status
+*
+*******************************************************************************/
+UI_Ret_t UI_ShowBattery(uint8_t soc);
+
+/***************************************************************************//*!
+*  \brief User interface load assets
+*
+*   This function is used to set the LED patterns of the UI_LED_PATTERN_ASSET
+*   table and to set them again every time the table changes. The battery
+*   level is shown again when the table is removed.
+*
+*   Preconditions: UI_InitInterface, LED_InitController and
+*                  ASSET_STORE_InitModule called.
+*
+*   Side Effects: None.
+*
+*   \return     operation status
+*
+*******************************************************************************/
+UI_Ret_t UI_LoadAssets(void);
+
 #endif//_USER_INTERFACE_H
\ No newline at end of file
@@ -0,0 +1,77 @@
+#!/usr/bin/env python
+# SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""
+Asset file builder.
+
+Packs a table into the file format read by assetStore.c: a header followed by
+fixed size entries. Every CSV row is one entry, its fields are packed with a
+Python struct format. The firmware reads two tables:
+
+    # LED pattern per LED: index, LED_Pattern_t, period ms, red, green, blue
+    python asset_pack.py --type led_pattern --format '<BBHBBB' leds.csv assets/leds.pat
+    # Boot rail steps: SOFT_IO_Id_t, on, delay ms before the step
+    python asset_pack.py --type power_sequence --format '<BBH' boot.csv assets/boot.seq
+
+The files of a directory are turned into an image of the "assets" partition
+and written without reflashing the application, the asset store picks the
+changes up on its own:
+
+    python $IDF_PATH/components/spiffs/spiffsgen.py 0x10000 assets assets.bin
+    parttool.py write_partition --partition-name assets --input assets.bin
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import zlib
+
+MAGIC = 0x31545341              # ASSET_STORE_MAGIC
+HEADER = struct.Struct('<IHHHHI')
+NAME_SIZE = 24                  # ASSET_STORE_NAME_SIZE, terminator included
+
+TYPES = {
+    'led_pattern': 1,
+    'power_sequence': 2,
+    'config': 3,
+}
+
+
+def pack(rows, entry_format: str, table_type: int, version: int) -> bytes:
+    entry = struct.Struct(entry_format)
+    entries = b''.join(entry.pack(*(int(field, 0) for field in row)) for row in rows if row)
+    count = len(entries) // entry.size
+    if count > 0xFFFF or entry.size > 0xFFFF:
+        raise ValueError('table too large')
+    return HEADER.pack(MAGIC, table_type, version, entry.size, count, zlib.crc32(entries)) + entries
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--type', required=True, choices=sorted(TYPES), help='Table type')
+    parser.add_argument('--format', required=True, help='struct format of an entry, e.g. <HBBB')
+    parser.add_argument('--version', type=int, default=1, help='Table layout version')
+    parser.add_argument('--skip-header', action='store_true', help='Ignore the first CSV row')
+    parser.add_argument('input', help='CSV file, one entry per row, integer fields')
+    parser.add_argument('output', help='Asset file, named as the firmware acquires it')
+    args = parser.parse_args()
+
+    name = args.output.replace('\\', '/').split('/')[-1]
+    if len(name) >= NAME_SIZE:
+        parser.error('file name longer than {} characters'.format(NAME_SIZE - 1))
+
+    with open(args.input, newline='') as f:
+        rows = list(csv.reader(f))
+    if args.skip_header:
+        rows = rows[1:]
+
+    data = pack(rows, args.format, TYPES[args.type], args.version)
+    with open(args.output, 'wb') as f:
+        f.write(data)
+    print('{}: {} entries, {} bytes'.format(args.output, (len(data) - HEADER.size) // struct.calcsize(args.format), len(data)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
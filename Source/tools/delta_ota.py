@@ -0,0 +1,227 @@
+#!/usr/bin/env python
+# SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""
+Delta OTA patch maker.
+
+Builds the patch applied on the device by deltaOta.c, from the image it runs
+to a new image. The body is a list of bsdiff style records: approximate
+matches against the old image are sent as byte differences, mostly zeros
+once code moved, and the rest as extra bytes. The body is then compressed
+with heatshrink's LZSS format, which the device decodes with a window of
+2^window bytes.
+
+The patch is decoded and applied again before it is written, a patch that
+does not rebuild the new image is never produced.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+from typing import Dict, List, NamedTuple, Tuple
+
+MAGIC = 0x41544F44
+VERSION = 1
+HEADER = struct.Struct('<IBBBBII32s32s')
+RECORD = struct.Struct('<IIi')
+
+MAX_WINDOW_BITS = 11    # DELTA_OTA_MAX_WINDOW_BITS
+MIN_WINDOW_BITS = 4
+SEED_LEN = 8            # Bytes hashed to find match candidates in the old image
+MIN_MATCH = 32          # Shorter matches cost more as records than as extra bytes
+MAX_CANDIDATES = 16     # LZSS match candidates tried per position
+
+
+class Record(NamedTuple):
+    old_pos: int        # Start of the diff in the old image
+    new_pos: int        # Start of the diff in the new image
+    diff_len: int
+    extra_len: int      # Extra bytes following the diff in the new image
+
+
+def extend(old: bytes, new: bytes, old_pos: int, new_pos: int) -> int:
+    """Length of the approximate match, the prefix with the most matches over mismatches"""
+    best_len = 0
+    best_score = 0
+    score = 0
+    limit = min(len(old) - old_pos, len(new) - new_pos)
+    for i in range(limit):
+        score += 1 if old[old_pos + i] == new[new_pos + i] else -1
+        if score > best_score:
+            best_score = score
+            best_len = i + 1
+        elif score < best_score - MIN_MATCH:
+            break
+    return best_len
+
+
+def diff(old: bytes, new: bytes) -> List[Record]:
+    seeds: Dict[bytes, int] = {}
+    for pos in range(len(old) - SEED_LEN, -1, -1):
+        seeds[old[pos:pos + SEED_LEN]] = pos
+
+    matches: List[Tuple[int, int, int]] = []
+    new_pos = 0
+    last_shift = 0
+    while new_pos < len(new):
+        # Code that did not move keeps the shift of the previous match
+        candidates = [new_pos + last_shift, seeds.get(new[new_pos:new_pos + SEED_LEN], -1)]
+        best = (0, 0)
+        for old_pos in candidates:
+            if 0 <= old_pos < len(old):
+                length = extend(old, new, old_pos, new_pos)
+                if length > best[0]:
+                    best = (length, old_pos)
+        if best[0] >= MIN_MATCH:
+            matches.append((best[1], new_pos, best[0]))
+            last_shift = best[1] - new_pos
+            new_pos += best[0]
+        else:
+            new_pos += 1
+
+    # Every match becomes a diff, the new bytes up to the next match are its extra bytes
+    if not matches or matches[0][:2] != (0, 0):
+        matches.insert(0, (0, 0, 0))
+    records = []
+    for i, (old_pos, new_pos, length) in enumerate(matches):
+        end = matches[i + 1][1] if i + 1 < len(matches) else len(new)
+        records.append(Record(old_pos, new_pos, length, end - new_pos - length))
+    return records
+
+
+def encode_body(old: bytes, new: bytes, records: List[Record]) -> bytes:
+    body = bytearray()
+    for i, record in enumerate(records):
+        next_old = records[i + 1].old_pos if i + 1 < len(records) else record.old_pos + record.diff_len
+        body += RECORD.pack(record.diff_len, record.extra_len, next_old - record.old_pos - record.diff_len)
+        body += bytes((new[record.new_pos + j] - old[record.old_pos + j]) & 0xFF for j in range(record.diff_len))
+        extra = record.new_pos + record.diff_len
+        body += new[extra:extra + record.extra_len]
+    return bytes(body)
+
+
+class BitWriter:
+    def __init__(self) -> None:
+        self.data = bytearray()
+        self.bits = 0
+
+    def put(self, value: int, count: int) -> None:
+        for i in range(count - 1, -1, -1):
+            if self.bits == 0:
+                self.data.append(0)
+            if value & (1 << i):
+                self.data[-1] |= 0x80 >> self.bits
+            self.bits = (self.bits + 1) % 8
+
+
+def compress(data: bytes, window_bits: int, lookahead_bits: int) -> bytes:
+    window = 1 << window_bits
+    lookahead = 1 << lookahead_bits
+    backref_bits = 1 + window_bits + lookahead_bits
+    chains: Dict[bytes, List[int]] = {}
+    out = BitWriter()
+
+    def index(pos: int) -> None:
+        chain = chains.setdefault(data[pos:pos + 3], [])
+        chain.append(pos)
+        if len(chain) > MAX_CANDIDATES:
+            del chain[0]
+
+    pos = 0
+    while pos < len(data):
+        best_len = 0
+        best_offset = 0
+        for start in reversed(chains.get(data[pos:pos + 3], [])):
+            if pos - start > window:
+                break
+            length = 0
+            while length < lookahead and pos + length < len(data) and data[start + length] == data[pos + length]:
+                length += 1
+            if length > best_len:
+                best_len = length
+                best_offset = pos - start
+        if best_len * 9 > backref_bits:
+            out.put(0, 1)
+            out.put(best_offset - 1, window_bits)
+            out.put(best_len - 1, lookahead_bits)
+        else:
+            best_len = 1
+            out.put(1, 1)
+            out.put(data[pos], 8)
+        for i in range(best_len):
+            index(pos + i)
+        pos += best_len
+    return bytes(out.data)
+
+
+def decompress(data: bytes, window_bits: int, lookahead_bits: int, size: int) -> bytes:
+    bits = ''.join('{:08b}'.format(byte) for byte in data)
+    out = bytearray()
+    pos = 0
+    while len(out) < size:
+        if bits[pos] == '1':
+            out.append(int(bits[pos + 1:pos + 9], 2))
+            pos += 9
+        else:
+            offset = int(bits[pos + 1:pos + 1 + window_bits], 2) + 1
+            count = int(bits[pos + 1 + window_bits:pos + 1 + window_bits + lookahead_bits], 2) + 1
+            pos += 1 + window_bits + lookahead_bits
+            for _ in range(count):
+                out.append(out[-offset] if offset <= len(out) else 0)
+    return bytes(out)
+
+
+def apply(old: bytes, body: bytes, size: int) -> bytes:
+    new = bytearray()
+    pos = 0
+    old_pos = 0
+    while len(new) < size:
+        diff_len, extra_len, seek = RECORD.unpack_from(body, pos)
+        pos += RECORD.size
+        new += bytes((body[pos + i] + old[old_pos + i]) & 0xFF for i in range(diff_len))
+        pos += diff_len
+        new += body[pos:pos + extra_len]
+        pos += extra_len
+        old_pos += diff_len + seek
+    return bytes(new)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('old', type=argparse.FileType('rb'), help='Image running on the device')
+    parser.add_argument('new', type=argparse.FileType('rb'), help='New image')
+    parser.add_argument('patch', type=argparse.FileType('wb'), help='Patch to write')
+    parser.add_argument('--window', type=int, default=10,
+                        help='LZSS window bits, {} to {}, 0 for no compression'.format(MIN_WINDOW_BITS, MAX_WINDOW_BITS))
+    parser.add_argument('--lookahead', type=int, default=5, help='LZSS lookahead bits')
+    args = parser.parse_args()
+
+    if args.window != 0 and not (MIN_WINDOW_BITS <= args.window <= MAX_WINDOW_BITS and 0 < args.lookahead < args.window):
+        parser.error('unsupported window {} and lookahead {}'.format(args.window, args.lookahead))
+
+    old = args.old.read()
+    new = args.new.read()
+    if not new:
+        parser.error('the new image is empty')
+
+    body = encode_body(old, new, diff(old, new))
+    packed = compress(body, args.window, args.lookahead) if args.window else body
+
+    unpacked = decompress(packed, args.window, args.lookahead, len(body)) if args.window else packed
+    if apply(old, unpacked, len(new)) != new:
+        print('Patch does not rebuild the new image', file=sys.stderr)
+        return 1
+
+    lookahead = args.lookahead if args.window else 0
+    header = HEADER.pack(MAGIC, VERSION, args.window, lookahead, 0, len(old), len(new),
+                         hashlib.sha256(old).digest(), hashlib.sha256(new).digest())
+    args.patch.write(header + packed)
+
+    print('{} -> {} bytes, patch {} bytes ({:.1f}% of the new image)'.format(
+        len(old), len(new), len(header) + len(packed), 100.0 * (len(header) + len(packed)) / len(new)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,104 @@
+#!/usr/bin/env python
+# SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""
+Flight recorder decoder.
+
+Prints the events recorded by flightRecorder.c before a crash. The panic
+handler copies the rings of both cores into the core dump, they are found by
+their magic so the dump can be given as the ELF file or as the raw "coredump"
+partition:
+
+    parttool.py read_partition --partition-name coredump --output core.bin
+    python flight_recorder.py core.bin
+
+Any other memory dump holding the rings works too, e.g. the RTC memory where
+they are kept across resets.
+
+Event times are relative to the last event of the same core, the cores have
+their own cycle counters. Two consecutive events more than 2^32 cycles apart
+(26 s at 160 MHz) show a shorter gap.
+"""
+
+import argparse
+import struct
+import sys
+from typing import Iterator, List, Tuple
+
+MAGIC = struct.pack('<II', 0x52544C46, 0x31434552)  # FLIGHT_REC_MAGIC_0, FLIGHT_REC_MAGIC_1
+RING_HEADER = struct.Struct('<IIBBHHHI')
+EVENT = struct.Struct('<IIBBH')
+VERSION = 1
+
+TYPE_RAIL = 1
+TYPE_BUTTON = 2
+TYPE_ADC_ALARM = 3
+TYPE_TIMER = 4
+TYPE_BOOT = 5
+RAILS = ['power', 'charging']
+
+
+def rings(data: bytes) -> Iterator[Tuple[int, int, int, List[Tuple[int, int, int, int, int]]]]:
+    pos = data.find(MAGIC)
+    while pos >= 0:
+        _, _, version, core, size, event_size, cpu_mhz, head = RING_HEADER.unpack_from(data, pos)
+        end = pos + RING_HEADER.size + size * event_size
+        # The magic alone may show up in a stack, the header must make sense
+        if version == VERSION and event_size == EVENT.size and size and not size & (size - 1) and end <= len(data):
+            events = [EVENT.unpack_from(data, pos + RING_HEADER.size + i * event_size) for i in range(size)]
+            yield core, cpu_mhz, head, events
+        pos = data.find(MAGIC, pos + 1)
+
+
+def describe(rtype: int, rid: int, value: int) -> str:
+    if rtype == TYPE_RAIL:
+        return 'rail {} {}'.format(RAILS[rid] if rid < len(RAILS) else rid, 'on' if value else 'off')
+    if rtype == TYPE_BUTTON:
+        return 'button GPIO{} {}'.format(rid, 'pressed' if value else 'released')
+    if rtype == TYPE_ADC_ALARM:
+        return 'ADC alarm channel {}, {} mV'.format(rid, value)
+    if rtype == TYPE_TIMER:
+        return 'timer {} dispatched, {}'.format(rid, value)
+    if rtype == TYPE_BOOT:
+        return 'boot, reset reason {}, earlier times are from the previous boot'.format(value)
+    return 'type {} id {} value {}'.format(rtype, rid, value)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('path', help='Core dump, ELF file or raw partition')
+    args = parser.parse_args()
+
+    with open(args.path, 'rb') as f:
+        data = f.read()
+
+    found = False
+    for core, cpu_mhz, head, events in rings(data):
+        found = True
+        # Slots being written when the dump was taken hold sequence 0
+        recorded = sorted(e for e in events if e[0] and head - len(events) < e[0] <= head)
+        print('== core {}: {} events recorded, last {} in the dump'.format(core, head, len(recorded)))
+        if not recorded:
+            continue
+
+        # Back from the last event, one cycle counter wrap at most between two events
+        times = [0.0] * len(recorded)
+        for i in range(len(recorded) - 2, -1, -1):
+            delta = (recorded[i + 1][1] - recorded[i][1]) & 0xFFFFFFFF
+            times[i] = times[i + 1] - delta / (cpu_mhz or 1) / 1000.0
+
+        previous = None
+        for (sequence, _, rtype, rid, value), time_ms in zip(recorded, times):
+            if previous is not None and sequence != previous + 1:
+                print('{:>14}  {} events lost'.format('', sequence - previous - 1))
+            print('{:11.3f} ms  #{:<6} {}'.format(time_ms, sequence, describe(rtype, rid, value)))
+            previous = sequence
+
+    if not found:
+        print('No flight recorder ring found', file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,108 @@
+#!/usr/bin/env python
+# SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""
+Log store reader.
+
+Prints the records of the files written by logStore.c. Files being written
+(.LOG) hold the records as they are, closed files (.LZS) are compressed with
+heatshrink's LZSS format behind a small header. The files are taken off the
+"logs" partition, e.g.
+
+    esptool.py read_flash 0x1d2000 0x2e000 logs.bin
+    python $IDF_PATH/components/fatfs/fatfsparse.py --wl-layer enabled logs.bin
+
+and given to this script in any order, records are printed oldest file first.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+from typing import Iterator, List, Tuple
+
+PACK_MAGIC = 0x314B504C     # LOG_STORE_PACK_MAGIC
+PACK_HEADER = struct.Struct('<IBBHI')
+RECORD_HEADER = struct.Struct('<BBHI')
+NAME_RE = re.compile(r'^L(\d{7})\.(LOG|LZS)$', re.IGNORECASE)
+
+TYPE_BOOT = 0
+TYPE_TEXT = 1
+RESET_REASONS = ['unknown', 'power on', 'external', 'software', 'panic', 'interrupt watchdog', 'task watchdog',
+                 'watchdog', 'deep sleep', 'brownout', 'sdio', 'usb', 'jtag', 'efuse', 'power glitch', 'cpu lockup']
+
+
+def decompress(data: bytes, window_bits: int, lookahead_bits: int, size: int) -> bytes:
+    bits = ''.join('{:08b}'.format(byte) for byte in data)
+    out = bytearray()
+    pos = 0
+    while len(out) < size:
+        if bits[pos] == '1':
+            out.append(int(bits[pos + 1:pos + 9], 2))
+            pos += 9
+        else:
+            offset = int(bits[pos + 1:pos + 1 + window_bits], 2) + 1
+            count = int(bits[pos + 1 + window_bits:pos + 1 + window_bits + lookahead_bits], 2) + 1
+            pos += 1 + window_bits + lookahead_bits
+            for _ in range(count):
+                out.append(out[-offset] if offset <= len(out) else 0)
+    return bytes(out[:size])
+
+
+def load(path: str) -> bytes:
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not path.upper().endswith('.LZS'):
+        return data
+    magic, window_bits, lookahead_bits, _, size = PACK_HEADER.unpack_from(data)
+    if magic != PACK_MAGIC:
+        raise ValueError('{} is not a compressed log file'.format(path))
+    return decompress(data[PACK_HEADER.size:], window_bits, lookahead_bits, size)
+
+
+def records(data: bytes) -> Iterator[Tuple[int, int, int, bytes]]:
+    pos = 0
+    # A flush may leave the end of the last batch unwritten
+    while pos + RECORD_HEADER.size <= len(data):
+        rtype, length, sequence, timestamp_ms = RECORD_HEADER.unpack_from(data, pos)
+        pos += RECORD_HEADER.size
+        if pos + length > len(data):
+            break
+        yield sequence, timestamp_ms, rtype, data[pos:pos + length]
+        pos += length
+
+
+def describe(rtype: int, payload: bytes) -> str:
+    if rtype == TYPE_BOOT and len(payload) == 1:
+        reason = payload[0]
+        return 'boot, reset reason {}'.format(RESET_REASONS[reason] if reason < len(RESET_REASONS) else reason)
+    if rtype == TYPE_TEXT:
+        return payload.decode('utf-8', 'replace')
+    return 'type 0x{:02x} {}'.format(rtype, payload.hex())
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('paths', nargs='+', help='Log files, or directories holding them')
+    args = parser.parse_args()
+
+    files: List[Tuple[int, str]] = []
+    for path in args.paths:
+        names = [os.path.join(path, name) for name in os.listdir(path)] if os.path.isdir(path) else [path]
+        for name in names:
+            match = NAME_RE.match(os.path.basename(name))
+            if match:
+                files.append((int(match.group(1)), name))
+    if not files:
+        parser.error('no log file found')
+
+    for index, path in sorted(files):
+        print('== {} (file {})'.format(os.path.basename(path), index))
+        for sequence, timestamp_ms, rtype, payload in records(load(path)):
+            print('{:10.3f} #{:<5} {}'.format(timestamp_ms / 1000.0, sequence, describe(rtype, payload)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
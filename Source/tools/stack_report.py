@@ -0,0 +1,207 @@
+#!/usr/bin/env python
+# SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: CC0-1.0
+"""
+Worst-case stack estimate of the application tasks.
+
+Reads the call graph files (.ci) written by GCC with -fcallgraph-info=su for the
+main component, walks the deepest path from each task entry function and merges
+the result with the peaks logged at run time by the stack monitor
+(stackMonitor.c). Prints the recommended stack size of each task as sdkconfig
+lines, ready to go into sdkconfig.defaults.
+"""
+
+import argparse
+import os
+import re
+import sys
+from typing import Dict, List, NamedTuple, Optional, Set, Tuple
+
+NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"]*)"')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+FRAME_RE = re.compile(r'\\n(\d+) bytes \(([a-z,]+)\)')
+MONITOR_RE = re.compile(r"STACK_MON: '(.+?)' size (\d+) peak (\d+)")
+
+INDIRECT_CALL = '__indirect_call'
+SIZE_ALIGN = 64
+
+
+class Task(NamedTuple):
+    name: str           # FreeRTOS task name, as logged by the stack monitor
+    entry: str          # Task function
+    config: str         # Kconfig option of the stack size
+    size: int           # Configured stack size
+
+
+class Estimate(NamedTuple):
+    depth: int          # Bytes used by the deepest path
+    path: List[str]     # Functions on the deepest path
+    dynamic: bool       # A function on some path has a dynamic frame
+    recursive: bool     # The graph has a cycle, the depth is a lower bound
+    indirect: bool      # A function pointer is called, the callee is not counted
+    external: Set[str]  # Functions called outside the analysed code, not counted
+
+
+class CallGraph:
+    def __init__(self) -> None:
+        self.frames: Dict[str, Tuple[int, str]] = {}
+        self.calls: Dict[str, List[str]] = {}
+        self._memo: Dict[str, Estimate] = {}
+
+    def load(self, path: str) -> None:
+        with open(path, encoding='utf-8') as f:
+            for line in f:
+                node = NODE_RE.match(line)
+                if node:
+                    frame = FRAME_RE.search(node.group(2))
+                    if frame:
+                        self.frames[node.group(1)] = (int(frame.group(1)), frame.group(2))
+                    continue
+                edge = EDGE_RE.match(line)
+                if edge:
+                    self.calls.setdefault(edge.group(1), []).append(edge.group(2))
+
+    def find(self, function: str) -> Optional[str]:
+        # static functions are prefixed with their file name
+        for title in self.frames:
+            if title == function or title.split(':')[-1] == function:
+                return title
+        return None
+
+    def estimate(self, title: str, visiting: Optional[Set[str]] = None) -> Estimate:
+        if title in self._memo:
+            return self._memo[title]
+        visiting = visiting or set()
+
+        frame, qualifier = self.frames[title]
+        deepest = Estimate(0, [], False, False, False, set())
+        dynamic = qualifier != 'static'
+        recursive = indirect = False
+        external: Set[str] = set()
+
+        visiting.add(title)
+        for callee in self.calls.get(title, []):
+            if callee == INDIRECT_CALL:
+                indirect = True
+            elif callee not in self.frames:
+                external.add(callee)
+            elif callee in visiting:
+                recursive = True
+            else:
+                sub = self.estimate(callee, visiting)
+                dynamic |= sub.dynamic
+                recursive |= sub.recursive
+                indirect |= sub.indirect
+                external |= sub.external
+                if sub.depth > deepest.depth:
+                    deepest = sub
+        visiting.discard(title)
+
+        result = Estimate(frame + deepest.depth, [title.split(':')[-1]] + deepest.path,
+                          dynamic, recursive, indirect, external)
+        if not recursive:
+            self._memo[title] = result
+        return result
+
+
+def parse_task(spec: str) -> Task:
+    try:
+        name, entry, config, size = spec.rsplit(':', 3)
+        return Task(name, entry, config, int(size))
+    except ValueError:
+        raise argparse.ArgumentTypeError('expected NAME:ENTRY:CONFIG:SIZE, got {}'.format(spec))
+
+
+def load_peaks(path: str) -> Dict[str, int]:
+    peaks: Dict[str, int] = {}
+    with open(path, encoding='utf-8', errors='replace') as f:
+        for line in f:
+            match = MONITOR_RE.search(line)
+            if match:
+                peaks[match.group(1)] = max(peaks.get(match.group(1), 0), int(match.group(3)))
+    return peaks
+
+
+def round_up(value: int) -> int:
+    return (value + SIZE_ALIGN - 1) // SIZE_ALIGN * SIZE_ALIGN
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--ci-dir', required=True, help='Directory searched for .ci files')
+    parser.add_argument('--task', type=parse_task, action='append', default=[],
+                        help='Task to analyse, as NAME:ENTRY:CONFIG:SIZE')
+    parser.add_argument('--monitor-log', default=os.environ.get('STACK_MONITOR_LOG', ''),
+                        help='Console log with stack monitor peaks (default: $STACK_MONITOR_LOG)')
+    parser.add_argument('--overhead', type=int, default=768,
+                        help='Bytes added to the static estimate for the interrupt context frame and '
+                             'the SDK functions called by the task, which are not in the call graph')
+    parser.add_argument('--margin', type=int, default=25, help='Margin over the estimate, in percent')
+    parser.add_argument('--log-hook', action='append', default=[],
+                        help='Function installed with esp_log_set_vprintf. It runs on top of any task '
+                             'logging, through a pointer the call graph does not follow')
+    args = parser.parse_args()
+
+    graph = CallGraph()
+    ci_files = 0
+    for root, _, files in os.walk(args.ci_dir):
+        for name in files:
+            if name.endswith('.ci'):
+                graph.load(os.path.join(root, name))
+                ci_files += 1
+    if ci_files == 0:
+        print('No .ci files in {}, enable CONFIG_STACK_USAGE_ANALYSIS and build first'.format(args.ci_dir))
+        return 1
+
+    peaks = load_peaks(args.monitor_log) if args.monitor_log else {}
+
+    hook: Optional[Estimate] = None
+    for function in args.log_hook:
+        title = graph.find(function)
+        if title is None:
+            print('Log hook {} not found'.format(function))
+            continue
+        est = graph.estimate(title)
+        if hook is None or est.depth > hook.depth:
+            hook = est
+
+    recommendations = []
+    for task in args.task:
+        title = graph.find(task.entry)
+        if title is None:
+            print('{}: entry function {} not found'.format(task.name, task.entry))
+            continue
+        est = graph.estimate(title)
+        peak = peaks.get(task.name)
+
+        print("'{}' ({}), configured {} bytes".format(task.name, task.entry, task.size))
+        print('    static estimate {} bytes: {}'.format(est.depth, ' -> '.join(est.path)))
+        if est.dynamic:
+            print('    dynamic stack allocation on some path, estimate is a lower bound')
+        if est.recursive:
+            print('    recursion in the call graph, estimate is a lower bound')
+        if est.indirect:
+            print('    calls through function pointers are not counted')
+        if est.external:
+            print('    {} external functions not counted, covered by the {} bytes overhead'.format(
+                len(est.external), args.overhead))
+        if hook is not None:
+            print('    log hook adds {} bytes: {}'.format(hook.depth, ' -> '.join(hook.path)))
+        if peak is not None:
+            print('    measured peak {} bytes'.format(peak))
+
+        base = max(est.depth + (hook.depth if hook else 0) + args.overhead, peak or 0)
+        recommended = max(round_up(base * (100 + args.margin) // 100), 768)
+        recommendations.append((task, recommended))
+        print('    recommended {} bytes ({:+d})'.format(recommended, recommended - task.size))
+
+    if recommendations:
+        print('\n# Recommended stack sizes')
+        for task, recommended in recommendations:
+            print('CONFIG_{}={}'.format(task.config, recommended))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())